@@ -0,0 +1,271 @@
+#!/usr/bin/env node
+// Local time-series archive: one MQTT subscription for the whole fleet, an append-only
+// segment store on disk, and HTTP range queries for the dashboard's history.
+// Replaces the dashboard's per-sample Firebase writes, which every open tab repeated.
+'use strict';
+
+const http = require('http');
+const path = require('path');
+const { MqttClient } = require('../loadtest/lib/mqtt');
+const { SegmentStore } = require('./lib/store');
+const CBOR = require('../../web/cbor.js');
+const TSCodec = require('../../web/tscodec.js');
+
+// Same layout as firmware/ESP32/main/app_main.c
+const ROOT = 'esp32';
+const FILTERS = [`${ROOT}/+/sensor/sht3x/periodic/+`, `${ROOT}/+/sensor/sht3x/batch`];
+const METRICS = ['temperature', 'humidity'];
+const DEVICE_PATTERN = /^[A-Za-z0-9_.-]{1,64}$/;
+const MAX_POINTS = 100000;
+const MAX_BUCKETS = 10000;
+const RECONNECT_MS = 2000;
+
+const DEFAULTS = {
+    url: 'mqtt://127.0.0.1:1883',
+    user: 'DataLogger',
+    pass: 'datalogger',
+    dir: path.join(__dirname, 'data'),
+    httpHost: '127.0.0.1',
+    httpPort: 8090,
+    blockSamples: 256,      // Samples per block
+    flushInterval: 10,      // s an open block may wait before it is written
+    segmentMb: 16,
+    retentionDays: 0        // 0 = keep everything
+};
+
+const HELP = `Usage: node archive.js [options]
+  --url URL              Broker (default ${DEFAULTS.url})
+  --user NAME            MQTT username (default ${DEFAULTS.user})
+  --pass SECRET          MQTT password
+  --dir PATH             Segment directory (default broker/archive/data)
+  --http-host HOST       Query API address (default ${DEFAULTS.httpHost})
+  --http-port PORT       Query API port (default ${DEFAULTS.httpPort})
+  --block-samples N      Samples per block (default ${DEFAULTS.blockSamples})
+  --flush-interval S     Longest time a sample waits in memory (default ${DEFAULTS.flushInterval})
+  --segment-mb N         Segment file size (default ${DEFAULTS.segmentMb})
+  --retention-days N     Drop segments older than this, 0 = never (default ${DEFAULTS.retentionDays})
+
+API (JSON, CORS enabled):
+  GET /api/series                                         Series with sample counts and time span
+  GET /api/range?device=D&metric=M[&from=ms][&to=ms][&limit=N]
+                                                          Newest N samples in the range, oldest first
+  GET /api/summary?device=D&metric=M&step=ms[&from=ms][&to=ms]
+                                                          Min/max/avg per step
+  GET /api/stats                                          Ingest and store counters
+`;
+
+function parseArgs(argv) {
+    const options = { ...DEFAULTS };
+    for (let i = 0; i < argv.length; i++) {
+        const arg = argv[i];
+        if (arg === '--help' || arg === '-h') {
+            process.stdout.write(HELP);
+            process.exit(0);
+        }
+        const key = arg.replace(/^--/, '').replace(/-([a-z])/g, (m, c) => c.toUpperCase());
+        if (!arg.startsWith('--') || !(key in DEFAULTS) || i + 1 >= argv.length) {
+            process.stderr.write(`Unknown or incomplete option ${arg}\n\n${HELP}`);
+            process.exit(2);
+        }
+        const value = argv[++i];
+        options[key] = typeof DEFAULTS[key] === 'number' ? Number(value) : value;
+    }
+    return options;
+}
+
+const log = (line) => process.stderr.write(`${new Date().toISOString()} ${line}\n`);
+
+// Decoded batch (CBOR map or ts_codec block) -> [{ time, temperature, humidity }], placed
+// like the dashboard does: the last sample now, the others before it by their UART offsets
+function batchSamples(payload, now) {
+    let dtUs, temperature, humidity;
+    if (TSCodec.isBlock(payload)) {
+        const block = TSCodec.decode(payload);
+        dtUs = block.time.map((t) => t - block.time[0]);
+        [temperature, humidity] = block.values;
+    } else {
+        const batch = CBOR.decode(payload);
+        ({ dt_us: dtUs, temperature, humidity } = batch);
+    }
+    if (!Array.isArray(dtUs) || !dtUs.length || !Array.isArray(temperature) || !Array.isArray(humidity)) {
+        throw new Error('incomplete batch');
+    }
+    const lastUs = dtUs[dtUs.length - 1];
+    return dtUs.map((dt, i) => ({
+        time: now - Math.round((lastUs - dt) / 1000),
+        temperature: temperature[i],
+        humidity: humidity[i]
+    }));
+}
+
+function startIngest(options, store, counters) {
+    const connect = async () => {
+        const client = new MqttClient({
+            url: options.url,
+            clientId: `archive_${process.pid}`,
+            username: options.user,
+            password: options.pass
+        });
+
+        client.on('message', (topic, payload) => {
+            const parts = topic.split('/');
+            const device = parts[1];
+            const now = Date.now();
+            counters.messages++;
+            try {
+                if (parts[parts.length - 1] === 'batch') {
+                    for (const sample of batchSamples(payload, now)) {
+                        store.append(`${device}/temperature`, sample.time, sample.temperature);
+                        store.append(`${device}/humidity`, sample.time, sample.humidity);
+                        counters.samples += 2;
+                    }
+                    return;
+                }
+                const metric = parts[parts.length - 1];
+                const value = CBOR.isBinary(payload) ? CBOR.decode(payload) : parseFloat(payload.toString());
+                if (!METRICS.includes(metric) || typeof value !== 'number' || !isFinite(value)) {
+                    throw new Error('not a sample');
+                }
+                store.append(`${device}/${metric}`, now, value);
+                counters.samples++;
+            } catch (err) {
+                counters.rejected++;
+            }
+        });
+        client.on('close', () => {
+            log(`Disconnected from ${options.url}, retrying in ${RECONNECT_MS / 1000} s`);
+            setTimeout(connect, RECONNECT_MS);
+        });
+        client.on('error', (err) => log(`MQTT error: ${err.message}`));
+
+        try {
+            await client.connect();
+            await client.subscribe(FILTERS, 1);
+            counters.connects++;
+            log(`Subscribed to ${FILTERS.join(', ')} on ${options.url}`);
+        } catch (err) {
+            // The socket's close event schedules the retry
+            log(`Cannot connect to ${options.url}: ${err.message}`);
+        }
+    };
+    connect();
+}
+
+function startHttp(options, store, counters) {
+    const send = (res, status, body) => {
+        res.writeHead(status, {
+            'Content-Type': 'application/json',
+            'Access-Control-Allow-Origin': '*',
+            'Cache-Control': 'no-store'
+        });
+        res.end(JSON.stringify(body));
+    };
+
+    const server = http.createServer((req, res) => {
+        const url = new URL(req.url, 'http://archive');
+        const q = url.searchParams;
+        if (req.method === 'OPTIONS') {
+            res.writeHead(204, { 'Access-Control-Allow-Origin': '*', 'Access-Control-Allow-Methods': 'GET' });
+            res.end();
+            return;
+        }
+        if (req.method !== 'GET') {
+            send(res, 405, { error: 'GET only' });
+            return;
+        }
+
+        const number = (name, fallback) => (q.has(name) ? Number(q.get(name)) : fallback);
+        const series = () => {
+            const device = q.get('device') || '';
+            const metric = q.get('metric') || '';
+            return DEVICE_PATTERN.test(device) && METRICS.includes(metric) ? `${device}/${metric}` : null;
+        };
+        const started = process.hrtime.bigint();
+
+        switch (url.pathname) {
+            case '/api/series':
+                send(res, 200, store.list());
+                break;
+            case '/api/range': {
+                const key = series();
+                const from = number('from', 0), to = number('to', Date.now()), limit = number('limit', 1000);
+                if (!key || !isFinite(from) || !isFinite(to) || !(limit >= 1 && limit <= MAX_POINTS)) {
+                    send(res, 400, { error: `device, metric (${METRICS.join('|')}) and limit 1-${MAX_POINTS} required` });
+                    return;
+                }
+                const points = store.range(key, from, to, Math.floor(limit));
+                send(res, 200, { series: key, from, to, points });
+                break;
+            }
+            case '/api/summary': {
+                const key = series();
+                const from = number('from', 0), to = number('to', Date.now()), step = number('step', 0);
+                if (!key || !isFinite(from) || !isFinite(to) || !(step >= 1) || (to - from) / step > MAX_BUCKETS) {
+                    send(res, 400, { error: `device, metric and a step giving at most ${MAX_BUCKETS} buckets required` });
+                    return;
+                }
+                send(res, 200, { series: key, from, to, step, buckets: store.summary(key, from, to, step) });
+                break;
+            }
+            case '/api/stats':
+                send(res, 200, {
+                    ...counters,
+                    series: store.series.size,
+                    segments: store.segments.length,
+                    disk_bytes: store.diskBytes(),
+                    store: store.stats
+                });
+                break;
+            default:
+                send(res, 404, { error: 'not found' });
+                return;
+        }
+        counters.queries++;
+        counters.queryNs += Number(process.hrtime.bigint() - started);
+    });
+
+    server.listen(options.httpPort, options.httpHost, () => {
+        log(`Query API on http://${options.httpHost}:${options.httpPort}/api/`);
+    });
+    return server;
+}
+
+function main() {
+    const options = parseArgs(process.argv.slice(2));
+    if (!(options.blockSamples >= 16) || !(options.flushInterval > 0) || !(options.segmentMb >= 1) ||
+        !(options.retentionDays >= 0)) {
+        process.stderr.write(`Invalid option value\n\n${HELP}`);
+        process.exit(2);
+    }
+
+    const store = new SegmentStore({
+        dir: options.dir,
+        blockSamples: options.blockSamples,
+        flushMs: options.flushInterval * 1000,
+        segmentBytes: options.segmentMb * 1024 * 1024,
+        retentionMs: options.retentionDays * 86400000
+    });
+    const opened = Date.now();
+    store.open();
+    const blocks = store.list().reduce((n, s) => n + s.blocks, 0);
+    log(`Opened ${options.dir}: ${store.series.size} series, ${blocks} blocks, ` +
+        `${store.segments.length} segment(s) in ${Date.now() - opened} ms` +
+        (store.stats.truncatedBytes ? `, cut ${store.stats.truncatedBytes} bytes of a torn record` : ''));
+
+    const counters = { connects: 0, messages: 0, samples: 0, rejected: 0, queries: 0, queryNs: 0 };
+    startIngest(options, store, counters);
+    const server = startHttp(options, store, counters);
+    const flushTimer = setInterval(() => store.flush(), 1000);
+
+    const shutdown = () => {
+        clearInterval(flushTimer);
+        server.close();
+        store.close();
+        log(`Stopped after ${counters.samples} samples`);
+        process.exit(0);
+    };
+    process.on('SIGINT', shutdown);
+    process.on('SIGTERM', shutdown);
+}
+
+main();
@@ -0,0 +1,185 @@
+#!/usr/bin/env node
+// Archive store benchmark: ingest rate, bytes per sample, index rebuild time and
+// query rate for the dashboard's history request and for long-span summaries.
+// Runs the store directly, without MQTT or HTTP, on a temporary directory.
+'use strict';
+
+const fs = require('fs');
+const os = require('os');
+const path = require('path');
+const { performance } = require('perf_hooks');
+const { SegmentStore } = require('./lib/store');
+
+const DEFAULTS = {
+    series: 20,             // 10 devices x temperature, humidity
+    samples: 86400,         // Per series: one day at 1 Hz
+    blockSamples: 256,
+    queries: 2000,
+    dir: '',                // Default: a temporary directory, removed afterwards
+    json: false
+};
+
+const HELP = `Usage: node bench.js [options]
+  --series N          Series written in parallel (default ${DEFAULTS.series})
+  --samples N         Samples per series, 1 s apart (default ${DEFAULTS.samples})
+  --block-samples N   Samples per block (default ${DEFAULTS.blockSamples})
+  --queries N         Queries per query type (default ${DEFAULTS.queries})
+  --dir PATH          Keep the store in PATH instead of a temporary directory
+  --json              Print the results as one JSON object on stdout
+`;
+
+function parseArgs(argv) {
+    const options = { ...DEFAULTS };
+    for (let i = 0; i < argv.length; i++) {
+        const arg = argv[i];
+        if (arg === '--help' || arg === '-h') {
+            process.stdout.write(HELP);
+            process.exit(0);
+        }
+        if (arg === '--json') {
+            options.json = true;
+            continue;
+        }
+        const key = arg.replace(/^--/, '').replace(/-([a-z])/g, (m, c) => c.toUpperCase());
+        if (!arg.startsWith('--') || !(key in DEFAULTS) || i + 1 >= argv.length) {
+            process.stderr.write(`Unknown or incomplete option ${arg}\n\n${HELP}`);
+            process.exit(2);
+        }
+        const value = argv[++i];
+        options[key] = typeof DEFAULTS[key] === 'number' ? Number(value) : value;
+    }
+    return options;
+}
+
+// xorshift32, so every run writes the same data
+let rng = 0x2545F491;
+function random() {
+    rng ^= rng << 13;
+    rng ^= rng >>> 17;
+    rng ^= rng << 5;
+    return (rng >>> 0) / 4294967296;
+}
+
+function percentile(sorted, p) {
+    return sorted[Math.min(sorted.length - 1, Math.ceil((p / 100) * sorted.length) - 1)];
+}
+
+function timeQueries(count, fn) {
+    const us = [];
+    let points = 0;
+    const start = performance.now();
+    for (let i = 0; i < count; i++) {
+        const t0 = performance.now();
+        points += fn(i);
+        us.push((performance.now() - t0) * 1000);
+    }
+    const elapsed = performance.now() - start;
+    us.sort((a, b) => a - b);
+    return {
+        per_s: Math.round(count / (elapsed / 1000)),
+        p50_us: Math.round(percentile(us, 50)),
+        p95_us: Math.round(percentile(us, 95)),
+        points_per_query: Math.round(points / count)
+    };
+}
+
+function main() {
+    const options = parseArgs(process.argv.slice(2));
+    if (!(options.series >= 1) || !(options.samples >= 1) || !(options.blockSamples >= 16) || !(options.queries >= 1)) {
+        process.stderr.write(`Invalid option value\n\n${HELP}`);
+        process.exit(2);
+    }
+    const dir = options.dir || fs.mkdtempSync(path.join(os.tmpdir(), 'archive-bench-'));
+    const storeOptions = { dir, blockSamples: options.blockSamples, flushMs: Infinity };
+    const keys = Array.from({ length: options.series }, (_, i) =>
+        `ESP32_BENCH${String(i >> 1).padStart(2, '0')}/${i % 2 ? 'humidity' : 'temperature'}`);
+    const start = Date.UTC(2025, 0, 1);
+    const span = options.samples * 1000;
+
+    // Ingest: series interleaved as they arrive live, 1 Hz with up to 20 ms of jitter
+    // and values drifting by hundredths
+    const values = keys.map((k) => (k.endsWith('humidity') ? 52 : 23.5));
+    const expected = [];    // First series, to check what comes back
+    let store = new SegmentStore(storeOptions).open();
+    let t0 = performance.now();
+    for (let n = 0; n < options.samples; n++) {
+        for (let s = 0; s < keys.length; s++) {
+            const r = random();
+            if (r < 0.1) values[s] += r < 0.05 ? 0.01 : -0.01;
+            const time = start + n * 1000 + Math.floor(random() * 20);
+            store.append(keys[s], time, values[s]);
+            if (s === 0) expected.push([time, Math.round(values[s] * 100) / 100]);
+        }
+    }
+    store.close();
+    const ingestMs = performance.now() - t0;
+    const total = options.series * options.samples;
+    const diskBytes = fs.readdirSync(dir).reduce((n, f) => n + fs.statSync(path.join(dir, f)).size, 0);
+
+    // Reopen: scan the segments and rebuild the index
+    t0 = performance.now();
+    store = new SegmentStore(storeOptions).open();
+    const openMs = performance.now() - t0;
+    const blocks = store.list().reduce((n, s) => n + s.blocks, 0);
+
+    // Everything written must come back, in order, before anything is timed
+    const stored = store.range(keys[0], -Infinity, Infinity, Infinity);
+    if (stored.length !== expected.length ||
+        stored.some(([t, v], i) => t !== expected[i][0] || v !== expected[i][1])) {
+        process.stderr.write(`${keys[0]}: read back ${stored.length} samples that differ from the ${expected.length} written\n`);
+        process.exit(1);
+    }
+
+    // Dashboard "Load Data": newest 50 samples before a random time
+    const latest = timeQueries(options.queries, (i) => {
+        const to = start + random() * span;
+        return store.range(keys[i % keys.length], 0, to, 50).length;
+    });
+    // One hour of raw samples
+    const hour = timeQueries(options.queries, (i) => {
+        const from = start + random() * Math.max(0, span - 3600000);
+        return store.range(keys[i % keys.length], from, from + 3600000, 100000).length;
+    });
+    // Whole span at 1 h per bucket: full blocks come from the index
+    const readsBefore = store.stats.blocksRead;
+    const hitsBefore = store.stats.indexHits;
+    const summary = timeQueries(Math.max(1, Math.floor(options.queries / 10)), (i) =>
+        store.summary(keys[i % keys.length], start, start + span, 3600000).length);
+    const reads = store.stats.blocksRead - readsBefore;
+    const hits = store.stats.indexHits - hitsBefore;
+    store.close();
+    if (!options.dir) fs.rmSync(dir, { recursive: true, force: true });
+
+    const results = {
+        samples: total,
+        series: options.series,
+        block_samples: options.blockSamples,
+        ingest_per_s: Math.round(total / (ingestMs / 1000)),
+        disk_bytes: diskBytes,
+        bytes_per_sample: Number((diskBytes / total).toFixed(2)),
+        blocks,
+        open_ms: Math.round(openMs),
+        latest50: latest,
+        hour,
+        summary_1h: { ...summary, index_fraction: Number((hits / Math.max(1, hits + reads)).toFixed(3)) }
+    };
+
+    if (options.json) {
+        process.stdout.write(JSON.stringify(results) + '\n');
+        return;
+    }
+    const r = results;
+    console.log(`Ingest   ${r.samples} samples (${r.series} series) at ${r.ingest_per_s}/s`);
+    console.log(`Disk     ${r.disk_bytes} bytes, ${r.bytes_per_sample} per sample, ${r.blocks} blocks of ${r.block_samples}`);
+    console.log(`Reopen   ${r.open_ms} ms to rebuild the index`);
+    console.log('');
+    console.log('| Query | Points | Queries/s | p50 us | p95 us |');
+    console.log('|-------|--------|-----------|--------|--------|');
+    const row = (name, q) => console.log(`| ${name} | ${q.points_per_query} | ${q.per_s} | ${q.p50_us} | ${q.p95_us} |`);
+    row('newest 50', r.latest50);
+    row('1 h raw', r.hour);
+    row('whole span, 1 h buckets', r.summary_1h);
+    console.log(`\nSummary buckets took ${(r.summary_1h.index_fraction * 100).toFixed(1)} % of their blocks from the index.`);
+}
+
+main();
@@ -0,0 +1,347 @@
+// Append-only segment store for sample series (e.g. "ESP32_A1B2C3/temperature").
+//
+// Samples of a series collect in an open block in memory. A block is sealed when it
+// holds --block-samples samples or its first sample is --flush-interval old. Sealing
+// appends one record to the active segment file:
+//
+//   segment  "DLSEG1\n\0" | record...
+//   record   u32 payload length | u32 CRC-32 of the payload | payload
+//   payload  u8 key length | key | u32 count | f64 tMin | f64 tMax | f64 vMin | f64 vMax | f64 sum | block
+//
+// The block is a ts_codec block (web/tscodec.js): millisecond times as delta-of-delta,
+// values in hundredths as deltas. All integers are little-endian.
+//
+// At open, the segments are scanned once and the fields before each block become an
+// in-memory index per series, sorted by time. Queries binary-search that index and
+// read only the blocks they need, with positioned reads that the page cache serves.
+// A record torn by a crash fails its CRC and is cut off the last segment.
+'use strict';
+
+const fs = require('fs');
+const path = require('path');
+const TSCodec = require('../../../web/tscodec.js');
+
+const SEGMENT_MAGIC = Buffer.from('DLSEG1\n\0', 'latin1');
+const SEGMENT_PATTERN = /^seg-(\d{8})\.dls$/;
+const RECORD_HEADER = 8;
+const BLOCK_META = 4 + 5 * 8;
+const DECIMALS = 2;
+
+const CRC_TABLE = (() => {
+    const table = new Int32Array(256);
+    for (let n = 0; n < 256; n++) {
+        let c = n;
+        for (let k = 0; k < 8; k++) c = c & 1 ? 0xEDB88320 ^ (c >>> 1) : c >>> 1;
+        table[n] = c;
+    }
+    return table;
+})();
+
+function crc32(data, start = 0, end = data.length) {
+    let crc = -1;
+    for (let i = start; i < end; i++) crc = CRC_TABLE[(crc ^ data[i]) & 0xFF] ^ (crc >>> 8);
+    return (crc ^ -1) >>> 0;
+}
+
+// Stored values are hundredths, as the STM32 prints them
+const quantize = (value) => Math.round(value * 100) / 100;
+
+class SegmentStore {
+    constructor(options) {
+        this.dir = options.dir;
+        this.blockSamples = options.blockSamples || 256;
+        this.flushMs = options.flushMs ?? 10000;
+        this.segmentBytes = options.segmentBytes || 16 * 1024 * 1024;
+        this.retentionMs = options.retentionMs || 0;            // 0 = keep everything
+        this.series = new Map();    // key -> { blocks: [index entries], open: { time, value, since }, seq, last }
+        this.segments = [];         // { id, file, fd, size, tMax }, oldest first
+        this.stats = {
+            appended: 0, blocksWritten: 0, bytesWritten: 0, blocksRead: 0,
+            indexHits: 0, truncatedBytes: 0, segmentsDropped: 0
+        };
+    }
+
+    open() {
+        fs.mkdirSync(this.dir, { recursive: true });
+        const files = fs.readdirSync(this.dir).filter((f) => SEGMENT_PATTERN.test(f)).sort();
+        files.forEach((file, i) => this.scanSegment(file, i === files.length - 1));
+        if (!this.segments.length) this.rollSegment();
+        return this;
+    }
+
+    // Rebuild the index from one segment; only the last may end in a torn record
+    scanSegment(file, last) {
+        const id = Number(SEGMENT_PATTERN.exec(file)[1]);
+        const fullPath = path.join(this.dir, file);
+        const data = fs.readFileSync(fullPath);
+        const segment = { id, file: fullPath, fd: fs.openSync(fullPath, 'r+'), size: 0, tMax: -Infinity };
+        this.segments.push(segment);
+
+        if (data.length < SEGMENT_MAGIC.length || !data.subarray(0, SEGMENT_MAGIC.length).equals(SEGMENT_MAGIC)) {
+            throw new Error(`${fullPath} is not a DLSEG1 segment`);
+        }
+        let pos = SEGMENT_MAGIC.length;
+        while (pos + RECORD_HEADER <= data.length) {
+            const length = data.readUInt32LE(pos);
+            const start = pos + RECORD_HEADER;
+            if (start + length > data.length || crc32(data, start, start + length) !== data.readUInt32LE(pos + 4)) {
+                break;
+            }
+            this.indexRecord(segment, data, start, length);
+            pos = start + length;
+        }
+
+        if (pos < data.length) {
+            if (!last) throw new Error(`${fullPath}: damaged record at offset ${pos}`);
+            fs.ftruncateSync(segment.fd, pos);
+            this.stats.truncatedBytes += data.length - pos;
+        }
+        segment.size = pos;
+    }
+
+    indexRecord(segment, data, start, length) {
+        const keyLength = data[start];
+        const key = data.toString('utf8', start + 1, start + 1 + keyLength);
+        let p = start + 1 + keyLength;
+        const entry = {
+            segment,
+            count: data.readUInt32LE(p),
+            tMin: data.readDoubleLE(p + 4),
+            tMax: data.readDoubleLE(p + 12),
+            vMin: data.readDoubleLE(p + 20),
+            vMax: data.readDoubleLE(p + 28),
+            sum: data.readDoubleLE(p + 36),
+            offset: 0,
+            length: 0
+        };
+        p += BLOCK_META;
+        entry.offset = p;
+        entry.length = start + length - p;
+
+        const s = this.getSeries(key);
+        s.blocks.push(entry);
+        s.seq++;
+        s.last = Math.max(s.last, entry.tMax);
+        segment.tMax = Math.max(segment.tMax, entry.tMax);
+    }
+
+    getSeries(key) {
+        let s = this.series.get(key);
+        if (!s) {
+            s = { blocks: [], open: { time: [], value: [], since: 0 }, seq: 0, last: -Infinity };
+            this.series.set(key, s);
+        }
+        return s;
+    }
+
+    rollSegment() {
+        const id = this.segments.length ? this.segments[this.segments.length - 1].id + 1 : 1;
+        const file = path.join(this.dir, `seg-${String(id).padStart(8, '0')}.dls`);
+        const fd = fs.openSync(file, 'wx+');
+        fs.writeSync(fd, SEGMENT_MAGIC, 0, SEGMENT_MAGIC.length, 0);
+        this.segments.push({ id, file, fd, size: SEGMENT_MAGIC.length, tMax: -Infinity });
+        this.applyRetention(Date.now());
+    }
+
+    // Whole segments go once their newest sample is older than the retention
+    applyRetention(now) {
+        if (!this.retentionMs) return;
+        while (this.segments.length > 1 && this.segments[0].tMax < now - this.retentionMs) {
+            const old = this.segments.shift();
+            for (const s of this.series.values()) {
+                s.blocks = s.blocks.filter((e) => e.segment !== old);
+            }
+            fs.closeSync(old.fd);
+            fs.unlinkSync(old.file);
+            this.stats.segmentsDropped++;
+        }
+    }
+
+    // Times of a series never go backwards, so its blocks stay sorted
+    append(key, time, value) {
+        const s = this.getSeries(key);
+        if (time < s.last) time = s.last;
+        s.last = time;
+        if (!s.open.time.length) s.open.since = Date.now();
+        s.open.time.push(time);
+        s.open.value.push(quantize(value));
+        this.stats.appended++;
+        if (s.open.time.length >= this.blockSamples) this.seal(key, s);
+    }
+
+    seal(key, s) {
+        const { time, value } = s.open;
+        const block = Buffer.from(TSCodec.encode({ sequence: s.seq, decimals: DECIMALS, time, values: [value] }));
+        const keyBytes = Buffer.from(key, 'utf8');
+        if (keyBytes.length > 255) throw new Error(`Series key too long: ${key}`);
+
+        let vMin = Infinity, vMax = -Infinity, sum = 0;
+        for (const v of value) {
+            if (v < vMin) vMin = v;
+            if (v > vMax) vMax = v;
+            sum += v;
+        }
+
+        const payloadLength = 1 + keyBytes.length + BLOCK_META + block.length;
+        const record = Buffer.alloc(RECORD_HEADER + payloadLength);
+        let p = RECORD_HEADER;
+        record[p++] = keyBytes.length;
+        keyBytes.copy(record, p);
+        p += keyBytes.length;
+        record.writeUInt32LE(time.length, p);
+        record.writeDoubleLE(time[0], p + 4);
+        record.writeDoubleLE(time[time.length - 1], p + 12);
+        record.writeDoubleLE(vMin, p + 20);
+        record.writeDoubleLE(vMax, p + 28);
+        record.writeDoubleLE(sum, p + 36);
+        block.copy(record, p + BLOCK_META);
+        record.writeUInt32LE(payloadLength, 0);
+        record.writeUInt32LE(crc32(record, RECORD_HEADER), 4);
+
+        let segment = this.segments[this.segments.length - 1];
+        if (segment.size > SEGMENT_MAGIC.length && segment.size + record.length > this.segmentBytes) {
+            this.rollSegment();
+            segment = this.segments[this.segments.length - 1];
+        }
+        fs.writeSync(segment.fd, record, 0, record.length, segment.size);
+
+        const blockOffset = segment.size + RECORD_HEADER + 1 + keyBytes.length + BLOCK_META;
+        s.blocks.push({
+            segment, count: time.length, tMin: time[0], tMax: time[time.length - 1],
+            vMin, vMax, sum, offset: blockOffset, length: block.length
+        });
+        segment.size += record.length;
+        segment.tMax = Math.max(segment.tMax, time[time.length - 1]);
+        s.seq++;
+        s.open = { time: [], value: [], since: 0 };
+        this.stats.blocksWritten++;
+        this.stats.bytesWritten += record.length;
+    }
+
+    // Seal open blocks that waited long enough, or all of them
+    flush(all = false) {
+        const now = Date.now();
+        for (const [key, s] of this.series) {
+            if (s.open.time.length && (all || now - s.open.since >= this.flushMs)) this.seal(key, s);
+        }
+    }
+
+    close() {
+        this.flush(true);
+        for (const segment of this.segments) fs.closeSync(segment.fd);
+        this.segments = [];
+    }
+
+    readBlock(entry) {
+        const data = Buffer.allocUnsafe(entry.length);
+        fs.readSync(entry.segment.fd, data, 0, entry.length, entry.offset);
+        this.stats.blocksRead++;
+        const block = TSCodec.decode(data);
+        return { time: block.time, value: block.values[0] };
+    }
+
+    // Index of the last block starting at or before t, -1 if none
+    static lastBlockBefore(blocks, t) {
+        let lo = 0, hi = blocks.length - 1, found = -1;
+        while (lo <= hi) {
+            const mid = (lo + hi) >> 1;
+            if (blocks[mid].tMin <= t) {
+                found = mid;
+                lo = mid + 1;
+            } else {
+                hi = mid - 1;
+            }
+        }
+        return found;
+    }
+
+    // The newest `limit` samples in [from, to], oldest first, as [time, value] pairs
+    range(key, from, to, limit) {
+        const s = this.series.get(key);
+        if (!s || limit <= 0) return [];
+        const points = [];      // Newest first while collecting
+
+        const collect = (time, value) => {
+            for (let i = time.length - 1; i >= 0 && points.length < limit; i--) {
+                if (time[i] > to) continue;
+                if (time[i] < from) return false;
+                points.push([time[i], value[i]]);
+            }
+            return points.length < limit;
+        };
+
+        let more = collect(s.open.time, s.open.value);
+        for (let b = SegmentStore.lastBlockBefore(s.blocks, to); more && b >= 0; b--) {
+            const entry = s.blocks[b];
+            if (entry.tMax < from) break;
+            const block = this.readBlock(entry);
+            more = collect(block.time, block.value);
+        }
+        return points.reverse();
+    }
+
+    // Min/max/avg per `step` ms bucket over [from, to]. A block inside a single bucket
+    // is answered from its index entry without reading it.
+    summary(key, from, to, step) {
+        const s = this.series.get(key);
+        const buckets = new Map();
+        if (!s) return [];
+
+        const add = (i, min, max, sum, count) => {
+            const bucket = buckets.get(i);
+            if (!bucket) {
+                buckets.set(i, { min, max, sum, count });
+            } else {
+                bucket.min = Math.min(bucket.min, min);
+                bucket.max = Math.max(bucket.max, max);
+                bucket.sum += sum;
+                bucket.count += count;
+            }
+        };
+        const addPoints = (time, value) => {
+            for (let i = 0; i < time.length; i++) {
+                if (time[i] >= from && time[i] <= to) {
+                    add(Math.floor((time[i] - from) / step), value[i], value[i], value[i], 1);
+                }
+            }
+        };
+
+        let b = SegmentStore.lastBlockBefore(s.blocks, from);
+        if (b < 0) b = 0;
+        for (; b < s.blocks.length && s.blocks[b].tMin <= to; b++) {
+            const e = s.blocks[b];
+            if (e.tMax < from) continue;
+            const first = Math.floor((e.tMin - from) / step);
+            if (e.tMin >= from && e.tMax <= to && first === Math.floor((e.tMax - from) / step)) {
+                add(first, e.vMin, e.vMax, e.sum, e.count);
+                this.stats.indexHits++;
+            } else {
+                const block = this.readBlock(e);
+                addPoints(block.time, block.value);
+            }
+        }
+        addPoints(s.open.time, s.open.value);
+
+        return [...buckets.entries()].sort((a, b) => a[0] - b[0]).map(([i, v]) => ({
+            t: from + i * step,
+            min: v.min,
+            max: v.max,
+            avg: Math.round((v.sum / v.count) * 100) / 100,
+            count: v.count
+        }));
+    }
+
+    list() {
+        return [...this.series.entries()].map(([key, s]) => {
+            const samples = s.blocks.reduce((n, e) => n + e.count, 0) + s.open.time.length;
+            const first = s.blocks.length ? s.blocks[0].tMin : s.open.time[0];
+            return { series: key, samples, blocks: s.blocks.length, first: first ?? null, last: samples ? s.last : null };
+        });
+    }
+
+    diskBytes() {
+        return this.segments.reduce((n, segment) => n + segment.size, 0);
+    }
+}
+
+module.exports = { SegmentStore, crc32 };
@@ -0,0 +1,215 @@
+#!/usr/bin/env node
+// Fleet command with aggregated acknowledgements.
+// Publishes one {"id","cmd"} request to esp32/group/<group>/command, collects the
+// per-device results from esp32/+/ack and reports completion against the group's
+// members (found through their retained esp32/+/state) within a deadline.
+'use strict';
+
+const crypto = require('crypto');
+const { performance } = require('perf_hooks');
+const { MqttClient } = require('../loadtest/lib/mqtt');
+const CBOR = require('../../web/cbor.js');
+
+// Same layout as firmware/ESP32/main/app_main.c
+const ROOT = 'esp32';
+const groupTopic = (group) => `${ROOT}/group/${group}/command`;
+const STATE_FILTER = `${ROOT}/+/state`;
+const ACK_FILTER = `${ROOT}/+/ack`;
+const ID_PATTERN = /^[A-Za-z0-9_.-]{1,16}$/;     // COMMAND_ID_MAX_LEN, survives the STM32 tokenizer
+const COMMAND_MAX_LEN = 47;
+
+const DEFAULTS = {
+    url: 'mqtt://127.0.0.1:1883',
+    user: 'DataLogger',
+    pass: 'datalogger',
+    group: 'all',
+    deadline: 10,           // s to wait for acks after publishing
+    discover: 1,            // s to collect retained states before publishing
+    expect: 0,              // Expected acks, 0 = members found by discovery
+    id: '',
+    json: false
+};
+
+const HELP = `Usage: node fleetcmd.js [options] "<command>"
+  --url URL          Broker (default ${DEFAULTS.url})
+  --user NAME        MQTT username (default ${DEFAULTS.user})
+  --pass SECRET      MQTT password
+  --group NAME       Command group; "all" reaches every bridge (default ${DEFAULTS.group})
+  --deadline S       Seconds to wait for acknowledgements (default ${DEFAULTS.deadline})
+  --discover S       Seconds to collect retained states of the members (default ${DEFAULTS.discover})
+  --expect N         Wait for N acks instead of the discovered members
+  --id ID            Correlation ID, 1-16 of [A-Za-z0-9_.-] (default random)
+  --json             Print the report as one JSON object on stdout
+
+Examples:
+  node fleetcmd.js "SHT3X PERIODIC 1 HIGH"
+  node fleetcmd.js --group lab2 --deadline 5 "SHT3X HEATER DISABLE"
+
+Exit status: 0 if every member answered OK, 1 otherwise, 2 on usage errors.
+`;
+
+function parseArgs(argv) {
+    const options = { ...DEFAULTS, command: '' };
+    for (let i = 0; i < argv.length; i++) {
+        const arg = argv[i];
+        if (arg === '--help' || arg === '-h') {
+            process.stdout.write(HELP);
+            process.exit(0);
+        }
+        if (arg === '--json') {
+            options.json = true;
+            continue;
+        }
+        if (!arg.startsWith('--')) {
+            options.command = options.command ? `${options.command} ${arg}` : arg;
+            continue;
+        }
+        const key = arg.slice(2).replace(/-([a-z])/g, (m, c) => c.toUpperCase());
+        if (!(key in DEFAULTS) || i + 1 >= argv.length) {
+            process.stderr.write(`Unknown or incomplete option ${arg}\n\n${HELP}`);
+            process.exit(2);
+        }
+        const value = argv[++i];
+        options[key] = typeof DEFAULTS[key] === 'number' ? Number(value) : value;
+    }
+    return options;
+}
+
+const log = (line) => process.stderr.write(line + '\n');
+const sleep = (ms) => new Promise((resolve) => setTimeout(resolve, ms));
+
+function percentile(sorted, p) {
+    if (!sorted.length) return null;
+    return sorted[Math.min(sorted.length - 1, Math.ceil((p / 100) * sorted.length) - 1)];
+}
+
+async function main() {
+    const options = parseArgs(process.argv.slice(2));
+    options.command = options.command.trim();
+    if (!options.command || options.command.length > COMMAND_MAX_LEN) {
+        process.stderr.write(`A command of 1-${COMMAND_MAX_LEN} characters is required\n\n${HELP}`);
+        process.exit(2);
+    }
+    const id = options.id || crypto.randomBytes(4).toString('hex');
+    if (!ID_PATTERN.test(id)) {
+        log(`Invalid correlation ID ${id}`);
+        process.exit(2);
+    }
+
+    const client = new MqttClient({
+        url: options.url,
+        clientId: `fleetcmd_${id}_${process.pid}`,
+        username: options.user,
+        password: options.pass
+    });
+
+    const members = new Map();      // client id -> state, from retained esp32/<id>/state
+    const acks = new Map();         // client id -> { result, error, ms }
+    let sentAt = 0;
+    let onProgress = () => {};
+
+    client.on('message', (topic, payload) => {
+        const device = topic.split('/')[1];
+        let body;
+        try {
+            // State is CBOR on bridges built with CONFIG_BRIDGE_CBOR_STATE; acks are always JSON
+            body = CBOR.isBinary(payload) ? CBOR.decode(payload) : JSON.parse(payload.toString());
+        } catch (err) {
+            return;
+        }
+        if (topic.endsWith('/state')) {
+            if (options.group === 'all' || body.group === options.group) members.set(device, body);
+        } else if (topic.endsWith('/ack') && body.id === id && sentAt && !acks.has(device)) {
+            acks.set(device, { result: body.result, error: body.error || null, ms: performance.now() - sentAt });
+            onProgress();
+        }
+    });
+
+    try {
+        await client.connect();
+        await client.subscribe([STATE_FILTER, ACK_FILTER], 1);
+    } catch (err) {
+        log(`Cannot connect to ${options.url}: ${err.message}`);
+        process.exit(1);
+    }
+
+    // Retained states arrive right after SUBACK; the window covers a busy broker
+    await sleep(options.discover * 1000);
+    const expected = options.expect || members.size;
+    if (!expected) {
+        log(`No members of group "${options.group}" found on ${STATE_FILTER}; use --expect N to send anyway`);
+        client.end();
+        process.exit(1);
+    }
+
+    log(`Sending "${options.command}" to ${groupTopic(options.group)} as ${id}, ` +
+        `expecting ${expected} ack(s) within ${options.deadline} s`);
+    sentAt = performance.now();
+    await client.publish(groupTopic(options.group), JSON.stringify({ id, cmd: options.command }), { qos: 1 });
+
+    await new Promise((resolve) => {
+        const timer = setTimeout(resolve, options.deadline * 1000);
+        onProgress = () => {
+            if (acks.size >= expected && (options.expect || [...members.keys()].every((d) => acks.has(d)))) {
+                clearTimeout(timer);
+                resolve();
+            }
+        };
+        onProgress();
+    });
+    const elapsedMs = performance.now() - sentAt;
+    client.end();
+
+    const answered = [...acks.entries()];
+    const ok = answered.filter(([, a]) => a.result === 'OK').map(([d]) => d);
+    const failed = answered.filter(([, a]) => a.result !== 'OK').map(([d, a]) => ({ device: d, error: a.error }));
+    const missing = options.expect ? [] : [...members.keys()].filter((d) => !acks.has(d));
+    const unexpected = options.expect ? [] : answered.filter(([d]) => !members.has(d)).map(([d]) => d);
+    const latencies = answered.map(([, a]) => a.ms).sort((a, b) => a - b);
+    const complete = ok.length >= expected && failed.length === 0 && missing.length === 0;
+
+    const report = {
+        id,
+        command: options.command,
+        group: options.group,
+        expected,
+        acked: answered.length,
+        ok: ok.length,
+        error: failed.length,
+        missing: options.expect ? Math.max(0, expected - answered.length) : missing.length,
+        complete,
+        elapsed_ms: elapsedMs,
+        ack_ms: {
+            p50: percentile(latencies, 50),
+            p95: percentile(latencies, 95),
+            max: latencies.length ? latencies[latencies.length - 1] : null
+        },
+        failed,
+        missing_devices: missing,
+        unexpected_devices: unexpected
+    };
+
+    if (options.json) {
+        process.stdout.write(JSON.stringify(report) + '\n');
+    } else {
+        printReport(report);
+    }
+    process.exit(complete ? 0 : 1);
+}
+
+function printReport(r) {
+    const ms = (value) => (value === null ? '-' : value.toFixed(0));
+    console.log(`${r.complete ? 'COMPLETE' : 'INCOMPLETE'}: ${r.acked}/${r.expected} acknowledged in ${(r.elapsed_ms / 1000).toFixed(2)} s ` +
+                `(${r.ok} OK, ${r.error} ERROR, ${r.missing} missing)`);
+    if (r.acked) {
+        console.log(`  ack time p50 ${ms(r.ack_ms.p50)} ms, p95 ${ms(r.ack_ms.p95)} ms, max ${ms(r.ack_ms.max)} ms`);
+    }
+    for (const f of r.failed) console.log(`  ERROR    ${f.device}${f.error ? ` (${f.error})` : ''}`);
+    for (const d of r.missing_devices) console.log(`  MISSING  ${d}`);
+    for (const d of r.unexpected_devices) console.log(`  EXTRA    ${d} (no retained state in the group)`);
+}
+
+main().catch((err) => {
+    log(err.stack || err.message);
+    process.exit(1);
+});
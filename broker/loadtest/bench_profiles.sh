@@ -0,0 +1,111 @@
+#!/bin/sh
+# Broker profile benchmark: runs loadtest.js at several fleet sizes against a
+# throwaway mosquitto started from each profile, then tabulates the results.
+#
+#   broker/loadtest/bench_profiles.sh [profile.conf ...]
+#
+# Defaults to broker/mosquitto.conf and broker/mosquitto.highthroughput.conf.
+# Each profile is copied with its listeners moved to loopback test ports and its
+# password file, persistence and log paths moved to a temp dir; every other
+# setting (logging, persistence, limits) is benchmarked as written.
+#
+# Environment:
+#   MOSQUITTO         mosquitto binary                      (default: mosquitto)
+#   MOSQUITTO_PASSWD  mosquitto_passwd binary               (default: mosquitto_passwd)
+#   PORT, WS_PORT     loopback test ports                   (default: 18883, 18083)
+#   LEVELS            bridges:rate_hz pairs                 (default: "10:1 50:2 100:5 200:10")
+#   SUBS_TCP, SUBS_WS dashboards per transport              (default: 5, 5)
+#   WATCH             devices per dashboard, 0 = all        (default: 1)
+#   QOS               sample QoS                            (default: 0)
+#   DURATION          seconds per run                       (default: 30)
+#   OUT               results directory                     (default: ./bench-<date>)
+#
+# Writes one loadtest JSON per run and summary.md to $OUT; exits non-zero if any
+# run fails, so it can run as a CI step.
+set -eu
+
+LOADTEST_DIR=$(cd "$(dirname "$0")" && pwd)
+BROKER_DIR=$(dirname "$LOADTEST_DIR")
+MOSQUITTO=${MOSQUITTO:-mosquitto}
+MOSQUITTO_PASSWD=${MOSQUITTO_PASSWD:-mosquitto_passwd}
+PORT=${PORT:-18883}
+WS_PORT=${WS_PORT:-18083}
+LEVELS=${LEVELS:-"10:1 50:2 100:5 200:10"}
+SUBS_TCP=${SUBS_TCP:-5}
+SUBS_WS=${SUBS_WS:-5}
+WATCH=${WATCH:-1}
+QOS=${QOS:-0}
+DURATION=${DURATION:-30}
+OUT=${OUT:-$PWD/bench-$(date +%Y%m%d-%H%M%S)}
+USER_NAME=loadtest
+USER_PASS=loadtest
+WORK=$(mktemp -d)
+BROKER_PID=
+
+cleanup() {
+    [ -n "$BROKER_PID" ] && kill "$BROKER_PID" 2>/dev/null || true
+    wait 2>/dev/null || true
+    rm -rf "$WORK"
+}
+trap cleanup EXIT INT TERM
+
+if [ $# -eq 0 ]; then
+    set -- "$BROKER_DIR/mosquitto.conf" "$BROKER_DIR/mosquitto.highthroughput.conf"
+fi
+
+mkdir -p "$OUT"
+"$MOSQUITTO_PASSWD" -c -b "$WORK/passwd" "$USER_NAME" "$USER_PASS"
+
+wait_for_port() {
+    i=0
+    until node -e "require('net').connect($1, '127.0.0.1').on('connect', () => process.exit(0)).on('error', () => process.exit(1))" 2>/dev/null; do
+        i=$((i + 1))
+        if [ $i -gt 100 ]; then
+            echo "broker not listening on $1 after 10 s:" >&2
+            cat "$2" >&2
+            exit 1
+        fi
+        sleep 0.1
+    done
+}
+
+for profile in "$@"; do
+    name=$(basename "$profile" .conf)
+
+    for level in $LEVELS; do
+        bridges=${level%%:*}
+        rate=${level##*:}
+
+        # Fresh broker per run, so retained topics and RSS do not carry over
+        rm -rf "$WORK/data" "$WORK/mosquitto.log"
+        mkdir -p "$WORK/data"
+        awk -v port="$PORT" -v ws="$WS_PORT" -v work="$WORK" '
+            $1 == "listener" && $2 == "1883" { print "listener " port " 127.0.0.1"; next }
+            $1 == "listener" && $2 == "8083" { print "listener " ws " 127.0.0.1"; next }
+            $1 == "password_file"            { print "password_file " work "/passwd"; next }
+            $1 == "persistence_location"     { print "persistence_location " work "/data/"; next }
+            $1 == "log_dest" && $2 == "file" { print "log_dest file " work "/mosquitto.log"; next }
+            { print }
+        ' "$profile" > "$WORK/$name.conf"
+
+        "$MOSQUITTO" -c "$WORK/$name.conf" > "$WORK/stdout.log" 2>&1 &
+        BROKER_PID=$!
+        wait_for_port "$PORT" "$WORK/stdout.log"
+        wait_for_port "$WS_PORT" "$WORK/stdout.log"
+
+        echo "== $name: $bridges bridges x $rate Hz" >&2
+        node "$LOADTEST_DIR/loadtest.js" \
+            --url "mqtt://127.0.0.1:$PORT" --ws-url "ws://127.0.0.1:$WS_PORT/mqtt" \
+            --user "$USER_NAME" --pass "$USER_PASS" \
+            --bridges "$bridges" --rate "$rate" --subs-tcp "$SUBS_TCP" --subs-ws "$SUBS_WS" --watch "$WATCH" \
+            --qos "$QOS" --duration "$DURATION" --broker-pid "$BROKER_PID" --json \
+            > "$OUT/$name@${bridges}x${rate}.json"
+
+        kill "$BROKER_PID"
+        wait "$BROKER_PID" 2>/dev/null || true
+        BROKER_PID=
+    done
+done
+
+node "$LOADTEST_DIR/summarize.js" "$OUT"/*.json > "$OUT/summary.md"
+cat "$OUT/summary.md"
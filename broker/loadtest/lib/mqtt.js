@@ -0,0 +1,239 @@
+// Minimal MQTT 3.1.1 client for the load generator: CONNECT, PUBLISH (QoS 0/1),
+// SUBSCRIBE and PINGREQ over TCP (mqtt://) or WebSockets (ws://).
+// Only what the simulated bridges and dashboards need; no QoS 2, no session resume.
+'use strict';
+
+const net = require('net');
+const { EventEmitter } = require('events');
+const ws = require('./ws');
+
+const CONNECT = 1, CONNACK = 2, PUBLISH = 3, PUBACK = 4, SUBSCRIBE = 8, SUBACK = 9;
+const PINGREQ = 12, PINGRESP = 13, DISCONNECT = 14;
+
+function encodeLength(length) {
+    const bytes = [];
+    do {
+        let byte = length % 128;
+        length = Math.floor(length / 128);
+        if (length > 0) byte |= 0x80;
+        bytes.push(byte);
+    } while (length > 0);
+    return Buffer.from(bytes);
+}
+
+function encodeString(value) {
+    const data = Buffer.isBuffer(value) ? value : Buffer.from(String(value), 'utf8');
+    const length = Buffer.alloc(2);
+    length.writeUInt16BE(data.length);
+    return Buffer.concat([length, data]);
+}
+
+function packet(type, flags, parts) {
+    const body = Buffer.concat(parts);
+    return Buffer.concat([Buffer.from([(type << 4) | flags]), encodeLength(body.length), body]);
+}
+
+function openTransport(url) {
+    const parsed = new URL(url);
+    switch (parsed.protocol) {
+        case 'mqtt:':
+        case 'tcp:': {
+            const socket = net.connect(Number(parsed.port) || 1883, parsed.hostname);
+            socket.setNoDelay(true);
+            return socket;
+        }
+        case 'ws:':
+            return ws.connect(parsed, 'mqtt');
+        default:
+            throw new Error(`Unsupported broker URL ${url}`);
+    }
+}
+
+class MqttClient extends EventEmitter {
+    constructor(options) {
+        super();
+        this.url = options.url;
+        this.clientId = options.clientId;
+        this.username = options.username || '';
+        this.password = options.password || '';
+        this.keepalive = options.keepalive ?? 60;
+        this.connected = false;
+        this.nextId = 1;
+        this.pending = new Map();   // packet id -> resolve, for PUBACK and SUBACK
+        this.buffer = Buffer.alloc(0);
+        this.socket = null;
+        this.pingTimer = null;
+        this.stats = { published: 0, received: 0, bytesOut: 0, bytesIn: 0, backpressure: 0 };
+    }
+
+    connect() {
+        return new Promise((resolve, reject) => {
+            const socket = openTransport(this.url);
+            this.socket = socket;
+
+            const fail = (err) => {
+                if (!this.connected) reject(err);
+                else this.emit('error', err);
+            };
+            socket.on('error', fail);
+            socket.on('close', () => {
+                const wasConnected = this.connected;
+                this.connected = false;
+                clearInterval(this.pingTimer);
+                if (!wasConnected) reject(new Error(`${this.clientId}: connection closed before CONNACK`));
+                this.emit('close');
+            });
+            socket.on('data', (chunk) => this.onData(chunk));
+            socket.once('connect', () => this.sendConnect());
+
+            this.once('connack', (code) => {
+                if (code !== 0) {
+                    reject(new Error(`${this.clientId}: CONNACK return code ${code}`));
+                    socket.destroy();
+                    return;
+                }
+                this.connected = true;
+                if (this.keepalive > 0) {
+                    this.pingTimer = setInterval(() => this.write(packet(PINGREQ, 0, [])),
+                                                 this.keepalive * 500);
+                    this.pingTimer.unref();
+                }
+                resolve(this);
+            });
+        });
+    }
+
+    sendConnect() {
+        let flags = 0x02;   // Clean session
+        const payload = [encodeString(this.clientId)];
+        if (this.username) {
+            flags |= 0x80;
+            payload.push(encodeString(this.username));
+        }
+        if (this.password) {
+            flags |= 0x40;
+            payload.push(encodeString(this.password));
+        }
+        const keepalive = Buffer.alloc(2);
+        keepalive.writeUInt16BE(this.keepalive);
+        this.write(packet(CONNECT, 0, [encodeString('MQTT'), Buffer.from([4, flags]), keepalive, ...payload]));
+    }
+
+    allocateId() {
+        const id = this.nextId;
+        this.nextId = this.nextId === 0xFFFF ? 1 : this.nextId + 1;
+        return id;
+    }
+
+    write(data) {
+        this.stats.bytesOut += data.length;
+        if (!this.socket.write(data)) {
+            this.stats.backpressure++;
+            return false;
+        }
+        return true;
+    }
+
+    // QoS 0 resolves immediately; QoS 1 resolves on PUBACK
+    publish(topic, payload, options = {}) {
+        const qos = options.qos || 0;
+        const flags = (qos << 1) | (options.retain ? 1 : 0);
+        const parts = [encodeString(topic)];
+        let id = 0;
+        if (qos > 0) {
+            id = this.allocateId();
+            const idBytes = Buffer.alloc(2);
+            idBytes.writeUInt16BE(id);
+            parts.push(idBytes);
+        }
+        parts.push(Buffer.isBuffer(payload) ? payload : Buffer.from(String(payload), 'utf8'));
+        this.write(packet(PUBLISH, flags, parts));
+        this.stats.published++;
+        if (qos === 0) return Promise.resolve();
+        return new Promise((resolve) => this.pending.set(id, resolve));
+    }
+
+    subscribe(topics, qos = 0) {
+        const id = this.allocateId();
+        const idBytes = Buffer.alloc(2);
+        idBytes.writeUInt16BE(id);
+        const parts = [idBytes];
+        for (const topic of topics) {
+            parts.push(encodeString(topic), Buffer.from([qos]));
+        }
+        this.write(packet(SUBSCRIBE, 0x02, parts));
+        return new Promise((resolve) => this.pending.set(id, resolve));
+    }
+
+    end() {
+        if (!this.socket) return;
+        if (this.connected) this.write(packet(DISCONNECT, 0, []));
+        this.connected = false;
+        this.socket.end();
+    }
+
+    onData(chunk) {
+        this.stats.bytesIn += chunk.length;
+        this.buffer = this.buffer.length ? Buffer.concat([this.buffer, chunk]) : chunk;
+
+        for (;;) {
+            // Fixed header: type/flags byte, then up to four bytes of remaining length
+            let length = 0, multiplier = 1, offset = 1, complete = false;
+            while (offset < this.buffer.length && offset <= 4) {
+                const byte = this.buffer[offset++];
+                length += (byte & 0x7F) * multiplier;
+                multiplier *= 128;
+                if (!(byte & 0x80)) {
+                    complete = true;
+                    break;
+                }
+            }
+            if (!complete || this.buffer.length < offset + length) break;
+
+            const header = this.buffer[0];
+            const body = this.buffer.subarray(offset, offset + length);
+            this.buffer = this.buffer.subarray(offset + length);
+            this.onPacket(header >> 4, header & 0x0F, body);
+        }
+    }
+
+    onPacket(type, flags, body) {
+        switch (type) {
+            case CONNACK:
+                this.emit('connack', body[1]);
+                break;
+            case PUBLISH: {
+                const qos = (flags >> 1) & 0x03;
+                const topicLength = body.readUInt16BE(0);
+                const topic = body.toString('utf8', 2, 2 + topicLength);
+                let offset = 2 + topicLength;
+                if (qos > 0) {
+                    const id = body.readUInt16BE(offset);
+                    offset += 2;
+                    const ack = Buffer.alloc(2);
+                    ack.writeUInt16BE(id);
+                    this.write(packet(PUBACK, 0, [ack]));
+                }
+                this.stats.received++;
+                this.emit('message', topic, body.subarray(offset), { qos, retain: (flags & 1) === 1 });
+                break;
+            }
+            case PUBACK:
+            case SUBACK: {
+                const id = body.readUInt16BE(0);
+                const resolve = this.pending.get(id);
+                if (resolve) {
+                    this.pending.delete(id);
+                    resolve(type === SUBACK ? Array.from(body.subarray(2)) : undefined);
+                }
+                break;
+            }
+            case PINGRESP:
+                break;
+            default:
+                this.emit('error', new Error(`${this.clientId}: unexpected packet type ${type}`));
+        }
+    }
+}
+
+module.exports = { MqttClient };
@@ -0,0 +1,143 @@
+// Latency histogram and /proc sampling for the load generator
+'use strict';
+
+const fs = require('fs');
+const { execSync } = require('child_process');
+
+// Log-spaced buckets, 2% wide, from 1 us to ~100 s: percentiles within 2% in fixed memory
+const BUCKET_GROWTH = 1.02;
+const BUCKET_COUNT = Math.ceil(Math.log(1e8) / Math.log(BUCKET_GROWTH)) + 1;
+
+class Histogram {
+    constructor() {
+        this.counts = new Float64Array(BUCKET_COUNT);
+        this.reset();
+    }
+
+    reset() {
+        this.counts.fill(0);
+        this.count = 0;
+        this.sum = 0;
+        this.max = 0;
+        this.negative = 0;      // Samples that arrived "before" they were sent: clock skew
+    }
+
+    add(us) {
+        if (us < 0) {
+            this.negative++;
+            us = 0;
+        }
+        const bucket = us < 1 ? 0 : Math.min(BUCKET_COUNT - 1, Math.floor(Math.log(us) / Math.log(BUCKET_GROWTH)) + 1);
+        this.counts[bucket]++;
+        this.count++;
+        this.sum += us;
+        if (us > this.max) this.max = us;
+    }
+
+    merge(other) {
+        for (let i = 0; i < BUCKET_COUNT; i++) this.counts[i] += other.counts[i];
+        this.count += other.count;
+        this.sum += other.sum;
+        this.negative += other.negative;
+        if (other.max > this.max) this.max = other.max;
+    }
+
+    // Upper edge of the bucket holding the p-th sample, capped at the observed max
+    percentile(p) {
+        if (this.count === 0) return 0;
+        const rank = Math.ceil(this.count * p / 100);
+        let seen = 0;
+        for (let i = 0; i < BUCKET_COUNT; i++) {
+            seen += this.counts[i];
+            if (seen >= rank) return Math.min(this.max, i === 0 ? 1 : Math.pow(BUCKET_GROWTH, i));
+        }
+        return this.max;
+    }
+
+    summary() {
+        return {
+            count: this.count,
+            mean_ms: this.count ? this.sum / this.count / 1000 : 0,
+            p50_ms: this.percentile(50) / 1000,
+            p95_ms: this.percentile(95) / 1000,
+            p99_ms: this.percentile(99) / 1000,
+            max_ms: this.max / 1000
+        };
+    }
+}
+
+let clockTicks = null;
+
+function clockTicksPerSecond() {
+    if (clockTicks === null) {
+        try {
+            clockTicks = Number(execSync('getconf CLK_TCK', { encoding: 'utf8' }).trim()) || 100;
+        } catch (err) {
+            clockTicks = 100;
+        }
+    }
+    return clockTicks;
+}
+
+// CPU time (s) and resident set (bytes) of a process, or null once it is gone
+function readProcess(pid) {
+    try {
+        const stat = fs.readFileSync(`/proc/${pid}/stat`, 'utf8');
+        // Fields after the parenthesised command name, which may itself contain spaces
+        const fields = stat.slice(stat.lastIndexOf(')') + 2).split(' ');
+        const cpu = (Number(fields[11]) + Number(fields[12])) / clockTicksPerSecond();
+        const status = fs.readFileSync(`/proc/${pid}/status`, 'utf8');
+        const rss = /VmRSS:\s+(\d+) kB/.exec(status);
+        const hwm = /VmHWM:\s+(\d+) kB/.exec(status);
+        return {
+            cpu,
+            rss: rss ? Number(rss[1]) * 1024 : 0,
+            peakRss: hwm ? Number(hwm[1]) * 1024 : 0
+        };
+    } catch (err) {
+        return null;
+    }
+}
+
+// Tracks CPU % between samples plus the RSS range of one process
+class ProcessSampler {
+    constructor(pid) {
+        this.pid = pid;
+        this.first = readProcess(pid);
+        this.last = this.first;
+        this.lastTime = process.hrtime.bigint();
+        this.startTime = this.lastTime;
+        this.maxRss = this.first ? this.first.rss : 0;
+    }
+
+    get available() {
+        return this.first !== null;
+    }
+
+    sample() {
+        const now = process.hrtime.bigint();
+        const current = readProcess(this.pid);
+        if (!current || !this.last) return null;
+        const seconds = Number(now - this.lastTime) / 1e9;
+        const cpuPercent = seconds > 0 ? (current.cpu - this.last.cpu) / seconds * 100 : 0;
+        this.last = current;
+        this.lastTime = now;
+        if (current.rss > this.maxRss) this.maxRss = current.rss;
+        return { cpuPercent, rss: current.rss };
+    }
+
+    summary() {
+        if (!this.first || !this.last) return null;
+        const seconds = Number(this.lastTime - this.startTime) / 1e9;
+        return {
+            pid: this.pid,
+            cpu_percent_avg: seconds > 0 ? (this.last.cpu - this.first.cpu) / seconds * 100 : 0,
+            rss_start_mb: this.first.rss / 1048576,
+            rss_end_mb: this.last.rss / 1048576,
+            rss_max_mb: this.maxRss / 1048576,
+            rss_peak_hwm_mb: this.last.peakRss / 1048576
+        };
+    }
+}
+
+module.exports = { Histogram, ProcessSampler };
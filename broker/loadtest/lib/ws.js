@@ -0,0 +1,166 @@
+// Minimal RFC 6455 WebSocket client carrying binary frames, exposed as a Duplex
+// stream so the MQTT client can treat it like a TCP socket. Mosquitto's websockets
+// listener requires the "mqtt" subprotocol, the same one mqtt.js asks for.
+'use strict';
+
+const crypto = require('crypto');
+const http = require('http');
+const { Duplex } = require('stream');
+
+const OP_CONTINUATION = 0x0, OP_TEXT = 0x1, OP_BINARY = 0x2;
+const OP_CLOSE = 0x8, OP_PING = 0x9, OP_PONG = 0xA;
+const GUID = '258EAFA5-E914-47DA-95CA-C5AB0DC85B11';
+
+function frame(opcode, payload) {
+    // Client frames are always masked
+    const mask = crypto.randomBytes(4);
+    let header;
+    if (payload.length < 126) {
+        header = Buffer.from([0x80 | opcode, 0x80 | payload.length]);
+    } else if (payload.length < 65536) {
+        header = Buffer.alloc(4);
+        header[0] = 0x80 | opcode;
+        header[1] = 0x80 | 126;
+        header.writeUInt16BE(payload.length, 2);
+    } else {
+        header = Buffer.alloc(10);
+        header[0] = 0x80 | opcode;
+        header[1] = 0x80 | 127;
+        header.writeBigUInt64BE(BigInt(payload.length), 2);
+    }
+    const masked = Buffer.alloc(payload.length);
+    for (let i = 0; i < payload.length; i++) {
+        masked[i] = payload[i] ^ mask[i & 3];
+    }
+    return Buffer.concat([header, mask, masked]);
+}
+
+class WebSocketStream extends Duplex {
+    constructor(url, protocol) {
+        super();
+        this.socket = null;
+        this.buffer = Buffer.alloc(0);
+        this.fragments = [];
+        this.queue = [];        // Writes issued before the upgrade completes
+
+        const key = crypto.randomBytes(16).toString('base64');
+        const request = http.request({
+            host: url.hostname,
+            port: Number(url.port) || 80,
+            path: url.pathname + url.search,
+            headers: {
+                Connection: 'Upgrade',
+                Upgrade: 'websocket',
+                'Sec-WebSocket-Key': key,
+                'Sec-WebSocket-Version': '13',
+                'Sec-WebSocket-Protocol': protocol
+            }
+        });
+
+        request.on('upgrade', (response, socket, head) => {
+            const accept = crypto.createHash('sha1').update(key + GUID).digest('base64');
+            if (response.headers['sec-websocket-accept'] !== accept) {
+                socket.destroy();
+                this.destroy(new Error('WebSocket handshake: bad Sec-WebSocket-Accept'));
+                return;
+            }
+            socket.setNoDelay(true);
+            this.socket = socket;
+            socket.on('data', (chunk) => this.onData(chunk));
+            socket.on('end', () => this.push(null));
+            socket.on('close', () => this.destroy());
+            socket.on('error', (err) => this.destroy(err));
+            socket.on('drain', () => this.emit('drain'));
+            if (head.length) this.onData(head);
+            for (const [chunk, callback] of this.queue) this.socket.write(chunk, callback);
+            this.queue = [];
+            this.emit('connect');
+        });
+        request.on('response', (response) => {
+            this.destroy(new Error(`WebSocket handshake: HTTP ${response.statusCode}`));
+        });
+        request.on('error', (err) => this.destroy(err));
+        request.end();
+    }
+
+    onData(chunk) {
+        this.buffer = this.buffer.length ? Buffer.concat([this.buffer, chunk]) : chunk;
+
+        while (this.buffer.length >= 2) {
+            const fin = (this.buffer[0] & 0x80) !== 0;
+            const opcode = this.buffer[0] & 0x0F;
+            const masked = (this.buffer[1] & 0x80) !== 0;
+            let length = this.buffer[1] & 0x7F;
+            let offset = 2;
+
+            if (length === 126) {
+                if (this.buffer.length < 4) return;
+                length = this.buffer.readUInt16BE(2);
+                offset = 4;
+            } else if (length === 127) {
+                if (this.buffer.length < 10) return;
+                length = Number(this.buffer.readBigUInt64BE(2));
+                offset = 10;
+            }
+            const maskOffset = offset;
+            if (masked) offset += 4;
+            if (this.buffer.length < offset + length) return;
+
+            let payload = this.buffer.subarray(offset, offset + length);
+            if (masked) {
+                const mask = this.buffer.subarray(maskOffset, maskOffset + 4);
+                payload = Buffer.from(payload.map((byte, i) => byte ^ mask[i & 3]));
+            }
+            this.buffer = this.buffer.subarray(offset + length);
+
+            switch (opcode) {
+                case OP_CONTINUATION:
+                case OP_TEXT:
+                case OP_BINARY:
+                    this.fragments.push(payload);
+                    if (fin) {
+                        this.push(this.fragments.length === 1 ? this.fragments[0] : Buffer.concat(this.fragments));
+                        this.fragments = [];
+                    }
+                    break;
+                case OP_PING:
+                    this.socket.write(frame(OP_PONG, payload));
+                    break;
+                case OP_CLOSE:
+                    this.socket.end(frame(OP_CLOSE, payload.subarray(0, 2)));
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    setNoDelay() {
+        // Already set on the upgraded socket
+    }
+
+    _write(chunk, encoding, callback) {
+        const data = frame(OP_BINARY, chunk);
+        if (this.socket) this.socket.write(data, callback);
+        else this.queue.push([data, callback]);
+    }
+
+    _read() {
+    }
+
+    _final(callback) {
+        if (this.socket) this.socket.end(frame(OP_CLOSE, Buffer.from([0x03, 0xE8])));
+        callback();
+    }
+
+    _destroy(err, callback) {
+        if (this.socket) this.socket.destroy();
+        callback(err);
+    }
+}
+
+function connect(url, protocol) {
+    return new WebSocketStream(url, protocol);
+}
+
+module.exports = { connect };
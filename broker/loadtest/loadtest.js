@@ -0,0 +1,565 @@
+#!/usr/bin/env node
+// Fleet simulator and broker load test.
+// N simulated ESP32 bridges publish the bridge's topics at a configurable sample rate;
+// M simulated dashboards subscribe to the dashboard's topics over TCP and WebSockets.
+// Reports publish throughput, fan-out latency (bridge publish -> dashboard receive),
+// delivery loss and the broker's CPU and RSS.
+'use strict';
+
+const { performance } = require('perf_hooks');
+const { execSync } = require('child_process');
+const { MqttClient } = require('./lib/mqtt');
+const { Histogram, ProcessSampler } = require('./lib/stats');
+const CBOR = require('../../web/cbor.js');
+
+// Same topics as firmware/ESP32/main/app_main.c and web/script.js, below esp32/<client id>/
+const ROOT = 'esp32';
+const TOPICS = {
+    command: 'sensor/sht3x/command',
+    deviceControl: 'control/relay',
+    periodicTemp: 'sensor/sht3x/periodic/temperature',
+    periodicHumi: 'sensor/sht3x/periodic/humidity',
+    singleTemp: 'sensor/sht3x/single/temperature',
+    singleHumi: 'sensor/sht3x/single/humidity',
+    stateSync: 'state',
+    trace: 'sensor/sht3x/trace'
+};
+const BRIDGE_SUBSCRIPTIONS = ['command', 'deviceControl', 'stateSync'];
+// Per watched device; the dashboard also subscribes esp32/+/state for discovery
+const DASHBOARD_SUBSCRIPTIONS = ['periodicTemp', 'periodicHumi', 'singleTemp', 'singleHumi', 'deviceControl', 'trace'];
+
+const deviceTopic = (device, key) => `${ROOT}/${device}/${TOPICS[key]}`;
+const groupTopic = (group) => `${ROOT}/group/${group}/command`;
+const bridgeId = (index) => 'ESP32_LT' + index.toString(16).toUpperCase().padStart(4, '0');
+
+const DEFAULTS = {
+    url: 'mqtt://127.0.0.1:1883',
+    wsUrl: 'ws://127.0.0.1:8083/mqtt',
+    user: 'DataLogger',
+    pass: 'datalogger',
+    bridges: 10,
+    rate: 1,                // Samples per second per bridge, three messages each
+    stateInterval: 10,      // s between retained esp32/<id>/state republishes, 0 = only at connect
+    metricsInterval: 30,    // s between esp32/<id>/metrics, 0 = off (CONFIG_BRIDGE_METRICS_INTERVAL_S)
+    subsTcp: 5,
+    subsWs: 5,
+    watch: 1,               // Devices each dashboard selects, 0 = every device through wildcards
+    groups: 0,              // Bridge i also joins command group lt<i % groups>, 0 = "all" only
+    ackDelay: 30,           // ms a bridge takes to acknowledge a command (UART round trip + STM32)
+    qos: 0,
+    encoding: 'text',       // text, or cbor as a bridge built with the CONFIG_BRIDGE_CBOR_* options
+    duration: 30,
+    warmup: 2,              // s of latency samples discarded after the bridges start
+    drain: 2,               // s to wait for in-flight messages after publishing stops
+    interval: 5,            // s between progress lines
+    connectBatch: 50,       // Concurrent CONNECTs while ramping up
+    brokerPid: 0,
+    container: '',
+    json: false
+};
+
+const HELP = `Usage: node loadtest.js [options]
+  --url URL              TCP listener for bridges and TCP dashboards (default ${DEFAULTS.url})
+  --ws-url URL           WebSocket listener for WS dashboards (default ${DEFAULTS.wsUrl})
+  --user NAME            MQTT username (default ${DEFAULTS.user})
+  --pass SECRET          MQTT password
+  --bridges N            Simulated ESP32 bridges (default ${DEFAULTS.bridges})
+  --rate HZ              Samples per second per bridge (default ${DEFAULTS.rate})
+  --state-interval S     Retained esp32/<id>/state republish period, 0 = at connect only (default ${DEFAULTS.stateInterval})
+  --metrics-interval S   esp32/<id>/metrics period, 0 = off (default ${DEFAULTS.metricsInterval})
+  --subs-tcp M           Dashboards subscribed over TCP (default ${DEFAULTS.subsTcp})
+  --subs-ws M            Dashboards subscribed over WebSockets (default ${DEFAULTS.subsWs})
+  --watch K              Devices each dashboard subscribes to, 0 = all via esp32/+/... (default ${DEFAULTS.watch})
+  --groups G             Bridge i joins command group lt<i mod G> besides "all", 0 = none (default ${DEFAULTS.groups})
+  --ack-delay MS         Time a bridge takes to acknowledge a command (default ${DEFAULTS.ackDelay})
+  --qos 0|1              QoS of sample publishes and subscriptions (default ${DEFAULTS.qos})
+  --encoding text|cbor   Sample, state and trace payloads (default ${DEFAULTS.encoding})
+  --duration S           Publishing time (default ${DEFAULTS.duration})
+  --warmup S             Latency samples ignored after start (default ${DEFAULTS.warmup})
+  --drain S              Wait for in-flight messages after publishing stops (default ${DEFAULTS.drain})
+  --interval S           Progress line period (default ${DEFAULTS.interval})
+  --broker-pid PID       Sample the broker's CPU and RSS from /proc
+  --container NAME       Same, resolving the PID with docker inspect
+  --json                 Print the final report as one JSON object on stdout
+`;
+
+function parseArgs(argv) {
+    const options = { ...DEFAULTS };
+    for (let i = 0; i < argv.length; i++) {
+        const arg = argv[i];
+        if (arg === '--help' || arg === '-h') {
+            process.stdout.write(HELP);
+            process.exit(0);
+        }
+        if (arg === '--json') {
+            options.json = true;
+            continue;
+        }
+        if (!arg.startsWith('--') || i + 1 >= argv.length) {
+            process.stderr.write(`Unknown or incomplete option ${arg}\n\n${HELP}`);
+            process.exit(2);
+        }
+        const key = arg.slice(2).replace(/-([a-z])/g, (m, c) => c.toUpperCase());
+        if (!(key in DEFAULTS)) {
+            process.stderr.write(`Unknown option ${arg}\n\n${HELP}`);
+            process.exit(2);
+        }
+        const value = argv[++i];
+        options[key] = typeof DEFAULTS[key] === 'number' ? Number(value) : value;
+    }
+    return options;
+}
+
+const log = (line) => process.stderr.write(line + '\n');
+const nowUs = () => Math.round(performance.now() * 1000);
+
+// JSON text, or CBOR as the bridge's cbor_codec writes it
+function encodePayload(value, cbor) {
+    return cbor ? Buffer.from(CBOR.encode(value)) : JSON.stringify(value);
+}
+
+// Retained state in the bridge's create_state_message() / create_state_cbor() format
+function stateMessage(bridge) {
+    return encodePayload({
+        device: 'ON', periodic: 'ON', rate: bridge.rate, repeat: 'HIGH',
+        heater: 'OFF', status: '0x0000', group: bridge.group, timestamp: Math.round(performance.now())
+    }, bridge.cbor);
+}
+
+// Same keys and bucket layout as Metrics_Format() in firmware/ESP32/components/bridge_metrics
+const METRICS_EDGES_US = [100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000];
+
+function metricsMessage(bridge) {
+    // One bucket per edge plus the overflow bucket
+    const bins = () => Array.from({ length: METRICS_EDGES_US.length + 1 }, () => Math.floor(Math.random() * 100));
+    return JSON.stringify({
+        uptime_s: Math.round((performance.now() - bridge.startMs) / 1000),
+        c: {
+            lines: bridge.seq, rejected: 0, parse_fail: 0, ring_overflow: 0, queue_drop: 0,
+            backlog_drop: 0, pub_ok: bridge.client.stats.published, pub_fail: 0,
+            reconnects: 0, disconnects: 0
+        },
+        h: {
+            edges_us: METRICS_EDGES_US,
+            ingest: { n: bridge.seq, avg: 120, max: 900, b: bins() },
+            e2e: { n: bridge.seq, avg: 850, max: 4200, b: bins() }
+        },
+        heap: { free: 182344, min_free: 171208, largest: 110592 },
+        stack_free: { stm32_uart: 1204, publisher: 1876, mqtt_task: 2310, dlog: 1420, main: 1988 }
+    });
+}
+
+class Bridge {
+    constructor(index, options) {
+        this.index = index;
+        this.rate = options.rate;
+        this.qos = options.qos;
+        this.period = 1000 / options.rate;
+        this.client = new MqttClient({
+            url: options.url,
+            clientId: bridgeId(index),
+            username: options.user,
+            password: options.pass
+        });
+        this.topics = Object.fromEntries(Object.keys(TOPICS).map((key) => [key, deviceTopic(this.client.clientId, key)]));
+        this.group = options.groups > 0 ? `lt${index % options.groups}` : '';
+        this.commandTopics = [this.topics.command, groupTopic('all'), ...(this.group ? [groupTopic(this.group)] : [])];
+        this.ackDelay = options.ackDelay;
+        this.cbor = options.encoding === 'cbor';
+        this.watchers = 0;          // Dashboards subscribed to this bridge's samples
+        this.tracesMeasured = 0;
+        this.seq = 0;
+        this.temp = 20 + Math.random() * 10;
+        this.humi = 40 + Math.random() * 20;
+        this.nextSample = 0;
+        this.nextState = 0;
+        this.nextMetrics = 0;
+        this.startMs = performance.now();
+    }
+
+    async start(options) {
+        await this.client.connect();
+        this.client.on('close', () => {
+            if (!run.stopping) run.disconnects++;
+        });
+        this.client.on('error', () => run.errors++);
+        this.client.on('message', (topic, payload) => {
+            if (this.commandTopics.includes(topic)) this.onCommand(payload.toString());
+        });
+        await this.client.subscribe(BRIDGE_SUBSCRIPTIONS.map((key) => this.topics[key]), 0);
+        await this.client.subscribe(this.commandTopics.slice(1), 1);
+        await this.client.publish(this.topics.stateSync, stateMessage(this), { qos: 1, retain: true });
+        run.statePublished++;
+    }
+
+    // Like execute_command() + the STM32's "ACK <id> OK|ERROR": SHT3X and RELAY commands succeed
+    onCommand(payload) {
+        let request;
+        try {
+            request = JSON.parse(payload);
+        } catch (err) {
+            return;     // Plain-text commands are not acknowledged
+        }
+        if (typeof request.id !== 'string') return;
+        const ok = typeof request.cmd === 'string' && /^(SHT3X|RELAY) /.test(request.cmd);
+        setTimeout(() => {
+            if (run.stopping) return;
+            this.client.publish(`${ROOT}/${this.client.clientId}/ack`,
+                JSON.stringify({ id: request.id, result: ok ? 'OK' : 'ERROR' }), { qos: 1 });
+            run.commandsAcked++;
+        }, this.ackDelay);
+    }
+
+    schedule(startMs, options) {
+        // Spread the fleet over one sample period so the broker sees a steady stream, not bursts
+        this.nextSample = startMs + Math.random() * this.period;
+        this.nextState = options.stateInterval > 0 ? startMs + options.stateInterval * 1000 * Math.random() : Infinity;
+        this.nextMetrics = options.metricsInterval > 0 ? startMs + options.metricsInterval * 1000 * Math.random() : Infinity;
+    }
+
+    sample() {
+        this.temp += (Math.random() - 0.5) * 0.1;
+        this.humi += (Math.random() - 0.5) * 0.2;
+        const publishOptions = { qos: this.qos };
+        // CBOR samples are single-precision floats, 5 bytes like the firmware's
+        const value = (v) => (this.cbor ? Buffer.from(CBOR.encode(Math.fround(v))) : v.toFixed(2));
+        this.client.publish(this.topics.periodicTemp, value(this.temp), publishOptions);
+        this.client.publish(this.topics.periodicHumi, value(this.humi), publishOptions);
+
+        // stm_us and rx_us keep the bridge's format; pub_us is this process's clock,
+        // which the dashboards share, so receive - pub_us is the true fan-out latency.
+        // "lt" marks load-test traces so a real bridge on the same broker is not counted.
+        const pub = nowUs();
+        const trace = encodePayload({
+            seq: this.seq++,
+            stm_us: (pub - 4000) >>> 0,
+            rx_us: (pub - 900) >>> 0,
+            pub_us: pub,
+            lt: this.index
+        }, this.cbor);
+        this.client.publish(this.topics.trace, trace, publishOptions);
+        run.tracesPublished++;
+        if (pub >= run.measureFromUs && pub < run.measureUntilUs) this.tracesMeasured++;
+    }
+
+    tick(now) {
+        let due = 0;
+        while (this.nextSample <= now) {
+            this.nextSample += this.period;
+            due++;
+        }
+        // Send at most a couple of overdue samples; the rest count as generator lag
+        if (due > 2) {
+            run.lagged += due - 2;
+            due = 2;
+        }
+        for (let i = 0; i < due; i++) this.sample();
+
+        if (now >= this.nextState) {
+            this.client.publish(this.topics.stateSync, stateMessage(this), { qos: 1, retain: true });
+            run.statePublished++;
+            this.nextState += run.options.stateInterval * 1000;
+        }
+        if (now >= this.nextMetrics) {
+            this.client.publish(`${ROOT}/${this.client.clientId}/metrics`, metricsMessage(this), { qos: 0, retain: true });
+            this.nextMetrics += run.options.metricsInterval * 1000;
+        }
+    }
+}
+
+class Dashboard {
+    // watched: client ids whose samples this dashboard selects, null for all of them
+    constructor(index, transport, watched, options) {
+        this.transport = transport;
+        this.watched = watched;
+        this.client = new MqttClient({
+            url: transport === 'ws' ? options.wsUrl : options.url,
+            clientId: `dashboard_lt_${transport}_${index}_${process.pid}`,
+            username: options.user,
+            password: options.pass
+        });
+        this.received = 0;
+        this.traces = 0;
+        this.tracesMeasured = 0;
+        this.retainedStates = 0;
+    }
+
+    async start(options) {
+        this.client.on('message', (topic, payload, info) => this.onMessage(topic, payload, info));
+        this.client.on('close', () => {
+            if (!run.stopping) run.disconnects++;
+        });
+        this.client.on('error', () => run.errors++);
+        await this.client.connect();
+        const topics = [deviceTopic('+', 'stateSync')];
+        for (const device of this.watched || ['+']) {
+            topics.push(...DASHBOARD_SUBSCRIPTIONS.map((key) => deviceTopic(device, key)));
+        }
+        await this.client.subscribe(topics, options.qos);
+    }
+
+    onMessage(topic, payload, info) {
+        this.received++;
+        run.received++;
+        if (info.retain && topic.endsWith('/' + TOPICS.stateSync)) this.retainedStates++;
+        if (!topic.endsWith('/' + TOPICS.trace)) return;
+
+        const received = nowUs();
+        let trace;
+        try {
+            trace = CBOR.isBinary(payload) ? CBOR.decode(payload) : JSON.parse(payload.toString());
+        } catch (err) {
+            return;
+        }
+        if (trace.lt === undefined) return;
+
+        this.traces++;
+        if (trace.pub_us >= run.measureFromUs && trace.pub_us < run.measureUntilUs) {
+            this.tracesMeasured++;
+            const latency = received - trace.pub_us;
+            run.window[this.transport].add(latency);
+            run.total[this.transport].add(latency);
+        }
+    }
+}
+
+const run = {
+    options: null,
+    stopping: false,
+    measureFromUs: Infinity,
+    measureUntilUs: Infinity,
+    tracesPublished: 0,
+    statePublished: 0,
+    commandsAcked: 0,
+    received: 0,
+    lagged: 0,
+    disconnects: 0,
+    errors: 0,
+    window: { tcp: new Histogram(), ws: new Histogram() },
+    total: { tcp: new Histogram(), ws: new Histogram() }
+};
+
+async function startAll(items, batch, label) {
+    const started = performance.now();
+    for (let i = 0; i < items.length; i += batch) {
+        await Promise.all(items.slice(i, i + batch).map((item) => item.start(run.options)));
+    }
+    if (items.length) {
+        log(`${items.length} ${label} connected in ${((performance.now() - started) / 1000).toFixed(2)} s`);
+    }
+}
+
+function resolveBrokerPid(options) {
+    if (options.brokerPid) return options.brokerPid;
+    if (!options.container) return 0;
+    try {
+        return Number(execSync(`docker inspect -f '{{.State.Pid}}' ${options.container}`, { encoding: 'utf8' }).trim());
+    } catch (err) {
+        log(`Cannot resolve the PID of container ${options.container}: ${err.message.split('\n')[0]}`);
+        return 0;
+    }
+}
+
+function sumClientStats(clients, key) {
+    return clients.reduce((sum, c) => sum + c.client.stats[key], 0);
+}
+
+function fmt(value, digits = 1) {
+    return Number(value).toFixed(digits);
+}
+
+async function main() {
+    const options = parseArgs(process.argv.slice(2));
+    run.options = options;
+    if (options.rate <= 0 || options.bridges < 1 || !['text', 'cbor'].includes(options.encoding)) {
+        log('--rate must be > 0, --bridges >= 1 and --encoding text or cbor');
+        process.exit(2);
+    }
+
+    const brokerPid = resolveBrokerPid(options);
+    const broker = brokerPid ? new ProcessSampler(brokerPid) : null;
+    if (broker && !broker.available) {
+        log(`Cannot read /proc/${brokerPid}; broker CPU/RSS will not be reported`);
+    }
+    const self = new ProcessSampler(process.pid);
+
+    // Dashboards first, so every sample has its full audience
+    const bridges = [];
+    for (let i = 0; i < options.bridges; i++) bridges.push(new Bridge(i, options));
+
+    // Dashboard d selects bridges d*K .. d*K+K-1 (mod N), spreading interest over the fleet
+    const watch = Math.min(options.watch, options.bridges);
+    const dashboards = [];
+    const transports = [...Array(options.subsTcp).fill('tcp'), ...Array(options.subsWs).fill('ws')];
+    transports.forEach((transport, d) => {
+        let watched = null;
+        if (watch > 0) {
+            const picked = Array.from({ length: watch }, (_, j) => bridges[(d * watch + j) % bridges.length]);
+            picked.forEach((bridge) => bridge.watchers++);
+            watched = picked.map((bridge) => bridge.client.clientId);
+        } else {
+            bridges.forEach((bridge) => bridge.watchers++);
+        }
+        dashboards.push(new Dashboard(d, transport, watched, options));
+    });
+
+    try {
+        await startAll(dashboards, options.connectBatch, 'dashboards');
+        await startAll(bridges, options.connectBatch, 'bridges');
+    } catch (err) {
+        log(`Connect failed: ${err.message}`);
+        process.exit(1);
+    }
+
+    const messagesPerSample = 3;
+    log(`Publishing ${fmt(options.bridges * options.rate * messagesPerSample, 0)} msg/s ` +
+        `(${options.bridges} bridges x ${options.rate} Hz x ${messagesPerSample}) to ${dashboards.length} dashboards ` +
+        `for ${options.duration} s, QoS ${options.qos}, ${options.encoding}`);
+
+    const startMs = performance.now();
+    for (const bridge of bridges) bridge.schedule(startMs, options);
+    run.measureFromUs = Math.round((startMs + options.warmup * 1000) * 1000);
+    const stopMs = startMs + options.duration * 1000;
+    run.measureUntilUs = Math.round(stopMs * 1000);
+
+    let lastReportMs = startMs;
+    let lastPublished = 0;
+    let lastReceived = 0;
+
+    await new Promise((resolve) => {
+        const timer = setInterval(() => {
+            const now = performance.now();
+            if (now >= stopMs) {
+                clearInterval(timer);
+                resolve();
+                return;
+            }
+            for (const bridge of bridges) bridge.tick(now);
+
+            if (now - lastReportMs >= options.interval * 1000) {
+                const seconds = (now - lastReportMs) / 1000;
+                const published = sumClientStats(bridges, 'published');
+                const both = new Histogram();
+                both.merge(run.window.tcp);
+                both.merge(run.window.ws);
+                let line = `[${fmt((now - startMs) / 1000, 0).padStart(4)} s] ` +
+                    `pub ${fmt((published - lastPublished) / seconds, 0)} msg/s  ` +
+                    `recv ${fmt((run.received - lastReceived) / seconds, 0)} msg/s  ` +
+                    `fan-out p50 ${fmt(both.percentile(50) / 1000, 2)} p99 ${fmt(both.percentile(99) / 1000, 2)} ` +
+                    `max ${fmt(both.max / 1000, 2)} ms`;
+                const brokerNow = broker && broker.available ? broker.sample() : null;
+                if (brokerNow) {
+                    line += `  broker ${fmt(brokerNow.cpuPercent)}% ${fmt(brokerNow.rss / 1048576)} MB`;
+                }
+                const selfNow = self.sample();
+                if (selfNow) line += `  self ${fmt(selfNow.cpuPercent)}%`;
+                log(line);
+                run.window.tcp.reset();
+                run.window.ws.reset();
+                lastReportMs = now;
+                lastPublished = published;
+                lastReceived = run.received;
+            }
+        }, 1);
+    });
+
+    const publishSeconds = (performance.now() - startMs) / 1000;
+    await new Promise((resolve) => setTimeout(resolve, options.drain * 1000));
+    if (broker && broker.available) broker.sample();
+    self.sample();
+
+    run.stopping = true;
+    for (const client of [...bridges, ...dashboards]) client.client.end();
+
+    // Traces published inside the measurement window, times the dashboards that should see each one
+    const expected = bridges.reduce((sum, b) => sum + b.tracesMeasured * b.watchers, 0);
+    const delivered = dashboards.reduce((sum, d) => sum + d.tracesMeasured, 0);
+    const all = new Histogram();
+    all.merge(run.total.tcp);
+    all.merge(run.total.ws);
+
+    const published = sumClientStats(bridges, 'published');
+    const report = {
+        config: {
+            bridges: options.bridges, rate_hz: options.rate, qos: options.qos, encoding: options.encoding,
+            subs_tcp: options.subsTcp, subs_ws: options.subsWs, watch,
+            duration_s: options.duration, state_interval_s: options.stateInterval,
+            metrics_interval_s: options.metricsInterval
+        },
+        publish: {
+            messages: published,
+            msg_per_s: published / publishSeconds,
+            bytes_per_s: sumClientStats(bridges, 'bytesOut') / publishSeconds,
+            retained_state: run.statePublished,
+            generator_lag_samples: run.lagged,
+            socket_backpressure: sumClientStats(bridges, 'backpressure')
+        },
+        fanout: {
+            received: run.received,
+            msg_per_s: run.received / publishSeconds,
+            expected_traces: expected,
+            delivered_traces: delivered,
+            loss_percent: expected ? (1 - delivered / expected) * 100 : 0,
+            latency: all.summary(),
+            latency_tcp: run.total.tcp.summary(),
+            latency_ws: run.total.ws.summary(),
+            clock_skew_samples: all.negative
+        },
+        retained_state_on_subscribe: dashboards.reduce((sum, d) => sum + d.retainedStates, 0),
+        commands_acked: run.commandsAcked,
+        disconnects: run.disconnects,
+        errors: run.errors,
+        broker: broker ? broker.summary() : null,
+        loadtest: self.summary()
+    };
+
+    if (options.json) {
+        process.stdout.write(JSON.stringify(report) + '\n');
+    } else {
+        printReport(report);
+    }
+    setTimeout(() => process.exit(0), 200).unref();
+}
+
+function printLatency(label, summary) {
+    if (!summary.count) return;
+    console.log(`  ${label.padEnd(6)} n=${summary.count}  p50 ${fmt(summary.p50_ms, 2)}  p95 ${fmt(summary.p95_ms, 2)}  ` +
+                `p99 ${fmt(summary.p99_ms, 2)}  max ${fmt(summary.max_ms, 2)} ms`);
+}
+
+function printReport(report) {
+    const c = report.config;
+    const watching = c.watch ? `${c.watch} device(s) each` : 'all devices';
+    console.log(`\n=== ${c.bridges} bridges x ${c.rate_hz} Hz, ${c.subs_tcp} TCP + ${c.subs_ws} WS dashboards watching ${watching}, ` +
+                `QoS ${c.qos}, ${c.encoding}, ${c.duration_s} s ===`);
+    console.log(`Publish    ${fmt(report.publish.msg_per_s, 0)} msg/s, ${fmt(report.publish.bytes_per_s / 1024)} KiB/s, ` +
+                `${report.publish.retained_state} retained state`);
+    if (report.publish.generator_lag_samples) {
+        console.log(`           ${report.publish.generator_lag_samples} samples skipped: the generator could not keep up`);
+    }
+    console.log(`Fan-out    ${fmt(report.fanout.msg_per_s, 0)} msg/s received, ` +
+                `${report.fanout.delivered_traces}/${report.fanout.expected_traces} traces, ` +
+                `loss ${fmt(report.fanout.loss_percent, 2)}%`);
+    printLatency('all', report.fanout.latency);
+    printLatency('tcp', report.fanout.latency_tcp);
+    printLatency('ws', report.fanout.latency_ws);
+    if (report.broker) {
+        const b = report.broker;
+        console.log(`Broker     pid ${b.pid}, CPU ${fmt(b.cpu_percent_avg)}% avg, ` +
+                    `RSS ${fmt(b.rss_start_mb)} -> ${fmt(b.rss_end_mb)} MB (max ${fmt(b.rss_max_mb)})`);
+    }
+    if (report.loadtest) {
+        console.log(`Loadtest   CPU ${fmt(report.loadtest.cpu_percent_avg)}% avg, RSS max ${fmt(report.loadtest.rss_max_mb)} MB`);
+    }
+    if (report.commands_acked) {
+        console.log(`Commands   ${report.commands_acked} acknowledged by the simulated bridges`);
+    }
+    if (report.disconnects || report.errors) {
+        console.log(`Clients    ${report.disconnects} unexpected disconnects, ${report.errors} errors`);
+    }
+}
+
+main().catch((err) => {
+    log(err.stack || String(err));
+    process.exit(1);
+});
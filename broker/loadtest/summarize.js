@@ -0,0 +1,40 @@
+#!/usr/bin/env node
+// Tabulates loadtest.js --json reports as a Markdown table, one row per run.
+// Files named <profile>@<bridges>x<rate>.json (bench_profiles.sh) are grouped by profile.
+'use strict';
+
+const fs = require('fs');
+const path = require('path');
+
+const files = process.argv.slice(2);
+if (!files.length) {
+    process.stderr.write('Usage: node summarize.js report.json ...\n');
+    process.exit(2);
+}
+
+const rows = files.map((file) => {
+    const report = JSON.parse(fs.readFileSync(file, 'utf8'));
+    const profile = path.basename(file, '.json').split('@')[0];
+    return { profile, report };
+});
+rows.sort((a, b) =>
+    a.report.config.bridges * a.report.config.rate_hz - b.report.config.bridges * b.report.config.rate_hz ||
+    a.profile.localeCompare(b.profile));
+
+const f = (value, digits = 1) => (value === null || value === undefined ? '-' : Number(value).toFixed(digits));
+
+const first = rows[0].report.config;
+const watching = first.watch ? `${first.watch} device(s) each` : 'all devices';
+console.log(`Dashboards: ${first.subs_tcp} TCP + ${first.subs_ws} WS watching ${watching}, QoS ${first.qos}, ` +
+            `${first.duration_s} s per run\n`);
+console.log('| Profile | Fleet | Publish msg/s | Fan-out msg/s | p50 ms | p95 ms | p99 ms | max ms | Loss % | Broker CPU % | Broker RSS MB |');
+console.log('|---------|-------|---------------|---------------|--------|--------|--------|--------|--------|--------------|---------------|');
+for (const { profile, report } of rows) {
+    const c = report.config;
+    const latency = report.fanout.latency;
+    const broker = report.broker || {};
+    console.log(`| ${profile} | ${c.bridges} x ${c.rate_hz} Hz | ${f(report.publish.msg_per_s, 0)} | ` +
+                `${f(report.fanout.msg_per_s, 0)} | ${f(latency.p50_ms, 2)} | ${f(latency.p95_ms, 2)} | ` +
+                `${f(latency.p99_ms, 2)} | ${f(latency.max_ms, 2)} | ${f(report.fanout.loss_percent, 2)} | ` +
+                `${f(broker.cpu_percent_avg)} | ${f(broker.rss_max_mb)} |`);
+}
@@ -0,0 +1,146 @@
+/**
+ * @file bridge_metrics.c
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "bridge_metrics.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/* STATIC VARIABLES ----------------------------------------------------------*/
+static const char* const COUNTER_NAMES[METRIC_COUNTER_COUNT] = {
+    "lines", "rejected", "parse_fail", "ring_overflow", "queue_drop",
+    "backlog_drop", "pub_ok", "pub_fail", "reconnects", "disconnects"
+};
+static const char* const HISTOGRAM_NAMES[METRIC_HIST_COUNT] = { "ingest", "e2e" };
+static const uint32_t HIST_EDGES_US[METRICS_HIST_BINS - 1] = METRICS_HIST_EDGES_US;
+
+static uint32_t s_counters[METRIC_COUNTER_COUNT];
+static metrics_histogram_t s_histograms[METRIC_HIST_COUNT];
+static const char* s_tasks[METRICS_MAX_TASKS];
+static int s_task_count = 0;
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+
+/**
+ * @brief Append to buffer, tracking overflow in *len (set to -1)
+ */
+static void metrics_append(char* buffer, size_t size, int* len, const char* fmt, ...)
+{
+    if (*len < 0)
+    {
+        return;
+    }
+
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(buffer + *len, size - *len, fmt, ap);
+    va_end(ap);
+
+    *len = (n < 0 || (size_t)(*len + n) >= size) ? -1 : *len + n;
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+void Metrics_Add(metric_counter_t id, uint32_t n)
+{
+    if (id < METRIC_COUNTER_COUNT)
+    {
+        __atomic_fetch_add(&s_counters[id], n, __ATOMIC_RELAXED);
+    }
+}
+
+void Metrics_Set(metric_counter_t id, uint32_t value)
+{
+    if (id < METRIC_COUNTER_COUNT)
+    {
+        __atomic_store_n(&s_counters[id], value, __ATOMIC_RELAXED);
+    }
+}
+
+void Metrics_Observe(metric_histogram_t id, uint32_t value_us)
+{
+    if (id >= METRIC_HIST_COUNT)
+    {
+        return;
+    }
+
+    metrics_histogram_t* h = &s_histograms[id];
+    int bin = 0;
+    while (bin < METRICS_HIST_BINS - 1 && value_us >= HIST_EDGES_US[bin])
+    {
+        bin++;
+    }
+
+    h->bins[bin]++;
+    h->count++;
+    h->sum_us += value_us;
+    if (value_us > h->max_us)
+    {
+        h->max_us = value_us;
+    }
+}
+
+bool Metrics_WatchTask(const char* name)
+{
+    if (!name || s_task_count >= METRICS_MAX_TASKS)
+    {
+        return false;
+    }
+    s_tasks[s_task_count++] = name;
+    return true;
+}
+
+int Metrics_Format(char* buffer, size_t size)
+{
+    int len = 0;
+
+    metrics_append(buffer, size, &len, "{\"uptime_s\":%lu,\"c\":{",
+                   (unsigned long)(esp_timer_get_time() / 1000000));
+    for (int i = 0; i < METRIC_COUNTER_COUNT; i++)
+    {
+        metrics_append(buffer, size, &len, "%s\"%s\":%lu", i ? "," : "", COUNTER_NAMES[i],
+                       (unsigned long)__atomic_load_n(&s_counters[i], __ATOMIC_RELAXED));
+    }
+
+    // Histograms: bucket counts per upper edge, last bucket is the overflow
+    metrics_append(buffer, size, &len, "},\"h\":{\"edges_us\":[");
+    for (int i = 0; i < METRICS_HIST_BINS - 1; i++)
+    {
+        metrics_append(buffer, size, &len, "%s%lu", i ? "," : "", (unsigned long)HIST_EDGES_US[i]);
+    }
+    metrics_append(buffer, size, &len, "]");
+    for (int i = 0; i < METRIC_HIST_COUNT; i++)
+    {
+        const metrics_histogram_t* h = &s_histograms[i];
+        metrics_append(buffer, size, &len, ",\"%s\":{\"n\":%lu,\"avg\":%lu,\"max\":%lu,\"b\":[",
+                       HISTOGRAM_NAMES[i], (unsigned long)h->count,
+                       (unsigned long)(h->count ? h->sum_us / h->count : 0), (unsigned long)h->max_us);
+        for (int b = 0; b < METRICS_HIST_BINS; b++)
+        {
+            metrics_append(buffer, size, &len, "%s%lu", b ? "," : "", (unsigned long)h->bins[b]);
+        }
+        metrics_append(buffer, size, &len, "]}");
+    }
+
+    metrics_append(buffer, size, &len, "},\"heap\":{\"free\":%lu,\"min_free\":%lu,\"largest\":%lu}",
+                   (unsigned long)esp_get_free_heap_size(),
+                   (unsigned long)esp_get_minimum_free_heap_size(),
+                   (unsigned long)heap_caps_get_largest_free_block(MALLOC_CAP_8BIT));
+
+    // Minimum free stack ever seen per task, in bytes; -1 if the task does not exist (yet)
+    metrics_append(buffer, size, &len, ",\"stack_free\":{");
+    for (int i = 0; i < s_task_count; i++)
+    {
+        TaskHandle_t task = xTaskGetHandle(s_tasks[i]);
+        long hwm = task ? (long)uxTaskGetStackHighWaterMark(task) : -1;
+        metrics_append(buffer, size, &len, "%s\"%s\":%ld", i ? "," : "", s_tasks[i], hwm);
+    }
+    metrics_append(buffer, size, &len, "}}");
+
+    return len;
+}
@@ -0,0 +1,91 @@
+/**
+ * @file bridge_metrics.h
+ * @brief In-process counters, latency histograms and watermarks for the bridge
+ */
+#ifndef BRIDGE_METRICS_H
+#define BRIDGE_METRICS_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define METRICS_HIST_BINS       11      // 10 upper edges (METRICS_HIST_EDGES_US) + overflow
+#define METRICS_HIST_EDGES_US   { 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000 }
+#define METRICS_MAX_TASKS       8
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef enum {
+    METRIC_LINES_RX = 0,        // Lines delivered by the UART line assembler
+    METRIC_LINES_REJECTED,      // Lines dropped by the UART line cleaner
+    METRIC_PARSE_FAILURES,      // Lines that are neither sample, AGGREGATE nor STATE
+    METRIC_RING_OVERFLOW,       // UART ring buffer bytes lost (mirrored)
+    METRIC_QUEUE_DROPS,         // Pipeline queue full (mirrored)
+    METRIC_BACKLOG_DROPS,       // Publish backlog overwritten (mirrored)
+    METRIC_PUBLISH_OK,          // MQTT publishes accepted by the client (mirrored)
+    METRIC_PUBLISH_FAILURES,    // MQTT publishes refused by the client (mirrored)
+    METRIC_RECONNECTS,          // MQTT connections after the first (mirrored)
+    METRIC_DISCONNECTS,         // MQTT disconnect/error events (mirrored)
+    METRIC_COUNTER_COUNT
+} metric_counter_t;
+
+typedef enum {
+    METRIC_HIST_INGEST = 0,     // Line terminator -> enqueued (UART task)
+    METRIC_HIST_END_TO_END,     // Line terminator -> handed to the MQTT client
+    METRIC_HIST_COUNT
+} metric_histogram_t;
+
+typedef struct {
+    uint32_t bins[METRICS_HIST_BINS];
+    uint32_t count;
+    uint64_t sum_us;
+    uint32_t max_us;
+} metrics_histogram_t;
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+
+/**
+ * @brief Add to a counter (any task)
+ * 
+ * @param id Counter
+ * @param n Increment
+ */
+void Metrics_Add(metric_counter_t id, uint32_t n);
+
+/**
+ * @brief Overwrite a counter with a value owned by another component
+ * 
+ * @param id Counter
+ * @param value Current value
+ */
+void Metrics_Set(metric_counter_t id, uint32_t value);
+
+/**
+ * @brief Record one latency sample (a single writer task per histogram)
+ * 
+ * @param id Histogram
+ * @param value_us Latency in microseconds
+ */
+void Metrics_Observe(metric_histogram_t id, uint32_t value_us);
+
+/**
+ * @brief Register a task whose stack high-water mark is reported
+ * 
+ * @param name FreeRTOS task name, looked up with xTaskGetHandle() on each report
+ * 
+ * @return true if registered
+ */
+bool Metrics_WatchTask(const char* name);
+
+/**
+ * @brief Serialize everything as compact JSON
+ * 
+ * @param buffer Output buffer
+ * @param size Buffer size (worst case is about 700 bytes with 8 tasks)
+ * 
+ * @return Length written, -1 if the buffer is too small
+ */
+int Metrics_Format(char* buffer, size_t size);
+
+#endif /* BRIDGE_METRICS_H */
@@ -0,0 +1,417 @@
+/**
+ * @file cbor_codec.c
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "cbor_codec.h"
+#include <string.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define CBOR_MAJOR_UINT     0
+#define CBOR_MAJOR_NEGINT   1
+#define CBOR_MAJOR_BYTES    2
+#define CBOR_MAJOR_TEXT     3
+#define CBOR_MAJOR_ARRAY    4
+#define CBOR_MAJOR_MAP      5
+#define CBOR_MAJOR_TAG      6
+#define CBOR_MAJOR_SIMPLE   7
+
+#define CBOR_FALSE          0xF4
+#define CBOR_TRUE           0xF5
+#define CBOR_HALF           0xF9
+#define CBOR_SINGLE         0xFA
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+
+/**
+ * @brief Append raw bytes, setting overflow instead of writing past the buffer
+ */
+static void cbor_write(cbor_writer_t* writer, const uint8_t* data, size_t length)
+{
+    if (writer->overflow || length > writer->size - writer->length)
+    {
+        writer->overflow = true;
+        return;
+    }
+
+    memcpy(writer->buffer + writer->length, data, length);
+    writer->length += length;
+}
+
+/**
+ * @brief Write a major type with its argument in the shortest big-endian form
+ */
+static void cbor_write_head(cbor_writer_t* writer, uint8_t major, uint64_t value)
+{
+    uint8_t head[9];
+    size_t bytes;
+
+    if (value < 24)
+    {
+        head[0] = (uint8_t)((major << 5) | value);
+        cbor_write(writer, head, 1);
+        return;
+    }
+
+    if (value <= 0xFF)
+    {
+        head[0] = (uint8_t)((major << 5) | 24);
+        bytes = 1;
+    }
+    else if (value <= 0xFFFF)
+    {
+        head[0] = (uint8_t)((major << 5) | 25);
+        bytes = 2;
+    }
+    else if (value <= 0xFFFFFFFFULL)
+    {
+        head[0] = (uint8_t)((major << 5) | 26);
+        bytes = 4;
+    }
+    else
+    {
+        head[0] = (uint8_t)((major << 5) | 27);
+        bytes = 8;
+    }
+
+    for (size_t i = 0; i < bytes; i++)
+    {
+        head[bytes - i] = (uint8_t)(value >> (8 * i));
+    }
+    cbor_write(writer, head, bytes + 1);
+}
+
+/**
+ * @brief Convert a float to half precision if no bits are lost
+ *
+ * @return true and *half set when exact
+ */
+static bool float_to_half(float value, uint16_t* half)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+    int32_t exponent = (int32_t)((bits >> 23) & 0xFF);
+    uint32_t mantissa = bits & 0x7FFFFF;
+
+    if (exponent == 0xFF)
+    {
+        // Infinity keeps its sign; every NaN becomes the canonical quiet NaN
+        *half = mantissa ? 0x7E00 : (uint16_t)(sign | 0x7C00);
+        return true;
+    }
+    if (exponent == 0 && mantissa == 0)
+    {
+        *half = sign;
+        return true;
+    }
+    if (exponent == 0)
+    {
+        return false;           // Float subnormals are far below the half range
+    }
+
+    exponent -= 127;
+    if (exponent >= -14 && exponent <= 15)
+    {
+        if (mantissa & 0x1FFF)
+        {
+            return false;
+        }
+        *half = (uint16_t)(sign | ((exponent + 15) << 10) | (mantissa >> 13));
+        return true;
+    }
+    if (exponent >= -24 && exponent < -14)
+    {
+        // Half subnormal: value = m * 2^-24
+        uint32_t full = mantissa | 0x800000;
+        uint32_t shift = (uint32_t)(-1 - exponent);
+        if (full & ((1UL << shift) - 1))
+        {
+            return false;
+        }
+        *half = (uint16_t)(sign | (full >> shift));
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Expand a half precision value without libm
+ */
+static float half_to_float(uint16_t half)
+{
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exponent = (half >> 10) & 0x1F;
+    uint32_t mantissa = half & 0x3FF;
+    uint32_t bits;
+    float value;
+
+    if (exponent == 0)
+    {
+        value = (float)mantissa * (1.0f / 16777216.0f);
+        return sign ? -value : value;
+    }
+
+    if (exponent == 0x1F)
+    {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else
+    {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/**
+ * @brief Read a big-endian argument of 1, 2, 4 or 8 bytes
+ */
+static bool cbor_read_argument(cbor_reader_t* reader, uint8_t info, uint64_t* value)
+{
+    size_t bytes;
+
+    if (info < 24)
+    {
+        *value = info;
+        return true;
+    }
+
+    switch (info)
+    {
+    case 24: bytes = 1; break;
+    case 25: bytes = 2; break;
+    case 26: bytes = 4; break;
+    case 27: bytes = 8; break;
+    default: return false;      // Reserved or indefinite length
+    }
+
+    if ((size_t)(reader->end - reader->pos) < bytes)
+    {
+        return false;
+    }
+
+    *value = 0;
+    for (size_t i = 0; i < bytes; i++)
+    {
+        *value = (*value << 8) | reader->pos[i];
+    }
+    reader->pos += bytes;
+    return true;
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+void CBOR_WriterInit(cbor_writer_t* writer, uint8_t* buffer, size_t size)
+{
+    writer->buffer = buffer;
+    writer->size = size;
+    writer->length = 0;
+    writer->overflow = false;
+}
+
+int CBOR_WriterLength(const cbor_writer_t* writer)
+{
+    return writer->overflow ? -1 : (int)writer->length;
+}
+
+void CBOR_PutArray(cbor_writer_t* writer, size_t items)
+{
+    cbor_write_head(writer, CBOR_MAJOR_ARRAY, items);
+}
+
+void CBOR_PutMap(cbor_writer_t* writer, size_t pairs)
+{
+    cbor_write_head(writer, CBOR_MAJOR_MAP, pairs);
+}
+
+void CBOR_PutUint(cbor_writer_t* writer, uint64_t value)
+{
+    cbor_write_head(writer, CBOR_MAJOR_UINT, value);
+}
+
+void CBOR_PutInt(cbor_writer_t* writer, int64_t value)
+{
+    if (value >= 0)
+    {
+        cbor_write_head(writer, CBOR_MAJOR_UINT, (uint64_t)value);
+    }
+    else
+    {
+        // -1 - value without overflowing at INT64_MIN
+        cbor_write_head(writer, CBOR_MAJOR_NEGINT, ~(uint64_t)value);
+    }
+}
+
+void CBOR_PutFloat(cbor_writer_t* writer, float value)
+{
+    uint8_t out[5];
+    uint16_t half;
+
+    if (float_to_half(value, &half))
+    {
+        out[0] = CBOR_HALF;
+        out[1] = (uint8_t)(half >> 8);
+        out[2] = (uint8_t)half;
+        cbor_write(writer, out, 3);
+        return;
+    }
+
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    out[0] = CBOR_SINGLE;
+    out[1] = (uint8_t)(bits >> 24);
+    out[2] = (uint8_t)(bits >> 16);
+    out[3] = (uint8_t)(bits >> 8);
+    out[4] = (uint8_t)bits;
+    cbor_write(writer, out, 5);
+}
+
+void CBOR_PutText(cbor_writer_t* writer, const char* text)
+{
+    size_t length = strlen(text);
+    cbor_write_head(writer, CBOR_MAJOR_TEXT, length);
+    cbor_write(writer, (const uint8_t*)text, length);
+}
+
+void CBOR_PutBool(cbor_writer_t* writer, bool value)
+{
+    uint8_t out = value ? CBOR_TRUE : CBOR_FALSE;
+    cbor_write(writer, &out, 1);
+}
+
+void CBOR_ReaderInit(cbor_reader_t* reader, const uint8_t* data, size_t length)
+{
+    reader->pos = data;
+    reader->end = data + length;
+}
+
+bool CBOR_Next(cbor_reader_t* reader, cbor_item_t* item)
+{
+    if (reader->pos >= reader->end)
+    {
+        return false;
+    }
+
+    uint8_t initial = *reader->pos++;
+    uint8_t major = initial >> 5;
+    uint8_t info = initial & 0x1F;
+    uint64_t argument;
+
+    if (!cbor_read_argument(reader, info, &argument))
+    {
+        return false;
+    }
+
+    size_t remaining = (size_t)(reader->end - reader->pos);
+
+    switch (major)
+    {
+    case CBOR_MAJOR_UINT:
+        item->type = CBOR_TYPE_UINT;
+        item->uint_value = argument;
+        return true;
+
+    case CBOR_MAJOR_NEGINT:
+        if (argument > (uint64_t)INT64_MAX)
+        {
+            return false;
+        }
+        item->type = CBOR_TYPE_NEGINT;
+        item->int_value = -1 - (int64_t)argument;
+        return true;
+
+    case CBOR_MAJOR_TEXT:
+        if (argument > remaining)
+        {
+            return false;
+        }
+        item->type = CBOR_TYPE_TEXT;
+        item->text = (const char*)reader->pos;
+        item->length = (size_t)argument;
+        reader->pos += argument;
+        return true;
+
+    case CBOR_MAJOR_ARRAY:
+    case CBOR_MAJOR_MAP:
+        // Every item takes at least one byte, which bounds the count for CBOR_Skip
+        if (argument > remaining || (major == CBOR_MAJOR_MAP && argument * 2 > remaining))
+        {
+            return false;
+        }
+        item->type = (major == CBOR_MAJOR_ARRAY) ? CBOR_TYPE_ARRAY : CBOR_TYPE_MAP;
+        item->count = (size_t)argument;
+        return true;
+
+    case CBOR_MAJOR_SIMPLE:
+        if (info == 20 || info == 21)
+        {
+            item->type = CBOR_TYPE_BOOL;
+            item->bool_value = (info == 21);
+            return true;
+        }
+        if (info == 22)
+        {
+            item->type = CBOR_TYPE_NULL;
+            return true;
+        }
+        if (info == 25)
+        {
+            item->type = CBOR_TYPE_FLOAT;
+            item->float_value = half_to_float((uint16_t)argument);
+            return true;
+        }
+        if (info == 26)
+        {
+            uint32_t bits = (uint32_t)argument;
+            float value;
+            memcpy(&value, &bits, sizeof(value));
+            item->type = CBOR_TYPE_FLOAT;
+            item->float_value = value;
+            return true;
+        }
+        if (info == 27)
+        {
+            item->type = CBOR_TYPE_FLOAT;
+            memcpy(&item->float_value, &argument, sizeof(item->float_value));
+            return true;
+        }
+        return false;
+
+    case CBOR_MAJOR_BYTES:
+    case CBOR_MAJOR_TAG:
+    default:
+        return false;
+    }
+}
+
+bool CBOR_Skip(cbor_reader_t* reader)
+{
+    size_t pending = 1;
+    cbor_item_t item;
+
+    while (pending > 0)
+    {
+        if (!CBOR_Next(reader, &item))
+        {
+            return false;
+        }
+        pending--;
+
+        if (item.type == CBOR_TYPE_ARRAY)
+        {
+            pending += item.count;
+        }
+        else if (item.type == CBOR_TYPE_MAP)
+        {
+            pending += item.count * 2;
+        }
+    }
+    return true;
+}
+
+bool CBOR_TextEquals(const cbor_item_t* item, const char* text)
+{
+    return item->type == CBOR_TYPE_TEXT
+        && strlen(text) == item->length
+        && memcmp(item->text, text, item->length) == 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file cbor_codec.h
+ * @brief Minimal CBOR (RFC 8949) writer and reader for the bridge's binary payloads
+ *
+ * Covers what the bridge sends: unsigned/negative integers, floats, text strings,
+ * booleans and definite-length arrays and maps. No allocation; the writer fills a
+ * caller buffer and flags overflow instead of failing each call.
+ */
+#ifndef CBOR_CODEC_H
+#define CBOR_CODEC_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+// Every CBOR payload of the bridge starts with a byte >= 0x80 (array, map or float);
+// text and JSON payloads never do, so consumers can tell them apart by the first byte
+#define CBOR_IS_BINARY(first_byte)  ((uint8_t)(first_byte) >= 0x80)
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef struct {
+    uint8_t* buffer;
+    size_t size;
+    size_t length;
+    bool overflow;              // Set by the first write that did not fit; later writes are ignored
+} cbor_writer_t;
+
+typedef enum {
+    CBOR_TYPE_UINT = 0,
+    CBOR_TYPE_NEGINT,
+    CBOR_TYPE_TEXT,
+    CBOR_TYPE_ARRAY,
+    CBOR_TYPE_MAP,
+    CBOR_TYPE_FLOAT,
+    CBOR_TYPE_BOOL,
+    CBOR_TYPE_NULL
+} cbor_type_t;
+
+typedef struct {
+    cbor_type_t type;
+    union {
+        uint64_t uint_value;    // CBOR_TYPE_UINT
+        int64_t int_value;      // CBOR_TYPE_NEGINT (and UINT values up to INT64_MAX)
+        double float_value;     // CBOR_TYPE_FLOAT, from half, single or double
+        bool bool_value;        // CBOR_TYPE_BOOL
+        size_t count;           // CBOR_TYPE_ARRAY items, CBOR_TYPE_MAP pairs
+        struct {
+            const char* text;   // Not NUL-terminated
+            size_t length;
+        };
+    };
+} cbor_item_t;
+
+typedef struct {
+    const uint8_t* pos;
+    const uint8_t* end;
+} cbor_reader_t;
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+
+/**
+ * @brief Start writing into a buffer
+ *
+ * @param writer Writer
+ * @param buffer Output buffer
+ * @param size Buffer size
+ */
+void CBOR_WriterInit(cbor_writer_t* writer, uint8_t* buffer, size_t size);
+
+/**
+ * @brief Bytes written so far
+ *
+ * @param writer Writer
+ *
+ * @return Length, -1 if anything did not fit
+ */
+int CBOR_WriterLength(const cbor_writer_t* writer);
+
+/**
+ * @brief Open an array of a known number of items
+ */
+void CBOR_PutArray(cbor_writer_t* writer, size_t items);
+
+/**
+ * @brief Open a map of a known number of key/value pairs
+ */
+void CBOR_PutMap(cbor_writer_t* writer, size_t pairs);
+
+/**
+ * @brief Write an unsigned integer in the shortest form (1, 2, 3, 5 or 9 bytes)
+ */
+void CBOR_PutUint(cbor_writer_t* writer, uint64_t value);
+
+/**
+ * @brief Write a signed integer in the shortest form
+ */
+void CBOR_PutInt(cbor_writer_t* writer, int64_t value);
+
+/**
+ * @brief Write a float as half precision when that is exact, otherwise single
+ *
+ * @note Rates such as 0.5 or 10 take 3 bytes; sensor values take 5
+ */
+void CBOR_PutFloat(cbor_writer_t* writer, float value);
+
+/**
+ * @brief Write a NUL-terminated text string
+ */
+void CBOR_PutText(cbor_writer_t* writer, const char* text);
+
+/**
+ * @brief Write true or false
+ */
+void CBOR_PutBool(cbor_writer_t* writer, bool value);
+
+/**
+ * @brief Start reading a buffer
+ *
+ * @param reader Reader
+ * @param data CBOR data
+ * @param length Data length
+ */
+void CBOR_ReaderInit(cbor_reader_t* reader, const uint8_t* data, size_t length);
+
+/**
+ * @brief Read the next item head
+ *
+ * @note Arrays and maps only report their count; their items follow as the next
+ *       items (two per map pair). Indefinite lengths, tags and byte strings are
+ *       not produced by the bridge and are rejected.
+ *
+ * @param reader Reader
+ * @param item Decoded item
+ *
+ * @return false at the end of data or on malformed/unsupported input
+ */
+bool CBOR_Next(cbor_reader_t* reader, cbor_item_t* item);
+
+/**
+ * @brief Skip one complete item, including everything inside an array or map
+ *
+ * @return false on malformed/unsupported input
+ */
+bool CBOR_Skip(cbor_reader_t* reader);
+
+/**
+ * @brief Compare a text item with a NUL-terminated string
+ */
+bool CBOR_TextEquals(const cbor_item_t* item, const char* text);
+
+#endif /* CBOR_CODEC_H */
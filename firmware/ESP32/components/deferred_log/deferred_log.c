@@ -0,0 +1,436 @@
+/**
+ * @file deferred_log.c
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "deferred_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define DLOG_SITE_UNSUPPORTED   (-2)    // arg_count: format cannot be deferred
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef enum {
+    DLOG_ARG_INT = 0,           // Everything promoted to int (d i u x c, h/l on 32-bit)
+    DLOG_ARG_INT64,             // ll, j
+    DLOG_ARG_DOUBLE,            // f e g a (float is promoted)
+    DLOG_ARG_STRING,            // s, copied into the record
+    DLOG_ARG_POINTER,           // p
+    DLOG_ARG_WIDTH,             // '*' width, an int
+    DLOG_ARG_PRECISION          // '*' precision, an int (bounds a following %s copy)
+} dlog_arg_type_t;
+
+typedef union {
+    int32_t i;
+    int64_t ll;
+    double d;
+    const void* p;
+    uint32_t str_offset;        // DLOG_ARG_STRING: offset in the string area
+} dlog_value_t;
+
+/* Ring record: header, arg_count values, then str_len bytes of NUL-terminated strings */
+typedef struct {
+    const dlog_site_t* site;
+    uint32_t timestamp_ms;
+    uint16_t suppressed;
+    uint8_t arg_count;
+    uint8_t str_len;
+    dlog_value_t args[];
+} dlog_record_t;
+
+/* STATIC VARIABLES ----------------------------------------------------------*/
+static const char *TAG = "DLOG";
+
+static RingbufHandle_t s_ring = NULL;
+static volatile dlog_mode_t s_mode = DLOG_MODE_DEFERRED;
+static dlog_stats_t s_stats;
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+
+/**
+ * @brief Length of the conversion spec at fmt ('%' included), 0 if unsupported
+ */
+static int dlog_spec_length(const char* fmt, dlog_arg_type_t* type, dlog_arg_type_t stars[2], int* star_count)
+{
+    const char* p = fmt + 1;
+    int longs = 0;
+    *star_count = 0;
+
+    while (*p && strchr("-+ #0", *p)) p++;
+    if (*p == '*')
+    {
+        stars[(*star_count)++] = DLOG_ARG_WIDTH;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.')
+    {
+        p++;
+        if (*p == '*')
+        {
+            stars[(*star_count)++] = DLOG_ARG_PRECISION;
+            p++;
+        }
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    while (*p && strchr("hlzjt", *p))
+    {
+        longs += (*p == 'l' || *p == 'j');
+        p++;
+    }
+
+    switch (*p)
+    {
+    case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+        // int and long are both 32-bit on the ESP32 targets
+        *type = (longs >= 2 || (longs == 1 && sizeof(long) == 8)) ? DLOG_ARG_INT64 : DLOG_ARG_INT;
+        break;
+    case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+        *type = DLOG_ARG_DOUBLE;
+        break;
+    case 's':
+        *type = DLOG_ARG_STRING;
+        break;
+    case 'p':
+        *type = DLOG_ARG_POINTER;
+        break;
+    default:
+        return 0;
+    }
+    return (int)(p - fmt) + 1;
+}
+
+/**
+ * @brief Derive the argument types of a call site once
+ */
+static void dlog_parse_site(dlog_site_t* site)
+{
+    int count = 0;
+
+    for (const char* p = site->fmt; *p; p++)
+    {
+        if (*p != '%')
+        {
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            p++;
+            continue;
+        }
+
+        dlog_arg_type_t type;
+        dlog_arg_type_t star_types[2];
+        int stars;
+        int len = dlog_spec_length(p, &type, star_types, &stars);
+        if (len == 0 || count + stars + 1 > DLOG_MAX_ARGS)
+        {
+            site->arg_count = DLOG_SITE_UNSUPPORTED;
+            return;
+        }
+
+        for (int s = 0; s < stars; s++)
+        {
+            site->arg_types[count++] = star_types[s];
+        }
+        site->arg_types[count++] = type;
+        p += len - 1;
+    }
+
+    site->arg_count = count;
+}
+
+/**
+ * @brief Print in ESP_LOGx layout, with the timestamp of the original call
+ */
+static void dlog_emit(esp_log_level_t level, const char* tag, uint32_t timestamp_ms,
+                      const char* message, uint32_t suppressed)
+{
+    static const char letters[] = "NEWIDV";
+
+    if (suppressed)
+    {
+        esp_log_write(level, tag, "%c (%lu) %s: %s (+%lu suppressed)\n", letters[level],
+                      (unsigned long)timestamp_ms, tag, message, (unsigned long)suppressed);
+    }
+    else
+    {
+        esp_log_write(level, tag, "%c (%lu) %s: %s\n", letters[level],
+                      (unsigned long)timestamp_ms, tag, message);
+    }
+}
+
+/**
+ * @brief Format a record back into text using the site's format string
+ */
+static void dlog_format(const dlog_record_t* rec, char* out, size_t size)
+{
+    const char* strings = (const char*)&rec->args[rec->arg_count];
+    const dlog_site_t* site = rec->site;
+    size_t len = 0;
+    int arg = 0;
+
+    for (const char* p = site->fmt; *p && len < size - 1; p++)
+    {
+        if (*p != '%')
+        {
+            out[len++] = *p;
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            out[len++] = '%';
+            p++;
+            continue;
+        }
+
+        dlog_arg_type_t type;
+        dlog_arg_type_t star_types[2];
+        int stars;
+        int spec_len = dlog_spec_length(p, &type, star_types, &stars);
+        char spec[16];
+        if (spec_len >= (int)sizeof(spec))
+        {
+            break;
+        }
+        memcpy(spec, p, spec_len);
+        spec[spec_len] = '\0';
+        p += spec_len - 1;
+
+        // Ring items are only 4-byte aligned: copy values out before use
+        dlog_value_t value;
+        int star[2] = {0, 0};
+        for (int s = 0; s < stars; s++)
+        {
+            memcpy(&value, &rec->args[arg++], sizeof(value));
+            star[s] = value.i;
+        }
+        memcpy(&value, &rec->args[arg++], sizeof(value));
+        const dlog_value_t* v = &value;
+        char* dst = out + len;
+        size_t room = size - len;
+        int n;
+
+        // Same conversion, re-run with the recorded value and 0-2 '*' arguments
+#define DLOG_SNPRINTF(value) \
+        (stars == 0 ? snprintf(dst, room, spec, value) : \
+         stars == 1 ? snprintf(dst, room, spec, star[0], value) : \
+                      snprintf(dst, room, spec, star[0], star[1], value))
+        switch (type)
+        {
+        case DLOG_ARG_INT64:    n = DLOG_SNPRINTF(v->ll); break;
+        case DLOG_ARG_DOUBLE:   n = DLOG_SNPRINTF(v->d); break;
+        case DLOG_ARG_STRING:   n = DLOG_SNPRINTF(strings + v->str_offset); break;
+        case DLOG_ARG_POINTER:  n = DLOG_SNPRINTF(v->p); break;
+        default:                n = DLOG_SNPRINTF(v->i); break;
+        }
+#undef DLOG_SNPRINTF
+
+        if (n < 0)
+        {
+            break;
+        }
+        len += ((size_t)n < room) ? (size_t)n : room - 1;
+    }
+
+    out[len] = '\0';
+}
+
+/**
+ * @brief Formatter task: drains the ring at low priority
+ */
+static void dlog_task(void *pvParameters)
+{
+    static char message[DLOG_MAX_LINE];
+    uint32_t reported_drops = 0;
+
+    while (1)
+    {
+        size_t size;
+        dlog_record_t* rec = (dlog_record_t*)xRingbufferReceive(s_ring, &size, pdMS_TO_TICKS(1000));
+
+        if (rec)
+        {
+            const dlog_site_t* site = rec->site;
+            if (site->level <= esp_log_level_get(site->tag))
+            {
+                dlog_format(rec, message, sizeof(message));
+                dlog_emit(site->level, site->tag, rec->timestamp_ms, message, rec->suppressed);
+            }
+            vRingbufferReturnItem(s_ring, rec);
+            s_stats.formatted++;
+        }
+
+        if (s_stats.dropped != reported_drops)
+        {
+            ESP_LOGW(TAG, "%lu record(s) dropped, ring full",
+                     (unsigned long)(s_stats.dropped - reported_drops));
+            reported_drops = s_stats.dropped;
+        }
+    }
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+bool DeferredLog_Init(void)
+{
+    if (s_ring)
+    {
+        return true;
+    }
+
+    s_ring = xRingbufferCreate(CONFIG_DEFERRED_LOG_RING_SIZE, RINGBUF_TYPE_NOSPLIT);
+    if (!s_ring)
+    {
+        ESP_LOGE(TAG, "Failed to create record ring");
+        return false;
+    }
+
+    int core = CONFIG_DEFERRED_LOG_TASK_CORE;
+    if (core < 0 || core >= portNUM_PROCESSORS)
+    {
+        core = tskNO_AFFINITY;
+    }
+
+    if (xTaskCreatePinnedToCore(dlog_task, "dlog", 3072, NULL,
+                                CONFIG_DEFERRED_LOG_TASK_PRIORITY, NULL, core) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to create formatter task");
+        vRingbufferDelete(s_ring);
+        s_ring = NULL;
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Deferred log ready: %d byte ring", CONFIG_DEFERRED_LOG_RING_SIZE);
+    return true;
+}
+
+void DeferredLog_Write(dlog_site_t* site, const char* tag, ...)
+{
+    dlog_mode_t mode = s_mode;
+    if (mode == DLOG_MODE_OFF)
+    {
+        return;
+    }
+
+    int64_t now_us = esp_timer_get_time();
+
+    // Per call site rate limit (unsynchronized: a race only miscounts)
+    if (site->min_interval_ms && site->last_us &&
+        (now_us - site->last_us) < (int64_t)site->min_interval_ms * 1000)
+    {
+        site->suppressed++;
+        s_stats.suppressed++;
+        return;
+    }
+    site->last_us = now_us;
+    uint32_t suppressed = site->suppressed;
+    site->suppressed = 0;
+
+    if (site->arg_count == -1)
+    {
+        site->tag = tag;
+        dlog_parse_site(site);
+    }
+
+    va_list ap;
+    va_start(ap, tag);
+
+    if (mode == DLOG_MODE_SYNC || !s_ring || site->arg_count < 0)
+    {
+        char message[DLOG_MAX_LINE];
+        vsnprintf(message, sizeof(message), site->fmt, ap);
+        va_end(ap);
+        if (site->level <= esp_log_level_get(tag))
+        {
+            dlog_emit(site->level, tag, (uint32_t)(now_us / 1000), message, suppressed);
+        }
+        return;
+    }
+
+    // Header, values and strings are built on the stack, then copied into the ring once
+    uint8_t buf[sizeof(dlog_record_t) + DLOG_MAX_ARGS * sizeof(dlog_value_t) + DLOG_MAX_STRING]
+        __attribute__((aligned(8)));
+    dlog_record_t* rec = (dlog_record_t*)buf;
+    char* strings = (char*)&rec->args[site->arg_count];
+    size_t str_len = 0;
+    int precision = -1;
+
+    rec->site = site;
+    rec->timestamp_ms = (uint32_t)(now_us / 1000);
+    rec->suppressed = suppressed > UINT16_MAX ? UINT16_MAX : (uint16_t)suppressed;
+    rec->arg_count = (uint8_t)site->arg_count;
+
+    for (int i = 0; i < site->arg_count; i++)
+    {
+        dlog_value_t* v = &rec->args[i];
+
+        switch (site->arg_types[i])
+        {
+        case DLOG_ARG_INT64:
+            v->ll = va_arg(ap, long long);
+            break;
+        case DLOG_ARG_DOUBLE:
+            v->d = va_arg(ap, double);
+            break;
+        case DLOG_ARG_POINTER:
+            v->p = va_arg(ap, const void*);
+            break;
+        case DLOG_ARG_STRING:
+        {
+            // Honour a '*' precision: the argument may not be NUL-terminated
+            const char* s = va_arg(ap, const char*);
+            size_t room = DLOG_MAX_STRING - str_len - 1;
+            size_t n = 0;
+            if (s)
+            {
+                n = strnlen(s, (precision >= 0 && (size_t)precision < room) ? (size_t)precision : room);
+                memcpy(strings + str_len, s, n);
+            }
+            strings[str_len + n] = '\0';
+            v->str_offset = (uint32_t)str_len;
+            str_len += n + 1;
+            break;
+        }
+        default:
+            v->i = va_arg(ap, int);
+            break;
+        }
+        precision = (site->arg_types[i] == DLOG_ARG_PRECISION) ? rec->args[i].i : -1;
+    }
+    va_end(ap);
+
+    rec->str_len = (uint8_t)str_len;
+    size_t size = (size_t)(strings - (char*)rec) + str_len;
+
+    if (xRingbufferSend(s_ring, rec, size, 0) == pdTRUE)
+    {
+        s_stats.recorded++;
+    }
+    else
+    {
+        s_stats.dropped++;
+    }
+}
+
+void DeferredLog_SetMode(dlog_mode_t mode)
+{
+    s_mode = mode;
+}
+
+dlog_mode_t DeferredLog_GetMode(void)
+{
+    return s_mode;
+}
+
+void DeferredLog_GetStats(dlog_stats_t* stats)
+{
+    if (stats)
+    {
+        *stats = s_stats;
+    }
+}
@@ -0,0 +1,116 @@
+/**
+ * @file deferred_log.h
+ * @brief Deferred binary logging for hot paths
+ * 
+ * A DLOGx() call copies its call site pointer, a timestamp and the raw
+ * arguments into a ring buffer; a low-priority task formats and prints them
+ * later in ESP_LOGx layout. Each call site can be rate limited.
+ */
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_log.h"
+
+/* DEFINES -------------------------------------------------------------------*/
+#define DLOG_MAX_ARGS           6       // Conversions (including '*') per format string
+#define DLOG_MAX_STRING         96      // Bytes copied for all %s arguments of one record
+#define DLOG_MAX_LINE           192     // Formatted message length
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef enum {
+    DLOG_MODE_DEFERRED = 0,     // Record now, format in the background task
+    DLOG_MODE_SYNC,             // Format and print in the caller, like ESP_LOGx
+    DLOG_MODE_OFF               // Discard (benchmark baseline)
+} dlog_mode_t;
+
+/**
+ * @brief One per DLOGx() call site, statically allocated by the macro
+ * 
+ * @note The address is the record's format ID
+ */
+typedef struct {
+    const char* fmt;
+    esp_log_level_t level;
+    uint32_t min_interval_ms;   // 0 = no rate limit
+    const char* tag;            // Set on first use (TAG is not a constant expression)
+    int64_t last_us;
+    uint32_t suppressed;        // Calls skipped by the rate limit since the last record
+    int8_t arg_count;           // -1 until the format has been parsed
+    uint8_t arg_types[DLOG_MAX_ARGS];
+} dlog_site_t;
+
+typedef struct {
+    uint32_t recorded;          // Records written to the ring
+    uint32_t dropped;           // Ring full
+    uint32_t suppressed;        // Rate limited
+    uint32_t formatted;         // Printed by the formatter task
+} dlog_stats_t;
+
+/* MACROS --------------------------------------------------------------------*/
+#define DLOG_AT(lvl, tag, interval_ms, format, ...) do {                            \
+        if (LOG_LOCAL_LEVEL >= (lvl))                                               \
+        {                                                                           \
+            static dlog_site_t _dlog_site = {                                       \
+                .fmt = (format), .level = (lvl),                                    \
+                .min_interval_ms = (interval_ms), .arg_count = -1 };                \
+            DeferredLog_Write(&_dlog_site, (tag), ##__VA_ARGS__);                   \
+        }                                                                           \
+    } while (0)
+
+#define DLOGE(tag, format, ...)     DLOG_AT(ESP_LOG_ERROR, tag, 0, format, ##__VA_ARGS__)
+#define DLOGW(tag, format, ...)     DLOG_AT(ESP_LOG_WARN, tag, 0, format, ##__VA_ARGS__)
+#define DLOGI(tag, format, ...)     DLOG_AT(ESP_LOG_INFO, tag, 0, format, ##__VA_ARGS__)
+#define DLOGD(tag, format, ...)     DLOG_AT(ESP_LOG_DEBUG, tag, 0, format, ##__VA_ARGS__)
+
+/* At most one record per interval_ms from this call site; skipped calls are counted */
+#define DLOGW_LIMIT(tag, interval_ms, format, ...)  DLOG_AT(ESP_LOG_WARN, tag, interval_ms, format, ##__VA_ARGS__)
+#define DLOGI_LIMIT(tag, interval_ms, format, ...)  DLOG_AT(ESP_LOG_INFO, tag, interval_ms, format, ##__VA_ARGS__)
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+
+/**
+ * @brief Create the record ring and start the formatter task
+ * 
+ * @note Until this is called DLOGx() prints synchronously
+ * 
+ * @return true if successful
+ */
+bool DeferredLog_Init(void);
+
+/**
+ * @brief Record one log call (use the DLOGx macros)
+ * 
+ * @note Supports d i u x X o c p s f e g a with flags, width, precision ('*' too)
+ *       and h/l/ll/z/j/t length modifiers. Formats with anything else print synchronously.
+ * 
+ * @param site Call site
+ * @param tag Log tag; the pointer is kept, so it must be static
+ * @param ... Arguments matching site->fmt
+ */
+void DeferredLog_Write(dlog_site_t* site, const char* tag, ...);
+
+/**
+ * @brief Select deferred, synchronous or no logging for all DLOGx sites
+ * 
+ * @param mode New mode
+ */
+void DeferredLog_SetMode(dlog_mode_t mode);
+
+/**
+ * @brief Current mode
+ * 
+ * @return Mode
+ */
+dlog_mode_t DeferredLog_GetMode(void);
+
+/**
+ * @brief Copy the counters
+ * 
+ * @param stats Output
+ */
+void DeferredLog_GetStats(dlog_stats_t* stats);
+
+#endif /* DEFERRED_LOG_H */
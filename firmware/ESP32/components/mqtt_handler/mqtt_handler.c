@@ -6,12 +6,97 @@
 #include "mqtt5_client.h"
 #include "esp_log.h"
 #include "esp_wifi.h"
+#include "esp_timer.h"
+#include "deferred_log.h"
 #include <string.h>
 
 /* STATIC VARIABLES ----------------------------------------------------------*/
 static const char *TAG = "MQTT_HANDLER";
 
 /* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+static void mqtt_mark_ready(mqtt_handler_t *mqtt)
+{
+    mqtt->ready = true;
+    mqtt->ready_latency_us = esp_timer_get_time() - mqtt->connect_start_us;
+    
+    ESP_LOGI(TAG, "MQTT ready #%lu: CONNACK %lld ms, %d SUBACK(s) %lld ms",
+             (unsigned long)mqtt->connect_count,
+             (long long)(mqtt->connack_latency_us / 1000),
+             mqtt->subscription_count,
+             (long long)(mqtt->ready_latency_us / 1000));
+    
+    if (mqtt->ready_callback)
+    {
+        mqtt->ready_callback();
+    }
+}
+
+/**
+ * @brief Clean session: the broker forgot every subscription, send the whole table
+ */
+static void mqtt_resubscribe_all(mqtt_handler_t *mqtt)
+{
+    mqtt->pending_subacks = 0;
+    
+    for (int i = 0; i < mqtt->subscription_count; i++)
+    {
+        mqtt_subscription_t *sub = &mqtt->subscriptions[i];
+        sub->subscribed = false;
+        sub->msg_id = MQTT_Handler_Subscribe(mqtt, sub->topic, sub->qos);
+        if (sub->msg_id >= 0)
+        {
+            mqtt->pending_subacks++;
+        }
+    }
+    
+    if (mqtt->pending_subacks == 0)
+    {
+        mqtt_mark_ready(mqtt);
+    }
+}
+
+/**
+ * @brief SUBACK: the payload holds one return code per topic, 0x80 and up refuse it
+ * 
+ * @note A refused subscription is not counted, so the bridge never turns ready on
+ *       this connection: a bridge deaf to its command topic must not look healthy
+ */
+static void mqtt_handle_suback(mqtt_handler_t *mqtt, esp_mqtt_event_handle_t event)
+{
+    mqtt_subscription_t *sub = NULL;
+    for (int i = 0; i < mqtt->subscription_count; i++)
+    {
+        if (mqtt->subscriptions[i].msg_id == event->msg_id)
+        {
+            sub = &mqtt->subscriptions[i];
+            break;
+        }
+    }
+    
+    for (int i = 0; i < event->data_len; i++)
+    {
+        if ((uint8_t)event->data[i] >= 0x80)
+        {
+            ESP_LOGE(TAG, "Subscription to %s refused (0x%02X), msg_id=%d",
+                     sub ? sub->topic : "?", (uint8_t)event->data[i], event->msg_id);
+            return;
+        }
+    }
+    
+    ESP_LOGI(TAG, "MQTT Subscribed, msg_id=%d", event->msg_id);
+    if (!sub)
+    {
+        return;
+    }
+    sub->subscribed = true;
+    sub->msg_id = -1;
+    
+    if (!mqtt->ready && mqtt->pending_subacks > 0 && --mqtt->pending_subacks == 0)
+    {
+        mqtt_mark_ready(mqtt);
+    }
+}
+
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, 
                                int32_t event_id, void *event_data)
 {
@@ -20,18 +105,28 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
     
     switch (event_id)
     {
+    case MQTT_EVENT_BEFORE_CONNECT:
+        mqtt->connect_start_us = esp_timer_get_time();
+        break;
+        
     case MQTT_EVENT_CONNECTED:
-        ESP_LOGI(TAG, "MQTT Connected");
         mqtt->connected = true;
+        mqtt->ready = false;
+        mqtt->connect_count++;
+        mqtt->connack_latency_us = esp_timer_get_time() - mqtt->connect_start_us;
+        ESP_LOGI(TAG, "MQTT Connected (%lld ms)", (long long)(mqtt->connack_latency_us / 1000));
+        mqtt_resubscribe_all(mqtt);
         break;
         
     case MQTT_EVENT_DISCONNECTED:
         ESP_LOGI(TAG, "MQTT Disconnected");
+        mqtt->disconnect_count++;
         mqtt->connected = false;
+        mqtt->ready = false;
         break;
         
     case MQTT_EVENT_SUBSCRIBED:
-        ESP_LOGI(TAG, "MQTT Subscribed, msg_id=%d", event->msg_id);
+        mqtt_handle_suback(mqtt, event);
         break;
         
     case MQTT_EVENT_UNSUBSCRIBED:
@@ -43,7 +138,7 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
         break;
         
     case MQTT_EVENT_DATA:
-        ESP_LOGI(TAG, "<- MQTT: %.*s = %.*s", 
+        DLOGI(TAG, "<- MQTT: %.*s = %.*s", 
                  event->topic_len, event->topic, 
                  event->data_len, event->data);
         
@@ -72,7 +167,9 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
         
     case MQTT_EVENT_ERROR:
         ESP_LOGE(TAG, "MQTT Error");
+        mqtt->disconnect_count++;
         mqtt->connected = false;
+        mqtt->ready = false;
         break;
         
     default:
@@ -94,7 +191,18 @@ bool MQTT_Handler_Init(mqtt_handler_t *mqtt, const char* broker_url,
     // Initialize structure
     mqtt->client = NULL;
     mqtt->data_callback = callback;
+    mqtt->ready_callback = NULL;
     mqtt->connected = false;
+    mqtt->ready = false;
+    mqtt->subscription_count = 0;
+    mqtt->pending_subacks = 0;
+    mqtt->connect_start_us = 0;
+    mqtt->connack_latency_us = 0;
+    mqtt->ready_latency_us = -1;
+    mqtt->connect_count = 0;
+    mqtt->disconnect_count = 0;
+    mqtt->publish_count = 0;
+    mqtt->publish_failures = 0;
     
     // Generate client ID from MAC
     uint8_t mac[6];
@@ -111,6 +219,7 @@ bool MQTT_Handler_Init(mqtt_handler_t *mqtt, const char* broker_url,
         .network.timeout_ms = 10000,
         .credentials.client_id = mqtt->client_id,
         .session.keepalive = 60,
+        .task.priority = MQTT_TASK_PRIORITY,
     };
     
     // Set credentials if provided
@@ -154,6 +263,8 @@ bool MQTT_Handler_Start(mqtt_handler_t *mqtt)
         return false;
     }
     
+    mqtt->connect_start_us = esp_timer_get_time();
+    
     esp_err_t ret = esp_mqtt_client_start(mqtt->client);
     if (ret != ESP_OK)
     {
@@ -165,6 +276,57 @@ bool MQTT_Handler_Start(mqtt_handler_t *mqtt)
     return true;
 }
 
+bool MQTT_Handler_AddSubscription(mqtt_handler_t *mqtt, const char* topic, int qos)
+{
+    if (!mqtt || !topic || mqtt->subscription_count >= MQTT_MAX_SUBSCRIPTIONS)
+    {
+        return false;
+    }
+    
+    mqtt_subscription_t *sub = &mqtt->subscriptions[mqtt->subscription_count];
+    sub->topic = topic;
+    sub->qos = qos;
+    sub->msg_id = -1;
+    sub->subscribed = false;
+    mqtt->subscription_count++;
+    
+    // Registered after the CONNECTED event: the table is only replayed on the next one
+    if (mqtt->connected)
+    {
+        sub->msg_id = MQTT_Handler_Subscribe(mqtt, topic, qos);
+    }
+    
+    return true;
+}
+
+void MQTT_Handler_SetReadyCallback(mqtt_handler_t *mqtt, mqtt_ready_callback_t callback)
+{
+    if (mqtt)
+    {
+        mqtt->ready_callback = callback;
+    }
+}
+
+int32_t MQTT_Handler_GetReadyLatencyMs(mqtt_handler_t *mqtt)
+{
+    if (!mqtt || !mqtt->ready)
+    {
+        return -1;
+    }
+    return (int32_t)(mqtt->ready_latency_us / 1000);
+}
+
+int MQTT_Handler_DeviceTopic(mqtt_handler_t *mqtt, const char* suffix, char* buffer, size_t size)
+{
+    if (!mqtt || !suffix || !buffer || size == 0)
+    {
+        return -1;
+    }
+    
+    int len = snprintf(buffer, size, MQTT_TOPIC_ROOT "/%s/%s", mqtt->client_id, suffix);
+    return (len < 0 || (size_t)len >= size) ? -1 : len;
+}
+
 int MQTT_Handler_Subscribe(mqtt_handler_t *mqtt, const char* topic, int qos)
 {
     if (!mqtt || !mqtt->client || !topic)
@@ -201,10 +363,12 @@ int MQTT_Handler_Publish(mqtt_handler_t *mqtt, const char* topic,
     int msg_id = esp_mqtt_client_publish(mqtt->client, topic, data, data_len, qos, retain);
     if (msg_id >= 0)
     {
+        mqtt->publish_count++;
         ESP_LOGD(TAG, "Published to %s: %.*s, msg_id=%d", topic, data_len, data, msg_id);
     }
     else
     {
+        mqtt->publish_failures++;
         ESP_LOGE(TAG, "Failed to publish to %s", topic);
     }
     
@@ -216,6 +380,11 @@ bool MQTT_Handler_IsConnected(mqtt_handler_t *mqtt)
     return mqtt ? mqtt->connected : false;
 }
 
+bool MQTT_Handler_IsReady(mqtt_handler_t *mqtt)
+{
+    return mqtt ? mqtt->ready : false;
+}
+
 void MQTT_Handler_Stop(mqtt_handler_t *mqtt)
 {
     if (!mqtt || !mqtt->client)
@@ -241,5 +410,6 @@ void MQTT_Handler_Deinit(mqtt_handler_t *mqtt)
     }
     
     mqtt->connected = false;
+    mqtt->ready = false;
     ESP_LOGI(TAG, "MQTT handler deinitialized");
 }
\ No newline at end of file
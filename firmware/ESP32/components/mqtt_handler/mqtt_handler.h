@@ -6,22 +6,55 @@
 #define MQTT_HANDLER_H
 
 /* INCLUDES ------------------------------------------------------------------*/
+#include <stddef.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include "sdkconfig.h"
 #include "mqtt_client.h"
 
 /* DEFINES -------------------------------------------------------------------*/
 #define MQTT_MAX_TOPIC_LEN      64
 #define MQTT_MAX_DATA_LEN       256
+#define MQTT_MAX_SUBSCRIPTIONS  8
+#define MQTT_TOPIC_ROOT         "esp32"     // Device topics: MQTT_TOPIC_ROOT/<client_id>/<suffix>
+
+/* esp-mqtt client task priority; the core is chosen by CONFIG_MQTT_USE_CORE_x */
+#ifdef CONFIG_BRIDGE_MQTT_TASK_PRIORITY
+#define MQTT_TASK_PRIORITY      CONFIG_BRIDGE_MQTT_TASK_PRIORITY
+#else
+#define MQTT_TASK_PRIORITY      5
+#endif
 
 /* TYPEDEFS ------------------------------------------------------------------*/
 typedef void (*mqtt_data_callback_t)(const char* topic, const char* data, int data_len);
+typedef void (*mqtt_ready_callback_t)(void);
+
+typedef struct {
+    const char* topic;      // Must outlive the handler (string literal or static)
+    int qos;
+    int msg_id;             // SUBSCRIBE sent on the current connection, -1 = none
+    bool subscribed;        // Granted by the broker's SUBACK
+} mqtt_subscription_t;
 
 typedef struct {
     esp_mqtt_client_handle_t client;
     mqtt_data_callback_t data_callback;
+    mqtt_ready_callback_t ready_callback;
     bool connected;
+    bool ready;                 // Connected and every subscription granted
     char client_id[32];
+    
+    mqtt_subscription_t subscriptions[MQTT_MAX_SUBSCRIPTIONS];
+    int subscription_count;
+    int pending_subacks;
+    
+    int64_t connect_start_us;   // Start of the current connection attempt
+    int64_t connack_latency_us; // Attempt start -> CONNACK
+    int64_t ready_latency_us;   // Attempt start -> last SUBACK
+    uint32_t connect_count;
+    uint32_t disconnect_count;  // DISCONNECTED and ERROR events
+    uint32_t publish_count;     // Accepted by esp_mqtt_client_publish()
+    uint32_t publish_failures;  // Refused (not connected, outbox full)
 } mqtt_handler_t;
 
 /* GLOBAL FUNCTIONS ----------------------------------------------------------*/
@@ -51,7 +84,49 @@ bool MQTT_Handler_Init(mqtt_handler_t *mqtt, const char* broker_url,
 bool MQTT_Handler_Start(mqtt_handler_t *mqtt);
 
 /**
- * @brief Subscribe to MQTT topic
+ * @brief Register a topic that is (re)subscribed on every MQTT_EVENT_CONNECTED
+ * 
+ * @param mqtt MQTT handler structure
+ * @param topic Topic filter; the pointer is kept, not copied
+ * @param qos QoS level (0-2)
+ * 
+ * @return true if registered (also subscribed right away when connected)
+ */
+bool MQTT_Handler_AddSubscription(mqtt_handler_t *mqtt, const char* topic, int qos);
+
+/**
+ * @brief Set the callback run once all subscriptions of a connection are granted (a refused one blocks it)
+ * 
+ * @note Runs in the MQTT client task on every (re)connect.
+ * 
+ * @param mqtt MQTT handler structure
+ * @param callback Ready callback (can be NULL)
+ */
+void MQTT_Handler_SetReadyCallback(mqtt_handler_t *mqtt, mqtt_ready_callback_t callback);
+
+/**
+ * @brief Latency of the last connection from attempt start to all SUBACKs
+ * 
+ * @param mqtt MQTT handler structure
+ * 
+ * @return Milliseconds, -1 if not ready yet
+ */
+int32_t MQTT_Handler_GetReadyLatencyMs(mqtt_handler_t *mqtt);
+
+/**
+ * @brief Build a device-scoped topic, MQTT_TOPIC_ROOT/<client_id>/<suffix>
+ * 
+ * @param mqtt MQTT handler structure (initialized, so the client ID exists)
+ * @param suffix Topic below the device level, e.g. "state"
+ * @param buffer Output buffer
+ * @param size Buffer size
+ * 
+ * @return Topic length, -1 if it does not fit
+ */
+int MQTT_Handler_DeviceTopic(mqtt_handler_t *mqtt, const char* suffix, char* buffer, size_t size);
+
+/**
+ * @brief Subscribe to MQTT topic once (not restored after a reconnect)
  * 
  * @param mqtt MQTT handler structure
  * @param topic Topic to subscribe
@@ -85,6 +160,15 @@ int MQTT_Handler_Publish(mqtt_handler_t *mqtt, const char* topic,
  */
 bool MQTT_Handler_IsConnected(mqtt_handler_t *mqtt);
 
+/**
+ * @brief Check if MQTT is connected and every subscription is granted
+ * 
+ * @param mqtt MQTT handler structure
+ * 
+ * @return true if ready
+ */
+bool MQTT_Handler_IsReady(mqtt_handler_t *mqtt);
+
 /**
  * @brief Stop MQTT client
  * 
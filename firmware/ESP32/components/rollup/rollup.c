@@ -0,0 +1,151 @@
+/**
+ * @file rollup.c
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "rollup.h"
+#include <stddef.h>
+#include <string.h>
+
+/* PRIVATE VARIABLES ---------------------------------------------------------*/
+static const uint32_t PERIOD_SECONDS[ROLLUP_PERIOD_COUNT] = {
+    [ROLLUP_1M]  = 60,
+    [ROLLUP_15M] = 15 * 60,
+    [ROLLUP_1H]  = 60 * 60,
+};
+
+static const uint16_t PERIOD_DEPTH[ROLLUP_PERIOD_COUNT] = {
+    [ROLLUP_1M]  = ROLLUP_DEPTH_1M,
+    [ROLLUP_15M] = ROLLUP_DEPTH_15M,
+    [ROLLUP_1H]  = ROLLUP_DEPTH_1H,
+};
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+
+static rollup_bucket_t* history(rollup_t* rollup, rollup_period_t period)
+{
+    switch (period)
+    {
+    case ROLLUP_1M:
+        return rollup->history_1m;
+    case ROLLUP_15M:
+        return rollup->history_15m;
+    default:
+        return rollup->history_1h;
+    }
+}
+
+/**
+ * @brief Move a non-empty open bucket into the history ring, overwriting the oldest when full
+ */
+static void close_bucket(rollup_t* rollup, rollup_period_t period)
+{
+    rollup_bucket_t* open = &rollup->open[period];
+    uint16_t depth = PERIOD_DEPTH[period];
+
+    history(rollup, period)[rollup->head[period]] = *open;
+    rollup->head[period] = (uint16_t)((rollup->head[period] + 1) % depth);
+    if (rollup->count[period] < depth)
+    {
+        rollup->count[period]++;
+    }
+    open->count = 0;
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+
+void Rollup_Init(rollup_t* rollup)
+{
+    memset(rollup, 0, sizeof(*rollup));
+}
+
+uint32_t Rollup_Advance(rollup_t* rollup, int64_t now_ms)
+{
+    uint32_t mask = 0;
+
+    if (now_ms > rollup->last_ms)
+    {
+        rollup->last_ms = now_ms;
+    }
+    int64_t now_s = rollup->last_ms / 1000;
+
+    for (int p = 0; p < ROLLUP_PERIOD_COUNT; p++)
+    {
+        const rollup_bucket_t* open = &rollup->open[p];
+        if (open->count > 0 && now_s >= (int64_t)open->start_s + PERIOD_SECONDS[p])
+        {
+            close_bucket(rollup, (rollup_period_t)p);
+            mask |= 1u << p;
+        }
+    }
+    return mask;
+}
+
+uint32_t Rollup_Add(rollup_t* rollup, int64_t time_ms, const int32_t* values)
+{
+    uint32_t mask = Rollup_Advance(rollup, time_ms);
+    uint32_t time_s = (uint32_t)(rollup->last_ms / 1000);
+
+    for (int p = 0; p < ROLLUP_PERIOD_COUNT; p++)
+    {
+        rollup_bucket_t* open = &rollup->open[p];
+        if (open->count == 0)
+        {
+            open->start_s = time_s - time_s % PERIOD_SECONDS[p];
+            for (int c = 0; c < ROLLUP_CHANNELS; c++)
+            {
+                open->min[c] = values[c];
+                open->max[c] = values[c];
+                open->sum[c] = 0;
+            }
+        }
+        open->count++;
+        for (int c = 0; c < ROLLUP_CHANNELS; c++)
+        {
+            if (values[c] < open->min[c])
+            {
+                open->min[c] = values[c];
+            }
+            if (values[c] > open->max[c])
+            {
+                open->max[c] = values[c];
+            }
+            open->sum[c] += values[c];
+        }
+    }
+    return mask;
+}
+
+uint32_t Rollup_PeriodSeconds(rollup_period_t period)
+{
+    return period < ROLLUP_PERIOD_COUNT ? PERIOD_SECONDS[period] : 0;
+}
+
+int Rollup_Count(const rollup_t* rollup, rollup_period_t period)
+{
+    return period < ROLLUP_PERIOD_COUNT ? rollup->count[period] : 0;
+}
+
+const rollup_bucket_t* Rollup_Get(const rollup_t* rollup, rollup_period_t period, int index)
+{
+    if (index < 0 || index >= Rollup_Count(rollup, period))
+    {
+        return NULL;
+    }
+
+    // The oldest bucket sits at head once the ring is full, at 0 before
+    uint16_t depth = PERIOD_DEPTH[period];
+    int oldest = rollup->count[period] < depth ? 0 : rollup->head[period];
+    return &history((rollup_t*)rollup, period)[(oldest + index) % depth];
+}
+
+int32_t Rollup_Mean(const rollup_bucket_t* bucket, int channel)
+{
+    int64_t sum = bucket->sum[channel];
+    int64_t count = bucket->count;
+
+    if (count == 0)
+    {
+        return 0;
+    }
+    return (int32_t)((sum >= 0 ? sum + count / 2 : sum - count / 2) / count);
+}
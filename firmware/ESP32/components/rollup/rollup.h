@@ -0,0 +1,133 @@
+/**
+ * @file rollup.h
+ * @brief Rolling min/max/mean/count aggregates of a sample stream over fixed periods
+ *
+ * Every sample is folded into one open bucket per period (1 min, 15 min, 1 h).
+ * Buckets are aligned to multiples of their period on the caller's clock, so
+ * four 15 min buckets cover exactly one 1 h bucket. Once the clock passes the
+ * end of an open bucket, the bucket is closed into that period's history, a
+ * ring of the newest ROLLUP_DEPTH_* closed buckets. Empty buckets are skipped,
+ * so gaps (periodic mode off) cost no history.
+ *
+ * Values are integers, round(x * 10^decimals), as in ts_codec; sums are 64-bit,
+ * so no bucket can overflow at any sample rate the STM32 supports.
+ *
+ * Plain C99 on stdint only, no allocation, no float; not thread-safe, so all
+ * calls must come from one task.
+ */
+#ifndef ROLLUP_H
+#define ROLLUP_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define ROLLUP_CHANNELS             2       // Temperature, humidity
+
+// Closed buckets kept per period
+#define ROLLUP_DEPTH_1M             60      // The last hour
+#define ROLLUP_DEPTH_15M            96      // The last day
+#define ROLLUP_DEPTH_1H             48      // The last two days
+#define ROLLUP_MAX_DEPTH            96
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef enum {
+    ROLLUP_1M = 0,
+    ROLLUP_15M,
+    ROLLUP_1H,
+    ROLLUP_PERIOD_COUNT
+} rollup_period_t;
+
+typedef struct {
+    uint32_t start_s;           // Clock at the bucket start, a multiple of the period
+    uint32_t count;             // Samples; 0 = empty
+    int32_t min[ROLLUP_CHANNELS];
+    int32_t max[ROLLUP_CHANNELS];
+    int64_t sum[ROLLUP_CHANNELS];
+} rollup_bucket_t;
+
+typedef struct {
+    rollup_bucket_t open[ROLLUP_PERIOD_COUNT];
+    rollup_bucket_t history_1m[ROLLUP_DEPTH_1M];
+    rollup_bucket_t history_15m[ROLLUP_DEPTH_15M];
+    rollup_bucket_t history_1h[ROLLUP_DEPTH_1H];
+    uint16_t head[ROLLUP_PERIOD_COUNT];     // Next history slot to write
+    uint16_t count[ROLLUP_PERIOD_COUNT];    // Closed buckets held
+    int64_t last_ms;                        // Latest time seen by Add() or Advance()
+} rollup_t;
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+
+/**
+ * @brief Empty all periods
+ *
+ * @param rollup Rollup state
+ */
+void Rollup_Init(rollup_t* rollup);
+
+/**
+ * @brief Fold one sample into the open bucket of every period
+ *
+ * @param rollup Rollup state
+ * @param time_ms Sample time; a time before the latest one seen is taken as that one,
+ *                so a sample never lands in a bucket that is already closed
+ * @param values One value per channel
+ *
+ * @return Bit mask (1 << rollup_period_t) of periods that closed a bucket first
+ */
+uint32_t Rollup_Add(rollup_t* rollup, int64_t time_ms, const int32_t* values);
+
+/**
+ * @brief Close every open bucket whose period has ended by `now_ms`
+ *
+ * @note Call it regularly: without samples, nothing else closes buckets
+ *
+ * @param rollup Rollup state
+ * @param now_ms Current time on the samples' clock
+ *
+ * @return Bit mask (1 << rollup_period_t) of periods that closed a bucket
+ */
+uint32_t Rollup_Advance(rollup_t* rollup, int64_t now_ms);
+
+/**
+ * @brief Period length
+ *
+ * @param period Period
+ *
+ * @return Seconds
+ */
+uint32_t Rollup_PeriodSeconds(rollup_period_t period);
+
+/**
+ * @brief Closed buckets held for a period
+ *
+ * @param rollup Rollup state
+ * @param period Period
+ *
+ * @return Count, at most ROLLUP_DEPTH_* of the period
+ */
+int Rollup_Count(const rollup_t* rollup, rollup_period_t period);
+
+/**
+ * @brief Closed bucket by age
+ *
+ * @param rollup Rollup state
+ * @param period Period
+ * @param index 0 = oldest, Rollup_Count() - 1 = newest
+ *
+ * @return Bucket, NULL if index is out of range
+ */
+const rollup_bucket_t* Rollup_Get(const rollup_t* rollup, rollup_period_t period, int index);
+
+/**
+ * @brief Mean of one channel, rounded to the nearest integer
+ *
+ * @param bucket Non-empty bucket
+ * @param channel Channel
+ *
+ * @return Mean
+ */
+int32_t Rollup_Mean(const rollup_bucket_t* bucket, int channel);
+
+#endif /* ROLLUP_H */
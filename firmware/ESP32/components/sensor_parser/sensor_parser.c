@@ -4,6 +4,7 @@
 /* INCLUDES ------------------------------------------------------------------*/
 #include "sensor_parser.h"
 #include "esp_log.h"
+#include "deferred_log.h"
 #include <string.h>
 #include <stdio.h>
 
@@ -38,12 +39,13 @@ sensor_data_t SensorParser_ParseLine(sensor_parser_t *parser, const char* line)
     
     char mode[16];
     float temp, hum;
+    unsigned long stamp_us;
     
-    // Parse format: "MODE TEMPERATURE HUMIDITY"
-    // Example: "PERIODIC 27.82 85.65" or "SINGLE 27.85 85.69"
-    int parsed = sscanf(line, "%15s %f %f", mode, &temp, &hum);
+    // Parse format: "MODE TEMPERATURE HUMIDITY [@TIMESTAMP_US]"
+    // Example: "PERIODIC 27.82 85.65 @23234871" or "SINGLE 27.85 85.69"
+    int parsed = sscanf(line, "%15s %f %f @%lu", mode, &temp, &hum, &stamp_us);
     
-    if (parsed == 3)
+    if (parsed >= 3)
     {
         // Determine sensor type
         if (strcmp(mode, SENSOR_MODE_SINGLE) == 0)
@@ -57,34 +59,36 @@ sensor_data_t SensorParser_ParseLine(sensor_parser_t *parser, const char* line)
         else
         {
             data.type = SENSOR_TYPE_UNKNOWN;
-            ESP_LOGW(TAG, "Unknown sensor mode: %s", mode);
+            DLOGW_LIMIT(TAG, 1000, "Unknown sensor mode: %s", mode);
             return data;
         }
         
         // Validate temperature range (-40 to 125°C for SHT3X)
         if (temp < -40.0f || temp > 125.0f)
         {
-            ESP_LOGW(TAG, "Temperature out of range: %.2f°C", temp);
+            DLOGW_LIMIT(TAG, 1000, "Temperature out of range: %.2f°C", temp);
             return data;
         }
         
         // Validate humidity range (0 to 100% for SHT3X)
         if (hum < 0.0f || hum > 100.0f)
         {
-            ESP_LOGW(TAG, "Humidity out of range: %.2f%%", hum);
+            DLOGW_LIMIT(TAG, 1000, "Humidity out of range: %.2f%%", hum);
             return data;
         }
         
         data.temperature = temp;
         data.humidity = hum;
+        data.stm32_time_us = (parsed == 4) ? (uint32_t)stamp_us : 0;
+        data.has_timestamp = (parsed == 4);
         data.valid = true;
         
-        ESP_LOGI(TAG, "Parsed %s: T=%.2f°C, H=%.2f%%", 
+        DLOGI(TAG, "Parsed %s: T=%.2f°C, H=%.2f%%", 
                  SensorParser_GetTypeString(data.type), temp, hum);
     } 
     else
     {
-        ESP_LOGW(TAG, "Failed to parse sensor data: %s", line);
+        DLOGW_LIMIT(TAG, 1000, "Failed to parse sensor data: %s", line);
     }
     
     return data;
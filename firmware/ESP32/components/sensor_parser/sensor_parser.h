@@ -24,6 +24,8 @@ typedef struct {
     sensor_type_t type;
     float temperature;
     float humidity;
+    uint32_t stm32_time_us;     // STM32 I2C completion time ("@<us>" field), wraps at 2^32
+    bool has_timestamp;
     bool valid;
 } sensor_data_t;
 
@@ -53,7 +55,7 @@ bool SensorParser_Init(sensor_parser_t *parser,
  * @brief Parse sensor data line
  * 
  * @param parser Sensor parser structure
- * @param line Data line from STM32 (e.g., "SINGLE 27.85 85.69")
+ * @param line Data line from STM32 (e.g., "SINGLE 27.85 85.69 @18234567", timestamp optional)
  * 
  * @return Parsed sensor data structure
  */
@@ -6,6 +6,8 @@
 #include "driver/uart.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "deferred_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
@@ -33,7 +35,8 @@ static void uart_event_task(void *pvParameters)
             {
                 if (!RingBuffer_Put(&uart->rx_buffer, data[i]))
                 {
-                    ESP_LOGW(TAG, "Ring buffer full, data lost");
+                    uart->rx_dropped += len - i;
+                    DLOGW_LIMIT(TAG, 1000, "Ring buffer full, data lost");
                     break;
                 }
             }
@@ -62,6 +65,10 @@ bool STM32_UART_Init(stm32_uart_t *uart, int uart_num, int baud_rate,
     uart->baud_rate = baud_rate;
     uart->tx_pin = tx_pin;
     uart->rx_pin = rx_pin;
+    uart->rx_dropped = 0;
+    uart->line_start_us = 0;
+    uart->lines_received = 0;
+    uart->lines_rejected = 0;
     uart->data_callback = callback;
     uart->initialized = false;
     
@@ -125,10 +132,17 @@ bool STM32_UART_SendCommand(stm32_uart_t *uart, const char* command)
     // FIXED: Longer delay before sending command to ensure STM32 is ready
     vTaskDelay(pdMS_TO_TICKS(50));
     
-    // FIXED: Clear receive buffer before sending new command
-    uart_flush_input(uart->uart_num);
-    RingBuffer_Clear(&uart->rx_buffer);
+    // The receive side is left alone: the ring and line buffer belong to the UART task,
+    // and flushing here spliced the line in progress onto the next one
     
+#if CONFIG_BRIDGE_STM32_WAKE_BYTE
+    // Wake the STM32 from STOP: its UART only runs again once the PLL is back
+    const char wake = STM32_UART_WAKE_BYTE;
+    uart_write_bytes(uart->uart_num, &wake, 1);
+    uart_wait_tx_done(uart->uart_num, pdMS_TO_TICKS(10));
+    vTaskDelay(pdMS_TO_TICKS(STM32_UART_WAKE_DELAY_MS));
+#endif
+
     char cmd_with_lf[STM32_UART_MAX_LINE_LENGTH];
     int len = snprintf(cmd_with_lf, sizeof(cmd_with_lf), "%s\n", command);
     
@@ -169,6 +183,8 @@ void STM32_UART_ProcessData(stm32_uart_t *uart)
             if (line_pos > 0)
             {
                 line_buffer[line_pos] = '\0';
+                uart->line_start_us = esp_timer_get_time();
+                uart->lines_received++;
                 
                 // FIXED: Clean up the line before processing
                 char cleaned_line[STM32_UART_MAX_LINE_LENGTH];
@@ -180,6 +196,10 @@ void STM32_UART_ProcessData(stm32_uart_t *uart)
                         uart->data_callback(cleaned_line);
                     }
                 }
+                else
+                {
+                    uart->lines_rejected++;
+                }
                 
                 line_pos = 0;
             }
@@ -218,7 +238,9 @@ static bool STM32_UART_CleanLine(const char* input, char* output, size_t output_
         // Look for valid sensor mode keywords
         if (!found_valid_start)
         {
-            if (strncmp(src, "SINGLE", 6) == 0 || strncmp(src, "PERIODIC", 8) == 0)
+            if (strncmp(src, "SINGLE", 6) == 0 || strncmp(src, "PERIODIC", 8) == 0 ||
+                strncmp(src, "AGGREGATE", 9) == 0 || strncmp(src, "STATE", 5) == 0 ||
+                strncmp(src, "ACK ", 4) == 0)
             {
                 found_valid_start = true;
             }
@@ -243,7 +265,7 @@ static bool STM32_UART_CleanLine(const char* input, char* output, size_t output_
     // Check if we found a valid line
     if (!found_valid_start || dst_pos == 0)
     {
-        ESP_LOGW(TAG, "No valid data found in line: %s", input);
+        DLOGW_LIMIT(TAG, 1000, "No valid data found in line: %s", input);
         return false;
     }
     
@@ -259,29 +281,36 @@ static bool STM32_UART_CleanLine(const char* input, char* output, size_t output_
     
     if (space_count < 2)
     {
-        ESP_LOGW(TAG, "Invalid line format (not enough spaces): %s", output);
+        DLOGW_LIMIT(TAG, 1000, "Invalid line format (not enough spaces): %s", output);
         return false;
     }
     
-    ESP_LOGI(TAG, "Cleaned line: '%s' -> '%s'", input, output);
+    DLOGI(TAG, "Cleaned line: '%s' -> '%s'", input, output);
     return true;
 }
 
 bool STM32_UART_StartTask(stm32_uart_t *uart)
+{
+    return STM32_UART_StartTaskPinned(uart, STM32_UART_TASK_PRIORITY, tskNO_AFFINITY);
+}
+
+bool STM32_UART_StartTaskPinned(stm32_uart_t *uart, int priority, int core_id)
 {
     if (!uart || !uart->initialized)
     {
         return false;
     }
     
-    BaseType_t ret = xTaskCreate(uart_event_task, "stm32_uart", 4096, uart, 5, NULL);
+    BaseType_t ret = xTaskCreatePinnedToCore(uart_event_task, "stm32_uart", STM32_UART_TASK_STACK,
+                                             uart, priority, NULL, core_id);
     if (ret != pdPASS)
     {
         ESP_LOGE(TAG, "Failed to create UART task");
         return false;
     }
     
-    ESP_LOGI(TAG, "STM32 UART task started");
+    ESP_LOGI(TAG, "STM32 UART task started (priority %d, core %d)",
+             priority, core_id == tskNO_AFFINITY ? -1 : core_id);
     return true;
 }
 
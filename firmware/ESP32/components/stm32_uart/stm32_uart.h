@@ -14,6 +14,14 @@
 /* DEFINES -------------------------------------------------------------------*/
 #define STM32_UART_MAX_LINE_LENGTH  128
 
+/* Lead-in newline that wakes an STM32 sleeping in STOP (CONFIG_BRIDGE_STM32_WAKE_BYTE);
+   it is lost or parsed as an empty line */
+#define STM32_UART_WAKE_BYTE        '\n'
+#define STM32_UART_WAKE_DELAY_MS    10
+
+#define STM32_UART_TASK_STACK       4096
+#define STM32_UART_TASK_PRIORITY    5
+
 /* TYPEDEFS ------------------------------------------------------------------*/
 typedef void (*stm32_data_callback_t)(const char* line);
 
@@ -24,6 +32,10 @@ typedef struct {
     int rx_pin;
     ring_buffer_t rx_buffer;
     stm32_data_callback_t data_callback;
+    uint32_t rx_dropped;        // Bytes lost because the ring buffer was full
+    int64_t line_start_us;      // esp_timer time the current line's terminator was read
+    uint32_t lines_received;    // Complete lines assembled
+    uint32_t lines_rejected;    // Lines refused by the cleaner
     bool initialized;
 } stm32_uart_t;
 
@@ -70,6 +82,17 @@ void STM32_UART_ProcessData(stm32_uart_t *uart);
  */
 bool STM32_UART_StartTask(stm32_uart_t *uart);
 
+/**
+ * @brief Start STM32 UART processing task with explicit priority and core
+ * 
+ * @param uart STM32 UART structure
+ * @param priority FreeRTOS task priority
+ * @param core_id Core to pin the task to, or tskNO_AFFINITY
+ * 
+ * @return true if successful
+ */
+bool STM32_UART_StartTaskPinned(stm32_uart_t *uart, int priority, int core_id);
+
 /**
  * @brief Deinitialize STM32 UART
  * 
@@ -0,0 +1,201 @@
+/**
+ * @file ts_codec.c
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "ts_codec.h"
+#include <string.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define VARINT_MAX_BYTES        10
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+
+/**
+ * @brief Map signed to unsigned so that small magnitudes give small numbers (0, -1, 1, -2 -> 0, 1, 2, 3)
+ */
+static uint64_t zigzag_encode(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t zigzag_decode(uint64_t value)
+{
+    return (int64_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+/**
+ * @brief Append an LEB128 varint, 7 bits per byte, setting overflow instead of writing past the buffer
+ */
+static void put_varint(ts_encoder_t* encoder, uint64_t value)
+{
+    uint8_t out[VARINT_MAX_BYTES];
+    size_t length = 0;
+
+    while (value >= 0x80)
+    {
+        out[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+
+    if (encoder->overflow || length > encoder->size - encoder->length)
+    {
+        encoder->overflow = true;
+        return;
+    }
+    memcpy(encoder->buffer + encoder->length, out, length);
+    encoder->length += length;
+}
+
+/**
+ * @brief Read an LEB128 varint of at most 10 bytes
+ */
+static bool get_varint(ts_decoder_t* decoder, uint64_t* value)
+{
+    uint64_t result = 0;
+
+    for (unsigned shift = 0; shift < 7 * VARINT_MAX_BYTES; shift += 7)
+    {
+        if (decoder->pos >= decoder->end)
+        {
+            return false;
+        }
+        uint8_t byte = *decoder->pos++;
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+        {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+bool TSCodec_EncoderInit(ts_encoder_t* encoder, uint8_t* buffer, size_t size,
+                         uint8_t channels, uint8_t decimals, uint32_t sequence)
+{
+    memset(encoder, 0, sizeof(*encoder));
+    if (channels == 0 || channels > TS_CODEC_MAX_CHANNELS)
+    {
+        return false;
+    }
+
+    encoder->buffer = buffer;
+    encoder->size = size;
+    encoder->channels = channels;
+
+    // Header bytes are below 0x80, so each is a one-byte varint
+    put_varint(encoder, TS_CODEC_FORMAT);
+    put_varint(encoder, channels);
+    put_varint(encoder, decimals & 0x7F);
+    put_varint(encoder, sequence);
+    return true;
+}
+
+void TSCodec_Append(ts_encoder_t* encoder, int64_t time, const int32_t* values)
+{
+    // Differences in uint64_t/uint32_t: wrap instead of overflowing, and the decoder wraps back
+    if (encoder->count == 0)
+    {
+        put_varint(encoder, zigzag_encode(time));
+    }
+    else
+    {
+        int64_t delta = (int64_t)((uint64_t)time - (uint64_t)encoder->time);
+        if (encoder->count == 1)
+        {
+            put_varint(encoder, zigzag_encode(delta));
+        }
+        else
+        {
+            put_varint(encoder, zigzag_encode((int64_t)((uint64_t)delta - (uint64_t)encoder->delta)));
+        }
+        encoder->delta = delta;
+    }
+    encoder->time = time;
+
+    for (uint8_t c = 0; c < encoder->channels; c++)
+    {
+        int32_t diff = (int32_t)((uint32_t)values[c] - (uint32_t)encoder->value[c]);
+        put_varint(encoder, zigzag_encode(diff));
+        encoder->value[c] = values[c];
+    }
+    encoder->count++;
+}
+
+int TSCodec_EncoderLength(const ts_encoder_t* encoder)
+{
+    return encoder->overflow ? -1 : (int)encoder->length;
+}
+
+bool TSCodec_DecoderInit(ts_decoder_t* decoder, const uint8_t* data, size_t length)
+{
+    uint64_t format, channels, decimals, sequence;
+
+    memset(decoder, 0, sizeof(*decoder));
+    decoder->pos = data;
+    decoder->end = data + length;
+
+    if (!get_varint(decoder, &format) || format != TS_CODEC_FORMAT ||
+        !get_varint(decoder, &channels) || channels == 0 || channels > TS_CODEC_MAX_CHANNELS ||
+        !get_varint(decoder, &decimals) ||
+        !get_varint(decoder, &sequence) || sequence > UINT32_MAX)
+    {
+        decoder->error = true;
+        return false;
+    }
+
+    decoder->channels = (uint8_t)channels;
+    decoder->decimals = (uint8_t)decimals;
+    decoder->sequence = (uint32_t)sequence;
+    return true;
+}
+
+bool TSCodec_Next(ts_decoder_t* decoder, int64_t* time, int32_t* values)
+{
+    uint64_t raw;
+
+    if (decoder->error || decoder->pos >= decoder->end)
+    {
+        return false;
+    }
+
+    if (!get_varint(decoder, &raw))
+    {
+        decoder->error = true;
+        return false;
+    }
+    if (decoder->count == 0)
+    {
+        decoder->time = zigzag_decode(raw);
+    }
+    else
+    {
+        if (decoder->count == 1)
+        {
+            decoder->delta = zigzag_decode(raw);
+        }
+        else
+        {
+            decoder->delta = (int64_t)((uint64_t)decoder->delta + (uint64_t)zigzag_decode(raw));
+        }
+        decoder->time = (int64_t)((uint64_t)decoder->time + (uint64_t)decoder->delta);
+    }
+
+    for (uint8_t c = 0; c < decoder->channels; c++)
+    {
+        // A value delta is a zigzag int32: anything above 32 bits is corrupt
+        if (!get_varint(decoder, &raw) || raw > UINT32_MAX)
+        {
+            decoder->error = true;
+            return false;
+        }
+        decoder->value[c] = (int32_t)((uint32_t)decoder->value[c] + (uint32_t)zigzag_decode(raw));
+        values[c] = decoder->value[c];
+    }
+
+    *time = decoder->time;
+    decoder->count++;
+    return true;
+}
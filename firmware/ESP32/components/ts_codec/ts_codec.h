@@ -0,0 +1,124 @@
+/**
+ * @file ts_codec.h
+ * @brief Delta/varint compression for blocks of timestamped fixed-point samples
+ *
+ * Consecutive SHT3X readings differ by a few hundredths, and periodic samples
+ * arrive at an almost constant interval. A block therefore stores:
+ *
+ *   header   u8 format (TS_CODEC_FORMAT) | u8 channels | u8 decimals | varint sequence
+ *   record   time | one value per channel
+ *
+ * - time: record 0 as a zigzag varint, record 1 as the delta from record 0,
+ *   then the delta-of-delta (jitter around the sample interval)
+ * - value: record 0 as a zigzag varint, then the delta from the previous value
+ *   of the same channel
+ *
+ * Values are integers, round(x * 10^decimals); the codec only carries
+ * `decimals` for the consumer. There is no record count: the block ends with
+ * its last record. Deltas wrap in two's complement, so every int64 time and
+ * int32 value sequence round-trips exactly.
+ *
+ * Plain C99 on stdint only, no allocation, no division, no float: the same
+ * file builds for the ESP32, the STM32 (Cortex-M3) and the host.
+ */
+#ifndef TS_CODEC_H
+#define TS_CODEC_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+// First byte of a block: below 0x80 (not CBOR) and not printable (not text or JSON)
+#define TS_CODEC_FORMAT             0x01
+#define TS_CODEC_MAX_CHANNELS       4
+
+// Worst case: 3 + 5 header bytes, 10 bytes of time and 5 per value for every record
+#define TS_CODEC_MAX_SIZE(channels, records) \
+    (8 + (size_t)(records) * (10 + 5 * (size_t)(channels)))
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef struct {
+    uint8_t* buffer;
+    size_t size;
+    size_t length;
+    bool overflow;              // Set by the first write that did not fit; later writes are ignored
+    uint8_t channels;
+    uint32_t count;             // Records appended
+    int64_t time;               // Previous record's time
+    int64_t delta;              // Previous time delta
+    int32_t value[TS_CODEC_MAX_CHANNELS];
+} ts_encoder_t;
+
+typedef struct {
+    const uint8_t* pos;
+    const uint8_t* end;
+    bool error;                 // Malformed block; Next() returns false from then on
+    uint8_t channels;
+    uint8_t decimals;
+    uint32_t sequence;
+    uint32_t count;             // Records decoded
+    int64_t time;
+    int64_t delta;
+    int32_t value[TS_CODEC_MAX_CHANNELS];
+} ts_decoder_t;
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+
+/**
+ * @brief Start a block and write its header
+ *
+ * @param encoder Encoder
+ * @param buffer Output buffer, TS_CODEC_MAX_SIZE() bytes always suffice
+ * @param size Buffer size
+ * @param channels Values per record, 1..TS_CODEC_MAX_CHANNELS
+ * @param decimals Fixed-point decimals of the values, passed to the consumer
+ * @param sequence Block number, passed to the consumer
+ *
+ * @return false if channels is out of range
+ */
+bool TSCodec_EncoderInit(ts_encoder_t* encoder, uint8_t* buffer, size_t size,
+                         uint8_t channels, uint8_t decimals, uint32_t sequence);
+
+/**
+ * @brief Append one record
+ *
+ * @param encoder Encoder
+ * @param time Record time (any unit, usually microseconds)
+ * @param values One value per channel
+ */
+void TSCodec_Append(ts_encoder_t* encoder, int64_t time, const int32_t* values);
+
+/**
+ * @brief Bytes written so far
+ *
+ * @param encoder Encoder
+ *
+ * @return Length, -1 if anything did not fit
+ */
+int TSCodec_EncoderLength(const ts_encoder_t* encoder);
+
+/**
+ * @brief Start reading a block and parse its header
+ *
+ * @param decoder Decoder
+ * @param data Block
+ * @param length Block length
+ *
+ * @return false if the header is malformed or of another format
+ */
+bool TSCodec_DecoderInit(ts_decoder_t* decoder, const uint8_t* data, size_t length);
+
+/**
+ * @brief Read the next record
+ *
+ * @param decoder Decoder
+ * @param time Receives the record time
+ * @param values Receives decoder->channels values
+ *
+ * @return false at the end of the block or on malformed data (decoder->error)
+ */
+bool TSCodec_Next(ts_decoder_t* decoder, int64_t* time, int32_t* values);
+
+#endif /* TS_CODEC_H */
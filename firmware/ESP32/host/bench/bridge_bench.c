@@ -0,0 +1,522 @@
+/**
+ * @file bridge_bench.c
+ * @brief Load generator for the host bridge: STM32 lines into the pty, MQTT messages out
+ *
+ * Writes "PERIODIC <t> <h> @<us>" lines at a fixed rate (or as fast as the pty
+ * takes them) and subscribes to the periodic temperature and trace topics.
+ * Traces are read as JSON or, from a bridge run with "-e cbor", as CBOR.
+ * The line timestamp is the low 32 bits of CLOCK_MONOTONIC in microseconds,
+ * the same clock the host bridge uses for rx_us/pub_us, so every hop of the
+ * trace is measured without offset estimation:
+ *
+ *   uart   = rx_us  - line written      (pty, UART task poll, line assembly)
+ *   bridge = pub_us - rx_us             (parse, pipeline queue, publisher task)
+ *   broker = received - pub_us          (MQTT client, broker, subscriber socket)
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include "host.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "mqtt_client.h"
+#include "cbor_codec.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define TOPIC_PERIODIC_TEMPERATURE  "sensor/sht3x/periodic/temperature"   // Below esp32/<client_id>/
+#define TOPIC_TRACE                 "sensor/sht3x/trace"
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef enum {
+    HOP_UART = 0,
+    HOP_BRIDGE,
+    HOP_BROKER,
+    HOP_TOTAL,
+    HOP_COUNT
+} hop_t;
+
+typedef struct {
+    int64_t* values;
+    size_t count;
+    size_t capacity;
+} series_t;
+
+/* VARIABLES -----------------------------------------------------------------*/
+host_config_t g_host = {
+    .broker_url = "mqtt://127.0.0.1:1883",
+    .log_level = ESP_LOG_WARN,
+};
+
+/* STATIC VARIABLES ----------------------------------------------------------*/
+static const char* const HOP_NAMES[HOP_COUNT] = { "uart", "bridge", "broker", "total" };
+
+static pthread_mutex_t s_lock = PTHREAD_MUTEX_INITIALIZER;
+static series_t s_hops[HOP_COUNT];
+static uint64_t s_received = 0;
+static uint64_t s_traces = 0;
+static int64_t s_first_rx_us = 0;
+static int64_t s_last_rx_us = 0;
+static volatile bool s_ready = false;
+static char s_topic_periodic[64];
+static char s_topic_trace[64];
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+static void series_push(series_t* s, int64_t value)
+{
+    if (s->count == s->capacity)
+    {
+        size_t capacity = s->capacity ? s->capacity * 2 : 4096;
+        int64_t* values = realloc(s->values, capacity * sizeof(*values));
+        if (!values)
+        {
+            return;
+        }
+        s->values = values;
+        s->capacity = capacity;
+    }
+    s->values[s->count++] = value;
+}
+
+static int cmp_i64(const void* a, const void* b)
+{
+    int64_t x = *(const int64_t*)a;
+    int64_t y = *(const int64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int64_t series_percentile(const series_t* s, double p)
+{
+    if (s->count == 0)
+    {
+        return 0;
+    }
+    size_t idx = (size_t)ceil(p / 100.0 * (double)s->count);
+    return s->values[idx ? idx - 1 : 0];
+}
+
+/**
+ * @brief Pull an integer field out of the flat trace JSON
+ */
+static bool json_i64(const char* json, const char* key, int64_t* out)
+{
+    char pattern[24];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char* p = strstr(json, pattern);
+    if (!p)
+    {
+        return false;
+    }
+    *out = strtoll(p + strlen(pattern), NULL, 10);
+    return true;
+}
+
+/**
+ * @brief Pull the integer fields out of a CBOR trace map
+ */
+static bool cbor_trace(const uint8_t* data, size_t len, int64_t* stm_us, int64_t* rx_us, int64_t* pub_us)
+{
+    cbor_reader_t reader;
+    cbor_item_t item;
+    int found = 0;
+
+    CBOR_ReaderInit(&reader, data, len);
+    if (!CBOR_Next(&reader, &item) || item.type != CBOR_TYPE_MAP)
+    {
+        return false;
+    }
+
+    size_t pairs = item.count;
+    for (size_t i = 0; i < pairs; i++)
+    {
+        if (!CBOR_Next(&reader, &item))
+        {
+            return false;
+        }
+        int64_t* out = CBOR_TextEquals(&item, "stm_us") ? stm_us :
+                       CBOR_TextEquals(&item, "rx_us") ? rx_us :
+                       CBOR_TextEquals(&item, "pub_us") ? pub_us : NULL;
+        if (!out)
+        {
+            if (!CBOR_Skip(&reader))
+            {
+                return false;
+            }
+            continue;
+        }
+        if (!CBOR_Next(&reader, &item) || (item.type != CBOR_TYPE_UINT && item.type != CBOR_TYPE_NEGINT))
+        {
+            return false;
+        }
+        *out = item.int_value;
+        found++;
+    }
+    return found == 3;
+}
+
+static void on_trace(const char* data, int len, int64_t now_us)
+{
+    int64_t stm_us, rx_us, pub_us;
+
+    if (len > 0 && CBOR_IS_BINARY(data[0]))
+    {
+        if (!cbor_trace((const uint8_t*)data, (size_t)len, &stm_us, &rx_us, &pub_us))
+        {
+            return;
+        }
+    }
+    else if (!json_i64(data, "stm_us", &stm_us) || !json_i64(data, "rx_us", &rx_us) ||
+             !json_i64(data, "pub_us", &pub_us))
+    {
+        return;
+    }
+
+    // Rebuild the full write time from its low 32 bits, within 71 minutes of now
+    int64_t sent_us = now_us - (int64_t)(uint32_t)((uint32_t)now_us - (uint32_t)stm_us);
+
+    pthread_mutex_lock(&s_lock);
+    series_push(&s_hops[HOP_UART], rx_us - sent_us);
+    series_push(&s_hops[HOP_BRIDGE], pub_us - rx_us);
+    series_push(&s_hops[HOP_BROKER], now_us - pub_us);
+    series_push(&s_hops[HOP_TOTAL], now_us - sent_us);
+    s_traces++;
+    pthread_mutex_unlock(&s_lock);
+}
+
+static void mqtt_event_handler(void* arg, const char* base, int32_t id, void* data)
+{
+    (void)arg;
+    (void)base;
+    esp_mqtt_event_t* event = (esp_mqtt_event_t*)data;
+
+    switch ((esp_mqtt_event_id_t)id)
+    {
+    case MQTT_EVENT_CONNECTED:
+        esp_mqtt_client_subscribe(event->client, s_topic_periodic, 0);
+        esp_mqtt_client_subscribe(event->client, s_topic_trace, 0);
+        break;
+
+    case MQTT_EVENT_SUBSCRIBED:
+        s_ready = true;
+        break;
+
+    case MQTT_EVENT_DATA:
+    {
+        int64_t now_us = esp_timer_get_time();
+        int suffix_len = (int)strlen(TOPIC_TRACE);
+        if (event->topic_len > suffix_len &&
+            memcmp(event->topic + event->topic_len - suffix_len, TOPIC_TRACE, suffix_len) == 0)
+        {
+            char json[160];
+            int len = event->data_len < (int)sizeof(json) - 1 ? event->data_len : (int)sizeof(json) - 1;
+            memcpy(json, event->data, len);
+            json[len] = '\0';
+            on_trace(json, len, now_us);
+        }
+        else
+        {
+            pthread_mutex_lock(&s_lock);
+            if (s_received++ == 0)
+            {
+                s_first_rx_us = now_us;
+            }
+            s_last_rx_us = now_us;
+            pthread_mutex_unlock(&s_lock);
+        }
+        break;
+    }
+
+    default:
+        break;
+    }
+}
+
+static void sleep_until_us(int64_t deadline_us)
+{
+    struct timespec ts = {
+        .tv_sec = deadline_us / 1000000,
+        .tv_nsec = (deadline_us % 1000000) * 1000,
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+}
+
+/**
+ * @brief Discard what the bridge sends to the STM32, so its writes never block
+ */
+static void drain_commands(int fd)
+{
+    char scratch[256];
+    while (read(fd, scratch, sizeof(scratch)) > 0)
+    {
+    }
+}
+
+static bool write_all(int fd, const char* data, size_t len)
+{
+    while (len)
+    {
+        ssize_t n = write(fd, data, len);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EAGAIN)
+            {
+                // Pty full: the bridge is the bottleneck, wait for it
+                usleep(200);
+                drain_commands(fd);
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
+
+/**
+ * @brief "VmRSS:\t  1234 kB" style field of /proc/<pid>/status, in kB; -1 if unavailable
+ */
+static long proc_status_kb(int pid, const char* field)
+{
+    char path[64], line[128];
+    long value = -1;
+    size_t field_len = strlen(field);
+
+    snprintf(path, sizeof(path), "/proc/%d/status", pid);
+    FILE* f = fopen(path, "r");
+    if (!f)
+    {
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f))
+    {
+        if (strncmp(line, field, field_len) == 0 && line[field_len] == ':')
+        {
+            value = strtol(line + field_len + 1, NULL, 10);
+            break;
+        }
+    }
+    fclose(f);
+    return value;
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "Usage: %s --pty PATH [options]\n"
+            "  -b, --broker URL     MQTT broker (default %s)\n"
+            "  -u, --user NAME      MQTT username\n"
+            "  -p, --pass SECRET    MQTT password\n"
+            "  -t, --pty PATH       Pty slave of bridge_host (its --pty-link)\n"
+            "  -d, --device ID      Client id of the bridge, e.g. ESP32_0A1B2C (default any: +)\n"
+            "  -r, --rate N         Lines per second, 0 = as fast as the pty accepts (default 100)\n"
+            "  -n, --count N        Lines to send (default 1000)\n"
+            "  -s, --settle MS      Wait for late messages after the last line (default 2000)\n"
+            "  -P, --pid PID        Report VmRSS/VmHWM of the bridge process\n"
+            "  -j, --json           One JSON line instead of the table\n",
+            prog, g_host.broker_url);
+}
+
+/* MAIN ----------------------------------------------------------------------*/
+int main(int argc, char** argv)
+{
+    static const struct option options[] = {
+        { "broker", required_argument, NULL, 'b' },
+        { "user",   required_argument, NULL, 'u' },
+        { "pass",   required_argument, NULL, 'p' },
+        { "pty",    required_argument, NULL, 't' },
+        { "device", required_argument, NULL, 'd' },
+        { "rate",   required_argument, NULL, 'r' },
+        { "count",  required_argument, NULL, 'n' },
+        { "settle", required_argument, NULL, 's' },
+        { "pid",    required_argument, NULL, 'P' },
+        { "json",   no_argument,       NULL, 'j' },
+        { "help",   no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    const char* pty = NULL;
+    const char* device = "+";
+    const char* user = "";
+    const char* pass = "";
+    double rate = 100;
+    long count = 1000;
+    long settle_ms = 2000;
+    int pid = 0;
+    bool json = false;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "b:u:p:t:d:r:n:s:P:jh", options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'b': g_host.broker_url = optarg; break;
+        case 'u': user = optarg; break;
+        case 'p': pass = optarg; break;
+        case 't': pty = optarg; break;
+        case 'd': device = optarg; break;
+        case 'r': rate = atof(optarg); break;
+        case 'n': count = atol(optarg); break;
+        case 's': settle_ms = atol(optarg); break;
+        case 'P': pid = atoi(optarg); break;
+        case 'j': json = true; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (!pty || count <= 0 || rate < 0)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    snprintf(s_topic_periodic, sizeof(s_topic_periodic), "esp32/%s/" TOPIC_PERIODIC_TEMPERATURE, device);
+    snprintf(s_topic_trace, sizeof(s_topic_trace), "esp32/%s/" TOPIC_TRACE, device);
+
+    int fd = open(pty, O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Cannot open %s: %s\n", pty, strerror(errno));
+        return 1;
+    }
+    drain_commands(fd);
+
+    esp_mqtt_client_config_t config = {
+        .broker.address.uri = g_host.broker_url,
+        .credentials.client_id = "bridge_bench",
+        .credentials.username = user,
+        .credentials.authentication.password = pass,
+        .session.keepalive = 30,
+        .network.reconnect_timeout_ms = 1000,
+    };
+    esp_mqtt_client_handle_t client = esp_mqtt_client_init(&config);
+    if (!client)
+    {
+        return 1;
+    }
+    esp_mqtt_client_register_event(client, MQTT_EVENT_ANY, mqtt_event_handler, NULL);
+    esp_mqtt_client_start(client);
+
+    for (int waited = 0; !s_ready; waited += 10)
+    {
+        if (waited > 10000)
+        {
+            fprintf(stderr, "No SUBACK from %s within 10 s\n", g_host.broker_url);
+            return 1;
+        }
+        usleep(10000);
+    }
+
+    // Send
+    int64_t period_us = rate > 0 ? (int64_t)(1e6 / rate) : 0;
+    int64_t start_us = esp_timer_get_time();
+    long sent = 0;
+    char line[64];
+
+    for (; sent < count; sent++)
+    {
+        if (period_us)
+        {
+            sleep_until_us(start_us + sent * period_us);
+        }
+        float t = 20.0f + (float)(sent % 1000) / 100.0f;
+        float h = 40.0f + (float)(sent % 500) / 25.0f;
+        int len = snprintf(line, sizeof(line), "PERIODIC %.2f %.2f @%lu\r\n", t, h,
+                           (unsigned long)(uint32_t)esp_timer_get_time());
+        if (!write_all(fd, line, (size_t)len))
+        {
+            fprintf(stderr, "Write to %s failed: %s\n", pty, strerror(errno));
+            break;
+        }
+        if ((sent & 63) == 0)
+        {
+            drain_commands(fd);
+        }
+    }
+    int64_t send_end_us = esp_timer_get_time();
+
+    // Settle: stop once nothing new arrived for settle_ms
+    uint64_t last_seen = ~0ull;
+    for (;;)
+    {
+        usleep((useconds_t)settle_ms * 1000);
+        drain_commands(fd);
+        pthread_mutex_lock(&s_lock);
+        uint64_t seen = s_received + s_traces;
+        pthread_mutex_unlock(&s_lock);
+        if (seen == last_seen || s_received >= (uint64_t)sent)
+        {
+            break;
+        }
+        last_seen = seen;
+    }
+
+    long rss_kb = pid ? proc_status_kb(pid, "VmRSS") : -1;
+    long hwm_kb = pid ? proc_status_kb(pid, "VmHWM") : -1;
+    esp_mqtt_client_destroy(client);
+    close(fd);
+
+    // Report
+    pthread_mutex_lock(&s_lock);
+    for (int i = 0; i < HOP_COUNT; i++)
+    {
+        qsort(s_hops[i].values, s_hops[i].count, sizeof(int64_t), cmp_i64);
+    }
+    double send_s = (double)(send_end_us - start_us) / 1e6;
+    double rx_s = s_received > 1 ? (double)(s_last_rx_us - s_first_rx_us) / 1e6 : 0;
+    double loss = sent ? 100.0 * (double)(sent - (long)s_received) / (double)sent : 0;
+
+    if (json)
+    {
+        printf("{\"sent\":%ld,\"received\":%llu,\"traces\":%llu,\"loss_pct\":%.2f,"
+               "\"send_rate\":%.1f,\"rx_rate\":%.1f",
+               sent, (unsigned long long)s_received, (unsigned long long)s_traces, loss,
+               send_s > 0 ? sent / send_s : 0, rx_s > 0 ? (s_received - 1) / rx_s : 0);
+        for (int i = 0; i < HOP_COUNT; i++)
+        {
+            const series_t* s = &s_hops[i];
+            printf(",\"%s_us\":{\"p50\":%lld,\"p95\":%lld,\"p99\":%lld,\"max\":%lld}", HOP_NAMES[i],
+                   (long long)series_percentile(s, 50), (long long)series_percentile(s, 95),
+                   (long long)series_percentile(s, 99), (long long)series_percentile(s, 100));
+        }
+        printf(",\"rss_kb\":%ld,\"hwm_kb\":%ld}\n", rss_kb, hwm_kb);
+    }
+    else
+    {
+        printf("Sent      %ld lines in %.2f s (%.1f lines/s)\n", sent, send_s, send_s > 0 ? sent / send_s : 0);
+        printf("Received  %llu periodic temperature messages (%.1f msg/s), loss %.2f %%\n",
+               (unsigned long long)s_received, rx_s > 0 ? (s_received - 1) / rx_s : 0, loss);
+        printf("Traces    %llu\n", (unsigned long long)s_traces);
+        printf("%-8s %10s %10s %10s %10s   (us)\n", "hop", "p50", "p95", "p99", "max");
+        for (int i = 0; i < HOP_COUNT; i++)
+        {
+            const series_t* s = &s_hops[i];
+            printf("%-8s %10lld %10lld %10lld %10lld\n", HOP_NAMES[i],
+                   (long long)series_percentile(s, 50), (long long)series_percentile(s, 95),
+                   (long long)series_percentile(s, 99), (long long)series_percentile(s, 100));
+        }
+        if (pid)
+        {
+            printf("Bridge    VmRSS %ld kB, VmHWM %ld kB\n", rss_kb, hwm_kb);
+        }
+    }
+    pthread_mutex_unlock(&s_lock);
+
+    return 0;
+}
@@ -0,0 +1,526 @@
+/**
+ * @file payload_bench.c
+ * @brief Text/JSON vs CBOR payloads of the bridge: size and encode/decode time
+ *
+ * Builds every payload the way main/app_main.c does (snprintf for text and
+ * JSON, cbor_codec for CBOR), decodes it the way a C consumer would, checks
+ * that the decoded values match what was encoded, then times both directions.
+ * Run it on the host for relative numbers; the ESP32 is roughly an order of
+ * magnitude slower, with the same ratios.
+ *
+ *   payload_bench [iterations]
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "cbor_codec.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define DEFAULT_ITERATIONS  200000
+#define BATCH_MAX           64
+#define PAYLOAD_SIZE        2048
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef struct {
+    char device[4];
+    char periodic[4];
+    float rate;
+    char repeat[8];
+    char heater[4];
+    char status[8];
+    char group[16];
+    long long timestamp;
+} state_t;
+
+typedef struct {
+    long long seq;
+    long long stm_us;
+    long long rx_us;
+    long long pub_us;
+} trace_t;
+
+typedef struct {
+    int count;
+    long long seq;
+    long long rx_us[BATCH_MAX];
+    float temperature[BATCH_MAX];
+    float humidity[BATCH_MAX];
+} batch_t;
+
+typedef struct {
+    const char* name;
+    int (*encode_text)(char* out, size_t size);
+    int (*encode_cbor)(uint8_t* out, size_t size);
+    int (*decode_text)(const char* in, int len);    // 0 if the decoded values match
+    int (*decode_cbor)(const uint8_t* in, int len);
+} bench_case_t;
+
+/* STATIC VARIABLES ----------------------------------------------------------*/
+static const float SAMPLE = 27.82f;
+static const state_t STATE = { "ON", "ON", 0.5f, "HIGH", "OFF", "0x8010", "lab2", 61234567LL };
+static const trace_t TRACE = { 4242, 23234871, 61234567, 61234990 };
+static batch_t s_batch;
+static volatile float s_sink;           // Keeps decoded values alive under -O2
+
+/* TEXT / JSON ---------------------------------------------------------------*/
+
+static int sample_text(char* out, size_t size)
+{
+    return snprintf(out, size, "%.2f", SAMPLE);
+}
+
+static int sample_text_decode(const char* in, int len)
+{
+    (void)len;
+    float value = strtof(in, NULL);
+    s_sink = value;
+    return fabsf(value - SAMPLE) < 0.006f ? 0 : -1;
+}
+
+static int state_text(char* out, size_t size)
+{
+    // Same format as create_state_message()
+    return snprintf(out, size,
+                    "{\"device\":\"%s\",\"periodic\":\"%s\",\"rate\":%g,\"repeat\":\"%s\","
+                    "\"heater\":\"%s\",\"status\":\"%s\",\"group\":\"%s\",\"timestamp\":%lld}",
+                    STATE.device, STATE.periodic, (double)STATE.rate, STATE.repeat,
+                    STATE.heater, STATE.status, STATE.group, STATE.timestamp);
+}
+
+/**
+ * @brief Locate the value of "key" in a flat JSON object
+ */
+static const char* json_value(const char* json, const char* key)
+{
+    char pattern[24];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char* p = strstr(json, pattern);
+    return p ? p + strlen(pattern) : NULL;
+}
+
+static int json_string(const char* json, const char* key, char* out, size_t size)
+{
+    const char* p = json_value(json, key);
+    if (!p || *p != '"')
+    {
+        return -1;
+    }
+    const char* end = strchr(++p, '"');
+    if (!end || (size_t)(end - p) >= size)
+    {
+        return -1;
+    }
+    memcpy(out, p, end - p);
+    out[end - p] = '\0';
+    return 0;
+}
+
+static int state_text_decode(const char* in, int len)
+{
+    (void)len;
+    state_t s = { 0 };
+    const char* rate = json_value(in, "rate");
+    const char* timestamp = json_value(in, "timestamp");
+
+    if (json_string(in, "device", s.device, sizeof(s.device)) ||
+        json_string(in, "periodic", s.periodic, sizeof(s.periodic)) ||
+        json_string(in, "repeat", s.repeat, sizeof(s.repeat)) ||
+        json_string(in, "heater", s.heater, sizeof(s.heater)) ||
+        json_string(in, "status", s.status, sizeof(s.status)) ||
+        json_string(in, "group", s.group, sizeof(s.group)) || !rate || !timestamp)
+    {
+        return -1;
+    }
+    s.rate = strtof(rate, NULL);
+    s.timestamp = strtoll(timestamp, NULL, 10);
+    s_sink = s.rate;
+
+    return (s.rate == STATE.rate && s.timestamp == STATE.timestamp &&
+            strcmp(s.device, STATE.device) == 0 && strcmp(s.group, STATE.group) == 0) ? 0 : -1;
+}
+
+static int trace_text(char* out, size_t size)
+{
+    return snprintf(out, size, "{\"seq\":%lld,\"stm_us\":%lld,\"rx_us\":%lld,\"pub_us\":%lld}",
+                    TRACE.seq, TRACE.stm_us, TRACE.rx_us, TRACE.pub_us);
+}
+
+static int trace_text_decode(const char* in, int len)
+{
+    (void)len;
+    const char* keys[4] = { "seq", "stm_us", "rx_us", "pub_us" };
+    long long values[4];
+
+    for (int i = 0; i < 4; i++)
+    {
+        const char* p = json_value(in, keys[i]);
+        if (!p)
+        {
+            return -1;
+        }
+        values[i] = strtoll(p, NULL, 10);
+    }
+    s_sink = (float)values[3];
+    return (values[0] == TRACE.seq && values[1] == TRACE.stm_us &&
+            values[2] == TRACE.rx_us && values[3] == TRACE.pub_us) ? 0 : -1;
+}
+
+/**
+ * @brief The 2 x n "%.2f" messages a batch replaces, NUL-separated
+ */
+static int batch_text(char* out, size_t size)
+{
+    int len = 0;
+    for (int i = 0; i < s_batch.count; i++)
+    {
+        len += snprintf(out + len, size - len, "%.2f", s_batch.temperature[i]) + 1;
+        len += snprintf(out + len, size - len, "%.2f", s_batch.humidity[i]) + 1;
+    }
+    return len;
+}
+
+static int batch_text_decode(const char* in, int len)
+{
+    const char* p = in;
+    int errors = 0;
+
+    for (int i = 0; i < s_batch.count && p < in + len; i++)
+    {
+        float t = strtof(p, NULL);
+        p += strlen(p) + 1;
+        float h = strtof(p, NULL);
+        p += strlen(p) + 1;
+        errors += fabsf(t - s_batch.temperature[i]) > 0.006f || fabsf(h - s_batch.humidity[i]) > 0.006f;
+        s_sink = t + h;
+    }
+    return errors ? -1 : 0;
+}
+
+/* CBOR ----------------------------------------------------------------------*/
+
+static int sample_cbor(uint8_t* out, size_t size)
+{
+    cbor_writer_t writer;
+    CBOR_WriterInit(&writer, out, size);
+    CBOR_PutFloat(&writer, SAMPLE);
+    return CBOR_WriterLength(&writer);
+}
+
+static int sample_cbor_decode(const uint8_t* in, int len)
+{
+    cbor_reader_t reader;
+    cbor_item_t item;
+    CBOR_ReaderInit(&reader, in, len);
+    if (!CBOR_Next(&reader, &item) || item.type != CBOR_TYPE_FLOAT)
+    {
+        return -1;
+    }
+    s_sink = (float)item.float_value;
+    return (float)item.float_value == SAMPLE ? 0 : -1;
+}
+
+static int state_cbor(uint8_t* out, size_t size)
+{
+    // Same layout as create_state_cbor()
+    cbor_writer_t writer;
+    CBOR_WriterInit(&writer, out, size);
+    CBOR_PutMap(&writer, 8);
+    CBOR_PutText(&writer, "device");
+    CBOR_PutText(&writer, STATE.device);
+    CBOR_PutText(&writer, "periodic");
+    CBOR_PutText(&writer, STATE.periodic);
+    CBOR_PutText(&writer, "rate");
+    CBOR_PutFloat(&writer, STATE.rate);
+    CBOR_PutText(&writer, "repeat");
+    CBOR_PutText(&writer, STATE.repeat);
+    CBOR_PutText(&writer, "heater");
+    CBOR_PutText(&writer, STATE.heater);
+    CBOR_PutText(&writer, "status");
+    CBOR_PutText(&writer, STATE.status);
+    CBOR_PutText(&writer, "group");
+    CBOR_PutText(&writer, STATE.group);
+    CBOR_PutText(&writer, "timestamp");
+    CBOR_PutUint(&writer, (uint64_t)STATE.timestamp);
+    return CBOR_WriterLength(&writer);
+}
+
+/**
+ * @brief Copy a text item into a NUL-terminated buffer
+ */
+static int cbor_string(const cbor_item_t* item, char* out, size_t size)
+{
+    if (item->type != CBOR_TYPE_TEXT || item->length >= size)
+    {
+        return -1;
+    }
+    memcpy(out, item->text, item->length);
+    out[item->length] = '\0';
+    return 0;
+}
+
+static int state_cbor_decode(const uint8_t* in, int len)
+{
+    cbor_reader_t reader;
+    cbor_item_t key, value;
+    state_t s = { 0 };
+    int errors = 0;
+
+    CBOR_ReaderInit(&reader, in, len);
+    if (!CBOR_Next(&reader, &value) || value.type != CBOR_TYPE_MAP)
+    {
+        return -1;
+    }
+
+    size_t pairs = value.count;
+    for (size_t i = 0; i < pairs; i++)
+    {
+        if (!CBOR_Next(&reader, &key) || !CBOR_Next(&reader, &value))
+        {
+            return -1;
+        }
+        if (CBOR_TextEquals(&key, "device"))         errors += cbor_string(&value, s.device, sizeof(s.device));
+        else if (CBOR_TextEquals(&key, "periodic"))  errors += cbor_string(&value, s.periodic, sizeof(s.periodic));
+        else if (CBOR_TextEquals(&key, "repeat"))    errors += cbor_string(&value, s.repeat, sizeof(s.repeat));
+        else if (CBOR_TextEquals(&key, "heater"))    errors += cbor_string(&value, s.heater, sizeof(s.heater));
+        else if (CBOR_TextEquals(&key, "status"))    errors += cbor_string(&value, s.status, sizeof(s.status));
+        else if (CBOR_TextEquals(&key, "group"))     errors += cbor_string(&value, s.group, sizeof(s.group));
+        else if (CBOR_TextEquals(&key, "rate"))      s.rate = (float)value.float_value;
+        else if (CBOR_TextEquals(&key, "timestamp")) s.timestamp = (long long)value.uint_value;
+    }
+    s_sink = s.rate;
+
+    return (!errors && s.rate == STATE.rate && s.timestamp == STATE.timestamp &&
+            strcmp(s.device, STATE.device) == 0 && strcmp(s.group, STATE.group) == 0) ? 0 : -1;
+}
+
+static int trace_cbor(uint8_t* out, size_t size)
+{
+    // Same layout as publish_trace()
+    cbor_writer_t writer;
+    CBOR_WriterInit(&writer, out, size);
+    CBOR_PutMap(&writer, 4);
+    CBOR_PutText(&writer, "seq");
+    CBOR_PutUint(&writer, (uint64_t)TRACE.seq);
+    CBOR_PutText(&writer, "stm_us");
+    CBOR_PutUint(&writer, (uint64_t)TRACE.stm_us);
+    CBOR_PutText(&writer, "rx_us");
+    CBOR_PutInt(&writer, TRACE.rx_us);
+    CBOR_PutText(&writer, "pub_us");
+    CBOR_PutInt(&writer, TRACE.pub_us);
+    return CBOR_WriterLength(&writer);
+}
+
+static int trace_cbor_decode(const uint8_t* in, int len)
+{
+    cbor_reader_t reader;
+    cbor_item_t key, value;
+    trace_t t = { 0 };
+
+    CBOR_ReaderInit(&reader, in, len);
+    if (!CBOR_Next(&reader, &value) || value.type != CBOR_TYPE_MAP)
+    {
+        return -1;
+    }
+
+    size_t pairs = value.count;
+    for (size_t i = 0; i < pairs; i++)
+    {
+        if (!CBOR_Next(&reader, &key) || !CBOR_Next(&reader, &value) || value.type != CBOR_TYPE_UINT)
+        {
+            return -1;
+        }
+        if (CBOR_TextEquals(&key, "seq"))          t.seq = value.int_value;
+        else if (CBOR_TextEquals(&key, "stm_us"))  t.stm_us = value.int_value;
+        else if (CBOR_TextEquals(&key, "rx_us"))   t.rx_us = value.int_value;
+        else if (CBOR_TextEquals(&key, "pub_us"))  t.pub_us = value.int_value;
+    }
+    s_sink = (float)t.pub_us;
+    return (t.seq == TRACE.seq && t.stm_us == TRACE.stm_us &&
+            t.rx_us == TRACE.rx_us && t.pub_us == TRACE.pub_us) ? 0 : -1;
+}
+
+static int batch_cbor(uint8_t* out, size_t size)
+{
+    // Same layout as encode_sample_batch()
+    cbor_writer_t writer;
+    CBOR_WriterInit(&writer, out, size);
+    CBOR_PutMap(&writer, 5);
+    CBOR_PutText(&writer, "seq");
+    CBOR_PutUint(&writer, (uint64_t)s_batch.seq);
+    CBOR_PutText(&writer, "rx_us");
+    CBOR_PutInt(&writer, s_batch.rx_us[0]);
+    CBOR_PutText(&writer, "dt_us");
+    CBOR_PutArray(&writer, s_batch.count);
+    for (int i = 0; i < s_batch.count; i++)
+    {
+        CBOR_PutInt(&writer, s_batch.rx_us[i] - s_batch.rx_us[0]);
+    }
+    CBOR_PutText(&writer, "temperature");
+    CBOR_PutArray(&writer, s_batch.count);
+    for (int i = 0; i < s_batch.count; i++)
+    {
+        CBOR_PutFloat(&writer, s_batch.temperature[i]);
+    }
+    CBOR_PutText(&writer, "humidity");
+    CBOR_PutArray(&writer, s_batch.count);
+    for (int i = 0; i < s_batch.count; i++)
+    {
+        CBOR_PutFloat(&writer, s_batch.humidity[i]);
+    }
+    return CBOR_WriterLength(&writer);
+}
+
+static int batch_cbor_decode(const uint8_t* in, int len)
+{
+    cbor_reader_t reader;
+    cbor_item_t key, value;
+    long long rx_us = 0;
+    int errors = 0;
+
+    CBOR_ReaderInit(&reader, in, len);
+    if (!CBOR_Next(&reader, &value) || value.type != CBOR_TYPE_MAP)
+    {
+        return -1;
+    }
+
+    size_t pairs = value.count;
+    for (size_t i = 0; i < pairs; i++)
+    {
+        if (!CBOR_Next(&reader, &key) || !CBOR_Next(&reader, &value))
+        {
+            return -1;
+        }
+        if (value.type != CBOR_TYPE_ARRAY)
+        {
+            if (CBOR_TextEquals(&key, "rx_us"))
+            {
+                rx_us = value.int_value;
+            }
+            continue;
+        }
+
+        size_t count = value.count;
+        bool is_dt = CBOR_TextEquals(&key, "dt_us");
+        bool is_temperature = CBOR_TextEquals(&key, "temperature");
+        if ((int)count != s_batch.count)
+        {
+            return -1;
+        }
+        for (size_t j = 0; j < count; j++)
+        {
+            if (!CBOR_Next(&reader, &value))
+            {
+                return -1;
+            }
+            if (is_dt)
+            {
+                errors += (rx_us + value.int_value != s_batch.rx_us[j]);
+            }
+            else
+            {
+                float v = (float)value.float_value;
+                errors += (v != (is_temperature ? s_batch.temperature[j] : s_batch.humidity[j]));
+                s_sink = v;
+            }
+        }
+    }
+    return errors ? -1 : 0;
+}
+
+/* BENCHMARK -----------------------------------------------------------------*/
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void fill_batch(int count)
+{
+    s_batch.count = count;
+    s_batch.seq = 7;
+    for (int i = 0; i < count; i++)
+    {
+        s_batch.rx_us[i] = 61234567LL + i * 100000LL + (i % 3) * 17;
+        s_batch.temperature[i] = 23.5f + (i % 7) * 0.01f;
+        s_batch.humidity[i] = 65.2f - (i % 5) * 0.03f;
+    }
+}
+
+/**
+ * @brief Verify one case, then time its four directions
+ *
+ * @return 0 on success, -1 if a payload did not decode to its input
+ */
+static int run_case(const bench_case_t* c, long iterations)
+{
+    static char text[PAYLOAD_SIZE];
+    static uint8_t cbor[PAYLOAD_SIZE];
+
+    int text_len = c->encode_text(text, sizeof(text));
+    int cbor_len = c->encode_cbor(cbor, sizeof(cbor));
+    if (text_len <= 0 || cbor_len <= 0 ||
+        c->decode_text(text, text_len) != 0 || c->decode_cbor(cbor, cbor_len) != 0)
+    {
+        fprintf(stderr, "%s: round trip failed\n", c->name);
+        return -1;
+    }
+
+    // Payload bytes only: the separators between batch messages are not sent
+    int text_bytes = 0;
+    for (int i = 0; i < text_len; i++)
+    {
+        text_bytes += (text[i] != '\0');
+    }
+
+    double t0 = now_ns();
+    for (long i = 0; i < iterations; i++) c->encode_text(text, sizeof(text));
+    double t1 = now_ns();
+    for (long i = 0; i < iterations; i++) c->encode_cbor(cbor, sizeof(cbor));
+    double t2 = now_ns();
+    for (long i = 0; i < iterations; i++) c->decode_text(text, text_len);
+    double t3 = now_ns();
+    for (long i = 0; i < iterations; i++) c->decode_cbor(cbor, cbor_len);
+    double t4 = now_ns();
+
+    printf("| %s | %d | %d | %.0f | %.0f | %.0f | %.0f |\n", c->name, text_bytes, cbor_len,
+           (t1 - t0) / iterations, (t2 - t1) / iterations, (t3 - t2) / iterations, (t4 - t3) / iterations);
+    return 0;
+}
+
+/* MAIN ----------------------------------------------------------------------*/
+int main(int argc, char** argv)
+{
+    long iterations = argc > 1 ? atol(argv[1]) : DEFAULT_ITERATIONS;
+    if (iterations <= 0)
+    {
+        fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+        return 2;
+    }
+
+    const bench_case_t cases[] = {
+        { "sample", sample_text, sample_cbor, sample_text_decode, sample_cbor_decode },
+        { "state", state_text, state_cbor, state_text_decode, state_cbor_decode },
+        { "trace", trace_text, trace_cbor, trace_text_decode, trace_cbor_decode },
+        { "batch x16", batch_text, batch_cbor, batch_text_decode, batch_cbor_decode },
+        { "batch x64", batch_text, batch_cbor, batch_text_decode, batch_cbor_decode },
+    };
+
+    printf("%ld iterations per case\n\n", iterations);
+    printf("| Payload | Text bytes | CBOR bytes | Text encode ns | CBOR encode ns | Text decode ns | CBOR decode ns |\n");
+    printf("|---------|------------|------------|----------------|----------------|----------------|----------------|\n");
+
+    int failed = 0;
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        fill_batch(strcmp(cases[i].name, "batch x16") == 0 ? 16 : BATCH_MAX);
+        failed |= run_case(&cases[i], iterations);
+    }
+
+    printf("\nThe text side of a batch is the 2 x n \"%%.2f\" messages it replaces.\n");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,252 @@
+/**
+ * @file rollup_bench.c
+ * @brief rollup on the host: bucket checks, then the cost of folding a sample
+ *
+ *   rollup_bench [samples]
+ *
+ * The checks run first and cover what the retained rollup topics rely on:
+ * buckets aligned to multiples of their period, a bucket closing on period
+ * rollover (by a sample or by Rollup_Advance() alone), history ring
+ * wrap-around in Rollup_Get() and Rollup_Mean() rounding of negative sums.
+ * Any failure exits with status 1 before anything is timed.
+ *
+ * The timing feeds a 10 Hz random walk, the STM32's fastest periodic rate,
+ * through Rollup_Add() the way the publisher task does, and a Rollup_Advance()
+ * per simulated second, as its one second wake-up does.
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "rollup.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define DEFAULT_SAMPLES     2000000
+#define SAMPLE_PERIOD_MS    100         // SHT3X PERIODIC 10
+
+#define CHECK(cond)         check((cond), #cond, __LINE__)
+
+/* STATIC VARIABLES ----------------------------------------------------------*/
+static rollup_t s_rollup;               // ~8 KB, as in app_main.c: static, not on the stack
+static int s_failed;
+static uint32_t s_rng = 0x2545F491u;
+static volatile uint32_t s_sink;        // Keeps the loop alive under -O2
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+static void check(int ok, const char* what, int line)
+{
+    if (!ok)
+    {
+        fprintf(stderr, "rollup_bench.c:%d: check failed: %s\n", line, what);
+        s_failed++;
+    }
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t next_random(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint32_t add(int64_t time_ms, int32_t temperature, int32_t humidity)
+{
+    const int32_t values[ROLLUP_CHANNELS] = { temperature, humidity };
+    return Rollup_Add(&s_rollup, time_ms, values);
+}
+
+/**
+ * @brief Buckets start on multiples of their period, whatever the first sample's time
+ */
+static void check_alignment(void)
+{
+    Rollup_Init(&s_rollup);
+    CHECK(add(3725400, 2315, 5120) == 0);
+
+    CHECK(s_rollup.open[ROLLUP_1M].start_s == 3720);
+    CHECK(s_rollup.open[ROLLUP_15M].start_s == 3600);
+    CHECK(s_rollup.open[ROLLUP_1H].start_s == 3600);
+    CHECK(Rollup_PeriodSeconds(ROLLUP_15M) == 900);
+    CHECK(Rollup_PeriodSeconds(ROLLUP_PERIOD_COUNT) == 0);
+}
+
+/**
+ * @brief A bucket closes when the clock reaches its end, with or without a sample
+ */
+static void check_rollover(void)
+{
+    Rollup_Init(&s_rollup);
+
+    // One full minute, 60..119 s: temperature 0..59, humidity constant
+    for (int s = 0; s < 60; s++)
+    {
+        CHECK(add((60 + s) * 1000LL, s, 5000) == 0);
+    }
+    CHECK(Rollup_Count(&s_rollup, ROLLUP_1M) == 0);
+
+    // The first sample of the next minute closes the 1 min bucket only
+    CHECK(add(120000, -100, 4900) == (1u << ROLLUP_1M));
+    CHECK(Rollup_Count(&s_rollup, ROLLUP_1M) == 1);
+    CHECK(Rollup_Count(&s_rollup, ROLLUP_15M) == 0);
+
+    const rollup_bucket_t* b = Rollup_Get(&s_rollup, ROLLUP_1M, 0);
+    CHECK(b != NULL);
+    if (b)
+    {
+        CHECK(b->start_s == 60);
+        CHECK(b->count == 60);
+        CHECK(b->min[0] == 0 && b->max[0] == 59 && b->sum[0] == 59 * 60 / 2);
+        CHECK(b->min[1] == 5000 && b->max[1] == 5000);
+        CHECK(Rollup_Mean(b, 0) == 30);     // 29.5 rounds away from zero
+    }
+
+    // Without samples only Advance() closes buckets, and only once
+    CHECK(Rollup_Advance(&s_rollup, 179999) == 0);
+    CHECK(Rollup_Advance(&s_rollup, 180000) == (1u << ROLLUP_1M));
+    CHECK(Rollup_Advance(&s_rollup, 181000) == 0);
+    CHECK(Rollup_Count(&s_rollup, ROLLUP_1M) == 2);
+
+    // A late sample is taken at the latest time seen, never into a closed bucket
+    CHECK(add(100000, 1, 1) == 0);
+    CHECK(s_rollup.open[ROLLUP_1M].start_s == 180);
+    CHECK(Rollup_Count(&s_rollup, ROLLUP_1M) == 2);
+
+    // 900 s ends the 15 min bucket too; the 1 h one stays open until 3600 s
+    CHECK(Rollup_Advance(&s_rollup, 900000) == ((1u << ROLLUP_1M) | (1u << ROLLUP_15M)));
+    CHECK(Rollup_Count(&s_rollup, ROLLUP_15M) == 1);
+    CHECK(Rollup_Count(&s_rollup, ROLLUP_1H) == 0);
+}
+
+/**
+ * @brief A full history keeps the newest ROLLUP_DEPTH_1M buckets, oldest first
+ */
+static void check_wrap(void)
+{
+    const int minutes = ROLLUP_DEPTH_1M + 6;   // The last one stays open
+    const int dropped = minutes - 1 - ROLLUP_DEPTH_1M;
+
+    Rollup_Init(&s_rollup);
+    for (int m = 0; m < minutes; m++)
+    {
+        add(m * 60000LL, m, -m);
+    }
+
+    CHECK(Rollup_Count(&s_rollup, ROLLUP_1M) == ROLLUP_DEPTH_1M);
+    for (int i = 0; i < ROLLUP_DEPTH_1M; i++)
+    {
+        const rollup_bucket_t* b = Rollup_Get(&s_rollup, ROLLUP_1M, i);
+        if (!b)
+        {
+            CHECK(b != NULL);
+            break;
+        }
+        CHECK(b->start_s == (uint32_t)(dropped + i) * 60);
+        CHECK(b->min[0] == dropped + i && b->min[1] == -(dropped + i));
+    }
+    CHECK(Rollup_Get(&s_rollup, ROLLUP_1M, -1) == NULL);
+    CHECK(Rollup_Get(&s_rollup, ROLLUP_1M, ROLLUP_DEPTH_1M) == NULL);
+
+    // 66 minutes also closed four 15 min buckets and one 1 h bucket, nowhere near full
+    CHECK(Rollup_Count(&s_rollup, ROLLUP_15M) == 4);
+    CHECK(Rollup_Count(&s_rollup, ROLLUP_1H) == 1);
+    CHECK(Rollup_Get(&s_rollup, ROLLUP_15M, 3) != NULL && Rollup_Get(&s_rollup, ROLLUP_15M, 3)->start_s == 2700);
+    CHECK(Rollup_Get(&s_rollup, ROLLUP_15M, 4) == NULL);
+}
+
+/**
+ * @brief Means round half away from zero, for negative sums too
+ */
+static void check_mean(void)
+{
+    static const struct {
+        int64_t sum;
+        uint32_t count;
+        int32_t mean;
+    } CASES[] = {
+        { -5, 2, -3 },      // -2.5
+        { -1, 2, -1 },      // -0.5
+        { -4, 3, -1 },      // -1.33
+        { -5, 3, -2 },      // -1.67
+        { 5, 2, 3 },        // 2.5
+        { 0, 0, 0 },        // Empty bucket
+        { -4631, 2, -2316 },// -2315.5: -23.16 C as in the topic
+    };
+
+    for (size_t i = 0; i < sizeof(CASES) / sizeof(CASES[0]); i++)
+    {
+        rollup_bucket_t b = { .count = CASES[i].count, .sum = { CASES[i].sum, 0 } };
+        if (Rollup_Mean(&b, 0) != CASES[i].mean)
+        {
+            fprintf(stderr, "Rollup_Mean(%lld / %lu) = %ld, expected %ld\n",
+                    (long long)CASES[i].sum, (unsigned long)CASES[i].count,
+                    (long)Rollup_Mean(&b, 0), (long)CASES[i].mean);
+            s_failed++;
+        }
+    }
+
+    // The same through Add(): -23.15 and -23.16 C in one bucket
+    Rollup_Init(&s_rollup);
+    add(0, -2315, 0);
+    add(1000, -2316, 0);
+    add(60000, 0, 0);
+    const rollup_bucket_t* b = Rollup_Get(&s_rollup, ROLLUP_1M, 0);
+    CHECK(b != NULL && Rollup_Mean(b, 0) == -2316);
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+int main(int argc, char** argv)
+{
+    long samples = argc > 1 ? atol(argv[1]) : DEFAULT_SAMPLES;
+    if (samples <= 0)
+    {
+        fprintf(stderr, "Usage: %s [samples]\n", argv[0]);
+        return 2;
+    }
+
+    check_alignment();
+    check_rollover();
+    check_wrap();
+    check_mean();
+    if (s_failed)
+    {
+        fprintf(stderr, "%d check(s) failed\n", s_failed);
+        return 1;
+    }
+    printf("Checks   alignment, rollover, ring wrap, mean rounding: ok\n");
+
+    Rollup_Init(&s_rollup);
+    int32_t temperature = 2300;
+    int32_t humidity = 5200;
+    uint32_t closed = 0;
+
+    double start = now_ns();
+    for (long i = 0; i < samples; i++)
+    {
+        int64_t time_ms = (int64_t)i * SAMPLE_PERIOD_MS;
+        temperature += (int32_t)(next_random() % 5) - 2;
+        humidity += (int32_t)(next_random() % 7) - 3;
+        closed |= add(time_ms, temperature, humidity);
+        if (time_ms % 1000 == 0)
+        {
+            closed |= Rollup_Advance(&s_rollup, time_ms);
+        }
+    }
+    double elapsed = now_ns() - start;
+    s_sink = closed;
+
+    printf("Samples  %ld at %d Hz (%.1f h of sensor time)\n", samples, 1000 / SAMPLE_PERIOD_MS,
+           samples * (double)SAMPLE_PERIOD_MS / 3.6e6);
+    printf("Add      %.1f ns per sample, Advance included\n", elapsed / samples);
+    printf("History  %d x 1 min, %d x 15 min, %d x 1 h buckets; state %zu bytes\n",
+           Rollup_Count(&s_rollup, ROLLUP_1M), Rollup_Count(&s_rollup, ROLLUP_15M),
+           Rollup_Count(&s_rollup, ROLLUP_1H), sizeof(s_rollup));
+    return 0;
+}
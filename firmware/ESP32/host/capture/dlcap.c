@@ -0,0 +1,163 @@
+/**
+ * @file dlcap.c
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "dlcap.h"
+#include <string.h>
+#include <sys/time.h>
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+static void put_le(uint8_t* out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+    {
+        out[i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+static uint64_t get_le(const uint8_t* in, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--)
+    {
+        value = (value << 8) | in[i];
+    }
+    return value;
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+bool DLCap_Create(dlcap_t* cap, const char* path, uint32_t baud_rate)
+{
+    if (!cap || !path)
+    {
+        return false;
+    }
+
+    memset(cap, 0, sizeof(*cap));
+    cap->file = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+    if (!cap->file)
+    {
+        return false;
+    }
+
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    cap->baud_rate = baud_rate;
+    cap->start_unix_us = (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_usec;
+
+    uint8_t header[DLCAP_HEADER_SIZE];
+    memcpy(header, DLCAP_MAGIC, 6);
+    put_le(header + 6, 0, 2);
+    put_le(header + 8, baud_rate, 4);
+    put_le(header + 12, cap->start_unix_us, 8);
+    return fwrite(header, 1, sizeof(header), cap->file) == sizeof(header);
+}
+
+bool DLCap_Write(dlcap_t* cap, uint64_t time_us, const uint8_t* data, size_t len)
+{
+    if (!cap || !cap->file || (!data && len))
+    {
+        return false;
+    }
+
+    do
+    {
+        size_t chunk = len > DLCAP_MAX_RECORD ? DLCAP_MAX_RECORD : len;
+        uint64_t delta = time_us > cap->time_us ? time_us - cap->time_us : 0;
+        uint8_t header[DLCAP_RECORD_HEADER];
+
+        put_le(header, delta > UINT32_MAX ? UINT32_MAX : delta, 4);
+        put_le(header + 4, chunk, 2);
+        if (fwrite(header, 1, sizeof(header), cap->file) != sizeof(header) ||
+            fwrite(data, 1, chunk, cap->file) != chunk)
+        {
+            return false;
+        }
+
+        cap->time_us += delta;
+        cap->records++;
+        cap->bytes += chunk;
+        data += chunk;
+        len -= chunk;
+    } while (len);
+
+    return true;
+}
+
+bool DLCap_Open(dlcap_t* cap, const char* path)
+{
+    if (!cap || !path)
+    {
+        return false;
+    }
+
+    memset(cap, 0, sizeof(*cap));
+    cap->file = strcmp(path, "-") == 0 ? stdin : fopen(path, "rb");
+    if (!cap->file)
+    {
+        return false;
+    }
+
+    uint8_t header[DLCAP_HEADER_SIZE];
+    if (fread(header, 1, sizeof(header), cap->file) != sizeof(header) ||
+        memcmp(header, DLCAP_MAGIC, 6) != 0)
+    {
+        DLCap_Close(cap);
+        return false;
+    }
+
+    cap->baud_rate = (uint32_t)get_le(header + 8, 4);
+    cap->start_unix_us = get_le(header + 12, 8);
+    return true;
+}
+
+bool DLCap_Read(dlcap_t* cap, uint8_t* buffer, size_t* len)
+{
+    uint8_t header[DLCAP_RECORD_HEADER];
+
+    if (!cap || !cap->file || !buffer || !len ||
+        fread(header, 1, sizeof(header), cap->file) != sizeof(header))
+    {
+        return false;
+    }
+
+    *len = (size_t)get_le(header + 4, 2);
+    if (fread(buffer, 1, *len, cap->file) != *len)
+    {
+        return false;
+    }
+
+    cap->time_us += get_le(header, 4);
+    cap->records++;
+    cap->bytes += *len;
+    return true;
+}
+
+bool DLCap_Rewind(dlcap_t* cap)
+{
+    if (!cap || !cap->file || fseek(cap->file, DLCAP_HEADER_SIZE, SEEK_SET) != 0)
+    {
+        return false;
+    }
+
+    cap->time_us = 0;
+    cap->records = 0;
+    cap->bytes = 0;
+    return true;
+}
+
+void DLCap_Close(dlcap_t* cap)
+{
+    if (cap && cap->file)
+    {
+        if (cap->file != stdout && cap->file != stdin)
+        {
+            fclose(cap->file);
+        }
+        else
+        {
+            fflush(cap->file);
+        }
+        cap->file = NULL;
+    }
+}
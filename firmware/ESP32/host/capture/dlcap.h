@@ -0,0 +1,101 @@
+/**
+ * @file dlcap.h
+ * @brief DLCAP1 capture files: raw STM32 UART bytes with their arrival times
+ *
+ * Layout, all integers little-endian:
+ *
+ *   header   "DLCAP1" | u16 reserved (0) | u32 baud rate | u64 start (Unix us)
+ *   record   u32 delta_us since the previous record | u16 length | length bytes
+ *
+ * A record is one read from the UART, as it arrived: noise, partial lines,
+ * CR/LF variants and all. Nothing is cleaned or split at line boundaries,
+ * so a replay sees exactly what STM32_UART_ProcessData() saw.
+ */
+#ifndef DLCAP_H
+#define DLCAP_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define DLCAP_MAGIC             "DLCAP1"
+#define DLCAP_HEADER_SIZE       20
+#define DLCAP_RECORD_HEADER     6
+#define DLCAP_MAX_RECORD        65535
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef struct {
+    FILE* file;
+    uint32_t baud_rate;
+    uint64_t start_unix_us;
+    uint64_t time_us;           // Arrival time of the last record, since the start
+    uint32_t records;
+    uint64_t bytes;
+} dlcap_t;
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+
+/**
+ * @brief Create a capture and write its header
+ * 
+ * @param cap Capture handle
+ * @param path File to create ("-" = stdout)
+ * @param baud_rate Line rate of the recorded UART, 0 if unknown
+ * 
+ * @return true if successful
+ */
+bool DLCap_Create(dlcap_t* cap, const char* path, uint32_t baud_rate);
+
+/**
+ * @brief Append one UART read
+ * 
+ * @param cap Capture handle
+ * @param time_us Arrival time since the start of the capture, not decreasing
+ * @param data Bytes as received
+ * @param len Byte count; longer reads are split into several records
+ * 
+ * @return true if successful
+ */
+bool DLCap_Write(dlcap_t* cap, uint64_t time_us, const uint8_t* data, size_t len);
+
+/**
+ * @brief Open a capture and check its header
+ * 
+ * @param cap Capture handle
+ * @param path File to read ("-" = stdin)
+ * 
+ * @return true if the file is a DLCAP1 capture
+ */
+bool DLCap_Open(dlcap_t* cap, const char* path);
+
+/**
+ * @brief Read the next record
+ * 
+ * @param cap Capture handle
+ * @param buffer Receives the bytes, at least DLCAP_MAX_RECORD long
+ * @param len Receives the byte count
+ * 
+ * @return true if a record was read, false at the end or on a truncated record
+ */
+bool DLCap_Read(dlcap_t* cap, uint8_t* buffer, size_t* len);
+
+/**
+ * @brief Go back to the first record
+ * 
+ * @param cap Capture handle
+ * 
+ * @return true if successful (false for pipes)
+ */
+bool DLCap_Rewind(dlcap_t* cap);
+
+/**
+ * @brief Flush and close
+ * 
+ * @param cap Capture handle
+ */
+void DLCap_Close(dlcap_t* cap);
+
+#endif /* DLCAP_H */
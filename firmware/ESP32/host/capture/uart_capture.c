@@ -0,0 +1,349 @@
+/**
+ * @file uart_capture.c
+ * @brief Record an STM32 UART stream to a DLCAP1 capture, or synthesize one
+ *
+ *   uart_capture --device /dev/ttyUSB0 [--baud 115200] [--duration S] -o run.dlcap
+ *   uart_capture --synth [--lines N] [--rate HZ] [--noise P] [--seed N] -o synth.dlcap
+ *
+ * A synthetic capture follows the STM32 output format (PERIODIC, SINGLE,
+ * AGGREGATE, STATE) at the line rate of the UART, delivered in FIFO-sized
+ * reads. A fraction of the lines carries the damage seen on a real wire:
+ * garbage before the keyword, non-printable bytes, bare wake bytes, lines cut
+ * short and glued to the next one, flipped characters and mixed CR/LF.
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include "host.h"
+#include "dlcap.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define CAPTURE_READ_SIZE       256
+#define SYNTH_FIFO_BYTES        120     // ESP32 UART rx FIFO full threshold
+
+/* VARIABLES -----------------------------------------------------------------*/
+host_config_t g_host = {
+    .log_level = ESP_LOG_WARN,
+};
+
+/* STATIC VARIABLES ----------------------------------------------------------*/
+static volatile sig_atomic_t s_stop = 0;
+static uint32_t s_rng = 0x2545F491u;
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+static void on_signal(int sig)
+{
+    (void)sig;
+    s_stop = 1;
+}
+
+static uint32_t rng_next(void)
+{
+    // xorshift32: deterministic for a given --seed
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static uint32_t rng_below(uint32_t n)
+{
+    return n ? rng_next() % n : 0;
+}
+
+static speed_t baud_to_speed(uint32_t baud)
+{
+    switch (baud)
+    {
+    case 9600:      return B9600;
+    case 19200:     return B19200;
+    case 38400:     return B38400;
+    case 57600:     return B57600;
+    case 230400:    return B230400;
+    case 460800:    return B460800;
+    case 921600:    return B921600;
+    default:        return B115200;
+    }
+}
+
+static int record_device(dlcap_t* cap, const char* device, uint32_t baud, double duration_s)
+{
+    int fd = open(device, O_RDONLY | O_NOCTTY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "Cannot open %s: %s\n", device, strerror(errno));
+        return 1;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        cfsetspeed(&tio, baud_to_speed(baud));
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    uint8_t buffer[CAPTURE_READ_SIZE];
+    int64_t start_us = esp_timer_get_time();
+    int64_t end_us = duration_s > 0 ? start_us + (int64_t)(duration_s * 1e6) : INT64_MAX;
+
+    while (!s_stop && esp_timer_get_time() < end_us)
+    {
+        struct pollfd pfd = { .fd = fd, .events = POLLIN };
+        if (poll(&pfd, 1, 100) <= 0)
+        {
+            continue;
+        }
+
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        if (n < 0 && errno != EINTR && errno != EAGAIN)
+        {
+            fprintf(stderr, "Read from %s failed: %s\n", device, strerror(errno));
+            break;
+        }
+        if (n > 0 && !DLCap_Write(cap, (uint64_t)(esp_timer_get_time() - start_us), buffer, (size_t)n))
+        {
+            fprintf(stderr, "Capture write failed\n");
+            break;
+        }
+    }
+
+    close(fd);
+    return 0;
+}
+
+/**
+ * @brief One well-formed STM32 line for synthetic sample i, CRLF-terminated
+ */
+static int synth_line(char* out, size_t size, uint32_t i, uint64_t time_us)
+{
+    float t = 22.0f + (float)(rng_below(800)) / 100.0f;
+    float h = 45.0f + (float)(rng_below(2000)) / 100.0f;
+    uint32_t kind = rng_below(100);
+
+    if (kind < 88)
+    {
+        return snprintf(out, size, "PERIODIC %.2f %.2f @%lu\r\n", t, h, (unsigned long)(uint32_t)time_us);
+    }
+    if (kind < 93)
+    {
+        return snprintf(out, size, "SINGLE %.2f %.2f @%lu\r\n", t, h, (unsigned long)(uint32_t)time_us);
+    }
+    if (kind < 96)
+    {
+        return snprintf(out, size, "AGGREGATE 60 %lu %.2f %.2f %.2f %.4f %.2f %.2f %.2f %.4f\r\n",
+                        (unsigned long)(60 + (i & 3)), t - 0.4f, t + 0.4f, t, 0.0312f,
+                        h - 1.5f, h + 1.5f, h, 0.2471f);
+    }
+    if (kind < 98)
+    {
+        static const char* const MPS[] = { "0", "0.5", "1", "2", "4", "10" };
+        return snprintf(out, size, "STATE %s %s %s 0x%04X\r\n", MPS[rng_below(6)],
+                        rng_below(2) ? "HIGH" : "LOW", rng_below(8) ? "OFF" : "ON", rng_below(4) << 4);
+    }
+    return snprintf(out, size, "SHT3X %s\r\n", rng_below(2) ? "OK" : "ERROR");
+}
+
+/**
+ * @brief Damage a line in place the way a noisy wire does; returns the new length
+ */
+static int synth_noise(char* line, int len, size_t size)
+{
+    char tmp[256];
+
+    switch (rng_below(6))
+    {
+    case 0:     // Garbage before the keyword, e.g. the STM32 waking from STOP
+    {
+        int junk = 1 + (int)rng_below(4);
+        for (int k = 0; k < junk; k++)
+        {
+            tmp[k] = (char)(rng_below(2) ? 0x80 + rng_below(0x80) : rng_below(0x20));
+        }
+        memcpy(tmp + junk, line, (size_t)len);
+        len += junk;
+        break;
+    }
+    case 1:     // Printable junk glued in front
+        len = snprintf(tmp, sizeof(tmp), "%c%c%.*s", '!' + (int)rng_below(30), '~', len, line);
+        break;
+    case 2:     // Wake byte on its own
+        len = snprintf(tmp, sizeof(tmp), "\n%.*s", len, line);
+        break;
+    case 3:     // Cut short: no terminator, the next line follows directly
+    {
+        int keep = 3 + (int)rng_below((uint32_t)(len > 6 ? len - 5 : 1));
+        memcpy(tmp, line, (size_t)keep);
+        len = keep;
+        break;
+    }
+    case 4:     // Flipped bit in a character
+        memcpy(tmp, line, (size_t)len);
+        tmp[rng_below((uint32_t)(len > 2 ? len - 2 : 1))] ^= (char)(1 << rng_below(7));
+        break;
+    default:    // Other line ending
+        memcpy(tmp, line, (size_t)len);
+        if (len >= 2)
+        {
+            len -= 1;
+            tmp[len - 1] = rng_below(2) ? '\n' : '\r';
+        }
+        break;
+    }
+
+    len = len < (int)size ? len : (int)size - 1;
+    memcpy(line, tmp, (size_t)len);
+    return len;
+}
+
+static int synthesize(dlcap_t* cap, uint32_t lines, double rate, double noise, uint32_t baud)
+{
+    char line[256];
+    double byte_us = 10.0 * 1e6 / baud;     // 8N1
+    double wire_free_us = 0;                // When the wire is idle again
+    uint32_t damaged = 0;
+
+    for (uint32_t i = 0; i < lines; i++)
+    {
+        double start_us = (double)i * 1e6 / rate;
+        if (start_us < wire_free_us)
+        {
+            start_us = wire_free_us;
+        }
+
+        int len = synth_line(line, sizeof(line), i, (uint64_t)start_us);
+        if ((double)rng_below(1000000) < noise * 1e6)
+        {
+            len = synth_noise(line, len, sizeof(line));
+            damaged++;
+        }
+
+        // The driver hands over what is in the FIFO: at most SYNTH_FIFO_BYTES, often a line in pieces
+        int pos = 0;
+        while (pos < len)
+        {
+            int piece = len - pos;
+            if (piece > SYNTH_FIFO_BYTES)
+            {
+                piece = SYNTH_FIFO_BYTES;
+            }
+            if (piece > 8 && rng_below(4) == 0)
+            {
+                piece = 1 + (int)rng_below((uint32_t)piece - 1);
+            }
+
+            double arrival_us = start_us + (pos + piece) * byte_us;
+            if (!DLCap_Write(cap, (uint64_t)arrival_us, (const uint8_t*)line + pos, (size_t)piece))
+            {
+                fprintf(stderr, "Capture write failed\n");
+                return 1;
+            }
+            pos += piece;
+        }
+        wire_free_us = start_us + len * byte_us;
+    }
+
+    fprintf(stderr, "Synthesized %lu lines (%lu damaged), %lu records, %llu bytes, %.1f s\n",
+            (unsigned long)lines, (unsigned long)damaged, (unsigned long)cap->records,
+            (unsigned long long)cap->bytes, (double)cap->time_us / 1e6);
+    return 0;
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "Usage: %s (--device DEV | --synth) [options]\n"
+            "  -o, --output FILE    Capture to write, - = stdout (default)\n"
+            "  -d, --device DEV     Record from a serial device until Ctrl-C or --duration\n"
+            "  -b, --baud N         Line rate (default 115200)\n"
+            "  -t, --duration S     Stop recording after S seconds\n"
+            "  -s, --synth          Generate a stream instead of recording\n"
+            "  -n, --lines N        Synthetic lines (default 10000)\n"
+            "  -r, --rate HZ        Synthetic lines per second (default 10)\n"
+            "  -e, --noise P        Fraction of damaged lines, 0..1 (default 0.02)\n"
+            "  -S, --seed N         Generator seed (default 1)\n",
+            prog);
+}
+
+/* MAIN ----------------------------------------------------------------------*/
+int main(int argc, char** argv)
+{
+    static const struct option options[] = {
+        { "output",   required_argument, NULL, 'o' },
+        { "device",   required_argument, NULL, 'd' },
+        { "baud",     required_argument, NULL, 'b' },
+        { "duration", required_argument, NULL, 't' },
+        { "synth",    no_argument,       NULL, 's' },
+        { "lines",    required_argument, NULL, 'n' },
+        { "rate",     required_argument, NULL, 'r' },
+        { "noise",    required_argument, NULL, 'e' },
+        { "seed",     required_argument, NULL, 'S' },
+        { "help",     no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    const char* output = "-";
+    const char* device = NULL;
+    uint32_t baud = 115200;
+    double duration_s = 0;
+    bool synth = false;
+    uint32_t lines = 10000;
+    double rate = 10;
+    double noise = 0.02;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "o:d:b:t:sn:r:e:S:h", options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'o': output = optarg; break;
+        case 'd': device = optarg; break;
+        case 'b': baud = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 't': duration_s = atof(optarg); break;
+        case 's': synth = true; break;
+        case 'n': lines = (uint32_t)strtoul(optarg, NULL, 10); break;
+        case 'r': rate = atof(optarg); break;
+        case 'e': noise = atof(optarg); break;
+        case 'S': s_rng = (uint32_t)strtoul(optarg, NULL, 10) * 2654435761u | 1u; break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (synth == (device != NULL) || baud == 0 || rate <= 0 || noise < 0 || noise > 1)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    dlcap_t cap;
+    if (!DLCap_Create(&cap, output, baud))
+    {
+        fprintf(stderr, "Cannot create %s: %s\n", output, strerror(errno));
+        return 1;
+    }
+
+    int rc = synth ? synthesize(&cap, lines, rate, noise, baud)
+                   : record_device(&cap, device, baud, duration_s);
+    if (!synth)
+    {
+        fprintf(stderr, "Recorded %lu records, %llu bytes, %.1f s\n", (unsigned long)cap.records,
+                (unsigned long long)cap.bytes, (double)cap.time_us / 1e6);
+    }
+    DLCap_Close(&cap);
+    return rc;
+}
@@ -0,0 +1,379 @@
+/**
+ * @file uart_replay.c
+ * @brief Feed a DLCAP1 capture through the bridge ingest path and measure it
+ *
+ *   uart_replay [--realtime [--speed X]] [--loops N] [--log deferred|sync|off] run.dlcap
+ *
+ * The bytes go through the same code as on the device: ring_buffer,
+ * STM32_UART_ProcessData() with its line cleaner, then the classification
+ * of app_main.c's UART callback and SensorParser_ProcessLine(). Nothing is
+ * published; the path ends where the sample would enter the pipeline queue.
+ *
+ * At maximum speed (the default) records are fed back to back and the
+ * figures are the CPU cost of ingest. With --realtime they are fed at their
+ * recorded arrival times, scaled by --speed.
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include "host.h"
+#include "dlcap.h"
+#include "esp_log.h"
+#include "stm32_uart.h"
+#include "sensor_parser.h"
+#include "deferred_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define REPLAY_READ_SIZE        128     // uart_event_task reads at most this much per pass
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef struct {
+    uint64_t aggregate;
+    uint64_t state;
+    uint64_t parse_fail;        // Starts like a sample but does not parse
+    uint64_t single;
+    uint64_t periodic;
+    uint64_t timestamped;       // Samples with the "@<us>" field
+} replay_counts_t;
+
+/* VARIABLES -----------------------------------------------------------------*/
+host_config_t g_host = {
+    .log_level = ESP_LOG_INFO,
+};
+
+/* STATIC VARIABLES ----------------------------------------------------------*/
+static stm32_uart_t s_uart;
+static sensor_parser_t s_parser;
+static replay_counts_t s_counts;
+static int s_show_failures = 0;
+
+static uint32_t* s_line_ns = NULL;     // Cost per line, one entry per line
+static size_t s_line_count = 0;
+static size_t s_line_capacity = 0;
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void push_line_cost(uint32_t ns)
+{
+    if (s_line_count == s_line_capacity)
+    {
+        size_t capacity = s_line_capacity ? s_line_capacity * 2 : 65536;
+        uint32_t* grown = realloc(s_line_ns, capacity * sizeof(*grown));
+        if (!grown)
+        {
+            return;
+        }
+        s_line_ns = grown;
+        s_line_capacity = capacity;
+    }
+    s_line_ns[s_line_count++] = ns;
+}
+
+static int cmp_u32(const void* a, const void* b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t percentile(double p)
+{
+    if (s_line_count == 0)
+    {
+        return 0;
+    }
+    size_t idx = (size_t)ceil(p / 100.0 * (double)s_line_count);
+    return s_line_ns[idx ? idx - 1 : 0];
+}
+
+static void on_sample(const sensor_data_t* data)
+{
+    if (data->type == SENSOR_TYPE_SINGLE)
+    {
+        s_counts.single++;
+    }
+    else
+    {
+        s_counts.periodic++;
+    }
+    if (data->has_timestamp)
+    {
+        s_counts.timestamped++;
+    }
+}
+
+/**
+ * @brief Same classification as on_stm32_data_received() in app_main.c
+ */
+static void on_line(const char* line)
+{
+    if (strncmp(line, "AGGREGATE", 9) == 0)
+    {
+        s_counts.aggregate++;
+        return;
+    }
+    if (strncmp(line, "STATE ", 6) == 0)
+    {
+        s_counts.state++;
+        return;
+    }
+    if (!SensorParser_ProcessLine(&s_parser, line))
+    {
+        // The cleaner only lets keyword lines through, so this is a damaged sample
+        s_counts.parse_fail++;
+        if (s_show_failures > 0)
+        {
+            s_show_failures--;
+            fprintf(stderr, "parse failure: '%s'\n", line);
+        }
+    }
+}
+
+/**
+ * @brief One pass of uart_event_task over a piece of a record
+ */
+static void ingest(const uint8_t* data, size_t len)
+{
+    uint32_t lines_before = s_uart.lines_received;
+    uint64_t t0 = now_ns();
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (!RingBuffer_Put(&s_uart.rx_buffer, data[i]))
+        {
+            s_uart.rx_dropped += (uint32_t)(len - i);
+            break;
+        }
+    }
+    STM32_UART_ProcessData(&s_uart);
+
+    uint64_t cost = now_ns() - t0;
+    uint32_t lines = s_uart.lines_received - lines_before;
+    for (uint32_t i = 0; i < lines; i++)
+    {
+        push_line_cost((uint32_t)(cost / lines));
+    }
+}
+
+static void sleep_until_ns(uint64_t deadline_ns)
+{
+    struct timespec ts = {
+        .tv_sec = (time_t)(deadline_ns / 1000000000ull),
+        .tv_nsec = (long)(deadline_ns % 1000000000ull),
+    };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+    {
+    }
+}
+
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options] CAPTURE\n"
+            "  -R, --realtime        Feed records at their recorded times\n"
+            "  -x, --speed X         Real-time speed factor (default 1)\n"
+            "  -l, --loops N         Replay the capture N times (default 1, max speed only)\n"
+            "  -L, --log MODE        deferred (device default), sync or off (default deferred)\n"
+            "  -f, --failures N      Print the first N lines that fail to parse\n"
+            "  -v, --verbose         Show the bridge's own log output\n"
+            "  -j, --json            One JSON line instead of the table\n",
+            prog);
+}
+
+/* MAIN ----------------------------------------------------------------------*/
+int main(int argc, char** argv)
+{
+    static const struct option options[] = {
+        { "realtime", no_argument,       NULL, 'R' },
+        { "speed",    required_argument, NULL, 'x' },
+        { "loops",    required_argument, NULL, 'l' },
+        { "log",      required_argument, NULL, 'L' },
+        { "failures", required_argument, NULL, 'f' },
+        { "verbose",  no_argument,       NULL, 'v' },
+        { "json",     no_argument,       NULL, 'j' },
+        { "help",     no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    bool realtime = false;
+    double speed = 1.0;
+    long loops = 1;
+    dlog_mode_t log_mode = DLOG_MODE_DEFERRED;
+    bool verbose = false;
+    bool json = false;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "Rx:l:L:f:vjh", options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'R': realtime = true; break;
+        case 'x': speed = atof(optarg); break;
+        case 'l': loops = atol(optarg); break;
+        case 'f': s_show_failures = atoi(optarg); break;
+        case 'v': verbose = true; break;
+        case 'j': json = true; break;
+        case 'L':
+            if (strcmp(optarg, "sync") == 0)
+            {
+                log_mode = DLOG_MODE_SYNC;
+            }
+            else if (strcmp(optarg, "off") == 0)
+            {
+                log_mode = DLOG_MODE_OFF;
+            }
+            else if (strcmp(optarg, "deferred") != 0)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+    if (optind != argc - 1 || speed <= 0 || loops < 1 || (realtime && loops != 1))
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    dlcap_t cap;
+    if (!DLCap_Open(&cap, argv[optind]))
+    {
+        fprintf(stderr, "%s is not a DLCAP1 capture\n", argv[optind]);
+        return 1;
+    }
+
+    // Logging is formatted as on the device but printed nowhere, unless asked for
+    if (!verbose)
+    {
+        g_host.log_stream = fopen("/dev/null", "w");
+    }
+    if (log_mode == DLOG_MODE_DEFERRED && !DeferredLog_Init())
+    {
+        fprintf(stderr, "Deferred log unavailable\n");
+        return 1;
+    }
+    DeferredLog_SetMode(log_mode);
+
+    SensorParser_Init(&s_parser, on_sample, on_sample);
+    RingBuffer_Init(&s_uart.rx_buffer);
+    s_uart.data_callback = on_line;
+    s_uart.initialized = true;
+
+    static uint8_t record[DLCAP_MAX_RECORD];
+    size_t len;
+    uint64_t records = 0;
+    uint64_t bytes = 0;
+    uint64_t capture_us = 0;
+    long loops_done = 0;
+    uint64_t start_ns = now_ns();
+
+    for (; loops_done < loops; loops_done++)
+    {
+        if (loops_done > 0 && !DLCap_Rewind(&cap))
+        {
+            fprintf(stderr, "Cannot rewind the capture, stopping after %ld loop(s)\n", loops_done);
+            break;
+        }
+        while (DLCap_Read(&cap, record, &len))
+        {
+            if (realtime)
+            {
+                sleep_until_ns(start_ns + (uint64_t)((double)cap.time_us * 1000.0 / speed));
+            }
+            for (size_t pos = 0; pos < len; pos += REPLAY_READ_SIZE)
+            {
+                ingest(record + pos, len - pos < REPLAY_READ_SIZE ? len - pos : REPLAY_READ_SIZE);
+            }
+            records++;
+            bytes += len;
+        }
+        capture_us = cap.time_us;
+    }
+    uint64_t wall_ns = now_ns() - start_ns;
+    DLCap_Close(&cap);
+
+    // Let the formatter catch up so its counters are final
+    if (log_mode == DLOG_MODE_DEFERRED)
+    {
+        vTaskDelay(pdMS_TO_TICKS(200));
+    }
+    dlog_stats_t dlog;
+    DeferredLog_GetStats(&dlog);
+
+    uint64_t ingest_ns = 0;
+    for (size_t i = 0; i < s_line_count; i++)
+    {
+        ingest_ns += s_line_ns[i];
+    }
+    qsort(s_line_ns, s_line_count, sizeof(*s_line_ns), cmp_u32);
+
+    const char* mode_name = log_mode == DLOG_MODE_SYNC ? "sync" : log_mode == DLOG_MODE_OFF ? "off" : "deferred";
+    double wall_s = (double)wall_ns / 1e9;
+    double lines_per_s = wall_s > 0 ? (double)s_uart.lines_received / wall_s : 0;
+    double mb_per_s = wall_s > 0 ? (double)bytes / wall_s / 1e6 : 0;
+    double ns_per_line = s_uart.lines_received ? (double)ingest_ns / s_uart.lines_received : 0;
+    double ns_per_byte = bytes ? (double)ingest_ns / (double)bytes : 0;
+
+    if (json)
+    {
+        printf("{\"loops\":%ld,\"records\":%llu,\"bytes\":%llu,\"capture_s\":%.3f,\"wall_s\":%.3f,\"log\":\"%s\","
+               "\"lines\":%lu,\"rejected\":%lu,\"parse_fail\":%llu,\"single\":%llu,\"periodic\":%llu,"
+               "\"timestamped\":%llu,\"aggregate\":%llu,\"state\":%llu,\"ring_dropped\":%lu,"
+               "\"lines_per_s\":%.0f,\"mb_per_s\":%.3f,\"ns_per_line\":{\"avg\":%.0f,\"p50\":%lu,"
+               "\"p99\":%lu,\"max\":%lu},\"ns_per_byte\":%.1f,\"dlog_dropped\":%lu}\n",
+               loops_done, (unsigned long long)records, (unsigned long long)bytes, (double)capture_us / 1e6,
+               wall_s, mode_name, (unsigned long)s_uart.lines_received, (unsigned long)s_uart.lines_rejected,
+               (unsigned long long)s_counts.parse_fail, (unsigned long long)s_counts.single,
+               (unsigned long long)s_counts.periodic, (unsigned long long)s_counts.timestamped,
+               (unsigned long long)s_counts.aggregate, (unsigned long long)s_counts.state,
+               (unsigned long)s_uart.rx_dropped, lines_per_s, mb_per_s, ns_per_line,
+               (unsigned long)percentile(50), (unsigned long)percentile(99), (unsigned long)percentile(100),
+               ns_per_byte, (unsigned long)dlog.dropped);
+    }
+    else
+    {
+        printf("Capture     %llu records, %llu bytes, %.2f s at %lu baud\n",
+               (unsigned long long)(records / loops_done), (unsigned long long)(bytes / loops_done),
+               (double)capture_us / 1e6, (unsigned long)cap.baud_rate);
+        printf("Replay      %s, %ld loop(s), %.3f s wall, log %s\n",
+               realtime ? "real time" : "maximum speed", loops_done, wall_s, mode_name);
+        printf("Lines       %lu assembled, %lu rejected by the cleaner, %llu parse failures\n",
+               (unsigned long)s_uart.lines_received, (unsigned long)s_uart.lines_rejected,
+               (unsigned long long)s_counts.parse_fail);
+        printf("Parsed      %llu periodic, %llu single (%llu timestamped), %llu aggregate, %llu state\n",
+               (unsigned long long)s_counts.periodic, (unsigned long long)s_counts.single,
+               (unsigned long long)s_counts.timestamped, (unsigned long long)s_counts.aggregate,
+               (unsigned long long)s_counts.state);
+        printf("Ring        %lu bytes dropped\n", (unsigned long)s_uart.rx_dropped);
+        printf("Throughput  %.0f lines/s, %.3f MB/s\n", lines_per_s, mb_per_s);
+        printf("Cost        %.0f ns/line avg, p50 %lu, p99 %lu, max %lu; %.1f ns/byte\n",
+               ns_per_line, (unsigned long)percentile(50), (unsigned long)percentile(99),
+               (unsigned long)percentile(100), ns_per_byte);
+        if (log_mode == DLOG_MODE_DEFERRED)
+        {
+            printf("Deferred    %lu recorded, %lu dropped, %lu rate-limited\n",
+                   (unsigned long)dlog.recorded, (unsigned long)dlog.dropped, (unsigned long)dlog.suppressed);
+        }
+    }
+
+    free(s_line_ns);
+    return 0;
+}
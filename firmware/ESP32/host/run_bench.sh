@@ -0,0 +1,66 @@
+#!/bin/sh
+# Host benchmark: local mosquitto, bridge_host on a pty, bridge_bench driving it.
+#
+#   firmware/ESP32/host/run_bench.sh [bridge_bench options]
+#
+# Environment:
+#   BUILD_DIR  build directory of host/CMakeLists.txt   (default: build-host next to this script)
+#   MOSQUITTO  mosquitto binary                         (default: mosquitto)
+#   PORT       TCP port for the throwaway broker        (default: 18883)
+#   BRIDGE_ARGS extra bridge_host options, e.g. "-e cbor" (default: none)
+#
+# Exits non-zero if any stage fails, so it can run as a CI step.
+set -eu
+
+HOST_DIR=$(cd "$(dirname "$0")" && pwd)
+BUILD_DIR=${BUILD_DIR:-$HOST_DIR/build-host}
+MOSQUITTO=${MOSQUITTO:-mosquitto}
+PORT=${PORT:-18883}
+BRIDGE_ARGS=${BRIDGE_ARGS:-}
+WORK=$(mktemp -d)
+BROKER_PID=
+BRIDGE_PID=
+
+cleanup() {
+    [ -n "$BRIDGE_PID" ] && kill "$BRIDGE_PID" 2>/dev/null || true
+    [ -n "$BROKER_PID" ] && kill "$BROKER_PID" 2>/dev/null || true
+    wait 2>/dev/null || true
+    rm -rf "$WORK"
+}
+trap cleanup EXIT INT TERM
+
+if [ ! -x "$BUILD_DIR/bridge_host" ] || [ ! -x "$BUILD_DIR/bridge_bench" ]; then
+    cmake -S "$HOST_DIR" -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release >/dev/null
+    cmake --build "$BUILD_DIR" -j >/dev/null
+fi
+
+# Anonymous loopback-only broker, no persistence: nothing from broker/ is reused
+cat > "$WORK/mosquitto.conf" <<CONF
+listener $PORT 127.0.0.1
+allow_anonymous true
+persistence false
+log_dest none
+CONF
+"$MOSQUITTO" -c "$WORK/mosquitto.conf" &
+BROKER_PID=$!
+
+# shellcheck disable=SC2086 # BRIDGE_ARGS is a list of options
+"$BUILD_DIR/bridge_host" --broker "mqtt://127.0.0.1:$PORT" --pty-link "$WORK/stm32" $BRIDGE_ARGS \
+    > "$WORK/bridge.log" 2>&1 &
+BRIDGE_PID=$!
+
+# Start once the bridge is ready, so the boot backlog does not count as loss.
+# A first connect that beats the broker is retried after the reconnect timeout.
+i=0
+until grep -q "MQTT ready #" "$WORK/bridge.log"; do
+    i=$((i + 1))
+    if [ $i -gt 300 ]; then
+        echo "bridge_host not ready after 30 s:" >&2
+        cat "$WORK/bridge.log" >&2
+        exit 1
+    fi
+    sleep 0.1
+done
+
+"$BUILD_DIR/bridge_bench" --broker "mqtt://127.0.0.1:$PORT" --pty "$WORK/stm32" \
+    --pid "$BRIDGE_PID" "$@"
@@ -0,0 +1,12 @@
+/**
+ * @file esp_netif.h
+ * @brief Host shim: the host network stack is already up
+ */
+#ifndef HOST_ESP_NETIF_H
+#define HOST_ESP_NETIF_H
+
+#include "esp_err.h"
+
+esp_err_t esp_netif_init(void);
+
+#endif /* HOST_ESP_NETIF_H */
@@ -0,0 +1,29 @@
+/**
+ * @file esp_system.h
+ * @brief Host shim: heap figures and restart
+ * 
+ * The "heap" is a nominal HOST_HEAP_SIZE budget minus the bytes currently
+ * allocated with malloc, so only changes between readings are meaningful.
+ */
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "esp_err.h"
+
+#define HOST_HEAP_SIZE  (300u * 1024u)
+
+uint32_t esp_get_free_heap_size(void);
+uint32_t esp_get_minimum_free_heap_size(void);
+const char* esp_get_idf_version(void);
+void esp_restart(void) __attribute__((noreturn));
+
+// newlib has strlcpy; glibc only from 2.38
+#if defined(__GLIBC__) && (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+#define HOST_NEEDS_STRLCPY 1
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+#endif /* HOST_ESP_SYSTEM_H */
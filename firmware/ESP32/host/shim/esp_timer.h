@@ -0,0 +1,15 @@
+/**
+ * @file esp_timer.h
+ * @brief Host shim: esp_timer_get_time() is CLOCK_MONOTONIC in microseconds
+ * 
+ * The clock is shared by every process on the machine, so timestamps taken by
+ * the bridge and by bench tools can be compared directly.
+ */
+#ifndef HOST_ESP_TIMER_H
+#define HOST_ESP_TIMER_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
+
+#endif /* HOST_ESP_TIMER_H */
@@ -0,0 +1,18 @@
+/**
+ * @file esp_wifi.h
+ * @brief Host shim: only the station MAC, taken from g_host
+ */
+#ifndef HOST_ESP_WIFI_H
+#define HOST_ESP_WIFI_H
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    WIFI_IF_STA = 0,
+    WIFI_IF_AP
+} wifi_interface_t;
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6]);
+
+#endif /* HOST_ESP_WIFI_H */
@@ -0,0 +1,10 @@
+/**
+ * @file example_common_private.h
+ * @brief Host shim: the Wi-Fi teardown app_main uses between connect rounds
+ */
+#ifndef HOST_EXAMPLE_COMMON_PRIVATE_H
+#define HOST_EXAMPLE_COMMON_PRIVATE_H
+
+void example_wifi_stop(void);
+
+#endif /* HOST_EXAMPLE_COMMON_PRIVATE_H */
@@ -0,0 +1,35 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host shim: FreeRTOS types and constants over POSIX threads
+ * 
+ * Ticks run at CONFIG_FREERTOS_HZ like the firmware, so vTaskDelay() and
+ * pdMS_TO_TICKS() keep their device timing.
+ */
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdTRUE                          1
+#define pdFALSE                         0
+#define pdPASS                          pdTRUE
+#define pdFAIL                          pdFALSE
+#define portMAX_DELAY                   ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ              CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS              (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)               ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000))
+#define configMAX_PRIORITIES            25
+#define configRUN_TIME_COUNTER_TYPE     uint64_t
+#define portNUM_PROCESSORS              2
+#define tskIDLE_PRIORITY                0
+#define tskNO_AFFINITY                  ((BaseType_t)0x7FFFFFFF)
+
+#endif /* HOST_FREERTOS_H */
@@ -0,0 +1,20 @@
+/**
+ * @file queue.h
+ * @brief Host shim: copy-in/copy-out queues on a mutex and two condition variables
+ */
+#ifndef HOST_QUEUE_H
+#define HOST_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct host_queue* QueueHandle_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size);
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks);
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+void vQueueDelete(QueueHandle_t queue);
+
+#define xQueueSendToBack(q, item, ticks)    xQueueSend((q), (item), (ticks))
+
+#endif /* HOST_QUEUE_H */
@@ -0,0 +1,24 @@
+/**
+ * @file ringbuf.h
+ * @brief Host shim: no-split ring buffer with the esp_ringbuf item overhead
+ */
+#ifndef HOST_RINGBUF_H
+#define HOST_RINGBUF_H
+
+#include "FreeRTOS.h"
+
+typedef struct host_ringbuf* RingbufHandle_t;
+
+typedef enum {
+    RINGBUF_TYPE_NOSPLIT = 0,
+    RINGBUF_TYPE_ALLOWSPLIT,
+    RINGBUF_TYPE_BYTEBUF
+} RingbufferType_t;
+
+RingbufHandle_t xRingbufferCreate(size_t size, RingbufferType_t type);
+BaseType_t xRingbufferSend(RingbufHandle_t ring, const void* data, size_t size, TickType_t ticks);
+void* xRingbufferReceive(RingbufHandle_t ring, size_t* size, TickType_t ticks);
+void vRingbufferReturnItem(RingbufHandle_t ring, void* item);
+void vRingbufferDelete(RingbufHandle_t ring);
+
+#endif /* HOST_RINGBUF_H */
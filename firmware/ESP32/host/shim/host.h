@@ -0,0 +1,50 @@
+/**
+ * @file host.h
+ * @brief Run-time settings of the host build, filled from the command line by host_main.c
+ */
+#ifndef HOST_H
+#define HOST_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef struct {
+    const char* broker_url;     // mqtt://host[:port]
+    const char* username;       // NULL or "" = none
+    const char* password;
+    const char* uart_device;    // Serial device to open; NULL = create a pty
+    const char* pty_link;       // Symlink to the pty slave (NULL = none)
+    const char* capture_path;   // DLCAP1 file receiving every UART read (NULL = none)
+    const char* group;          // CONFIG_BRIDGE_COMMAND_GROUP ("" = all only)
+    bool cbor;                  // CONFIG_BRIDGE_CBOR_SAMPLES/STATE/TRACE
+    int batch_size;             // CONFIG_BRIDGE_SAMPLE_BATCH_SIZE
+    bool batch_delta;           // CONFIG_BRIDGE_SAMPLE_BATCH_DELTA
+    uint8_t mac[6];             // Station MAC reported by esp_wifi_get_mac()
+    int log_level;              // esp_log_level_t
+    FILE* log_stream;           // Log output, NULL = stdout
+} host_config_t;
+
+/* VARIABLES -----------------------------------------------------------------*/
+extern host_config_t g_host;
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+
+/**
+ * @brief Peak resident set size of the process
+ * 
+ * @return Bytes
+ */
+uint64_t Host_PeakRssBytes(void);
+
+/**
+ * @brief Stack bytes requested by the running tasks, charged to the heap as on the ESP32
+ * 
+ * @return Bytes
+ */
+size_t Host_TaskStackBytes(void);
+
+#endif /* HOST_H */
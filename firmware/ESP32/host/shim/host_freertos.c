@@ -0,0 +1,626 @@
+/**
+ * @file host_freertos.c
+ * @brief FreeRTOS tasks, queues, mutexes and esp_ringbuf over POSIX threads
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/ringbuf.h"
+#include "esp_timer.h"
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define HOST_MAX_TASKS          32
+#define HOST_STACK_PAINT        0xA5
+#define HOST_STACK_MARGIN       (64 * 1024)     // x86-64/glibc frames are larger than Xtensa/newlib
+#define HOST_RINGBUF_OVERHEAD   8               // esp_ringbuf no-split item header
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+struct host_task {
+    pthread_t thread;
+    char name[16];
+    TaskFunction_t fn;
+    void* arg;
+    UBaseType_t priority;
+    BaseType_t core;
+    UBaseType_t number;
+    uint8_t* stack;             // Painted, grows down from stack + stack_size
+    size_t stack_size;
+    uint8_t* entry_sp;          // Frame of the task entry; glibc keeps the TCB and TLS above it
+    uint32_t requested;         // Stack size asked for, in bytes as in ESP-IDF
+    clockid_t cpu_clock;
+    volatile bool running;
+};
+
+struct host_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint8_t* items;
+    size_t item_size;
+    UBaseType_t length;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+struct host_mutex {
+    pthread_mutex_t lock;
+};
+
+typedef struct rb_item {
+    struct rb_item* next;
+    size_t size;
+    size_t cost;                // Bytes charged against the ring capacity
+    uint8_t data[] __attribute__((aligned(8)));
+} rb_item_t;
+
+struct host_ringbuf {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    size_t capacity;
+    size_t used;
+    rb_item_t* head;
+    rb_item_t* tail;
+};
+
+/* STATIC VARIABLES ----------------------------------------------------------*/
+static struct host_task* s_tasks[HOST_MAX_TASKS];
+static UBaseType_t s_task_count = 0;
+static pthread_mutex_t s_tasks_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread struct host_task* s_current = NULL;
+static int64_t s_boot_us = 0;
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+__attribute__((constructor))
+static void host_freertos_boot(void)
+{
+    s_boot_us = esp_timer_get_time();
+}
+
+/**
+ * @brief Absolute CLOCK_MONOTONIC deadline ticks from now
+ */
+static struct timespec host_deadline(TickType_t ticks)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    uint64_t ns = (uint64_t)ticks * portTICK_PERIOD_MS * 1000000ULL + (uint64_t)ts.tv_nsec;
+    ts.tv_sec += (time_t)(ns / 1000000000ULL);
+    ts.tv_nsec = (long)(ns % 1000000000ULL);
+    return ts;
+}
+
+static void host_cond_init(pthread_cond_t* cond)
+{
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
+/**
+ * @brief Wait on cond until signalled or the deadline; false on timeout
+ */
+static bool host_cond_wait(pthread_cond_t* cond, pthread_mutex_t* lock,
+                           TickType_t ticks, const struct timespec* deadline)
+{
+    if (ticks == 0)
+    {
+        return false;
+    }
+    if (ticks == portMAX_DELAY)
+    {
+        pthread_cond_wait(cond, lock);
+        return true;
+    }
+    return pthread_cond_timedwait(cond, lock, deadline) != ETIMEDOUT;
+}
+
+static void* host_task_entry(void* param)
+{
+    struct host_task* task = (struct host_task*)param;
+
+    s_current = task;
+    task->entry_sp = (uint8_t*)__builtin_frame_address(0);
+    pthread_getcpuclockid(pthread_self(), &task->cpu_clock);
+    task->fn(task->arg);
+
+    // Returning from a task function is an error in FreeRTOS; treat it as vTaskDelete(NULL)
+    task->running = false;
+    return NULL;
+}
+
+/**
+ * @brief Bytes from the task entry frame down to the deepest byte ever written
+ */
+static size_t host_stack_used(const struct host_task* task)
+{
+    size_t untouched = 0;
+    while (untouched < task->stack_size && task->stack[untouched] == HOST_STACK_PAINT)
+    {
+        untouched++;
+    }
+
+    const uint8_t* deepest = task->stack + untouched;
+    return (task->entry_sp && task->entry_sp > deepest) ? (size_t)(task->entry_sp - deepest) : 0;
+}
+
+/* TASK FUNCTIONS ------------------------------------------------------------*/
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stack_depth,
+                                   void* arg, UBaseType_t priority, TaskHandle_t* handle,
+                                   BaseType_t core_id)
+{
+    struct host_task* task = calloc(1, sizeof(*task));
+    if (!task)
+    {
+        return pdFAIL;
+    }
+
+    strncpy(task->name, name ? name : "", sizeof(task->name) - 1);
+    task->fn = fn;
+    task->arg = arg;
+    task->priority = priority;
+    task->core = core_id;
+    task->requested = stack_depth;
+    task->stack_size = ((size_t)stack_depth + HOST_STACK_MARGIN + 4095) & ~(size_t)4095;
+    task->running = true;
+
+    // Outside malloc, so the heap figures only see the size the firmware asked for
+    task->stack = mmap(NULL, task->stack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (task->stack == MAP_FAILED)
+    {
+        free(task);
+        return pdFAIL;
+    }
+    memset(task->stack, HOST_STACK_PAINT, task->stack_size);
+
+    pthread_mutex_lock(&s_tasks_lock);
+    if (s_task_count >= HOST_MAX_TASKS)
+    {
+        pthread_mutex_unlock(&s_tasks_lock);
+        munmap(task->stack, task->stack_size);
+        free(task);
+        return pdFAIL;
+    }
+    task->number = s_task_count;
+    s_tasks[s_task_count++] = task;
+    pthread_mutex_unlock(&s_tasks_lock);
+
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, task->stack, task->stack_size);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int err = pthread_create(&task->thread, &attr, host_task_entry, task);
+    pthread_attr_destroy(&attr);
+
+    if (err != 0)
+    {
+        task->running = false;
+        return pdFAIL;
+    }
+    pthread_setname_np(task->thread, task->name);
+
+    if (handle)
+    {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(TaskFunction_t fn, const char* name, uint32_t stack_depth,
+                       void* arg, UBaseType_t priority, TaskHandle_t* handle)
+{
+    return xTaskCreatePinnedToCore(fn, name, stack_depth, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (!task || task == s_current)
+    {
+        if (s_current)
+        {
+            s_current->running = false;
+        }
+        pthread_exit(NULL);
+    }
+
+    task->running = false;
+    pthread_cancel(task->thread);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == 0)
+    {
+        sched_yield();
+        return;
+    }
+
+    struct timespec deadline = host_deadline(ticks);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR)
+    {
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)((esp_timer_get_time() - s_boot_us) / (portTICK_PERIOD_MS * 1000));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return s_current;
+}
+
+TaskHandle_t xTaskGetHandle(const char* name)
+{
+    TaskHandle_t found = NULL;
+
+    pthread_mutex_lock(&s_tasks_lock);
+    for (UBaseType_t i = 0; i < s_task_count && name; i++)
+    {
+        if (s_tasks[i]->running && strcmp(s_tasks[i]->name, name) == 0)
+        {
+            found = s_tasks[i];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&s_tasks_lock);
+
+    return found;
+}
+
+BaseType_t xTaskGetCoreID(TaskHandle_t task)
+{
+    task = task ? task : s_current;
+    return task ? task->core : tskNO_AFFINITY;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    task = task ? task : s_current;
+    if (!task)
+    {
+        return 0;
+    }
+
+    size_t used = host_stack_used(task);
+    return used < task->requested ? (UBaseType_t)(task->requested - used) : 0;
+}
+
+size_t Host_TaskStackBytes(void)
+{
+    size_t total = 0;
+
+    pthread_mutex_lock(&s_tasks_lock);
+    for (UBaseType_t i = 0; i < s_task_count; i++)
+    {
+        if (s_tasks[i]->running)
+        {
+            total += s_tasks[i]->requested;
+        }
+    }
+    pthread_mutex_unlock(&s_tasks_lock);
+
+    return total;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    UBaseType_t count = 0;
+
+    pthread_mutex_lock(&s_tasks_lock);
+    for (UBaseType_t i = 0; i < s_task_count; i++)
+    {
+        count += s_tasks[i]->running ? 1 : 0;
+    }
+    pthread_mutex_unlock(&s_tasks_lock);
+
+    return count;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t* status, UBaseType_t size,
+                                 configRUN_TIME_COUNTER_TYPE* total_run_time)
+{
+    UBaseType_t count = 0;
+
+    pthread_mutex_lock(&s_tasks_lock);
+    for (UBaseType_t i = 0; i < s_task_count; i++)
+    {
+        struct host_task* task = s_tasks[i];
+        if (!task->running)
+        {
+            continue;
+        }
+        if (count == size)
+        {
+            pthread_mutex_unlock(&s_tasks_lock);
+            return 0;
+        }
+
+        struct timespec cpu = {0};
+        clock_gettime(task->cpu_clock, &cpu);
+
+        TaskStatus_t* st = &status[count++];
+        memset(st, 0, sizeof(*st));
+        st->xHandle = task;
+        st->pcTaskName = task->name;
+        st->xTaskNumber = task->number;
+        st->eCurrentState = (task == s_current) ? eRunning : eBlocked;
+        st->uxCurrentPriority = task->priority;
+        st->uxBasePriority = task->priority;
+        st->ulRunTimeCounter = (uint64_t)cpu.tv_sec * 1000000ULL + (uint64_t)cpu.tv_nsec / 1000;
+        st->pxStackBase = task->stack;
+        st->usStackHighWaterMark = (uint32_t)uxTaskGetStackHighWaterMark(task);
+        st->xCoreID = task->core;
+    }
+    pthread_mutex_unlock(&s_tasks_lock);
+
+    if (total_run_time)
+    {
+        *total_run_time = (configRUN_TIME_COUNTER_TYPE)(esp_timer_get_time() - s_boot_us);
+    }
+    return count;
+}
+
+/* QUEUE FUNCTIONS -----------------------------------------------------------*/
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct host_queue* queue = calloc(1, sizeof(*queue));
+    if (!queue)
+    {
+        return NULL;
+    }
+
+    queue->items = malloc(length * item_size);
+    if (!queue->items)
+    {
+        free(queue);
+        return NULL;
+    }
+    queue->length = length;
+    queue->item_size = item_size;
+    pthread_mutex_init(&queue->lock, NULL);
+    host_cond_init(&queue->not_empty);
+    host_cond_init(&queue->not_full);
+
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks)
+{
+    struct timespec deadline = host_deadline(ticks);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == queue->length)
+    {
+        if (!host_cond_wait(&queue->not_full, &queue->lock, ticks, &deadline))
+        {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+
+    UBaseType_t tail = (queue->head + queue->count) % queue->length;
+    memcpy(queue->items + tail * queue->item_size, item, queue->item_size);
+    queue->count++;
+
+    pthread_cond_signal(&queue->not_empty);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks)
+{
+    struct timespec deadline = host_deadline(ticks);
+
+    pthread_mutex_lock(&queue->lock);
+    while (queue->count == 0)
+    {
+        if (!host_cond_wait(&queue->not_empty, &queue->lock, ticks, &deadline))
+        {
+            pthread_mutex_unlock(&queue->lock);
+            return pdFALSE;
+        }
+    }
+
+    memcpy(item, queue->items + queue->head * queue->item_size, queue->item_size);
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+
+    pthread_cond_signal(&queue->not_full);
+    pthread_mutex_unlock(&queue->lock);
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    pthread_mutex_lock(&queue->lock);
+    UBaseType_t count = queue->count;
+    pthread_mutex_unlock(&queue->lock);
+    return count;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue)
+    {
+        pthread_mutex_destroy(&queue->lock);
+        pthread_cond_destroy(&queue->not_empty);
+        pthread_cond_destroy(&queue->not_full);
+        free(queue->items);
+        free(queue);
+    }
+}
+
+/* SEMAPHORE FUNCTIONS -------------------------------------------------------*/
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    struct host_mutex* sem = calloc(1, sizeof(*sem));
+    if (sem)
+    {
+        pthread_mutex_init(&sem->lock, NULL);
+    }
+    return sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY)
+    {
+        return pthread_mutex_lock(&sem->lock) == 0 ? pdTRUE : pdFALSE;
+    }
+    if (ticks == 0)
+    {
+        return pthread_mutex_trylock(&sem->lock) == 0 ? pdTRUE : pdFALSE;
+    }
+
+    struct timespec deadline = host_deadline(ticks);
+    return pthread_mutex_clocklock(&sem->lock, CLOCK_MONOTONIC, &deadline) == 0 ? pdTRUE : pdFALSE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    return pthread_mutex_unlock(&sem->lock) == 0 ? pdTRUE : pdFALSE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    if (sem)
+    {
+        pthread_mutex_destroy(&sem->lock);
+        free(sem);
+    }
+}
+
+/* RING BUFFER FUNCTIONS -----------------------------------------------------*/
+RingbufHandle_t xRingbufferCreate(size_t size, RingbufferType_t type)
+{
+    if (type != RINGBUF_TYPE_NOSPLIT)
+    {
+        return NULL;
+    }
+
+    struct host_ringbuf* ring = calloc(1, sizeof(*ring));
+    if (ring)
+    {
+        ring->capacity = size;
+        pthread_mutex_init(&ring->lock, NULL);
+        host_cond_init(&ring->not_empty);
+    }
+    return ring;
+}
+
+BaseType_t xRingbufferSend(RingbufHandle_t ring, const void* data, size_t size, TickType_t ticks)
+{
+    // Same accounting as esp_ringbuf: header plus the item rounded up to 4 bytes.
+    // Only non-blocking sends are needed (deferred_log), so a full ring fails at once.
+    (void)ticks;
+    size_t cost = HOST_RINGBUF_OVERHEAD + ((size + 3) & ~(size_t)3);
+
+    pthread_mutex_lock(&ring->lock);
+    if (ring->used + cost > ring->capacity)
+    {
+        pthread_mutex_unlock(&ring->lock);
+        return pdFALSE;
+    }
+    ring->used += cost;
+    pthread_mutex_unlock(&ring->lock);
+
+    rb_item_t* item = malloc(sizeof(rb_item_t) + size);
+    if (!item)
+    {
+        pthread_mutex_lock(&ring->lock);
+        ring->used -= cost;
+        pthread_mutex_unlock(&ring->lock);
+        return pdFALSE;
+    }
+    item->next = NULL;
+    item->size = size;
+    item->cost = cost;
+    memcpy(item->data, data, size);
+
+    pthread_mutex_lock(&ring->lock);
+    if (ring->tail)
+    {
+        ring->tail->next = item;
+    }
+    else
+    {
+        ring->head = item;
+    }
+    ring->tail = item;
+    pthread_cond_signal(&ring->not_empty);
+    pthread_mutex_unlock(&ring->lock);
+
+    return pdTRUE;
+}
+
+void* xRingbufferReceive(RingbufHandle_t ring, size_t* size, TickType_t ticks)
+{
+    struct timespec deadline = host_deadline(ticks);
+
+    pthread_mutex_lock(&ring->lock);
+    while (!ring->head)
+    {
+        if (!host_cond_wait(&ring->not_empty, &ring->lock, ticks, &deadline))
+        {
+            pthread_mutex_unlock(&ring->lock);
+            return NULL;
+        }
+    }
+
+    rb_item_t* item = ring->head;
+    ring->head = item->next;
+    if (!ring->head)
+    {
+        ring->tail = NULL;
+    }
+    pthread_mutex_unlock(&ring->lock);
+
+    if (size)
+    {
+        *size = item->size;
+    }
+    return item->data;
+}
+
+void vRingbufferReturnItem(RingbufHandle_t ring, void* data)
+{
+    rb_item_t* item = (rb_item_t*)((uint8_t*)data - offsetof(rb_item_t, data));
+
+    // Space is released on return, as in esp_ringbuf
+    pthread_mutex_lock(&ring->lock);
+    ring->used -= item->cost;
+    pthread_mutex_unlock(&ring->lock);
+
+    free(item);
+}
+
+void vRingbufferDelete(RingbufHandle_t ring)
+{
+    if (!ring)
+    {
+        return;
+    }
+
+    while (ring->head)
+    {
+        rb_item_t* next = ring->head->next;
+        free(ring->head);
+        ring->head = next;
+    }
+    pthread_mutex_destroy(&ring->lock);
+    pthread_cond_destroy(&ring->not_empty);
+    free(ring);
+}
@@ -0,0 +1,163 @@
+/**
+ * @file host_main.c
+ * @brief Entry point of the host build: parse options, run app_main() as the "main" task
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include "host.h"
+#include "sdkconfig.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <getopt.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define HOST_MAIN_TASK_STACK    3584    // CONFIG_ESP_MAIN_TASK_STACK_SIZE
+#define HOST_MAIN_TASK_PRIORITY 1
+
+/* VARIABLES -----------------------------------------------------------------*/
+host_config_t g_host = {
+    .broker_url = "mqtt://127.0.0.1:1883",
+    .username = "",
+    .password = "",
+    .group = "",
+    .mac = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x00 },
+    .log_level = ESP_LOG_INFO,
+};
+
+/* EXTERNAL FUNCTIONS --------------------------------------------------------*/
+extern void app_main(void);
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+static void usage(const char* prog)
+{
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -b, --broker URL      MQTT broker (default %s)\n"
+            "  -u, --user NAME       MQTT username\n"
+            "  -p, --pass SECRET     MQTT password\n"
+            "  -d, --uart DEVICE     Read the STM32 from a serial device instead of a pty\n"
+            "  -l, --pty-link PATH   Symlink the pty slave to PATH\n"
+            "  -c, --capture FILE    Record every UART read to a DLCAP1 capture\n"
+            "  -i, --id HEX6         Last three MAC bytes, i.e. client id ESP32_<HEX6> (default from pid)\n"
+            "  -g, --group NAME      Command group besides \"all\" (CONFIG_BRIDGE_COMMAND_GROUP)\n"
+            "  -e, --encoding ENC    text (default) or cbor for samples, state, trace and rollups\n"
+            "  -n, --batch N         Periodic samples per batch message, 0-64 (default 0)\n"
+            "  -k, --batch-format F  cbor (default) or delta (ts_codec) for batch messages\n"
+            "  -v, --log-level N     0=none .. 5=verbose (default %d)\n",
+            prog, g_host.broker_url, g_host.log_level);
+}
+
+static void main_task(void* param)
+{
+    (void)param;
+    app_main();
+    vTaskDelete(NULL);
+}
+
+/* MAIN ----------------------------------------------------------------------*/
+int main(int argc, char** argv)
+{
+    static const struct option options[] = {
+        { "broker",       required_argument, NULL, 'b' },
+        { "user",         required_argument, NULL, 'u' },
+        { "pass",         required_argument, NULL, 'p' },
+        { "uart",         required_argument, NULL, 'd' },
+        { "pty-link",     required_argument, NULL, 'l' },
+        { "capture",      required_argument, NULL, 'c' },
+        { "id",           required_argument, NULL, 'i' },
+        { "group",        required_argument, NULL, 'g' },
+        { "encoding",     required_argument, NULL, 'e' },
+        { "batch",        required_argument, NULL, 'n' },
+        { "batch-format", required_argument, NULL, 'k' },
+        { "log-level",    required_argument, NULL, 'v' },
+        { "help",         no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    // Distinct client ids for several bridges on one machine
+    pid_t pid = getpid();
+    g_host.mac[3] = (uint8_t)(pid >> 16);
+    g_host.mac[4] = (uint8_t)(pid >> 8);
+    g_host.mac[5] = (uint8_t)pid;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "b:u:p:d:l:c:i:g:e:n:k:v:h", options, NULL)) != -1)
+    {
+        switch (opt)
+        {
+        case 'b': g_host.broker_url = optarg; break;
+        case 'u': g_host.username = optarg; break;
+        case 'p': g_host.password = optarg; break;
+        case 'd': g_host.uart_device = optarg; break;
+        case 'l': g_host.pty_link = optarg; break;
+        case 'c': g_host.capture_path = optarg; break;
+        case 'g': g_host.group = optarg; break;
+        case 'e':
+            if (strcmp(optarg, "cbor") != 0 && strcmp(optarg, "text") != 0)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            g_host.cbor = (strcmp(optarg, "cbor") == 0);
+            break;
+        case 'n':
+            g_host.batch_size = atoi(optarg);
+            if (g_host.batch_size < 0 || g_host.batch_size > 64)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            break;
+        case 'k':
+            if (strcmp(optarg, "delta") != 0 && strcmp(optarg, "cbor") != 0)
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            g_host.batch_delta = (strcmp(optarg, "delta") == 0);
+            break;
+        case 'v': g_host.log_level = atoi(optarg); break;
+        case 'i':
+        {
+            unsigned long id = strtoul(optarg, NULL, 16);
+            g_host.mac[3] = (uint8_t)(id >> 16);
+            g_host.mac[4] = (uint8_t)(id >> 8);
+            g_host.mac[5] = (uint8_t)id;
+            break;
+        }
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    // Block the stop signals in every task; only this thread waits for them
+    sigset_t stop;
+    sigemptyset(&stop);
+    sigaddset(&stop, SIGINT);
+    sigaddset(&stop, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stop, NULL);
+
+    if (xTaskCreate(main_task, "main", HOST_MAIN_TASK_STACK, NULL, HOST_MAIN_TASK_PRIORITY, NULL) != pdPASS)
+    {
+        fprintf(stderr, "Cannot start the main task\n");
+        return 1;
+    }
+
+    int sig;
+    sigwait(&stop, &sig);
+
+    // Removes the pty link and completes the capture file
+    uart_driver_delete(CONFIG_MQTT_UART_PORT_NUM);
+    printf("Stopped by signal %d, peak RSS %llu kB\n", sig,
+           (unsigned long long)(Host_PeakRssBytes() / 1024));
+    fflush(stdout);
+    return 0;
+}
@@ -0,0 +1,680 @@
+/**
+ * @file host_mqtt.c
+ * @brief Minimal MQTT 3.1.1 client behind the esp-mqtt API (plain TCP, mqtt:// only)
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include "mqtt_client.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define MQTT_HOST_DEFAULT_PORT      "1883"
+#define MQTT_HOST_MAX_PACKET        8192            // Room for rollup messages (up to ~6 KB)
+#define MQTT_HOST_TASK_STACK        6144
+#define MQTT_HOST_POLL_MS           100
+
+/* Control packet types (upper nibble of the fixed header) */
+#define MQTT_PKT_CONNECT            0x10
+#define MQTT_PKT_CONNACK            0x20
+#define MQTT_PKT_PUBLISH            0x30
+#define MQTT_PKT_PUBACK             0x40
+#define MQTT_PKT_PUBREC             0x50
+#define MQTT_PKT_PUBREL             0x60
+#define MQTT_PKT_PUBCOMP            0x70
+#define MQTT_PKT_SUBSCRIBE          0x80
+#define MQTT_PKT_SUBACK             0x90
+#define MQTT_PKT_UNSUBACK           0xB0
+#define MQTT_PKT_PINGREQ            0xC0
+#define MQTT_PKT_PINGRESP           0xD0
+#define MQTT_PKT_DISCONNECT         0xE0
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+struct esp_mqtt_client {
+    char host[128];
+    char port[8];
+    char* client_id;
+    char* username;
+    char* password;
+    int keepalive_s;
+    int reconnect_ms;
+    int timeout_ms;
+    bool auto_reconnect;
+    int task_priority;
+
+    esp_event_handler_t handler;
+    void* handler_arg;
+
+    int sock;
+    pthread_mutex_t write_lock;     // Serializes packet writes from any task
+    volatile bool connected;
+    volatile bool running;
+    volatile bool task_done;
+    uint16_t next_msg_id;
+    int64_t last_tx_us;
+    int64_t last_rx_us;
+
+    uint8_t* rx;                    // Receive buffer, rx_len bytes pending
+    size_t rx_len;
+};
+
+/* STATIC VARIABLES ----------------------------------------------------------*/
+static const char *TAG = "HOST_MQTT";
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+static char* mqtt_strdup(const char* s)
+{
+    return (s && *s) ? strdup(s) : NULL;
+}
+
+static void mqtt_dispatch(esp_mqtt_client_handle_t client, esp_mqtt_event_t* event)
+{
+    event->client = client;
+    if (client->handler)
+    {
+        client->handler(client->handler_arg, "MQTT_EVENTS", event->event_id, event);
+    }
+}
+
+static void mqtt_simple_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t id, int msg_id)
+{
+    esp_mqtt_event_t event = { .event_id = id, .msg_id = msg_id };
+    mqtt_dispatch(client, &event);
+}
+
+static uint16_t mqtt_next_id(esp_mqtt_client_handle_t client)
+{
+    uint16_t id = __atomic_add_fetch(&client->next_msg_id, 1, __ATOMIC_RELAXED);
+    return id ? id : __atomic_add_fetch(&client->next_msg_id, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Encode the fixed header; returns its length (2-5 bytes)
+ */
+static size_t mqtt_fixed_header(uint8_t* out, uint8_t type_flags, size_t remaining)
+{
+    size_t n = 0;
+    out[n++] = type_flags;
+    do
+    {
+        uint8_t digit = remaining % 128;
+        remaining /= 128;
+        out[n++] = digit | (remaining ? 0x80 : 0);
+    } while (remaining);
+    return n;
+}
+
+static size_t mqtt_put_string(uint8_t* out, const char* s, size_t len)
+{
+    out[0] = (uint8_t)(len >> 8);
+    out[1] = (uint8_t)len;
+    memcpy(out + 2, s, len);
+    return len + 2;
+}
+
+/**
+ * @brief Write a whole packet under the write lock
+ */
+static bool mqtt_send(esp_mqtt_client_handle_t client, const uint8_t* data, size_t len)
+{
+    bool ok = true;
+
+    pthread_mutex_lock(&client->write_lock);
+    size_t sent = 0;
+    while (client->sock >= 0 && sent < len)
+    {
+        ssize_t n = send(client->sock, data + sent, len - sent, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            ok = false;
+            break;
+        }
+        sent += (size_t)n;
+    }
+    ok = ok && sent == len;
+    if (ok)
+    {
+        client->last_tx_us = esp_timer_get_time();
+    }
+    pthread_mutex_unlock(&client->write_lock);
+
+    return ok;
+}
+
+static bool mqtt_send_ack(esp_mqtt_client_handle_t client, uint8_t type_flags, uint16_t msg_id)
+{
+    uint8_t pkt[4] = { type_flags, 2, (uint8_t)(msg_id >> 8), (uint8_t)msg_id };
+    return mqtt_send(client, pkt, sizeof(pkt));
+}
+
+static void mqtt_close(esp_mqtt_client_handle_t client)
+{
+    pthread_mutex_lock(&client->write_lock);
+    client->connected = false;
+    if (client->sock >= 0)
+    {
+        close(client->sock);
+        client->sock = -1;
+    }
+    client->rx_len = 0;
+    pthread_mutex_unlock(&client->write_lock);
+}
+
+static bool mqtt_open_socket(esp_mqtt_client_handle_t client)
+{
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo* res = NULL;
+
+    if (getaddrinfo(client->host, client->port, &hints, &res) != 0)
+    {
+        ESP_LOGE(TAG, "Cannot resolve %s", client->host);
+        return false;
+    }
+
+    int sock = -1;
+    for (struct addrinfo* ai = res; ai; ai = ai->ai_next)
+    {
+        sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (sock < 0)
+        {
+            continue;
+        }
+        if (connect(sock, ai->ai_addr, ai->ai_addrlen) == 0)
+        {
+            break;
+        }
+        close(sock);
+        sock = -1;
+    }
+    freeaddrinfo(res);
+
+    if (sock < 0)
+    {
+        ESP_LOGE(TAG, "Cannot connect to %s:%s: %s", client->host, client->port, strerror(errno));
+        return false;
+    }
+
+    // Small packets back to back: do not let Nagle hold the second one for an ACK
+    int one = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    pthread_mutex_lock(&client->write_lock);
+    client->sock = sock;
+    client->rx_len = 0;
+    pthread_mutex_unlock(&client->write_lock);
+    return true;
+}
+
+static bool mqtt_send_connect(esp_mqtt_client_handle_t client)
+{
+    size_t id_len = strlen(client->client_id);
+    size_t user_len = client->username ? strlen(client->username) : 0;
+    size_t pass_len = client->password ? strlen(client->password) : 0;
+    size_t remaining = 10 + 2 + id_len + (client->username ? 2 + user_len : 0) +
+                       (client->password ? 2 + pass_len : 0);
+
+    uint8_t* pkt = malloc(remaining + 5);
+    if (!pkt)
+    {
+        return false;
+    }
+
+    size_t n = mqtt_fixed_header(pkt, MQTT_PKT_CONNECT, remaining);
+    n += mqtt_put_string(pkt + n, "MQTT", 4);
+    pkt[n++] = 4;                                           // Protocol level 3.1.1
+    pkt[n++] = 0x02 | (client->username ? 0x80 : 0) | (client->password ? 0x40 : 0);
+    pkt[n++] = (uint8_t)(client->keepalive_s >> 8);
+    pkt[n++] = (uint8_t)client->keepalive_s;
+    n += mqtt_put_string(pkt + n, client->client_id, id_len);
+    if (client->username)
+    {
+        n += mqtt_put_string(pkt + n, client->username, user_len);
+    }
+    if (client->password)
+    {
+        n += mqtt_put_string(pkt + n, client->password, pass_len);
+    }
+
+    bool ok = mqtt_send(client, pkt, n);
+    free(pkt);
+    return ok;
+}
+
+/**
+ * @brief Handle one complete packet; false if the connection must be dropped
+ */
+static bool mqtt_handle_packet(esp_mqtt_client_handle_t client, uint8_t header,
+                               uint8_t* body, size_t len)
+{
+    uint16_t msg_id = (len >= 2) ? (uint16_t)((body[0] << 8) | body[1]) : 0;
+
+    switch (header & 0xF0)
+    {
+    case MQTT_PKT_CONNACK:
+    {
+        if (len < 2 || body[1] != 0)
+        {
+            ESP_LOGE(TAG, "Connection refused, return code %d", len >= 2 ? body[1] : -1);
+            mqtt_simple_event(client, MQTT_EVENT_ERROR, -1);
+            return false;
+        }
+        client->connected = true;
+        esp_mqtt_event_t event = { .event_id = MQTT_EVENT_CONNECTED, .session_present = body[0] & 1 };
+        mqtt_dispatch(client, &event);
+        return true;
+    }
+
+    case MQTT_PKT_PUBLISH:
+    {
+        int qos = (header >> 1) & 3;
+        if (len < 2)
+        {
+            return false;
+        }
+        size_t topic_len = (size_t)((body[0] << 8) | body[1]);
+        size_t pos = 2 + topic_len;
+        if (pos + (qos ? 2 : 0) > len)
+        {
+            return false;
+        }
+        uint16_t id = 0;
+        if (qos)
+        {
+            id = (uint16_t)((body[pos] << 8) | body[pos + 1]);
+            pos += 2;
+        }
+
+        esp_mqtt_event_t event = {
+            .event_id = MQTT_EVENT_DATA,
+            .topic = (char*)body + 2, .topic_len = (int)topic_len,
+            .data = (char*)body + pos, .data_len = (int)(len - pos), .total_data_len = (int)(len - pos),
+            .msg_id = id, .qos = qos, .retain = header & 1, .dup = (header >> 3) & 1,
+        };
+        mqtt_dispatch(client, &event);
+
+        if (qos == 1)
+        {
+            return mqtt_send_ack(client, MQTT_PKT_PUBACK, id);
+        }
+        if (qos == 2)
+        {
+            return mqtt_send_ack(client, MQTT_PKT_PUBREC, id);
+        }
+        return true;
+    }
+
+    case MQTT_PKT_PUBACK:
+    case MQTT_PKT_PUBCOMP:
+        mqtt_simple_event(client, MQTT_EVENT_PUBLISHED, msg_id);
+        return true;
+
+    case MQTT_PKT_PUBREC:
+        return mqtt_send_ack(client, MQTT_PKT_PUBREL | 0x02, msg_id);
+
+    case MQTT_PKT_PUBREL:
+        return mqtt_send_ack(client, MQTT_PKT_PUBCOMP, msg_id);
+
+    case MQTT_PKT_SUBACK:
+    {
+        // Like esp-mqtt: the return codes, one per topic, are the event data
+        esp_mqtt_event_t event = {
+            .event_id = MQTT_EVENT_SUBSCRIBED, .msg_id = msg_id,
+            .data = (char*)body + 2, .data_len = len > 2 ? (int)(len - 2) : 0,
+        };
+        mqtt_dispatch(client, &event);
+        return true;
+    }
+
+    case MQTT_PKT_UNSUBACK:
+        mqtt_simple_event(client, MQTT_EVENT_UNSUBSCRIBED, msg_id);
+        return true;
+
+    case MQTT_PKT_PINGRESP:
+        return true;
+
+    default:
+        ESP_LOGW(TAG, "Unexpected packet 0x%02X", header);
+        return true;
+    }
+}
+
+/**
+ * @brief Read what is available and handle every complete packet in the buffer
+ */
+static bool mqtt_receive(esp_mqtt_client_handle_t client)
+{
+    if (client->rx_len == MQTT_HOST_MAX_PACKET)
+    {
+        ESP_LOGE(TAG, "Packet larger than %d bytes", MQTT_HOST_MAX_PACKET);
+        return false;
+    }
+
+    ssize_t n = recv(client->sock, client->rx + client->rx_len, MQTT_HOST_MAX_PACKET - client->rx_len, 0);
+    if (n <= 0)
+    {
+        return n < 0 && errno == EINTR;
+    }
+    client->rx_len += (size_t)n;
+    client->last_rx_us = esp_timer_get_time();
+
+    size_t pos = 0;
+    while (client->rx_len - pos >= 2)
+    {
+        size_t remaining = 0;
+        size_t hdr = 1;
+        uint32_t multiplier = 1;
+        bool complete_len = false;
+
+        while (hdr < 5 && pos + hdr < client->rx_len)
+        {
+            uint8_t digit = client->rx[pos + hdr++];
+            remaining += (digit & 0x7F) * multiplier;
+            multiplier *= 128;
+            if (!(digit & 0x80))
+            {
+                complete_len = true;
+                break;
+            }
+        }
+        if (!complete_len)
+        {
+            if (hdr == 5)
+            {
+                return false;   // Malformed length
+            }
+            break;
+        }
+        if (pos + hdr + remaining > client->rx_len)
+        {
+            break;
+        }
+
+        if (!mqtt_handle_packet(client, client->rx[pos], client->rx + pos + hdr, remaining))
+        {
+            return false;
+        }
+        pos += hdr + remaining;
+    }
+
+    memmove(client->rx, client->rx + pos, client->rx_len - pos);
+    client->rx_len -= pos;
+    return true;
+}
+
+static void mqtt_task(void* param)
+{
+    esp_mqtt_client_handle_t client = (esp_mqtt_client_handle_t)param;
+
+    while (client->running)
+    {
+        mqtt_simple_event(client, MQTT_EVENT_BEFORE_CONNECT, -1);
+
+        if (!mqtt_open_socket(client) || !mqtt_send_connect(client))
+        {
+            mqtt_simple_event(client, MQTT_EVENT_ERROR, -1);
+            mqtt_close(client);
+        }
+        else
+        {
+            int64_t start_us = esp_timer_get_time();
+            client->last_rx_us = start_us;
+
+            while (client->running)
+            {
+                struct pollfd pfd = { .fd = client->sock, .events = POLLIN };
+                int ready = poll(&pfd, 1, MQTT_HOST_POLL_MS);
+                if (ready > 0 && !mqtt_receive(client))
+                {
+                    break;
+                }
+
+                int64_t now = esp_timer_get_time();
+                if (!client->connected && now - start_us > (int64_t)client->timeout_ms * 1000)
+                {
+                    ESP_LOGE(TAG, "No CONNACK within %d ms", client->timeout_ms);
+                    break;
+                }
+                if (client->connected && now - client->last_tx_us >= (int64_t)client->keepalive_s * 500000)
+                {
+                    uint8_t ping[2] = { MQTT_PKT_PINGREQ, 0 };
+                    mqtt_send(client, ping, sizeof(ping));
+                }
+                if (now - client->last_rx_us > (int64_t)client->keepalive_s * 1500000)
+                {
+                    ESP_LOGE(TAG, "Broker silent for %d s", client->keepalive_s * 3 / 2);
+                    break;
+                }
+            }
+
+            bool was_connected = client->connected;
+            mqtt_close(client);
+            if (was_connected)
+            {
+                mqtt_simple_event(client, MQTT_EVENT_DISCONNECTED, -1);
+            }
+        }
+
+        if (!client->auto_reconnect)
+        {
+            break;
+        }
+        for (int waited = 0; client->running && waited < client->reconnect_ms; waited += MQTT_HOST_POLL_MS)
+        {
+            vTaskDelay(pdMS_TO_TICKS(MQTT_HOST_POLL_MS));
+        }
+    }
+
+    client->task_done = true;
+    vTaskDelete(NULL);
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+esp_mqtt_client_handle_t esp_mqtt_client_init(const esp_mqtt_client_config_t* config)
+{
+    const char* uri = config ? config->broker.address.uri : NULL;
+    if (!uri || strncmp(uri, "mqtt://", 7) != 0)
+    {
+        ESP_LOGE(TAG, "Only mqtt:// URIs are supported");
+        return NULL;
+    }
+
+    esp_mqtt_client_handle_t client = calloc(1, sizeof(*client));
+    if (!client)
+    {
+        return NULL;
+    }
+
+    // mqtt://host[:port][/path]
+    const char* host = uri + 7;
+    size_t host_len = strcspn(host, ":/");
+    if (host_len == 0 || host_len >= sizeof(client->host))
+    {
+        free(client);
+        return NULL;
+    }
+    memcpy(client->host, host, host_len);
+    if (host[host_len] == ':')
+    {
+        snprintf(client->port, sizeof(client->port), "%.*s",
+                 (int)strcspn(host + host_len + 1, "/"), host + host_len + 1);
+    }
+    else
+    {
+        strcpy(client->port, MQTT_HOST_DEFAULT_PORT);
+    }
+
+    client->client_id = strdup(config->credentials.client_id ? config->credentials.client_id : "host");
+    client->username = mqtt_strdup(config->credentials.username);
+    client->password = mqtt_strdup(config->credentials.authentication.password);
+    client->keepalive_s = config->session.keepalive > 0 ? config->session.keepalive : 120;
+    client->reconnect_ms = config->network.reconnect_timeout_ms > 0 ? config->network.reconnect_timeout_ms : 10000;
+    client->timeout_ms = config->network.timeout_ms > 0 ? config->network.timeout_ms : 10000;
+    client->auto_reconnect = !config->network.disable_auto_reconnect;
+    client->task_priority = config->task.priority > 0 ? config->task.priority : 5;
+    client->sock = -1;
+    client->rx = malloc(MQTT_HOST_MAX_PACKET);
+    pthread_mutex_init(&client->write_lock, NULL);
+
+    if (!client->rx || !client->client_id)
+    {
+        esp_mqtt_client_destroy(client);
+        return NULL;
+    }
+    return client;
+}
+
+esp_err_t esp_mqtt_client_register_event(esp_mqtt_client_handle_t client, esp_mqtt_event_id_t event,
+                                         esp_event_handler_t handler, void* handler_arg)
+{
+    (void)event;    // Every event goes to the one handler, as mqtt_handler registers ANY_ID
+    if (!client)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    client->handler = handler;
+    client->handler_arg = handler_arg;
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_start(esp_mqtt_client_handle_t client)
+{
+    if (!client || client->running)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    client->running = true;
+    client->task_done = false;
+    if (xTaskCreate(mqtt_task, "mqtt_task", MQTT_HOST_TASK_STACK, client,
+                    client->task_priority, NULL) != pdPASS)
+    {
+        client->running = false;
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_stop(esp_mqtt_client_handle_t client)
+{
+    if (!client || !client->running)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    if (client->connected)
+    {
+        uint8_t bye[2] = { MQTT_PKT_DISCONNECT, 0 };
+        mqtt_send(client, bye, sizeof(bye));
+    }
+    client->running = false;
+    while (!client->task_done)
+    {
+        vTaskDelay(pdMS_TO_TICKS(MQTT_HOST_POLL_MS));
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_mqtt_client_destroy(esp_mqtt_client_handle_t client)
+{
+    if (!client)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (client->running)
+    {
+        esp_mqtt_client_stop(client);
+    }
+
+    pthread_mutex_destroy(&client->write_lock);
+    free(client->client_id);
+    free(client->username);
+    free(client->password);
+    free(client->rx);
+    free(client);
+    return ESP_OK;
+}
+
+int esp_mqtt_client_subscribe(esp_mqtt_client_handle_t client, const char* topic, int qos)
+{
+    if (!client || !topic || !client->connected)
+    {
+        return -1;
+    }
+
+    size_t topic_len = strlen(topic);
+    uint8_t pkt[5 + 2 + 2 + 256 + 1];
+    if (topic_len > 256)
+    {
+        return -1;
+    }
+
+    uint16_t msg_id = mqtt_next_id(client);
+    size_t n = mqtt_fixed_header(pkt, MQTT_PKT_SUBSCRIBE | 0x02, 2 + 2 + topic_len + 1);
+    pkt[n++] = (uint8_t)(msg_id >> 8);
+    pkt[n++] = (uint8_t)msg_id;
+    n += mqtt_put_string(pkt + n, topic, topic_len);
+    pkt[n++] = (uint8_t)(qos & 3);
+
+    return mqtt_send(client, pkt, n) ? msg_id : -1;
+}
+
+int esp_mqtt_client_publish(esp_mqtt_client_handle_t client, const char* topic,
+                            const char* data, int len, int qos, int retain)
+{
+    if (!client || !topic || !client->connected)
+    {
+        return -1;
+    }
+
+    size_t topic_len = strlen(topic);
+    size_t data_len = data ? (len > 0 ? (size_t)len : strlen(data)) : 0;
+    size_t remaining = 2 + topic_len + (qos ? 2 : 0) + data_len;
+    if (remaining > MQTT_HOST_MAX_PACKET)
+    {
+        return -1;
+    }
+
+    uint8_t stack_buf[512];
+    uint8_t* pkt = (remaining + 5 <= sizeof(stack_buf)) ? stack_buf : malloc(remaining + 5);
+    if (!pkt)
+    {
+        return -1;
+    }
+
+    uint16_t msg_id = qos ? mqtt_next_id(client) : 0;
+    size_t n = mqtt_fixed_header(pkt, MQTT_PKT_PUBLISH | ((qos & 3) << 1) | (retain ? 1 : 0), remaining);
+    n += mqtt_put_string(pkt + n, topic, topic_len);
+    if (qos)
+    {
+        pkt[n++] = (uint8_t)(msg_id >> 8);
+        pkt[n++] = (uint8_t)msg_id;
+    }
+    if (data_len)
+    {
+        memcpy(pkt + n, data, data_len);
+        n += data_len;
+    }
+
+    bool ok = mqtt_send(client, pkt, n);
+    if (pkt != stack_buf)
+    {
+        free(pkt);
+    }
+    return ok ? msg_id : -1;
+}
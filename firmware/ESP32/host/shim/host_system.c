@@ -0,0 +1,242 @@
+/**
+ * @file host_system.c
+ * @brief esp_log, esp_timer, heap figures, GPIO and the no-op NVS/netif/Wi-Fi layers
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include "host.h"
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_system.h"
+#include "esp_heap_caps.h"
+#include "esp_event.h"
+#include "esp_netif.h"
+#include "esp_wifi.h"
+#include "nvs_flash.h"
+#include "protocol_examples_common.h"
+#include "example_common_private.h"
+#include "driver/gpio.h"
+#include <malloc.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+#define HOST_GPIO_COUNT     49
+
+/* STATIC VARIABLES ----------------------------------------------------------*/
+static pthread_mutex_t s_log_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t s_min_free_heap = HOST_HEAP_SIZE;
+static uint8_t s_gpio_level[HOST_GPIO_COUNT];
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+
+/**
+ * @brief Bytes currently allocated, task stacks included as on the ESP32
+ */
+static size_t host_heap_in_use(void)
+{
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd + Host_TaskStackBytes();
+}
+
+/* LOG FUNCTIONS -------------------------------------------------------------*/
+void esp_log_write(esp_log_level_t level, const char* tag, const char* format, ...)
+{
+    (void)level;
+    (void)tag;
+
+    FILE* out = g_host.log_stream ? g_host.log_stream : stdout;
+    va_list ap;
+    va_start(ap, format);
+    pthread_mutex_lock(&s_log_lock);
+    vfprintf(out, format, ap);
+    fflush(out);
+    pthread_mutex_unlock(&s_log_lock);
+    va_end(ap);
+}
+
+esp_log_level_t esp_log_level_get(const char* tag)
+{
+    (void)tag;
+    return (esp_log_level_t)g_host.log_level;
+}
+
+void esp_log_level_set(const char* tag, esp_log_level_t level)
+{
+    (void)tag;
+    g_host.log_level = (int)level;
+}
+
+uint32_t esp_log_timestamp(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/* TIMER FUNCTIONS -----------------------------------------------------------*/
+int64_t esp_timer_get_time(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* SYSTEM FUNCTIONS ----------------------------------------------------------*/
+uint32_t esp_get_free_heap_size(void)
+{
+    size_t used = host_heap_in_use();
+    uint32_t free_bytes = used < HOST_HEAP_SIZE ? (uint32_t)(HOST_HEAP_SIZE - used) : 0;
+
+    // Sampled on each call, so the minimum is only as good as the call rate
+    if (free_bytes < s_min_free_heap)
+    {
+        s_min_free_heap = free_bytes;
+    }
+    return free_bytes;
+}
+
+uint32_t esp_get_minimum_free_heap_size(void)
+{
+    esp_get_free_heap_size();
+    return s_min_free_heap;
+}
+
+size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    (void)caps;
+    return esp_get_free_heap_size();
+}
+
+const char* esp_get_idf_version(void)
+{
+    return "host";
+}
+
+void esp_restart(void)
+{
+    fprintf(stderr, "esp_restart() called, exiting\n");
+    exit(1);
+}
+
+uint64_t Host_PeakRssBytes(void)
+{
+    // VmHWM rather than getrusage(): ru_maxrss also counts the image before exec()
+    char line[128];
+    uint64_t kb = 0;
+    FILE* f = fopen("/proc/self/status", "r");
+    if (!f)
+    {
+        return 0;
+    }
+    while (fgets(line, sizeof(line), f))
+    {
+        if (strncmp(line, "VmHWM:", 6) == 0)
+        {
+            kb = strtoull(line + 6, NULL, 10);
+            break;
+        }
+    }
+    fclose(f);
+    return kb * 1024;
+}
+
+#ifdef HOST_NEEDS_STRLCPY
+size_t strlcpy(char* dst, const char* src, size_t size)
+{
+    size_t len = strlen(src);
+    if (size)
+    {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+const char* esp_err_to_name(esp_err_t code)
+{
+    switch (code)
+    {
+    case ESP_OK:                return "ESP_OK";
+    case ESP_FAIL:              return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:        return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:   return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_NOT_FOUND:     return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT:       return "ESP_ERR_TIMEOUT";
+    default:                    return "ESP_ERR_UNKNOWN";
+    }
+}
+
+/* PLATFORM STUBS ------------------------------------------------------------*/
+esp_err_t nvs_flash_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_netif_init(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_event_loop_create_default(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t example_connect(void)
+{
+    return ESP_OK;
+}
+
+esp_err_t example_disconnect(void)
+{
+    return ESP_OK;
+}
+
+void example_wifi_stop(void)
+{
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6])
+{
+    (void)ifx;
+    memcpy(mac, g_host.mac, 6);
+    return ESP_OK;
+}
+
+/* GPIO FUNCTIONS ------------------------------------------------------------*/
+esp_err_t gpio_config(const gpio_config_t* config)
+{
+    return (config && config->pin_bit_mask >> HOST_GPIO_COUNT == 0) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    if (gpio < 0 || gpio >= HOST_GPIO_COUNT)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_gpio_level[gpio] = level ? 1 : 0;
+    return ESP_OK;
+}
+
+int gpio_get_level(gpio_num_t gpio)
+{
+    return (gpio >= 0 && gpio < HOST_GPIO_COUNT) ? s_gpio_level[gpio] : 0;
+}
+
+esp_err_t gpio_reset_pin(gpio_num_t gpio)
+{
+    return gpio_set_level(gpio, 0);
+}
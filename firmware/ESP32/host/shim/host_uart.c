@@ -0,0 +1,330 @@
+/**
+ * @file host_uart.c
+ * @brief UART driver over a pseudo-terminal, or a real serial device
+ *
+ * With no device configured, uart_driver_install() creates a pty and logs the
+ * slave path. Whatever is written there (a recorded stream, a feeder script,
+ * `cat` of a capture) is what the bridge reads as STM32 output, and commands
+ * sent to the STM32 can be read back from it.
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#define _GNU_SOURCE
+#include "host.h"
+#include "dlcap.h"
+#include "driver/uart.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <pty.h>
+#include <stdio.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef struct {
+    int fd;                     // Read/write side used by the bridge
+    int hold_fd;                // pty slave kept open so reads do not fail between writers
+    bool installed;
+} host_uart_t;
+
+/* STATIC VARIABLES ----------------------------------------------------------*/
+static const char *TAG = "HOST_UART";
+static host_uart_t s_uart[UART_NUM_MAX];
+
+// One capture for the process: the bridge has a single STM32 UART
+static dlcap_t s_capture;
+static bool s_capturing = false;
+static int64_t s_capture_start_us = 0;
+static pthread_mutex_t s_capture_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* PRIVATE FUNCTIONS ---------------------------------------------------------*/
+static host_uart_t* host_uart_get(uart_port_t port)
+{
+    return (port >= 0 && port < UART_NUM_MAX && s_uart[port].installed) ? &s_uart[port] : NULL;
+}
+
+static void host_uart_make_raw(int fd)
+{
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0)
+    {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+}
+
+static speed_t host_uart_speed(int baud_rate)
+{
+    switch (baud_rate)
+    {
+    case 9600:      return B9600;
+    case 19200:     return B19200;
+    case 38400:     return B38400;
+    case 57600:     return B57600;
+    case 230400:    return B230400;
+    case 460800:    return B460800;
+    case 921600:    return B921600;
+    default:        return B115200;
+    }
+}
+
+static void host_uart_capture(const uint8_t* data, size_t len)
+{
+    pthread_mutex_lock(&s_capture_lock);
+    if (s_capturing && !DLCap_Write(&s_capture, (uint64_t)(esp_timer_get_time() - s_capture_start_us), data, len))
+    {
+        ESP_LOGE(TAG, "Capture write failed, capture stopped");
+        DLCap_Close(&s_capture);
+        s_capturing = false;
+    }
+    pthread_mutex_unlock(&s_capture_lock);
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size,
+                              int queue_size, void* uart_queue, int intr_alloc_flags)
+{
+    (void)rx_buffer_size;
+    (void)tx_buffer_size;
+    (void)queue_size;
+    (void)uart_queue;
+    (void)intr_alloc_flags;
+
+    if (port < 0 || port >= UART_NUM_MAX || s_uart[port].installed)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    host_uart_t* uart = &s_uart[port];
+    uart->hold_fd = -1;
+
+    if (g_host.uart_device)
+    {
+        uart->fd = open(g_host.uart_device, O_RDWR | O_NOCTTY);
+        if (uart->fd < 0)
+        {
+            ESP_LOGE(TAG, "Cannot open %s: %s", g_host.uart_device, strerror(errno));
+            return ESP_FAIL;
+        }
+        host_uart_make_raw(uart->fd);
+        ESP_LOGI(TAG, "UART%d on %s", port, g_host.uart_device);
+    }
+    else
+    {
+        char slave_path[64];
+        if (openpty(&uart->fd, &uart->hold_fd, slave_path, NULL, NULL) != 0)
+        {
+            ESP_LOGE(TAG, "openpty failed: %s", strerror(errno));
+            return ESP_FAIL;
+        }
+        // No echo or newline translation: the slave side behaves like the STM32 wire
+        host_uart_make_raw(uart->hold_fd);
+
+        if (g_host.pty_link)
+        {
+            unlink(g_host.pty_link);
+            if (symlink(slave_path, g_host.pty_link) != 0)
+            {
+                ESP_LOGW(TAG, "Cannot link %s: %s", g_host.pty_link, strerror(errno));
+            }
+        }
+        ESP_LOGI(TAG, "UART%d on pty %s%s%s", port, slave_path,
+                 g_host.pty_link ? " -> " : "", g_host.pty_link ? g_host.pty_link : "");
+    }
+
+    uart->installed = true;
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t port)
+{
+    host_uart_t* uart = host_uart_get(port);
+    if (!uart)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    close(uart->fd);
+    if (uart->hold_fd >= 0)
+    {
+        close(uart->hold_fd);
+    }
+    if (g_host.pty_link && !g_host.uart_device)
+    {
+        unlink(g_host.pty_link);
+    }
+
+    pthread_mutex_lock(&s_capture_lock);
+    if (s_capturing)
+    {
+        DLCap_Close(&s_capture);
+        s_capturing = false;
+    }
+    pthread_mutex_unlock(&s_capture_lock);
+
+    uart->installed = false;
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t* config)
+{
+    host_uart_t* uart = host_uart_get(port);
+    if (!uart || !config)
+    {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // The capture starts here, where the line rate for its header is known
+    pthread_mutex_lock(&s_capture_lock);
+    if (g_host.capture_path && !s_capturing)
+    {
+        s_capturing = DLCap_Create(&s_capture, g_host.capture_path, (uint32_t)config->baud_rate);
+        s_capture_start_us = esp_timer_get_time();
+        if (s_capturing)
+        {
+            ESP_LOGI(TAG, "Capturing UART%d to %s", port, g_host.capture_path);
+        }
+        else
+        {
+            ESP_LOGE(TAG, "Cannot create capture %s", g_host.capture_path);
+        }
+    }
+    pthread_mutex_unlock(&s_capture_lock);
+
+    // A pty has no line rate; a real device gets the configured baud, 8N1
+    if (g_host.uart_device)
+    {
+        struct termios tio;
+        if (tcgetattr(uart->fd, &tio) == 0)
+        {
+            cfsetspeed(&tio, host_uart_speed(config->baud_rate));
+            tcsetattr(uart->fd, TCSANOW, &tio);
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts)
+{
+    (void)tx;
+    (void)rx;
+    (void)rts;
+    (void)cts;
+    return host_uart_get(port) ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+int uart_read_bytes(uart_port_t port, void* buf, uint32_t length, TickType_t ticks)
+{
+    host_uart_t* uart = host_uart_get(port);
+    if (!uart || !buf)
+    {
+        return -1;
+    }
+
+    // Like the IDF driver: return once length bytes arrived or the timeout expired
+    int64_t deadline_us = esp_timer_get_time() + (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+    uint32_t got = 0;
+
+    while (got < length)
+    {
+        int64_t left_us = deadline_us - esp_timer_get_time();
+        if (left_us <= 0)
+        {
+            break;
+        }
+
+        struct pollfd pfd = { .fd = uart->fd, .events = POLLIN };
+        int ready = poll(&pfd, 1, (int)((left_us + 999) / 1000));
+        if (ready < 0 && errno != EINTR)
+        {
+            return -1;
+        }
+        if (ready <= 0)
+        {
+            continue;
+        }
+
+        ssize_t n = read(uart->fd, (uint8_t*)buf + got, length - got);
+        if (n > 0)
+        {
+            host_uart_capture((const uint8_t*)buf + got, (size_t)n);
+            got += (uint32_t)n;
+        }
+        else if (n < 0 && errno != EINTR && errno != EAGAIN)
+        {
+            return got ? (int)got : -1;
+        }
+    }
+
+    return (int)got;
+}
+
+int uart_write_bytes(uart_port_t port, const void* src, size_t size)
+{
+    host_uart_t* uart = host_uart_get(port);
+    if (!uart || !src)
+    {
+        return -1;
+    }
+
+    size_t sent = 0;
+    while (sent < size)
+    {
+        ssize_t n = write(uart->fd, (const uint8_t*)src + sent, size - sent);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+    return (int)sent;
+}
+
+esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks)
+{
+    (void)ticks;
+    host_uart_t* uart = host_uart_get(port);
+    if (!uart)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (g_host.uart_device)
+    {
+        tcdrain(uart->fd);
+    }
+    return ESP_OK;
+}
+
+esp_err_t uart_flush_input(uart_port_t port)
+{
+    host_uart_t* uart = host_uart_get(port);
+    if (!uart)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Discard whatever already arrived, without waiting for more
+    uint8_t scratch[256];
+    struct pollfd pfd = { .fd = uart->fd, .events = POLLIN };
+    while (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN))
+    {
+        if (read(uart->fd, scratch, sizeof(scratch)) <= 0)
+        {
+            break;
+        }
+    }
+    return ESP_OK;
+}
+
+esp_err_t uart_flush(uart_port_t port)
+{
+    return uart_flush_input(port);
+}
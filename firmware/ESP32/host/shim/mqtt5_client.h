@@ -0,0 +1,10 @@
+/**
+ * @file mqtt5_client.h
+ * @brief Host shim: nothing beyond mqtt_client.h is used
+ */
+#ifndef HOST_MQTT5_CLIENT_H
+#define HOST_MQTT5_CLIENT_H
+
+#include "mqtt_client.h"
+
+#endif /* HOST_MQTT5_CLIENT_H */
@@ -0,0 +1,13 @@
+/**
+ * @file protocol_examples_common.h
+ * @brief Host shim: no Wi-Fi to bring up
+ */
+#ifndef HOST_PROTOCOL_EXAMPLES_COMMON_H
+#define HOST_PROTOCOL_EXAMPLES_COMMON_H
+
+#include "esp_err.h"
+
+esp_err_t example_connect(void);
+esp_err_t example_disconnect(void);
+
+#endif /* HOST_PROTOCOL_EXAMPLES_COMMON_H */
@@ -0,0 +1,62 @@
+/**
+ * @file sdkconfig.h
+ * @brief Host build configuration: Kconfig defaults of the bridge, ESP32 target values
+ * 
+ * Broker, credentials and the UART device are chosen at run time (see host.h).
+ */
+#ifndef HOST_SDKCONFIG_H
+#define HOST_SDKCONFIG_H
+
+#include "host.h"
+
+/* Bridge Runtime Configuration */
+#define CONFIG_BROKER_URL                       (g_host.broker_url)
+#define CONFIG_MQTT_USERNAME                    (g_host.username)
+#define CONFIG_MQTT_PASSWORD                    (g_host.password)
+#define CONFIG_MQTT_UART_PORT_NUM               2
+#define CONFIG_MQTT_UART_BAUD_RATE              115200
+#define CONFIG_MQTT_UART_TXD                    17
+#define CONFIG_MQTT_UART_RXD                    16
+#define CONFIG_BRIDGE_STM32_WAKE_BYTE           0
+#define CONFIG_RELAY_GPIO_NUM                   18
+#define CONFIG_BRIDGE_BACKLOG_DEPTH             32
+#define CONFIG_BRIDGE_PIPELINE_DEPTH            32
+#define CONFIG_BRIDGE_METRICS_INTERVAL_S        30
+#define CONFIG_BRIDGE_COMMAND_GROUP             (g_host.group)
+#define CONFIG_BRIDGE_LATENCY_TRACE             1
+#define CONFIG_BRIDGE_LOG_BENCHMARK             0
+#define CONFIG_BRIDGE_LOG_BENCHMARK_SAMPLES     200
+#define CONFIG_BRIDGE_WIFI_RETRY_DELAY_MS       5000
+#define CONFIG_BRIDGE_ROLLUPS                   1
+
+/* Payload Encoding */
+#define CONFIG_BRIDGE_CBOR_SAMPLES              (g_host.cbor)
+#define CONFIG_BRIDGE_CBOR_STATE                (g_host.cbor)
+#define CONFIG_BRIDGE_CBOR_TRACE                (g_host.cbor)
+#define CONFIG_BRIDGE_SAMPLE_BATCH_SIZE         (g_host.batch_size)
+#define CONFIG_BRIDGE_SAMPLE_BATCH_DELTA        (g_host.batch_delta)
+#define CONFIG_BRIDGE_CBOR_ROLLUPS              (g_host.cbor)
+
+/* Bridge Task Layout (cores are recorded, not enforced) */
+#define CONFIG_BRIDGE_UART_TASK_CORE            1
+#define CONFIG_BRIDGE_UART_TASK_PRIORITY        10
+#define CONFIG_BRIDGE_PUBLISHER_TASK_CORE       0
+#define CONFIG_BRIDGE_PUBLISHER_TASK_PRIORITY   5
+#define CONFIG_BRIDGE_MQTT_TASK_PRIORITY        5
+#define CONFIG_BRIDGE_TASK_STATS_INTERVAL_S     60
+
+/* Deferred log */
+#define CONFIG_DEFERRED_LOG_RING_SIZE           4096
+#define CONFIG_DEFERRED_LOG_TASK_PRIORITY       1
+#define CONFIG_DEFERRED_LOG_TASK_CORE           0
+
+/* FreeRTOS, as in sdkconfig */
+#define CONFIG_FREERTOS_HZ                      100
+#define CONFIG_FREERTOS_USE_TRACE_FACILITY      1
+#define CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS 1
+#define CONFIG_ESP_MAIN_TASK_STACK_SIZE         3584
+
+/* No Wi-Fi: example_connect() returns at once */
+#define CONFIG_EXAMPLE_CONNECT_WIFI             0
+
+#endif /* HOST_SDKCONFIG_H */
@@ -3,6 +3,7 @@
  */
 /* INCLUDES ------------------------------------------------------------------*/
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include "esp_system.h"
 #include "nvs_flash.h"
@@ -11,24 +12,125 @@
 #include "protocol_examples_common.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "freertos/queue.h"
+#if CONFIG_EXAMPLE_CONNECT_WIFI
+#include "example_common_private.h"
+#endif
 
 // Include custom libraries
 #include "stm32_uart.h"
 #include "mqtt_handler.h"
 #include "relay_control.h"
 #include "sensor_parser.h"
+#include "deferred_log.h"
+#include "bridge_metrics.h"
+#include "cbor_codec.h"
+#include "ts_codec.h"
+#include "rollup.h"
 
 /* STATIC VARIABLES ----------------------------------------------------------*/
 static const char *TAG = "MQTT_BRIDGE_APP";
 
-// MQTT Topics
-#define TOPIC_SHT3X_COMMAND                     "esp32/sensor/sht3x/command"
-#define TOPIC_SHT3X_SINGLE_TEMPERATURE          "esp32/sensor/sht3x/single/temperature"
-#define TOPIC_SHT3X_SINGLE_HUMIDITY             "esp32/sensor/sht3x/single/humidity"
-#define TOPIC_SHT3X_PERIODIC_TEMPERATURE        "esp32/sensor/sht3x/periodic/temperature"
-#define TOPIC_SHT3X_PERIODIC_HUMIDITY           "esp32/sensor/sht3x/periodic/humidity"
-#define TOPIC_CONTROL_RELAY                     "esp32/control/relay"
-#define TOPIC_STATE_SYNC                        "esp32/state"
+#define PIPELINE_REPORT_INTERVAL_MS             60000
+#define TASK_STATS_MAX_TASKS                    24
+#define METRICS_JSON_SIZE                       1024
+#define COMMAND_ID_MAX_LEN                      16      // Correlation ID, echoed by the STM32 in "ACK <id> ..."
+#define SAMPLE_BATCH_MAX                        64      // Upper bound of CONFIG_BRIDGE_SAMPLE_BATCH_SIZE
+#define SAMPLE_BATCH_PAYLOAD_SIZE               (64 + SAMPLE_BATCH_MAX * 15)    // Also > TS_CODEC_MAX_SIZE(2, 64)
+#define SAMPLE_BATCH_DECIMALS                   2       // The STM32 prints "%.2f"
+#define SAMPLE_BATCH_IDLE_MS                    1000    // Partial batch sent this long after periodic mode stopped
+#define ROLLUP_TICK_MS                          1000    // Closes rollup buckets while no samples arrive
+#define ROLLUP_PAYLOAD_SIZE                     (64 + ROLLUP_MAX_DEPTH * 64)
+
+// Payload encoding per topic ("Payload Encoding" menu); bool options that are off are not defined
+#ifdef CONFIG_BRIDGE_CBOR_SAMPLES
+#define ENCODE_SAMPLES_CBOR                     CONFIG_BRIDGE_CBOR_SAMPLES
+#else
+#define ENCODE_SAMPLES_CBOR                     0
+#endif
+#ifdef CONFIG_BRIDGE_CBOR_STATE
+#define ENCODE_STATE_CBOR                       CONFIG_BRIDGE_CBOR_STATE
+#else
+#define ENCODE_STATE_CBOR                       0
+#endif
+#ifdef CONFIG_BRIDGE_CBOR_TRACE
+#define ENCODE_TRACE_CBOR                       CONFIG_BRIDGE_CBOR_TRACE
+#else
+#define ENCODE_TRACE_CBOR                       0
+#endif
+#ifdef CONFIG_BRIDGE_SAMPLE_BATCH_DELTA
+#define ENCODE_BATCH_DELTA                      CONFIG_BRIDGE_SAMPLE_BATCH_DELTA
+#else
+#define ENCODE_BATCH_DELTA                      0
+#endif
+#ifdef CONFIG_BRIDGE_CBOR_ROLLUPS
+#define ENCODE_ROLLUP_CBOR                      CONFIG_BRIDGE_CBOR_ROLLUPS
+#else
+#define ENCODE_ROLLUP_CBOR                      0
+#endif
+#ifdef CONFIG_BRIDGE_ROLLUPS                                     // "Bridge Runtime" menu, same rule
+#define PUBLISH_ROLLUPS                         CONFIG_BRIDGE_ROLLUPS
+#else
+#define PUBLISH_ROLLUPS                         0
+#endif
+
+// Kconfig core (-1 = any) -> xTaskCreatePinnedToCore core_id, any on single-core targets
+#define BRIDGE_TASK_CORE(core)  (((core) < 0 || (core) >= portNUM_PROCESSORS) ? tskNO_AFFINITY : (core))
+
+// MQTT topics, all below esp32/<client_id>/ so bridges sharing a broker do not collide.
+// Filled by build_device_topics() once MQTT_Handler_Init() has generated the client ID;
+// backlog entries queued before that point at g_topics and see the final string.
+typedef enum {
+    TOPIC_SHT3X_COMMAND = 0,
+    TOPIC_SHT3X_SINGLE_TEMPERATURE,
+    TOPIC_SHT3X_SINGLE_HUMIDITY,
+    TOPIC_SHT3X_PERIODIC_TEMPERATURE,
+    TOPIC_SHT3X_PERIODIC_HUMIDITY,
+    TOPIC_SHT3X_AGGREGATE,
+    TOPIC_SHT3X_TRACE,
+    TOPIC_SHT3X_BATCH,
+    TOPIC_SHT3X_ROLLUP_1M,              // Same order as rollup_period_t
+    TOPIC_SHT3X_ROLLUP_15M,
+    TOPIC_SHT3X_ROLLUP_1H,
+    TOPIC_CONTROL_RELAY,
+    TOPIC_STATE_SYNC,
+    TOPIC_TASK_STATS,
+    TOPIC_METRICS,
+    TOPIC_COMMAND_ACK,
+    TOPIC_COUNT
+} topic_id_t;
+
+static const char* const TOPIC_SUFFIXES[TOPIC_COUNT] = {
+    [TOPIC_SHT3X_COMMAND]               = "sensor/sht3x/command",
+    [TOPIC_SHT3X_SINGLE_TEMPERATURE]    = "sensor/sht3x/single/temperature",
+    [TOPIC_SHT3X_SINGLE_HUMIDITY]       = "sensor/sht3x/single/humidity",
+    [TOPIC_SHT3X_PERIODIC_TEMPERATURE]  = "sensor/sht3x/periodic/temperature",
+    [TOPIC_SHT3X_PERIODIC_HUMIDITY]     = "sensor/sht3x/periodic/humidity",
+    [TOPIC_SHT3X_AGGREGATE]             = "sensor/sht3x/aggregate",
+    [TOPIC_SHT3X_TRACE]                 = "sensor/sht3x/trace",
+    [TOPIC_SHT3X_BATCH]                 = "sensor/sht3x/batch",  // CBOR or ts_codec
+    [TOPIC_SHT3X_ROLLUP_1M]             = "sensor/sht3x/rollup/1m",     // Retained
+    [TOPIC_SHT3X_ROLLUP_15M]            = "sensor/sht3x/rollup/15m",    // Retained
+    [TOPIC_SHT3X_ROLLUP_1H]             = "sensor/sht3x/rollup/1h",     // Retained
+    [TOPIC_CONTROL_RELAY]               = "control/relay",
+    [TOPIC_STATE_SYNC]                  = "state",          // Retained; esp32/+/state is the discovery filter
+    [TOPIC_TASK_STATS]                  = "system/tasks",
+    [TOPIC_METRICS]                     = "metrics",
+    [TOPIC_COMMAND_ACK]                 = "ack",
+};
+
+static char g_topics[TOPIC_COUNT][MQTT_MAX_TOPIC_LEN];
+#define TOPIC(id)                               ((const char*)g_topics[id])
+
+// Fleet-wide commands: every bridge takes esp32/group/all/command, plus its own group if set
+#define GROUP_COMMAND_TOPIC_FMT                 MQTT_TOPIC_ROOT "/group/%s/command"
+#define GROUP_ALL                               "all"
+
+static char g_group_topics[2][MQTT_MAX_TOPIC_LEN];
+static int g_group_topic_count = 0;
 
 // Global components
 static stm32_uart_t stm32_uart;
@@ -36,10 +138,261 @@ static mqtt_handler_t mqtt_handler;
 static relay_control_t relay_control;
 static sensor_parser_t sensor_parser;
 
-// FIXED: Global state tracking
+// Device state; sensor fields come from the STM32 STATE record only
 static bool g_periodic_active = false;
 static bool g_device_on = false;
-static int g_periodic_rate = 1;  // Default 1 Hz
+static float g_periodic_rate = 1.0f;  // Default 1 Hz, kept while stopped
+static char g_repeat[8] = "HIGH";
+static bool g_heater_on = false;
+static unsigned int g_sensor_status = 0;
+
+// Sensor messages held while MQTT is not ready (boot, Wi-Fi loss); oldest dropped first
+typedef struct {
+    const char* topic;
+    char payload[STM32_UART_MAX_LINE_LENGTH];
+    int length;                 // CBOR payloads may contain 0 bytes
+} backlog_entry_t;
+
+static backlog_entry_t g_backlog[CONFIG_BRIDGE_BACKLOG_DEPTH];
+static int g_backlog_head = 0;
+static int g_backlog_count = 0;
+static uint32_t g_backlog_dropped = 0;
+static SemaphoreHandle_t g_backlog_mutex = NULL;
+
+// Periodic samples collected for one sensor/sht3x/batch message; publisher task only
+typedef struct {
+    int count;
+    uint32_t seq;
+    int64_t rx_us[SAMPLE_BATCH_MAX];
+    float temperature[SAMPLE_BATCH_MAX];
+    float humidity[SAMPLE_BATCH_MAX];
+} sample_batch_t;
+
+static sample_batch_t g_batch;
+
+// 1 min / 15 min / 1 h aggregates of the periodic samples, on the uptime clock; publisher task only
+static rollup_t g_rollup;
+static bool g_rollup_republish = false;     // Set on (re)connect, handled by the publisher task
+
+// Boot phase timestamps (esp_timer, us since reset), 0 until reached
+typedef struct {
+    int64_t app_start;
+    int64_t nvs;
+    int64_t uart_ready;
+    int64_t first_line;
+    int64_t wifi;
+    int64_t mqtt_ready;
+    int64_t first_publish;
+    uint32_t wifi_rounds;
+    bool reported;
+} boot_timings_t;
+
+static boot_timings_t g_boot;
+
+// Ingest -> publisher pipeline: the UART task only parses and enqueues, never blocks on MQTT
+typedef enum {
+    BRIDGE_MSG_SAMPLE = 0,      // Parsed SINGLE/PERIODIC measurement
+    BRIDGE_MSG_AGGREGATE,       // Window summary, forwarded as-is
+    BRIDGE_MSG_STATE,           // STM32 STATE record
+    BRIDGE_MSG_ACK,             // "ACK <id> OK|ERROR" for a command sent with a correlation ID
+    BRIDGE_MSG_TEXT             // Any other line (replies, errors), logged only
+} bridge_msg_type_t;
+
+typedef struct {
+    bridge_msg_type_t type;
+    int64_t ingest_us;          // When the UART task read the line terminator
+    union {
+        sensor_data_t sample;
+        char line[STM32_UART_MAX_LINE_LENGTH];
+    };
+} bridge_msg_t;
+
+typedef struct {
+    uint32_t enqueued;
+    uint32_t processed;
+    uint32_t dropped;           // Queue full: publisher stalled longer than the queue depth
+    uint32_t max_depth;
+} pipeline_stats_t;
+
+static QueueHandle_t g_pipeline_queue = NULL;
+static pipeline_stats_t g_pipeline;
+
+// Per-sample latency, split by deferred-log mode (logging cost shows up as the difference)
+typedef struct {
+    uint32_t samples;
+    uint64_t ingest_sum_us;     // Line terminator -> enqueued (UART task: clean, parse, log)
+    uint32_t ingest_max_us;
+    uint64_t e2e_sum_us;        // Line terminator -> published (publisher task done)
+    uint32_t e2e_max_us;
+} latency_stats_t;
+
+static const char* const LOG_MODE_NAMES[] = { "deferred", "sync", "off" };
+static latency_stats_t g_latency[3];    // Indexed by dlog_mode_t
+
+/* BOOT TIMING FUNCTIONS -----------------------------------------------------*/
+
+/**
+ * @brief Record a boot phase the first time it is reached
+ */
+static void boot_mark(int64_t* phase)
+{
+    if (*phase == 0)
+    {
+        *phase = esp_timer_get_time();
+    }
+}
+
+/**
+ * @brief Log the boot phase summary once, after the first sample reached the broker
+ */
+static void boot_report(void)
+{
+    if (g_boot.reported || g_boot.first_publish == 0)
+    {
+        return;
+    }
+    g_boot.reported = true;
+    
+    ESP_LOGI(TAG, "Boot timings (ms since reset): app=%lld nvs=%lld uart=%lld first_line=%lld "
+             "wifi=%lld (%lu round(s)) mqtt_ready=%lld first_publish=%lld",
+             g_boot.app_start / 1000, g_boot.nvs / 1000, g_boot.uart_ready / 1000,
+             g_boot.first_line / 1000, g_boot.wifi / 1000, (unsigned long)g_boot.wifi_rounds,
+             g_boot.mqtt_ready / 1000, g_boot.first_publish / 1000);
+    ESP_LOGI(TAG, "Backlog: %d queued, %lu dropped before MQTT was ready",
+             g_backlog_count, (unsigned long)g_backlog_dropped);
+}
+
+/* PUBLISH BACKLOG FUNCTIONS -------------------------------------------------*/
+
+/**
+ * @brief Publish a sensor message, or queue it until MQTT is ready
+ * 
+ * @note Messages already queued go out first so the broker sees them in order
+ * 
+ * @param length Payload length, 0 for a NUL-terminated string
+ */
+static void publish_or_backlog(const char* topic, const char* payload, int length)
+{
+    if (length == 0)
+    {
+        length = strlen(payload);
+    }
+    
+    xSemaphoreTake(g_backlog_mutex, portMAX_DELAY);
+    
+    if (g_backlog_count == 0 && MQTT_Handler_IsReady(&mqtt_handler))
+    {
+        xSemaphoreGive(g_backlog_mutex);
+        
+        if (MQTT_Handler_Publish(&mqtt_handler, topic, payload, length, 0, 0) >= 0)
+        {
+            boot_mark(&g_boot.first_publish);
+            boot_report();
+        }
+        return;
+    }
+    
+    if (g_backlog_count == CONFIG_BRIDGE_BACKLOG_DEPTH)
+    {
+        // Full: overwrite the oldest entry
+        g_backlog_head = (g_backlog_head + 1) % CONFIG_BRIDGE_BACKLOG_DEPTH;
+        g_backlog_count--;
+        g_backlog_dropped++;
+    }
+    
+    backlog_entry_t* entry = &g_backlog[(g_backlog_head + g_backlog_count) % CONFIG_BRIDGE_BACKLOG_DEPTH];
+    entry->topic = topic;
+    entry->length = (length < (int)sizeof(entry->payload)) ? length : (int)sizeof(entry->payload) - 1;
+    memcpy(entry->payload, payload, entry->length);
+    entry->payload[entry->length] = '\0';
+    g_backlog_count++;
+    
+    xSemaphoreGive(g_backlog_mutex);
+}
+
+/**
+ * @brief Publish everything queued while MQTT was not ready
+ * 
+ * @return Number of messages published
+ */
+static int flush_backlog(void)
+{
+    int published = 0;
+    
+    xSemaphoreTake(g_backlog_mutex, portMAX_DELAY);
+    
+    while (g_backlog_count > 0 && MQTT_Handler_IsReady(&mqtt_handler))
+    {
+        backlog_entry_t* entry = &g_backlog[g_backlog_head];
+        if (MQTT_Handler_Publish(&mqtt_handler, entry->topic, entry->payload, entry->length, 0, 0) < 0)
+        {
+            break;
+        }
+        g_backlog_head = (g_backlog_head + 1) % CONFIG_BRIDGE_BACKLOG_DEPTH;
+        g_backlog_count--;
+        published++;
+    }
+    
+    xSemaphoreGive(g_backlog_mutex);
+    
+    if (published > 0)
+    {
+        boot_mark(&g_boot.first_publish);
+    }
+    return published;
+}
+
+/* PIPELINE FUNCTIONS --------------------------------------------------------*/
+
+/**
+ * @brief Hand a message from the UART task to the publisher task
+ * 
+ * @note Never blocks: when the queue is full the message is dropped and counted
+ */
+static bool pipeline_push(const bridge_msg_t* msg)
+{
+    if (xQueueSend(g_pipeline_queue, msg, 0) != pdTRUE)
+    {
+        if (g_pipeline.dropped++ == 0)
+        {
+            ESP_LOGW(TAG, "Pipeline queue full, dropping messages");
+        }
+        return false;
+    }
+    
+    g_pipeline.enqueued++;
+    
+    uint32_t depth = (uint32_t)uxQueueMessagesWaiting(g_pipeline_queue);
+    if (depth > g_pipeline.max_depth)
+    {
+        g_pipeline.max_depth = depth;
+    }
+    return true;
+}
+
+/**
+ * @brief Enqueue a copy of a line under the given type
+ */
+static void pipeline_push_line(bridge_msg_type_t type, const char* line)
+{
+    bridge_msg_t msg;
+    msg.type = type;
+    msg.ingest_us = stm32_uart.line_start_us;
+    strlcpy(msg.line, line, sizeof(msg.line));
+    pipeline_push(&msg);
+}
+
+/**
+ * @brief Sensor parser callback (UART task): enqueue the parsed sample
+ */
+static void on_sample_parsed(const sensor_data_t* data)
+{
+    bridge_msg_t msg;
+    msg.type = BRIDGE_MSG_SAMPLE;
+    msg.ingest_us = stm32_uart.line_start_us;
+    msg.sample = *data;
+    pipeline_push(&msg);
+}
 
 /* STATE SYNCHRONIZATION FUNCTIONS -------------------------------------------*/
 
@@ -49,13 +402,51 @@ static int g_periodic_rate = 1;  // Default 1 Hz
 static void create_state_message(char* buffer, size_t buffer_size)
 {
     snprintf(buffer, buffer_size, 
-             "{\"device\":\"%s\",\"periodic\":\"%s\",\"rate\":%d,\"timestamp\":%lld}",
+             "{\"device\":\"%s\",\"periodic\":\"%s\",\"rate\":%g,\"repeat\":\"%s\","
+             "\"heater\":\"%s\",\"status\":\"0x%04X\",\"group\":\"%s\",\"timestamp\":%lld}",
              g_device_on ? "ON" : "OFF",
              g_periodic_active ? "ON" : "OFF", 
-             g_periodic_rate,
+             (double)g_periodic_rate,
+             g_repeat,
+             g_heater_on ? "ON" : "OFF",
+             g_sensor_status,
+             CONFIG_BRIDGE_COMMAND_GROUP,
              (long long)(esp_timer_get_time() / 1000));  // milliseconds
 }
 
+/**
+ * @brief Create the state as a CBOR map with the keys and value types of the JSON state
+ * 
+ * @return Length, -1 if it does not fit
+ */
+static int create_state_cbor(uint8_t* buffer, size_t buffer_size)
+{
+    char status[8];
+    snprintf(status, sizeof(status), "0x%04X", g_sensor_status);
+    
+    cbor_writer_t writer;
+    CBOR_WriterInit(&writer, buffer, buffer_size);
+    CBOR_PutMap(&writer, 8);
+    CBOR_PutText(&writer, "device");
+    CBOR_PutText(&writer, g_device_on ? "ON" : "OFF");
+    CBOR_PutText(&writer, "periodic");
+    CBOR_PutText(&writer, g_periodic_active ? "ON" : "OFF");
+    CBOR_PutText(&writer, "rate");
+    CBOR_PutFloat(&writer, g_periodic_rate);
+    CBOR_PutText(&writer, "repeat");
+    CBOR_PutText(&writer, g_repeat);
+    CBOR_PutText(&writer, "heater");
+    CBOR_PutText(&writer, g_heater_on ? "ON" : "OFF");
+    CBOR_PutText(&writer, "status");
+    CBOR_PutText(&writer, status);
+    CBOR_PutText(&writer, "group");
+    CBOR_PutText(&writer, CONFIG_BRIDGE_COMMAND_GROUP);
+    CBOR_PutText(&writer, "timestamp");
+    CBOR_PutUint(&writer, (uint64_t)(esp_timer_get_time() / 1000));  // milliseconds
+    
+    return CBOR_WriterLength(&writer);
+}
+
 /**
  * @brief Publish current state with retain flag
  */
@@ -67,306 +458,1201 @@ static void publish_current_state(void)
     }
     
     char state_msg[256];
+    
+    if (ENCODE_STATE_CBOR)
+    {
+        int len = create_state_cbor((uint8_t*)state_msg, sizeof(state_msg));
+        if (len > 0)
+        {
+            MQTT_Handler_Publish(&mqtt_handler, TOPIC(TOPIC_STATE_SYNC), state_msg, len, 1, 1);
+            ESP_LOGI(TAG, "State published: %d bytes CBOR", len);
+        }
+        return;
+    }
+    
     create_state_message(state_msg, sizeof(state_msg));
     
     // Publish with retain flag so new clients get latest state
-    MQTT_Handler_Publish(&mqtt_handler, TOPIC_STATE_SYNC, state_msg, 0, 1, 1);
+    MQTT_Handler_Publish(&mqtt_handler, TOPIC(TOPIC_STATE_SYNC), state_msg, 0, 1, 1);
     ESP_LOGI(TAG, "State published: %s", state_msg);
 }
 
 /**
  * @brief Update internal state and publish
  */
-static void update_and_publish_state(bool device_on, bool periodic_active, int rate)
+static void update_and_publish_state(bool device_on, bool periodic_active, float rate)
 {
     bool state_changed = false;
     
     if (g_device_on != device_on)
     {
-        g_device_on = device_on;
-        state_changed = true;
-        ESP_LOGI(TAG, "Device state changed: %s", device_on ? "ON" : "OFF");
+        g_device_on = device_on;
+        state_changed = true;
+        ESP_LOGI(TAG, "Device state changed: %s", device_on ? "ON" : "OFF");
+    }
+    
+    if (g_periodic_active != periodic_active)
+    {
+        g_periodic_active = periodic_active;
+        state_changed = true;
+        ESP_LOGI(TAG, "Periodic state changed: %s", periodic_active ? "ON" : "OFF");
+    }
+    
+    if (g_periodic_rate != rate)
+    {
+        g_periodic_rate = rate;
+        state_changed = true;
+        ESP_LOGI(TAG, "Periodic rate changed: %g Hz", (double)rate);
+    }
+    
+    if (state_changed)
+    {
+        publish_current_state();
+    }
+}
+
+/**
+ * @brief Apply a "STATE <mps> <repeat> <heater> <status>" record from the STM32
+ *
+ * @return false when the line is malformed
+ */
+static bool handle_stm32_state(const char* line)
+{
+    char mps[8], repeat[8], heater[4];
+    unsigned int status = 0;
+
+    if (sscanf(line, "STATE %7s %7s %3s %x", mps, repeat, heater, &status) != 4)
+    {
+        ESP_LOGW(TAG, "Malformed STATE record: %s", line);
+        return false;
+    }
+
+    float rate = strtof(mps, NULL);
+    bool periodic = rate > 0.0f;
+    bool heater_on = (strcmp(heater, "ON") == 0);
+
+    // A stopped sensor reports 0 mps: keep the last rate for the dashboard selector
+    float new_rate = periodic ? rate : g_periodic_rate;
+
+    bool changed = (g_periodic_active != periodic) ||
+                   (g_periodic_rate != new_rate) ||
+                   (strcmp(g_repeat, repeat) != 0) ||
+                   (g_heater_on != heater_on) ||
+                   (g_sensor_status != status);
+
+    g_periodic_active = periodic;
+    g_periodic_rate = new_rate;
+    strlcpy(g_repeat, repeat, sizeof(g_repeat));
+    g_heater_on = heater_on;
+    g_sensor_status = status;
+
+    if (changed)
+    {
+        ESP_LOGI(TAG, "STM32 state: periodic=%s rate=%g repeat=%s heater=%s status=0x%04X",
+                 periodic ? "ON" : "OFF", (double)new_rate, repeat, heater, status);
+        publish_current_state();
+    }
+
+    return true;
+}
+
+/* COMMAND FUNCTIONS ---------------------------------------------------------*/
+
+/**
+ * @brief Copy the string value of "key" from a flat JSON object without using cJSON
+ * 
+ * @note Escaped strings are rejected; commands and correlation IDs never need them
+ * 
+ * @return false if the key is missing, not a string, or does not fit
+ */
+static bool json_get_string(const char* json, const char* key, char* out, size_t size)
+{
+    char pattern[24];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    
+    const char* p = strstr(json, pattern);
+    if (!p)
+    {
+        return false;
+    }
+    p += strlen(pattern);
+    while (*p == ' ') p++;
+    if (*p++ != ':')
+    {
+        return false;
+    }
+    while (*p == ' ') p++;
+    if (*p++ != '"')
+    {
+        return false;
+    }
+    
+    size_t len = 0;
+    while (p[len] != '"')
+    {
+        if (p[len] == '\0' || p[len] == '\\' || len + 1 >= size)
+        {
+            return false;
+        }
+        len++;
+    }
+    memcpy(out, p, len);
+    out[len] = '\0';
+    return true;
+}
+
+/**
+ * @brief A correlation ID must survive the STM32 tokenizer and the ACK round trip
+ */
+static bool is_valid_command_id(const char* id)
+{
+    size_t len = strlen(id);
+    if (len == 0 || len > COMMAND_ID_MAX_LEN)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < len; i++)
+    {
+        char c = id[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+              c == '-' || c == '_' || c == '.'))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Publish {"id","result"[,"error"]} to esp32/<client_id>/ack (QoS 1, not retained)
+ * 
+ * @param error Reason when the bridge itself rejected the command, NULL for STM32 results
+ */
+static void publish_command_ack(const char* id, const char* result, const char* error)
+{
+    char json[96];
+    if (error)
+    {
+        snprintf(json, sizeof(json), "{\"id\":\"%s\",\"result\":\"%s\",\"error\":\"%s\"}", id, result, error);
+    }
+    else
+    {
+        snprintf(json, sizeof(json), "{\"id\":\"%s\",\"result\":\"%s\"}", id, result);
+    }
+    
+    MQTT_Handler_Publish(&mqtt_handler, TOPIC(TOPIC_COMMAND_ACK), json, 0, 1, 0);
+    ESP_LOGI(TAG, "Command %s acknowledged: %s%s%s", id, result, error ? " - " : "", error ? error : "");
+}
+
+/**
+ * @brief Run a command from the device or a group command topic
+ * 
+ * Plain text ("SHT3X PERIODIC 1 HIGH") is forwarded as before, without an ack.
+ * {"id":"<id>","cmd":"<command>"} is forwarded as "#<id> <command>"; the STM32 answers
+ * "ACK <id> OK|ERROR", which the publisher task turns into an ack message. RELAY
+ * commands run on the bridge and are acknowledged at once.
+ */
+static void execute_command(const char* payload)
+{
+    char id[COMMAND_ID_MAX_LEN + 1] = "";
+    char cmd[48];
+    
+    if (payload[0] == '{')
+    {
+        bool has_id = json_get_string(payload, "id", id, sizeof(id)) && is_valid_command_id(id);
+        if (!has_id || !json_get_string(payload, "cmd", cmd, sizeof(cmd)))
+        {
+            ESP_LOGW(TAG, "Malformed command request: %s", payload);
+            if (has_id)
+            {
+                publish_command_ack(id, "ERROR", "malformed");
+            }
+            return;
+        }
+    }
+    else
+    {
+        strlcpy(cmd, payload, sizeof(cmd));
+    }
+    
+    if (strncmp(cmd, "RELAY", 5) == 0)
+    {
+        bool ok = Relay_ProcessCommand(&relay_control, cmd);
+        ESP_LOGI(TAG, "Relay command %s: %s", ok ? "processed" : "unknown", cmd);
+        if (id[0])
+        {
+            publish_command_ack(id, ok ? "OK" : "ERROR", ok ? NULL : "unknown command");
+        }
+        return;
+    }
+    
+    // The relay powers the STM32: with it off nothing would ever answer
+    if (id[0] && !g_device_on)
+    {
+        publish_command_ack(id, "ERROR", "device off");
+        return;
+    }
+    
+    char line[COMMAND_ID_MAX_LEN + 2 + sizeof(cmd)];
+    if (id[0])
+    {
+        snprintf(line, sizeof(line), "#%s %s", id, cmd);
+    }
+    else
+    {
+        strlcpy(line, cmd, sizeof(line));
+    }
+    
+    // State is not guessed from the command: the STM32 answers with a STATE record
+    if (STM32_UART_SendCommand(&stm32_uart, line))
+    {
+        ESP_LOGI(TAG, "Command forwarded to STM32: %s", line);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Failed to send command to STM32: %s", line);
+        if (id[0])
+        {
+            publish_command_ack(id, "ERROR", "uart");
+        }
+    }
+}
+
+/**
+ * @brief Forward an "ACK <id> OK|ERROR" line from the STM32
+ */
+static void handle_stm32_ack(const char* line)
+{
+    char id[COMMAND_ID_MAX_LEN + 1], result[8];
+    
+    if (sscanf(line, "ACK %16s %7s", id, result) != 2 ||
+        (strcmp(result, "OK") != 0 && strcmp(result, "ERROR") != 0))
+    {
+        ESP_LOGW(TAG, "Malformed ACK: %s", line);
+        return;
+    }
+    
+    publish_command_ack(id, result, NULL);
+}
+
+/* SAMPLE ENCODING FUNCTIONS -------------------------------------------------*/
+
+/**
+ * @brief Publish one sample value as "%.2f" text or a CBOR float
+ */
+static void publish_sample(const char* topic, float value)
+{
+    char payload[16];
+    int len;
+    
+    if (ENCODE_SAMPLES_CBOR)
+    {
+        cbor_writer_t writer;
+        CBOR_WriterInit(&writer, (uint8_t*)payload, sizeof(payload));
+        CBOR_PutFloat(&writer, value);
+        len = CBOR_WriterLength(&writer);
+    }
+    else
+    {
+        len = snprintf(payload, sizeof(payload), "%.2f", value);
+    }
+    
+    publish_or_backlog(topic, payload, len);
+}
+
+/**
+ * @brief Encode the collected samples as {"seq","rx_us","dt_us":[],"temperature":[],"humidity":[]}
+ * 
+ * @note dt_us[i] is sample i's UART time relative to rx_us, which keeps it to 3-5 bytes
+ * 
+ * @return Length, -1 if it does not fit
+ */
+static int encode_sample_batch(const sample_batch_t* batch, uint8_t* buffer, size_t size)
+{
+    cbor_writer_t writer;
+    CBOR_WriterInit(&writer, buffer, size);
+    CBOR_PutMap(&writer, 5);
+    CBOR_PutText(&writer, "seq");
+    CBOR_PutUint(&writer, batch->seq);
+    CBOR_PutText(&writer, "rx_us");
+    CBOR_PutInt(&writer, batch->rx_us[0]);
+    
+    CBOR_PutText(&writer, "dt_us");
+    CBOR_PutArray(&writer, batch->count);
+    for (int i = 0; i < batch->count; i++)
+    {
+        CBOR_PutInt(&writer, batch->rx_us[i] - batch->rx_us[0]);
+    }
+    
+    CBOR_PutText(&writer, "temperature");
+    CBOR_PutArray(&writer, batch->count);
+    for (int i = 0; i < batch->count; i++)
+    {
+        CBOR_PutFloat(&writer, batch->temperature[i]);
+    }
+    
+    CBOR_PutText(&writer, "humidity");
+    CBOR_PutArray(&writer, batch->count);
+    for (int i = 0; i < batch->count; i++)
+    {
+        CBOR_PutFloat(&writer, batch->humidity[i]);
+    }
+    
+    return CBOR_WriterLength(&writer);
+}
+
+/**
+ * @brief Round a parsed "%.2f" reading to hundredths without libm
+ */
+static int32_t to_hundredths(float value)
+{
+    return (int32_t)(value * 100.0f + (value < 0 ? -0.5f : 0.5f));
+}
+
+/**
+ * @brief Encode the collected samples as a ts_codec block: UART times and hundredths
+ * 
+ * @note Consecutive readings differ by a few hundredths at an almost constant interval,
+ *       so most records take 3-4 bytes instead of ~15 in CBOR
+ * 
+ * @return Length, -1 if it does not fit
+ */
+static int encode_sample_batch_delta(const sample_batch_t* batch, uint8_t* buffer, size_t size)
+{
+    ts_encoder_t encoder;
+    int32_t values[2];
+    
+    TSCodec_EncoderInit(&encoder, buffer, size, 2, SAMPLE_BATCH_DECIMALS, batch->seq);
+    for (int i = 0; i < batch->count; i++)
+    {
+        values[0] = to_hundredths(batch->temperature[i]);
+        values[1] = to_hundredths(batch->humidity[i]);
+        TSCodec_Append(&encoder, batch->rx_us[i], values);
+    }
+    
+    return TSCodec_EncoderLength(&encoder);
+}
+
+/**
+ * @brief Publish the collected periodic samples as one batch message and start a new batch
+ * 
+ * @note Too large for the backlog: a batch completed while MQTT is not ready is dropped
+ */
+static void flush_sample_batch(void)
+{
+    static uint8_t payload[SAMPLE_BATCH_PAYLOAD_SIZE];
+    
+    if (g_batch.count == 0)
+    {
+        return;
+    }
+    
+    g_batch.seq++;
+    int len = ENCODE_BATCH_DELTA ? encode_sample_batch_delta(&g_batch, payload, sizeof(payload))
+                                 : encode_sample_batch(&g_batch, payload, sizeof(payload));
+    
+    if (len > 0 && MQTT_Handler_IsReady(&mqtt_handler) &&
+        MQTT_Handler_Publish(&mqtt_handler, TOPIC(TOPIC_SHT3X_BATCH), (const char*)payload, len, 1, 0) >= 0)
+    {
+        boot_mark(&g_boot.first_publish);
+        boot_report();
+        DLOGI(TAG, "Batch %lu published: %d samples, %d bytes", (unsigned long)g_batch.seq, g_batch.count, len);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Batch %lu dropped (%d samples): MQTT not ready", (unsigned long)g_batch.seq, g_batch.count);
+        xSemaphoreTake(g_backlog_mutex, portMAX_DELAY);
+        g_backlog_dropped++;
+        xSemaphoreGive(g_backlog_mutex);
+    }
+    
+    g_batch.count = 0;
+}
+
+/**
+ * @brief Add a periodic sample to the batch, publishing it once full
+ */
+static void batch_sample(const sensor_data_t* data, int64_t rx_us)
+{
+    if (!SensorParser_IsValid(data))
+    {
+        return;
+    }
+    
+    int i = g_batch.count++;
+    g_batch.rx_us[i] = rx_us;
+    g_batch.temperature[i] = data->temperature;
+    g_batch.humidity[i] = data->humidity;
+    
+    if (g_batch.count >= CONFIG_BRIDGE_SAMPLE_BATCH_SIZE || g_batch.count >= SAMPLE_BATCH_MAX)
+    {
+        flush_sample_batch();
+    }
+}
+
+/* ROLLUP FUNCTIONS ----------------------------------------------------------*/
+
+/**
+ * @brief Encode a period's closed buckets, oldest first, as
+ *        {"period_s","up_s","buckets":[[start_s,count,t_min,t_max,t_mean,h_min,h_max,h_mean],...]}
+ * 
+ * @note start_s and up_s are seconds of uptime; consumers place the buckets by
+ *       up_s, the uptime when the message was published
+ * 
+ * @return Length, -1 if it does not fit
+ */
+static int encode_rollup_json(rollup_period_t period, uint32_t up_s, char* buffer, size_t size)
+{
+    int count = Rollup_Count(&g_rollup, period);
+    int len = snprintf(buffer, size, "{\"period_s\":%lu,\"up_s\":%lu,\"buckets\":[",
+                       (unsigned long)Rollup_PeriodSeconds(period), (unsigned long)up_s);
+    
+    for (int i = 0; i < count && len > 0 && (size_t)len < size; i++)
+    {
+        const rollup_bucket_t* b = Rollup_Get(&g_rollup, period, i);
+        len += snprintf(buffer + len, size - len, "%s[%lu,%lu,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f]",
+                        i ? "," : "", (unsigned long)b->start_s, (unsigned long)b->count,
+                        b->min[0] / 100.0f, b->max[0] / 100.0f, Rollup_Mean(b, 0) / 100.0f,
+                        b->min[1] / 100.0f, b->max[1] / 100.0f, Rollup_Mean(b, 1) / 100.0f);
+    }
+    if (len > 0 && (size_t)len < size)
+    {
+        len += snprintf(buffer + len, size - len, "]}");
+    }
+    
+    return (len > 0 && (size_t)len < size) ? len : -1;
+}
+
+/**
+ * @brief Same keys and bucket layout as the JSON rollup, values as CBOR floats
+ * 
+ * @return Length, -1 if it does not fit
+ */
+static int encode_rollup_cbor(rollup_period_t period, uint32_t up_s, uint8_t* buffer, size_t size)
+{
+    int count = Rollup_Count(&g_rollup, period);
+    cbor_writer_t writer;
+    
+    CBOR_WriterInit(&writer, buffer, size);
+    CBOR_PutMap(&writer, 3);
+    CBOR_PutText(&writer, "period_s");
+    CBOR_PutUint(&writer, Rollup_PeriodSeconds(period));
+    CBOR_PutText(&writer, "up_s");
+    CBOR_PutUint(&writer, up_s);
+    CBOR_PutText(&writer, "buckets");
+    CBOR_PutArray(&writer, count);
+    for (int i = 0; i < count; i++)
+    {
+        const rollup_bucket_t* b = Rollup_Get(&g_rollup, period, i);
+        CBOR_PutArray(&writer, 2 + 3 * ROLLUP_CHANNELS);
+        CBOR_PutUint(&writer, b->start_s);
+        CBOR_PutUint(&writer, b->count);
+        for (int c = 0; c < ROLLUP_CHANNELS; c++)
+        {
+            CBOR_PutFloat(&writer, b->min[c] / 100.0f);
+            CBOR_PutFloat(&writer, b->max[c] / 100.0f);
+            CBOR_PutFloat(&writer, Rollup_Mean(b, c) / 100.0f);
+        }
+    }
+    
+    return CBOR_WriterLength(&writer);
+}
+
+/**
+ * @brief Publish a period's closed buckets, retained, replacing the previous message
+ * 
+ * @note Not backlogged: a message missed while MQTT is not ready is superseded by
+ *       the next one, which holds the same buckets and more
+ */
+static void publish_rollup(rollup_period_t period, uint32_t up_s)
+{
+    static char payload[ROLLUP_PAYLOAD_SIZE];
+    const char* topic = TOPIC(TOPIC_SHT3X_ROLLUP_1M + period);
+    
+    if (!MQTT_Handler_IsReady(&mqtt_handler))
+    {
+        return;
+    }
+    
+    // Nothing closed since boot: clear what an earlier boot left retained
+    if (Rollup_Count(&g_rollup, period) == 0)
+    {
+        MQTT_Handler_Publish(&mqtt_handler, topic, "", 0, 1, 1);
+        return;
+    }
+    
+    int len = ENCODE_ROLLUP_CBOR ? encode_rollup_cbor(period, up_s, (uint8_t*)payload, sizeof(payload))
+                                 : encode_rollup_json(period, up_s, payload, sizeof(payload));
+    if (len <= 0)
+    {
+        ESP_LOGW(TAG, "Rollup %lus does not fit in %d bytes",
+                 (unsigned long)Rollup_PeriodSeconds(period), ROLLUP_PAYLOAD_SIZE);
+        return;
+    }
+    
+    MQTT_Handler_Publish(&mqtt_handler, topic, payload, len, 1, 1);
+    DLOGI(TAG, "Rollup %lus published: %d bucket(s), %d bytes",
+          (unsigned long)Rollup_PeriodSeconds(period), Rollup_Count(&g_rollup, period), len);
+}
+
+/**
+ * @brief Publish the periods in `closed` (1 << rollup_period_t), or all of them after a (re)connect
+ */
+static void publish_rollups(uint32_t closed)
+{
+    if (g_rollup_republish && MQTT_Handler_IsReady(&mqtt_handler))
+    {
+        g_rollup_republish = false;
+        closed = (1u << ROLLUP_PERIOD_COUNT) - 1;
+    }
+    
+    uint32_t up_s = (uint32_t)(esp_timer_get_time() / 1000000);
+    for (int p = 0; p < ROLLUP_PERIOD_COUNT; p++)
+    {
+        if (closed & (1u << p))
+        {
+            publish_rollup((rollup_period_t)p, up_s);
+        }
+    }
+}
+
+/**
+ * @brief Fold a periodic sample into the rollups, in hundredths at its UART time
+ */
+static void rollup_sample(const sensor_data_t* data, int64_t rx_us)
+{
+    int32_t values[ROLLUP_CHANNELS];
+    
+    if (!SensorParser_IsValid(data))
+    {
+        return;
+    }
+    
+    values[0] = to_hundredths(data->temperature);
+    values[1] = to_hundredths(data->humidity);
+    publish_rollups(Rollup_Add(&g_rollup, rx_us / 1000, values));
+}
+
+/* CALLBACK FUNCTIONS --------------------------------------------------------*/
+
+/**
+ * @brief Callback when single sensor data is received
+ */
+static void on_single_sensor_data(const sensor_data_t* data)
+{
+    if (!SensorParser_IsValid(data))
+    {
+        return;
+    }
+    
+    publish_sample(TOPIC(TOPIC_SHT3X_SINGLE_TEMPERATURE), data->temperature);
+    publish_sample(TOPIC(TOPIC_SHT3X_SINGLE_HUMIDITY), data->humidity);
+    
+    DLOGI(TAG, "SINGLE data: T=%.2f°C, H=%.2f%%", 
+             data->temperature, data->humidity);
+}
+
+/**
+ * @brief Callback when periodic sensor data is received
+ */
+static void on_periodic_sensor_data(const sensor_data_t* data)
+{
+    if (!SensorParser_IsValid(data))
+    {
+        return;
+    }
+    
+    publish_sample(TOPIC(TOPIC_SHT3X_PERIODIC_TEMPERATURE), data->temperature);
+    publish_sample(TOPIC(TOPIC_SHT3X_PERIODIC_HUMIDITY), data->humidity);
+    
+    DLOGI(TAG, "PERIODIC data: T=%.2f°C, H=%.2f%%", 
+             data->temperature, data->humidity);
+}
+
+/**
+ * @brief Callback when data is received from STM32
+ */
+static void on_stm32_data_received(const char* line)
+{
+    // Runs in the UART task: classify, parse and enqueue only
+    boot_mark(&g_boot.first_line);
+    
+    // Window summaries are forwarded as-is, one record per window
+    if (strncmp(line, "AGGREGATE", 9) == 0)
+    {
+        pipeline_push_line(BRIDGE_MSG_AGGREGATE, line);
+        return;
+    }
+    
+    // Authoritative sensor state, emitted by the STM32 on change and on "SHT3X STATE"
+    if (strncmp(line, "STATE ", 6) == 0)
+    {
+        pipeline_push_line(BRIDGE_MSG_STATE, line);
+        return;
     }
     
-    if (g_periodic_active != periodic_active)
+    // Result of a "#<id> ..." command, after the command's own output
+    if (strncmp(line, "ACK ", 4) == 0)
     {
-        g_periodic_active = periodic_active;
-        state_changed = true;
-        ESP_LOGI(TAG, "Periodic state changed: %s", periodic_active ? "ON" : "OFF");
+        pipeline_push_line(BRIDGE_MSG_ACK, line);
+        return;
     }
     
-    if (g_periodic_rate != rate)
+    // Parse sensor data; the parser callback enqueues the sample
+    if (!SensorParser_ProcessLine(&sensor_parser, line))
     {
-        g_periodic_rate = rate;
-        state_changed = true;
-        ESP_LOGI(TAG, "Periodic rate changed: %d Hz", rate);
+        pipeline_push_line(BRIDGE_MSG_TEXT, line);
+        Metrics_Add(METRIC_PARSE_FAILURES, 1);
+        return;
     }
     
-    if (state_changed)
+    latency_stats_t* lat = &g_latency[DeferredLog_GetMode()];
+    uint32_t ingest_us = (uint32_t)(esp_timer_get_time() - stm32_uart.line_start_us);
+    lat->ingest_sum_us += ingest_us;
+    if (ingest_us > lat->ingest_max_us)
     {
-        publish_current_state();
+        lat->ingest_max_us = ingest_us;
     }
+    Metrics_Observe(METRIC_HIST_INGEST, ingest_us);
 }
 
-/* CALLBACK FUNCTIONS --------------------------------------------------------*/
+/**
+ * @brief Callback when relay state changes
+ */
+static void on_relay_state_changed(bool state)
+{
+    // Relay OFF powers the STM32 down; on power-up it reports its restored STATE itself
+    update_and_publish_state(state, state && g_periodic_active, g_periodic_rate);
+    
+    ESP_LOGI(TAG, "Relay state changed: %s", state ? "ON" : "OFF");
+}
 
 /**
- * @brief Callback when single sensor data is received
+ * @brief Callback when MQTT data is received
  */
-static void on_single_sensor_data(const sensor_data_t* data)
+static void on_mqtt_data_received(const char* topic, const char* data, int data_len)
 {
-    if (!SensorParser_IsValid(data) || !MQTT_Handler_IsConnected(&mqtt_handler))
+    // Commands and requests are text; binary payloads are our own CBOR state coming back
+    if (data_len > 0 && CBOR_IS_BINARY(data[0]))
     {
+        ESP_LOGD(TAG, "<- MQTT: %s = %d bytes CBOR", topic, data_len);
         return;
     }
     
-    char temp_str[16], hum_str[16];
-    snprintf(temp_str, sizeof(temp_str), "%.2f", data->temperature);
-    snprintf(hum_str, sizeof(hum_str), "%.2f", data->humidity);
-    
-    MQTT_Handler_Publish(&mqtt_handler, TOPIC_SHT3X_SINGLE_TEMPERATURE, temp_str, 0, 0, 0);
-    MQTT_Handler_Publish(&mqtt_handler, TOPIC_SHT3X_SINGLE_HUMIDITY, hum_str, 0, 0, 0);
+    ESP_LOGI(TAG, "<- MQTT: %s = %.*s", topic, data_len, data);
     
-    ESP_LOGI(TAG, "Published SINGLE data: T=%.2f°C, H=%.2f%%", 
-             data->temperature, data->humidity);
+    // Handle SHT3X commands, addressed to this device or to one of its groups
+    if (strcmp(topic, TOPIC(TOPIC_SHT3X_COMMAND)) == 0 ||
+        (g_group_topic_count > 0 && strcmp(topic, g_group_topics[0]) == 0) ||
+        (g_group_topic_count > 1 && strcmp(topic, g_group_topics[1]) == 0))
+    {
+        execute_command(data);
+    }
+    // Handle relay commands
+    else if (strcmp(topic, TOPIC(TOPIC_CONTROL_RELAY)) == 0)
+    {
+        if (Relay_ProcessCommand(&relay_control, data))
+        {
+            ESP_LOGI(TAG, "Relay command processed: %s", data);
+        } 
+        else 
+        {
+            ESP_LOGW(TAG, "Unknown relay command: %s", data);
+        }
+    }
+    // FIXED: Handle state sync requests
+    else if (strcmp(topic, TOPIC(TOPIC_STATE_SYNC)) == 0 && 
+             strstr(data, "REQUEST"))
+    {
+        ESP_LOGI(TAG, "State sync requested by client");
+        publish_current_state();
+    }
 }
 
 /**
- * @brief Callback when periodic sensor data is received
+ * @brief Runs on every (re)connect once all topics are subscribed
  */
-static void on_periodic_sensor_data(const sensor_data_t* data)
+static void on_mqtt_ready(void)
 {
-    if (!SensorParser_IsValid(data) || !MQTT_Handler_IsConnected(&mqtt_handler))
-    {
-        return;
-    }
-    
-    char temp_str[16], hum_str[16];
-    snprintf(temp_str, sizeof(temp_str), "%.2f", data->temperature);
-    snprintf(hum_str, sizeof(hum_str), "%.2f", data->humidity);
+    // Retained, so clients that connected while we were away get the latest state
+    publish_current_state();
+    g_rollup_republish = PUBLISH_ROLLUPS;
+    boot_mark(&g_boot.mqtt_ready);
     
-    MQTT_Handler_Publish(&mqtt_handler, TOPIC_SHT3X_PERIODIC_TEMPERATURE, temp_str, 0, 0, 0);
-    MQTT_Handler_Publish(&mqtt_handler, TOPIC_SHT3X_PERIODIC_HUMIDITY, hum_str, 0, 0, 0);
+    int flushed = flush_backlog();
     
-    ESP_LOGI(TAG, "Published PERIODIC data: T=%.2f°C, H=%.2f%%", 
-             data->temperature, data->humidity);
+    ESP_LOGI(TAG, "MQTT ready in %ld ms, state published, %d backlog message(s) flushed",
+             (long)MQTT_Handler_GetReadyLatencyMs(&mqtt_handler), flushed);
+    boot_report();
 }
 
+/* PUBLISHER TASK ------------------------------------------------------------*/
+
 /**
- * @brief Callback when data is received from STM32
+ * @brief Log per-sample latency for every log mode that has samples
  */
-static void on_stm32_data_received(const char* line)
+static void report_latency(void)
 {
-    ESP_LOGI(TAG, "<- STM32: %s", line);
-    
-    // Parse and process sensor data
-    SensorParser_ProcessLine(&sensor_parser, line);
+    for (int mode = 0; mode < 3; mode++)
+    {
+        const latency_stats_t* lat = &g_latency[mode];
+        if (lat->samples == 0)
+        {
+            continue;
+        }
+        ESP_LOGI(TAG, "Latency [log %s]: %lu samples, ingest avg %lu us max %lu us, "
+                 "end-to-end avg %lu us max %lu us",
+                 LOG_MODE_NAMES[mode], (unsigned long)lat->samples,
+                 (unsigned long)(lat->ingest_sum_us / lat->samples), (unsigned long)lat->ingest_max_us,
+                 (unsigned long)(lat->e2e_sum_us / lat->samples), (unsigned long)lat->e2e_max_us);
+    }
 }
 
 /**
- * @brief Callback when relay state changes
+ * @brief Account one published sample under the current log mode
  */
-static void on_relay_state_changed(bool state)
+static void record_sample_latency(int64_t ingest_us)
 {
-    // Update global state
-    update_and_publish_state(state, g_periodic_active, g_periodic_rate);
+    latency_stats_t* lat = &g_latency[DeferredLog_GetMode()];
+    uint32_t e2e_us = (uint32_t)(esp_timer_get_time() - ingest_us);
     
-    ESP_LOGI(TAG, "Relay state changed: %s", state ? "ON" : "OFF");
+    lat->samples++;
+    lat->e2e_sum_us += e2e_us;
+    if (e2e_us > lat->e2e_max_us)
+    {
+        lat->e2e_max_us = e2e_us;
+    }
+    Metrics_Observe(METRIC_HIST_END_TO_END, e2e_us);
+    
+#if CONFIG_BRIDGE_LOG_BENCHMARK
+    // Cycle sync -> deferred -> off, BRIDGE_LOG_BENCHMARK_SAMPLES samples each, then report
+    static const dlog_mode_t order[] = { DLOG_MODE_SYNC, DLOG_MODE_DEFERRED, DLOG_MODE_OFF };
+    static int phase = -1;
+    static uint32_t in_phase = 0;
+    
+    if (phase >= 0 && ++in_phase < CONFIG_BRIDGE_LOG_BENCHMARK_SAMPLES)
+    {
+        return;
+    }
+    in_phase = 0;
+    
+    if (++phase == 3)
+    {
+        ESP_LOGI(TAG, "=== Log benchmark (%d samples per mode) ===", CONFIG_BRIDGE_LOG_BENCHMARK_SAMPLES);
+        report_latency();
+        phase = 0;
+    }
+    if (phase == 0)
+    {
+        memset(g_latency, 0, sizeof(g_latency));
+    }
+    DeferredLog_SetMode(order[phase]);
+#endif
 }
 
 /**
- * @brief FIXED: Parse command and extract rate
+ * @brief Publish the timestamps of a sample that just went out directly
+ * 
+ * @note stm_us is the STM32 clock, rx_us/pub_us the esp_timer clock; the dashboard
+ *       estimates the offsets between them
  */
-static int extract_periodic_rate(const char* command)
+static void publish_trace(const sensor_data_t* data, int64_t rx_us, int64_t pub_us)
 {
-    // Look for rate in command like "SHT3X PERIODIC 2 HIGH"
-    char* rate_str = strstr(command, "PERIODIC");
-    if (rate_str)
+#if CONFIG_BRIDGE_LATENCY_TRACE
+    static uint32_t seq = 0;
+    
+    // Backlogged samples would only measure the outage
+    if (!data->has_timestamp || g_backlog_count != 0 || !MQTT_Handler_IsReady(&mqtt_handler))
     {
-        rate_str += 8; // Skip "PERIODIC"
-        while (*rate_str == ' ') rate_str++; // Skip spaces
-        
-        int rate = atoi(rate_str);
-        if (rate > 0 && rate <= 10)
-        {
-            return rate;
-        }
+        return;
+    }
+    
+    char json[112];
+    
+    if (ENCODE_TRACE_CBOR)
+    {
+        cbor_writer_t writer;
+        CBOR_WriterInit(&writer, (uint8_t*)json, sizeof(json));
+        CBOR_PutMap(&writer, 4);
+        CBOR_PutText(&writer, "seq");
+        CBOR_PutUint(&writer, ++seq);
+        CBOR_PutText(&writer, "stm_us");
+        CBOR_PutUint(&writer, data->stm32_time_us);
+        CBOR_PutText(&writer, "rx_us");
+        CBOR_PutInt(&writer, rx_us);
+        CBOR_PutText(&writer, "pub_us");
+        CBOR_PutInt(&writer, pub_us);
+        MQTT_Handler_Publish(&mqtt_handler, TOPIC(TOPIC_SHT3X_TRACE), json, CBOR_WriterLength(&writer), 0, 0);
+        return;
     }
-    return g_periodic_rate; // Return current rate if not found
+    
+    snprintf(json, sizeof(json), "{\"seq\":%lu,\"stm_us\":%lu,\"rx_us\":%lld,\"pub_us\":%lld}",
+             (unsigned long)++seq, (unsigned long)data->stm32_time_us, rx_us, pub_us);
+    MQTT_Handler_Publish(&mqtt_handler, TOPIC(TOPIC_SHT3X_TRACE), json, 0, 0, 0);
+#endif
 }
 
 /**
- * @brief Callback when MQTT data is received
+ * @brief Drain the pipeline queue; the only place sensor data is published from
  */
-static void on_mqtt_data_received(const char* topic, const char* data, int data_len)
+static void publisher_task(void *pvParameters)
 {
-    ESP_LOGI(TAG, "<- MQTT: %s = %.*s", topic, data_len, data);
+    bridge_msg_t msg;
     
-    // Handle SHT3X commands
-    if (strcmp(topic, TOPIC_SHT3X_COMMAND) == 0)
+    while (1)
     {
-        // FIXED: Track periodic state based on commands
-        if (strstr(data, "PERIODIC") && !strstr(data, "STOP"))
+        // With a partial batch pending, wake up to send it once periodic mode has stopped;
+        // with rollups, wake up to close their buckets when no samples arrive
+        TickType_t wait = g_batch.count ? pdMS_TO_TICKS(SAMPLE_BATCH_IDLE_MS) : portMAX_DELAY;
+        if (PUBLISH_ROLLUPS && wait > pdMS_TO_TICKS(ROLLUP_TICK_MS))
         {
-            int new_rate = extract_periodic_rate(data);
-            update_and_publish_state(g_device_on, true, new_rate);
+            wait = pdMS_TO_TICKS(ROLLUP_TICK_MS);
         }
-        else if (strstr(data, "PERIODIC STOP"))
+        if (xQueueReceive(g_pipeline_queue, &msg, wait) != pdTRUE)
         {
-            update_and_publish_state(g_device_on, false, g_periodic_rate);
+            if (g_batch.count && !g_periodic_active)
+            {
+                flush_sample_batch();
+            }
+            if (PUBLISH_ROLLUPS)
+            {
+                publish_rollups(Rollup_Advance(&g_rollup, esp_timer_get_time() / 1000));
+            }
+            continue;
         }
         
-        if (STM32_UART_SendCommand(&stm32_uart, data))
+        switch (msg.type)
         {
-            ESP_LOGI(TAG, "Command forwarded to STM32: %s", data);
-        } 
-        else
+        case BRIDGE_MSG_SAMPLE:
         {
-            ESP_LOGE(TAG, "Failed to send command to STM32: %s", data);
+            int64_t pub_us = esp_timer_get_time();
+            bool batched = (msg.sample.type != SENSOR_TYPE_SINGLE && CONFIG_BRIDGE_SAMPLE_BATCH_SIZE > 0);
+            if (msg.sample.type == SENSOR_TYPE_SINGLE)
+            {
+                on_single_sensor_data(&msg.sample);
+            }
+            else if (batched)
+            {
+                batch_sample(&msg.sample, msg.ingest_us);
+            }
+            else
+            {
+                on_periodic_sensor_data(&msg.sample);
+            }
+            if (PUBLISH_ROLLUPS && msg.sample.type != SENSOR_TYPE_SINGLE)
+            {
+                rollup_sample(&msg.sample, msg.ingest_us);
+            }
+            record_sample_latency(msg.ingest_us);
+            if (!batched)
+            {
+                publish_trace(&msg.sample, msg.ingest_us, pub_us);
+            }
+            break;
+        }
+            
+        case BRIDGE_MSG_AGGREGATE:
+            DLOGI(TAG, "<- STM32: %s", msg.line);
+            publish_or_backlog(TOPIC(TOPIC_SHT3X_AGGREGATE), msg.line, 0);
+            break;
+            
+        case BRIDGE_MSG_STATE:
+            DLOGI(TAG, "<- STM32: %s", msg.line);
+            handle_stm32_state(msg.line);
+            break;
+            
+        case BRIDGE_MSG_ACK:
+            DLOGI(TAG, "<- STM32: %s", msg.line);
+            handle_stm32_ack(msg.line);
+            break;
+            
+        default:
+            DLOGI(TAG, "<- STM32: %s", msg.line);
+            break;
         }
+        
+        g_pipeline.processed++;
     }
-    // Handle relay commands
-    else if (strcmp(topic, TOPIC_CONTROL_RELAY) == 0)
+}
+
+/* TASK STATISTICS FUNCTIONS -------------------------------------------------*/
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+/**
+ * @brief Publish per-task core, priority, CPU share and stack headroom since the last call
+ * 
+ * @note CPU share is per core: the run time delta divided by the elapsed run time
+ */
+static void publish_task_stats(void)
+{
+    static TaskStatus_t prev[TASK_STATS_MAX_TASKS];
+    static TaskStatus_t now[TASK_STATS_MAX_TASKS];
+    static UBaseType_t prev_count = 0;
+    static configRUN_TIME_COUNTER_TYPE prev_total = 0;
+    static char json[1536];
+    
+    configRUN_TIME_COUNTER_TYPE total;
+    UBaseType_t count = uxTaskGetSystemState(now, TASK_STATS_MAX_TASKS, &total);
+    if (count == 0)
     {
-        if (Relay_ProcessCommand(&relay_control, data))
-        {
-            ESP_LOGI(TAG, "Relay command processed: %s", data);
-        } 
-        else 
+        ESP_LOGW(TAG, "More than %d tasks, runtime stats skipped", TASK_STATS_MAX_TASKS);
+        return;
+    }
+    
+    configRUN_TIME_COUNTER_TYPE elapsed = total - prev_total;
+    int len = snprintf(json, sizeof(json), "{\"interval_ms\":%lu,\"tasks\":[",
+                       (unsigned long)(elapsed / 1000));
+    
+    for (UBaseType_t i = 0; i < count && len < (int)sizeof(json); i++)
+    {
+        // Delta against the same task in the previous snapshot (0 for new tasks)
+        configRUN_TIME_COUNTER_TYPE before = 0;
+        for (UBaseType_t j = 0; j < prev_count; j++)
         {
-            ESP_LOGW(TAG, "Unknown relay command: %s", data);
+            if (prev[j].xHandle == now[i].xHandle)
+            {
+                before = prev[j].ulRunTimeCounter;
+                break;
+            }
         }
+        
+        BaseType_t core = xTaskGetCoreID(now[i].xHandle);
+        float cpu = elapsed ? 100.0f * (float)(now[i].ulRunTimeCounter - before) / (float)elapsed : 0.0f;
+        
+        len += snprintf(json + len, sizeof(json) - len,
+                        "%s{\"name\":\"%s\",\"core\":%d,\"prio\":%u,\"cpu\":%.1f,\"stack_free\":%lu}",
+                        i ? "," : "", now[i].pcTaskName,
+                        core == tskNO_AFFINITY ? -1 : (int)core,
+                        (unsigned)now[i].uxCurrentPriority, cpu,
+                        (unsigned long)now[i].usStackHighWaterMark);
     }
-    // FIXED: Handle state sync requests
-    else if (strcmp(topic, TOPIC_STATE_SYNC) == 0 && 
-             strstr(data, "REQUEST"))
+    
+    if (len < (int)sizeof(json) - 2)
     {
-        ESP_LOGI(TAG, "State sync requested by client");
-        publish_current_state();
+        strcat(json, "]}");
+        MQTT_Handler_Publish(&mqtt_handler, TOPIC(TOPIC_TASK_STATS), json, 0, 0, 0);
+    }
+    else
+    {
+        ESP_LOGW(TAG, "Task stats do not fit in %d bytes", (int)sizeof(json));
+    }
+    
+    memcpy(prev, now, count * sizeof(TaskStatus_t));
+    prev_count = count;
+    prev_total = total;
+}
+#endif
+
+/* METRICS FUNCTIONS ---------------------------------------------------------*/
+
+/**
+ * @brief Publish the metrics snapshot, retained, to esp32/<client_id>/metrics
+ * 
+ * @note Counters owned by other components are mirrored in just before formatting
+ */
+static void publish_metrics(void)
+{
+    static char json[METRICS_JSON_SIZE];
+    
+    Metrics_Set(METRIC_LINES_RX, stm32_uart.lines_received);
+    Metrics_Set(METRIC_LINES_REJECTED, stm32_uart.lines_rejected);
+    Metrics_Set(METRIC_RING_OVERFLOW, stm32_uart.rx_dropped);
+    Metrics_Set(METRIC_QUEUE_DROPS, g_pipeline.dropped);
+    Metrics_Set(METRIC_BACKLOG_DROPS, g_backlog_dropped);
+    Metrics_Set(METRIC_PUBLISH_OK, mqtt_handler.publish_count);
+    Metrics_Set(METRIC_PUBLISH_FAILURES, mqtt_handler.publish_failures);
+    Metrics_Set(METRIC_RECONNECTS, mqtt_handler.connect_count ? mqtt_handler.connect_count - 1 : 0);
+    Metrics_Set(METRIC_DISCONNECTS, mqtt_handler.disconnect_count);
+    
+    if (Metrics_Format(json, sizeof(json)) < 0)
+    {
+        ESP_LOGW(TAG, "Metrics do not fit in %d bytes", METRICS_JSON_SIZE);
+        return;
     }
+    
+    MQTT_Handler_Publish(&mqtt_handler, TOPIC(TOPIC_METRICS), json, 0, 0, 1);
 }
 
 /* INITIALIZATION FUNCTIONS --------------------------------------------------*/
 
 /**
- * @brief Initialize all components
+ * @brief Initialize and start everything that does not need the network
+ * 
+ * @note Runs before Wi-Fi so samples produced during association are not lost
  */
-static bool initialize_components(void)
+static bool initialize_local_components(void)
 {
     bool success = true;
     
-    // Initialize STM32 UART
-    if (!STM32_UART_Init(&stm32_uart, 
-                         CONFIG_MQTT_UART_PORT_NUM,
-                         CONFIG_MQTT_UART_BAUD_RATE,
-                         CONFIG_MQTT_UART_TXD,
-                         CONFIG_MQTT_UART_RXD,
-                         on_stm32_data_received))
-                         {
-        ESP_LOGE(TAG, "Failed to initialize STM32 UART");
-        success = false;
+    g_backlog_mutex = xSemaphoreCreateMutex();
+    if (!g_backlog_mutex)
+    {
+        ESP_LOGE(TAG, "Failed to create backlog mutex");
+        return false;
     }
     
-    // Initialize MQTT Handler
-    if (!MQTT_Handler_Init(&mqtt_handler,
-                           CONFIG_BROKER_URL,
-                           CONFIG_MQTT_USERNAME,
-                           CONFIG_MQTT_PASSWORD,
-                           on_mqtt_data_received))
-                           {
-        ESP_LOGE(TAG, "Failed to initialize MQTT Handler");
-        success = false;
+    Rollup_Init(&g_rollup);
+    
+    // Publisher first so the queue is drained from the first UART line
+    g_pipeline_queue = xQueueCreate(CONFIG_BRIDGE_PIPELINE_DEPTH, sizeof(bridge_msg_t));
+    if (!g_pipeline_queue ||
+        xTaskCreatePinnedToCore(publisher_task, "publisher", 4096, NULL,
+                                CONFIG_BRIDGE_PUBLISHER_TASK_PRIORITY, NULL,
+                                BRIDGE_TASK_CORE(CONFIG_BRIDGE_PUBLISHER_TASK_CORE)) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Failed to start publisher pipeline");
+        return false;
     }
     
-    // Initialize Relay Control
-    if (!Relay_Init(&relay_control, CONFIG_RELAY_GPIO_NUM, on_relay_state_changed))
+    // Initialize Sensor Parser before UART so the first line has a consumer
+    if (!SensorParser_Init(&sensor_parser, on_sample_parsed, on_sample_parsed))
     {
-        ESP_LOGE(TAG, "Failed to initialize Relay Control");
+        ESP_LOGE(TAG, "Failed to initialize Sensor Parser");
         success = false;
     }
     
-    // Initialize Sensor Parser
-    if (!SensorParser_Init(&sensor_parser, on_single_sensor_data, on_periodic_sensor_data))
+    // Initialize Relay Control
+    if (!Relay_Init(&relay_control, CONFIG_RELAY_GPIO_NUM, on_relay_state_changed))
     {
-        ESP_LOGE(TAG, "Failed to initialize Sensor Parser");
+        ESP_LOGE(TAG, "Failed to initialize Relay Control");
         success = false;
     }
     
     // FIXED: Initialize global state with actual hardware state
     g_device_on = Relay_GetState(&relay_control);
     g_periodic_active = false;
-    g_periodic_rate = 1;
+    g_periodic_rate = 1.0f;
+    
+    // Initialize STM32 UART and start ingest
+    if (!STM32_UART_Init(&stm32_uart, 
+                         CONFIG_MQTT_UART_PORT_NUM,
+                         CONFIG_MQTT_UART_BAUD_RATE,
+                         CONFIG_MQTT_UART_TXD,
+                         CONFIG_MQTT_UART_RXD,
+                         on_stm32_data_received))
+                         {
+        ESP_LOGE(TAG, "Failed to initialize STM32 UART");
+        success = false;
+    }
+    else if (!STM32_UART_StartTaskPinned(&stm32_uart, CONFIG_BRIDGE_UART_TASK_PRIORITY,
+                                         BRIDGE_TASK_CORE(CONFIG_BRIDGE_UART_TASK_CORE)))
+    {
+        ESP_LOGE(TAG, "Failed to start STM32 UART task");
+        success = false;
+    }
     
     return success;
 }
 
 /**
- * @brief Start all services
+ * @brief Connect Wi-Fi, retrying forever while UART ingest keeps running
  */
-static bool start_services(void)
+static void connect_network(void)
 {
-    bool success = true;
-    
-    // Start STM32 UART task
-    if (!STM32_UART_StartTask(&stm32_uart))
-    {
-        ESP_LOGE(TAG, "Failed to start STM32 UART task");
-        success = false;
-    }
-    
-    // Start MQTT client
-    if (!MQTT_Handler_Start(&mqtt_handler))
+    while (1)
     {
-        ESP_LOGE(TAG, "Failed to start MQTT client");
-        success = false;
+        g_boot.wifi_rounds++;
+        if (example_connect() == ESP_OK)
+        {
+            boot_mark(&g_boot.wifi);
+            return;
+        }
+        
+        ESP_LOGW(TAG, "WiFi connection round %lu failed, retrying in %d ms (%d message(s) buffered)",
+                 (unsigned long)g_boot.wifi_rounds, CONFIG_BRIDGE_WIFI_RETRY_DELAY_MS, g_backlog_count);
+#if CONFIG_EXAMPLE_CONNECT_WIFI
+        // Tear down the failed station so the next round starts clean
+        example_wifi_stop();
+#endif
+        vTaskDelay(pdMS_TO_TICKS(CONFIG_BRIDGE_WIFI_RETRY_DELAY_MS));
     }
-    
-    return success;
 }
 
 /**
- * @brief Subscribe to MQTT topics
+ * @brief Fill g_topics with esp32/<client_id>/<suffix> for every bridge topic, and the group command topics
  */
-static void subscribe_mqtt_topics(void)
+static bool build_device_topics(void)
 {
-    // Wait for MQTT connection
-    int retry_count = 0;
-    while (!MQTT_Handler_IsConnected(&mqtt_handler) && retry_count < 30)
+    for (int i = 0; i < TOPIC_COUNT; i++)
     {
-        vTaskDelay(pdMS_TO_TICKS(1000));
-        retry_count++;
+        if (MQTT_Handler_DeviceTopic(&mqtt_handler, TOPIC_SUFFIXES[i], g_topics[i], sizeof(g_topics[i])) < 0)
+        {
+            ESP_LOGE(TAG, "Topic %s does not fit in %d bytes", TOPIC_SUFFIXES[i], MQTT_MAX_TOPIC_LEN);
+            return false;
+        }
     }
     
-    if (!MQTT_Handler_IsConnected(&mqtt_handler))
+    const char* groups[] = { GROUP_ALL, CONFIG_BRIDGE_COMMAND_GROUP };
+    g_group_topic_count = 0;
+    for (int i = 0; i < 2; i++)
     {
-        ESP_LOGE(TAG, "MQTT connection timeout, cannot subscribe to topics");
-        return;
+        if (groups[i][0] == '\0' || (i > 0 && strcmp(groups[i], GROUP_ALL) == 0))
+        {
+            continue;
+        }
+        int len = snprintf(g_group_topics[g_group_topic_count], MQTT_MAX_TOPIC_LEN, GROUP_COMMAND_TOPIC_FMT, groups[i]);
+        if (len < 0 || len >= MQTT_MAX_TOPIC_LEN)
+        {
+            ESP_LOGE(TAG, "Group %s does not fit in %d bytes", groups[i], MQTT_MAX_TOPIC_LEN);
+            return false;
+        }
+        g_group_topic_count++;
     }
     
-    // Subscribe to command topics
-    MQTT_Handler_Subscribe(&mqtt_handler, TOPIC_SHT3X_COMMAND, 1);
-    MQTT_Handler_Subscribe(&mqtt_handler, TOPIC_CONTROL_RELAY, 1);
-    MQTT_Handler_Subscribe(&mqtt_handler, TOPIC_STATE_SYNC, 1);  // NEW: Subscribe to state sync
-    
-    // FIXED: Publish initial state with retain flag
-    publish_current_state();
-    
-    ESP_LOGI(TAG, "MQTT topics subscribed and initial state published");
+    return true;
 }
 
 /**
- * @brief MQTT subscribe task
+ * @brief Initialize and start the MQTT client (needs Wi-Fi for the MAC-derived client ID)
  */
-static void mqtt_subscribe_task(void* param)
+static bool start_mqtt(void)
 {
-    subscribe_mqtt_topics();
-    vTaskDelete(NULL);
+    if (!MQTT_Handler_Init(&mqtt_handler,
+                           CONFIG_BROKER_URL,
+                           CONFIG_MQTT_USERNAME,
+                           CONFIG_MQTT_PASSWORD,
+                           on_mqtt_data_received))
+                           {
+        ESP_LOGE(TAG, "Failed to initialize MQTT Handler");
+        return false;
+    }
+    
+    if (!build_device_topics())
+    {
+        return false;
+    }
+    
+    // Replayed by the handler on every MQTT_EVENT_CONNECTED
+    MQTT_Handler_AddSubscription(&mqtt_handler, TOPIC(TOPIC_SHT3X_COMMAND), 1);
+    MQTT_Handler_AddSubscription(&mqtt_handler, TOPIC(TOPIC_CONTROL_RELAY), 1);
+    MQTT_Handler_AddSubscription(&mqtt_handler, TOPIC(TOPIC_STATE_SYNC), 1);
+    for (int i = 0; i < g_group_topic_count; i++)
+    {
+        MQTT_Handler_AddSubscription(&mqtt_handler, g_group_topics[i], 1);
+    }
+    MQTT_Handler_SetReadyCallback(&mqtt_handler, on_mqtt_ready);
+    
+    if (!MQTT_Handler_Start(&mqtt_handler))
+    {
+        ESP_LOGE(TAG, "Failed to start MQTT client");
+        return false;
+    }
+    
+    return true;
 }
 
 /* MAIN APPLICATION ----------------------------------------------------------*/
 
 void app_main(void)
 {
+    boot_mark(&g_boot.app_start);
+    
+    // Before any component so hot-path DLOGx calls are deferred from the first line
+    if (!DeferredLog_Init())
+    {
+        ESP_LOGW(TAG, "Deferred log unavailable, logging synchronously");
+    }
+    
     ESP_LOGI(TAG, "=== ESP32-STM32 MQTT Bridge Starting ===");
     ESP_LOGI(TAG, "Free heap: %lu bytes", esp_get_free_heap_size());
     ESP_LOGI(TAG, "IDF version: %s", esp_get_idf_version());
@@ -379,6 +1665,7 @@ void app_main(void)
         ret = nvs_flash_init();
     }
     ESP_ERROR_CHECK(ret);
+    boot_mark(&g_boot.nvs);
     ESP_LOGI(TAG, "NVS initialized");
     
     // Initialize network
@@ -386,28 +1673,32 @@ void app_main(void)
     ESP_ERROR_CHECK(esp_event_loop_create_default());
     ESP_LOGI(TAG, "Network interface initialized");
     
-    // Connect to WiFi
-    ESP_ERROR_CHECK(example_connect());
-    ESP_LOGI(TAG, "WiFi connected successfully");
-    
-    // Initialize all components
-    if (!initialize_components())
+    // UART ingest first: samples are buffered while the network comes up
+    if (!initialize_local_components())
     {
-        ESP_LOGE(TAG, "Failed to initialize components, restarting...");
-        esp_restart();
+        // Every publish path takes the backlog mutex: without it nothing can run
+        if (!g_backlog_mutex)
+        {
+            ESP_LOGE(TAG, "No backlog mutex, restarting");
+            esp_restart();
+        }
+        ESP_LOGE(TAG, "Some local components failed, continuing with what is available");
     }
-    ESP_LOGI(TAG, "All components initialized successfully");
+    boot_mark(&g_boot.uart_ready);
+    ESP_LOGI(TAG, "UART ingest running after %lld ms", g_boot.uart_ready / 1000);
+    
+    // The STM32 may have resumed a saved periodic mode: ask instead of assuming idle
+    STM32_UART_SendCommand(&stm32_uart, "SHT3X STATE");
     
-    // Start all services
-    if (!start_services())
+    // Connect to WiFi (retries in place, UART keeps running)
+    connect_network();
+    ESP_LOGI(TAG, "WiFi connected successfully after %lld ms", g_boot.wifi / 1000);
+    
+    // Backlog is flushed from the ready callback once all subscriptions are acknowledged
+    if (!start_mqtt())
     {
-        ESP_LOGE(TAG, "Failed to start services, restarting...");
-        esp_restart();
+        ESP_LOGE(TAG, "MQTT unavailable, running UART-only");
     }
-    ESP_LOGI(TAG, "All services started successfully");
-    
-    // Subscribe to MQTT topics (runs in background)
-    xTaskCreate(mqtt_subscribe_task, "mqtt_subscribe", 10240, NULL, 3, NULL);
     
     // Main loop - monitor system status
     ESP_LOGI(TAG, "=== System Ready ===");
@@ -417,19 +1708,44 @@ void app_main(void)
              CONFIG_MQTT_UART_RXD, CONFIG_MQTT_UART_BAUD_RATE);
     ESP_LOGI(TAG, "  Relay GPIO: %d", CONFIG_RELAY_GPIO_NUM);
     ESP_LOGI(TAG, "  MQTT Broker: %s", CONFIG_BROKER_URL);
-    ESP_LOGI(TAG, "Topics:");
-    ESP_LOGI(TAG, "  Commands: %s", TOPIC_SHT3X_COMMAND);
-    ESP_LOGI(TAG, "  Relay: %s", TOPIC_CONTROL_RELAY);
-    ESP_LOGI(TAG, "  State: %s", TOPIC_STATE_SYNC);
-    ESP_LOGI(TAG, "  Single T: %s", TOPIC_SHT3X_SINGLE_TEMPERATURE);
-    ESP_LOGI(TAG, "  Single H: %s", TOPIC_SHT3X_SINGLE_HUMIDITY);
-    ESP_LOGI(TAG, "  Periodic T: %s", TOPIC_SHT3X_PERIODIC_TEMPERATURE);
-    ESP_LOGI(TAG, "  Periodic H: %s", TOPIC_SHT3X_PERIODIC_HUMIDITY);
+    ESP_LOGI(TAG, "Topics (discovery: " MQTT_TOPIC_ROOT "/+/%s):", TOPIC_SUFFIXES[TOPIC_STATE_SYNC]);
+    for (int i = 0; i < TOPIC_COUNT; i++)
+    {
+        ESP_LOGI(TAG, "  %s", TOPIC(i));
+    }
+    for (int i = 0; i < g_group_topic_count; i++)
+    {
+        ESP_LOGI(TAG, "  %s (group)", g_group_topics[i]);
+    }
+    ESP_LOGI(TAG, "Tasks: stm32_uart core %d prio %d, publisher core %d prio %d, mqtt prio %d",
+             CONFIG_BRIDGE_UART_TASK_CORE, CONFIG_BRIDGE_UART_TASK_PRIORITY,
+             CONFIG_BRIDGE_PUBLISHER_TASK_CORE, CONFIG_BRIDGE_PUBLISHER_TASK_PRIORITY,
+             CONFIG_BRIDGE_MQTT_TASK_PRIORITY);
+    ESP_LOGI(TAG, "Encoding: samples %s, state %s, trace %s, batch %d (%s)",
+             ENCODE_SAMPLES_CBOR ? "CBOR" : "text", ENCODE_STATE_CBOR ? "CBOR" : "JSON",
+             ENCODE_TRACE_CBOR ? "CBOR" : "JSON", CONFIG_BRIDGE_SAMPLE_BATCH_SIZE,
+             ENCODE_BATCH_DELTA ? "ts_codec" : "CBOR");
+    if (PUBLISH_ROLLUPS)
+    {
+        ESP_LOGI(TAG, "Rollups: 1 min x %d, 15 min x %d, 1 h x %d buckets, %s",
+                 ROLLUP_DEPTH_1M, ROLLUP_DEPTH_15M, ROLLUP_DEPTH_1H, ENCODE_ROLLUP_CBOR ? "CBOR" : "JSON");
+    }
     
     // Status tracking
     bool last_relay = g_device_on;
     bool last_periodic = g_periodic_active;
     bool last_mqtt = MQTT_Handler_IsConnected(&mqtt_handler);
+    uint32_t last_dropped = 0;
+    uint32_t last_rx_dropped = 0;
+    TickType_t last_report = xTaskGetTickCount();
+    TickType_t last_task_stats = xTaskGetTickCount();
+    TickType_t last_metrics = xTaskGetTickCount();
+    
+    Metrics_WatchTask("stm32_uart");
+    Metrics_WatchTask("publisher");
+    Metrics_WatchTask("mqtt_task");
+    Metrics_WatchTask("dlog");
+    Metrics_WatchTask("main");
 
     ESP_LOGI(TAG, "Initial State: MQTT=%s, Device=%s, Periodic=%s",
              last_mqtt ? "Connected" : "Disconnected",
@@ -456,6 +1772,44 @@ void app_main(void)
         last_periodic = periodic_now;
         last_mqtt = mqtt_now;
         
+        // Pipeline metrics: periodically, and at once when anything was lost
+        bool lost = g_pipeline.dropped != last_dropped || stm32_uart.rx_dropped != last_rx_dropped;
+        if (lost || (xTaskGetTickCount() - last_report) >= pdMS_TO_TICKS(PIPELINE_REPORT_INTERVAL_MS))
+        {
+            ESP_LOGI(TAG, "Pipeline: depth %u/%d (max %lu), in %lu, out %lu, dropped %lu, UART overrun %lu byte(s)",
+                     (unsigned)uxQueueMessagesWaiting(g_pipeline_queue), CONFIG_BRIDGE_PIPELINE_DEPTH,
+                     (unsigned long)g_pipeline.max_depth, (unsigned long)g_pipeline.enqueued,
+                     (unsigned long)g_pipeline.processed, (unsigned long)g_pipeline.dropped,
+                     (unsigned long)stm32_uart.rx_dropped);
+            dlog_stats_t dlog;
+            DeferredLog_GetStats(&dlog);
+            ESP_LOGI(TAG, "Deferred log: %lu recorded, %lu dropped, %lu rate-limited",
+                     (unsigned long)dlog.recorded, (unsigned long)dlog.dropped,
+                     (unsigned long)dlog.suppressed);
+#if !CONFIG_BRIDGE_LOG_BENCHMARK
+            report_latency();
+#endif
+            last_dropped = g_pipeline.dropped;
+            last_rx_dropped = stm32_uart.rx_dropped;
+            last_report = xTaskGetTickCount();
+        }
+        
+        if (CONFIG_BRIDGE_METRICS_INTERVAL_S > 0 && MQTT_Handler_IsReady(&mqtt_handler) &&
+            (xTaskGetTickCount() - last_metrics) >= pdMS_TO_TICKS(CONFIG_BRIDGE_METRICS_INTERVAL_S * 1000))
+        {
+            publish_metrics();
+            last_metrics = xTaskGetTickCount();
+        }
+        
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+        if (CONFIG_BRIDGE_TASK_STATS_INTERVAL_S > 0 && MQTT_Handler_IsReady(&mqtt_handler) &&
+            (xTaskGetTickCount() - last_task_stats) >= pdMS_TO_TICKS(CONFIG_BRIDGE_TASK_STATS_INTERVAL_S * 1000))
+        {
+            publish_task_stats();
+            last_task_stats = xTaskGetTickCount();
+        }
+#endif
+        
         vTaskDelay(pdMS_TO_TICKS(200));
     }
 }
\ No newline at end of file
@@ -24,6 +24,11 @@
 
 #include "uart.h"
 #include "sht3x.h"
+#include "acquisition.h"
+#include "app_tasks.h"
+#include "profile.h"
+#include "power.h"
+#include "config_store.h"
 
 /* USER CODE END Includes */
 
@@ -35,8 +40,6 @@
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
 
-#define timeData 5000
-
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -53,10 +56,6 @@ UART_HandleTypeDef huart1;
 
 sht3x_handle_t g_sht3x;
 
-static float outT = 0.0f;
-static float outRH = 0.0f;
-static uint32_t next_fetch_ms = 0;
-
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -106,8 +105,20 @@ int main(void)
   MX_USART1_UART_Init();
   /* USER CODE BEGIN 2 */
 
+  PROFILE_INIT();
   UART_Init(&huart1);
   SHT3X_Init(&g_sht3x, &hi2c1, SHT3X_I2C_ADDR_GND);
+  ACQUISITION_Init(&g_sht3x);
+  CONFIG_Restore(&g_sht3x);
+  SHT3X_ReportState(&g_sht3x, true);
+
+#ifdef DATALOGGER_TICKLESS_IDLE
+  POWER_Init();
+#endif
+
+#ifdef DATALOGGER_USE_FREERTOS
+  APP_Tasks_Start();
+#endif
 
   /* USER CODE END 2 */
 
@@ -121,16 +132,13 @@ int main(void)
 
 	UART_Handle();
 
-	if (SHT3X_IS_PERIODIC_STATE(g_sht3x.currentState))
-	{
-		uint32_t now = HAL_GetTick();
-		if ((int32_t)(now - next_fetch_ms) >= 0)
-		{
-			SHT3X_FetchData(&g_sht3x, &outT, &outRH);
-			next_fetch_ms += timeData;
-		}
-	}
+	ACQUISITION_Handle();
+
+#ifdef DATALOGGER_TICKLESS_IDLE
+	POWER_Idle(ACQUISITION_TimeToNextMs());
+#else
 	__WFI(); // Wait For Interrupt
+#endif
   }
   /* USER CODE END 3 */
 }
@@ -189,7 +197,7 @@ static void MX_I2C1_Init(void)
 
   /* USER CODE END I2C1_Init 1 */
   hi2c1.Instance = I2C1;
-  hi2c1.Init.ClockSpeed = 100000;
+  hi2c1.Init.ClockSpeed = 400000;
   hi2c1.Init.DutyCycle = I2C_DUTYCYCLE_2;
   hi2c1.Init.OwnAddress1 = 0;
   hi2c1.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
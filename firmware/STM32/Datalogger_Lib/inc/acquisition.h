@@ -0,0 +1,88 @@
+/**
+ * @file acquisition.h
+ */
+#ifndef ACQUISITION_H
+#define ACQUISITION_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include "sht3x.h"
+#include "filter.h"
+#include <stdint.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+/*
+ * @brief Interval between PERIODIC reports when aggregation is disabled
+ */
+#ifndef ACQUISITION_REPORT_INTERVAL_MS
+#define ACQUISITION_REPORT_INTERVAL_MS	5000
+#endif
+
+/*
+ * @brief ACQUISITION_TimeToNextMs() result when nothing is scheduled
+ */
+#define ACQUISITION_IDLE				UINT32_MAX
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+/*
+ * @brief
+ *
+ * @param *handle
+ */
+void ACQUISITION_Init(sht3x_handle_t *handle);
+
+/*
+ * @brief Fetch and report data when due (call from main loop)
+ */
+void ACQUISITION_Handle(void);
+
+/*
+ * @brief Time until ACQUISITION_Handle() has work to do
+ *
+ * @return ms until the next fetch, ACQUISITION_IDLE when not in periodic mode
+ */
+uint32_t ACQUISITION_TimeToNextMs(void);
+
+/*
+ * @brief Number of sensor fetches since boot
+ */
+uint32_t ACQUISITION_GetFetchCount(void);
+
+/*
+ * @brief HAL tick of the first successful fetch since boot
+ *
+ * @return 0 until a sample has been read
+ */
+uint32_t ACQUISITION_GetFirstSampleMs(void);
+
+/*
+ * @brief Current aggregation window (0 when disabled)
+ */
+uint16_t ACQUISITION_GetAggregateWindow(void);
+
+/*
+ * @brief Current filter type
+ */
+filter_type_t ACQUISITION_GetFilter(void);
+
+/*
+ * @brief Select the aggregation window
+ *
+ * @note With a window set, every FIFO sample is fetched at the sensor rate
+ *       and one AGGREGATE record is printed per window instead of PERIODIC.
+ *
+ * @param windowSeconds 0 to disable
+ */
+void ACQUISITION_SetAggregateWindow(uint16_t windowSeconds);
+
+/*
+ * @brief Select the digital filter applied to raw samples
+ *
+ * @note Any filter other than FILTER_NONE fetches every FIFO sample; the
+ *       latest filtered value is reported every ACQUISITION_REPORT_INTERVAL_MS
+ *       (or fed to the aggregation window when one is set).
+ *
+ * @param type
+ */
+void ACQUISITION_SetFilter(filter_type_t type);
+
+#endif /* ACQUISITION_H */
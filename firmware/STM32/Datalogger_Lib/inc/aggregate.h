@@ -0,0 +1,95 @@
+/**
+ * @file aggregate.h
+ */
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+/*
+ * @brief Streaming statistics of one raw 16-bit channel
+ *
+ * @note Sums are kept in integer raw ticks, converted to physical units
+ *       only when the window is reported.
+ */
+typedef struct
+{
+	uint16_t min;
+	uint16_t max;
+	uint32_t sum;
+	uint64_t sumSq;
+} aggregate_channel_t;
+
+/*
+ * @brief
+ */
+typedef struct
+{
+	uint16_t windowSeconds;		//!< 0: aggregation disabled
+	uint32_t windowStartMs;
+	uint32_t count;
+	aggregate_channel_t temperature;
+	aggregate_channel_t humidity;
+} aggregate_t;
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+/*
+ * @brief
+ *
+ * @param *agg
+ * @param windowSeconds
+ * @param nowMs
+ */
+void Aggregate_Init(aggregate_t *agg, uint16_t windowSeconds, uint32_t nowMs);
+
+/*
+ * @brief Start a new window
+ *
+ * @param *agg
+ * @param nowMs
+ */
+void Aggregate_Reset(aggregate_t *agg, uint32_t nowMs);
+
+/*
+ * @brief Add one sample to the current window
+ *
+ * @param *agg
+ * @param rawT
+ * @param rawRH
+ */
+void Aggregate_Push(aggregate_t *agg, uint16_t rawT, uint16_t rawRH);
+
+/*
+ * @brief
+ *
+ * @param *agg
+ * @param nowMs
+ *
+ * @return true when the current window has run for windowSeconds
+ */
+bool Aggregate_WindowElapsed(const aggregate_t *agg, uint32_t nowMs);
+
+/*
+ * @brief Mean of a channel in raw ticks
+ *
+ * @param *ch
+ * @param count
+ *
+ * @return
+ */
+float Aggregate_Mean(const aggregate_channel_t *ch, uint32_t count);
+
+/*
+ * @brief Population variance of a channel in raw ticks^2
+ *
+ * @param *ch
+ * @param count
+ *
+ * @return
+ */
+float Aggregate_Variance(const aggregate_channel_t *ch, uint32_t count);
+
+#endif /* AGGREGATE_H */
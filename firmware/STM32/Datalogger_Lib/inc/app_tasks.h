@@ -0,0 +1,94 @@
+/**
+ * @file app_tasks.h
+ */
+#ifndef APP_TASKS_H
+#define APP_TASKS_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#ifdef DATALOGGER_USE_FREERTOS
+
+/* DEFINES -------------------------------------------------------------------*/
+/*
+ * @brief Task priorities: sampling first, then draining TX, CLI last
+ */
+#define APP_TASK_ACQ_PRIORITY		(tskIDLE_PRIORITY + 3)
+#define APP_TASK_TX_PRIORITY		(tskIDLE_PRIORITY + 2)
+#define APP_TASK_CMD_PRIORITY		(tskIDLE_PRIORITY + 1)
+
+/*
+ * @brief Stack sizes in words
+ */
+#define APP_TASK_ACQ_STACK			256
+#define APP_TASK_TX_STACK			128
+#define APP_TASK_CMD_STACK			384
+
+/*
+ * @brief Lines buffered for the TX task
+ */
+#define APP_TX_QUEUE_LENGTH			8
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+/*
+ * @brief Acquisition wake-up latency (scheduled fetch time -> task running)
+ */
+typedef struct
+{
+	uint32_t samples;
+	uint32_t maxUs;
+	uint64_t sumUs;
+} app_latency_t;
+
+/* VARIABLES -----------------------------------------------------------------*/
+extern app_latency_t g_acq_latency;
+extern uint32_t g_tx_dropped;
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+/*
+ * @brief Create queues and tasks and start the scheduler (does not return)
+ */
+void APP_Tasks_Start(void);
+
+/*
+ * @brief Queue one formatted line for the TX task
+ *
+ * @note Never blocks; the line is dropped (and counted) when the queue is full.
+ *
+ * @param *data
+ * @param len
+ */
+void APP_Tasks_Print(const char *data, uint16_t len);
+
+/*
+ * @brief Wake the command task (call from the UART RX ISR)
+ */
+void APP_Tasks_NotifyRxFromISR(void);
+
+/*
+ * @brief Print per-task CPU share and stack headroom through PRINT_CLI
+ */
+void APP_Tasks_PrintStats(void);
+
+/*
+ * @brief Hold the sensor against the acquisition task for one SHT3X or acquisition call
+ *
+ * @note Keep flash writes and printing outside: the lock delays sampling.
+ */
+void APP_Tasks_LockSensor(void);
+void APP_Tasks_UnlockSensor(void);
+
+#define SENSOR_LOCK()				APP_Tasks_LockSensor()
+#define SENSOR_UNLOCK()				APP_Tasks_UnlockSensor()
+
+#else
+
+/*
+ * @brief The bare-metal loop runs commands and sampling in turn: nothing to lock
+ */
+#define SENSOR_LOCK()
+#define SENSOR_UNLOCK()
+
+#endif /* DATALOGGER_USE_FREERTOS */
+
+#endif /* APP_TASKS_H */
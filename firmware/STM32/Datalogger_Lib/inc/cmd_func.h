@@ -9,10 +9,19 @@
 #include <stdint.h>
 
 /* TYPEDEFS ------------------------------------------------------------------*/
+/*
+ * @brief Command result, reported as "ACK <id> OK|ERROR" for "#<id> ..." commands
+ */
+typedef enum
+{
+	CMD_OK = 0,
+	CMD_ERROR
+} cmd_status_t;
+
 /*
  * @brief
  */
-typedef void (*CmdHandlerFunc)(uint8_t argc, char **argv);
+typedef cmd_status_t (*CmdHandlerFunc)(uint8_t argc, char **argv);
 
 /*
  * @brief
@@ -5,6 +5,7 @@
 #define CMD_PARSER_H
 
 /* INCLUDES ------------------------------------------------------------------*/
+#include "cmd_func.h"
 #include <stdint.h>
 
 /* GLOBAL FUNCTIONS ----------------------------------------------------------*/
@@ -16,7 +17,7 @@
  * @param argc
  * @param **argv
  */
-void Cmd_Default(uint8_t argc, char **argv);
+cmd_status_t Cmd_Default(uint8_t argc, char **argv);
 
 /*
  * @brief
@@ -26,7 +27,7 @@ void Cmd_Default(uint8_t argc, char **argv);
  * @param argc
  * @param **argv
  */
-void SHT3X_Heater_Parser(uint8_t argc, char **argv);
+cmd_status_t SHT3X_Heater_Parser(uint8_t argc, char **argv);
 
 /*
  * @brief
@@ -36,7 +37,7 @@ void SHT3X_Heater_Parser(uint8_t argc, char **argv);
  * @param argc
  * @param **argv
  */
-void SHT3X_Single_Parser(uint8_t argc, char **argv);
+cmd_status_t SHT3X_Single_Parser(uint8_t argc, char **argv);
 
 /*
  * @brief
@@ -46,7 +47,7 @@ void SHT3X_Single_Parser(uint8_t argc, char **argv);
  * @param argc
  * @param **argv
  */
-void SHT3X_Periodic_Parser(uint8_t argc, char **argv);
+cmd_status_t SHT3X_Periodic_Parser(uint8_t argc, char **argv);
 
 /*
  * @brief
@@ -56,7 +57,7 @@ void SHT3X_Periodic_Parser(uint8_t argc, char **argv);
  * @param argc
  * @param **argv
  */
-void SHT3X_ART_Parser(uint8_t argc, char **argv);
+cmd_status_t SHT3X_ART_Parser(uint8_t argc, char **argv);
 
 /*
  * @brief
@@ -66,6 +67,92 @@ void SHT3X_ART_Parser(uint8_t argc, char **argv);
  * @param argc
  * @param **argv
  */
-void SHT3X_Stop_Periodic_Parser(uint8_t argc, char **argv);
+cmd_status_t SHT3X_Stop_Periodic_Parser(uint8_t argc, char **argv);
+
+/*
+ * @brief
+ *
+ * @note
+ *
+ * @param argc
+ * @param **argv
+ */
+cmd_status_t SHT3X_Aggregate_Parser(uint8_t argc, char **argv);
+
+/*
+ * @brief
+ *
+ * @note
+ *
+ * @param argc
+ * @param **argv
+ */
+cmd_status_t SHT3X_Filter_Parser(uint8_t argc, char **argv);
+
+/*
+ * @brief
+ *
+ * @note
+ *
+ * @param argc
+ * @param **argv
+ */
+cmd_status_t SHT3X_State_Parser(uint8_t argc, char **argv);
+
+/*
+ * @brief
+ *
+ * @note
+ *
+ * @param argc
+ * @param **argv
+ */
+cmd_status_t I2C_Stats_Parser(uint8_t argc, char **argv);
+
+/*
+ * @brief
+ *
+ * @note
+ *
+ * @param argc
+ * @param **argv
+ */
+cmd_status_t Config_Parser(uint8_t argc, char **argv);
+
+#ifdef DATALOGGER_TICKLESS_IDLE
+/*
+ * @brief
+ *
+ * @note
+ *
+ * @param argc
+ * @param **argv
+ */
+cmd_status_t Power_Stats_Parser(uint8_t argc, char **argv);
+#endif
+
+#ifdef DATALOGGER_PROFILE
+/*
+ * @brief
+ *
+ * @note
+ *
+ * @param argc
+ * @param **argv
+ */
+cmd_status_t Stats_Parser(uint8_t argc, char **argv);
+#endif
+
+#ifdef DATALOGGER_USE_FREERTOS
+/*
+ * @brief
+ *
+ * @note
+ *
+ * @param argc
+ * @param **argv
+ */
+cmd_status_t Tasks_Parser(uint8_t argc, char **argv);
+#endif
 
 #endif /* CMD_PARSER_H */
@@ -0,0 +1,74 @@
+/**
+ * @file config_store.h
+ */
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include "stm32f1xx_hal.h"
+#include "sht3x.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+/*
+ * @brief Last flash page, reserved by the CONFIG region of the linker script
+ */
+#define CONFIG_PAGE_SIZE		FLASH_PAGE_SIZE
+#define CONFIG_MAGIC			0xC0F1u
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+/*
+ * @brief One append-only slot, 16 bytes (8 half-words programmed in order)
+ */
+typedef struct
+{
+	uint16_t magic;
+	uint8_t mode;			// sht3x_mode_t
+	uint8_t repeat;			// sht3x_repeat_t
+	uint8_t heater;			// sht3x_heater_mode_t
+	uint8_t filter;			// filter_type_t
+	uint16_t windowSeconds;
+	uint16_t reserved[3];
+	uint16_t crc;
+} config_record_t;
+
+#define CONFIG_SLOT_COUNT		(CONFIG_PAGE_SIZE / sizeof(config_record_t))
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+/*
+ * @brief Re-apply the last saved heater, filter, window and periodic mode
+ *
+ * @note Call after SHT3X_Init() and ACQUISITION_Init(). Nothing happens on a blank page.
+ *
+ * @param *handle
+ *
+ * @return true when a valid record was found and applied
+ */
+bool CONFIG_Restore(sht3x_handle_t *handle);
+
+/*
+ * @brief Append the current settings if they differ from the last record
+ *
+ * @note Erases the page only once every CONFIG_SLOT_COUNT changes.
+ *
+ * @param *handle
+ */
+void CONFIG_Save(const sht3x_handle_t *handle);
+
+/*
+ * @brief Erase the page: the next boot starts idle
+ */
+void CONFIG_Clear(void);
+
+/*
+ * @brief Latest valid record
+ *
+ * @param *record
+ * @param *slot Index of the record in the page (may be NULL)
+ *
+ * @return false when the page holds no valid record
+ */
+bool CONFIG_Load(config_record_t *record, uint16_t *slot);
+
+#endif /* CONFIG_STORE_H */
@@ -0,0 +1,89 @@
+/**
+ * @file filter.h
+ */
+#ifndef FILTER_H
+#define FILTER_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stdbool.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+/*
+ * @brief EMA smoothing factor alpha = 1 / 2^FILTER_EMA_SHIFT
+ */
+#ifndef FILTER_EMA_SHIFT
+#define FILTER_EMA_SHIFT		3
+#endif
+
+/*
+ * @brief Fractional bits kept in the EMA accumulator
+ */
+#define FILTER_EMA_FRAC_BITS	8
+
+/*
+ * @brief Moving median window (odd)
+ */
+#ifndef FILTER_MEDIAN_SIZE
+#define FILTER_MEDIAN_SIZE		5
+#endif
+
+/*
+ * @brief Boxcar decimation factor as a power of two
+ */
+#ifndef FILTER_BOXCAR_SHIFT
+#define FILTER_BOXCAR_SHIFT		3
+#endif
+#define FILTER_BOXCAR_SIZE		(1u << FILTER_BOXCAR_SHIFT)
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+/*
+ * @brief
+ */
+typedef enum
+{
+	FILTER_NONE = 0,
+	FILTER_EMA,			//!< exponential moving average, one output per sample
+	FILTER_MEDIAN,		//!< moving median, one output per sample
+	FILTER_BOXCAR		//!< mean of FILTER_BOXCAR_SIZE samples, one output per block
+} filter_type_t;
+
+/*
+ * @brief Filter state for one raw 16-bit channel
+ */
+typedef struct
+{
+	filter_type_t type;
+
+	int32_t emaAcc;		//!< value << FILTER_EMA_FRAC_BITS
+	bool emaPrimed;
+
+	uint16_t window[FILTER_MEDIAN_SIZE];
+	uint8_t windowIndex;
+	uint8_t windowFill;
+
+	uint32_t boxSum;
+	uint8_t boxCount;
+} filter_t;
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+/*
+ * @brief
+ *
+ * @param *filter
+ * @param type
+ */
+void Filter_Init(filter_t *filter, filter_type_t type);
+
+/*
+ * @brief Feed one raw sample
+ *
+ * @param *filter
+ * @param in
+ * @param *out
+ *
+ * @return true when *out holds a new filtered value
+ */
+bool Filter_Process(filter_t *filter, uint16_t in, uint16_t *out);
+
+#endif /* FILTER_H */
@@ -0,0 +1,112 @@
+/**
+ * @file i2c_bus.h
+ */
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include "stm32f1xx_hal.h"
+#include <stdint.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+/*
+ * @brief Extra attempts after a bus-level error (BERR/ARLO/timeout/busy)
+ */
+#ifndef I2C_BUS_MAX_RETRIES
+#define I2C_BUS_MAX_RETRIES		2
+#endif
+
+/*
+ * @brief SCL clocks sent to release a slave holding SDA low
+ */
+#define I2C_BUS_RECOVERY_CLOCKS	9
+
+/*
+ * @brief I2C1 pins (no remap)
+ */
+#define I2C_BUS_SCL_PORT		GPIOB
+#define I2C_BUS_SCL_PIN			GPIO_PIN_6
+#define I2C_BUS_SDA_PORT		GPIOB
+#define I2C_BUS_SDA_PIN			GPIO_PIN_7
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+/*
+ * @brief Per-error-type transfer counters
+ */
+typedef struct
+{
+	uint32_t transfers;		//!< transfers requested
+	uint32_t retries;		//!< extra attempts made
+	uint32_t nack;			//!< address/data not acknowledged (no data ready)
+	uint32_t busError;		//!< misplaced START/STOP
+	uint32_t arbitration;	//!< arbitration lost
+	uint32_t overrun;		//!< overrun/underrun
+	uint32_t timeout;		//!< HAL timeout or bus stuck busy
+	uint32_t recoveries;	//!< bus-clear sequences run
+	uint32_t failures;		//!< transfers given up after all retries
+} i2c_bus_stats_t;
+
+/* VARIABLES -----------------------------------------------------------------*/
+extern i2c_bus_stats_t g_i2c_stats;
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+/*
+ * @brief
+ *
+ * @param *hi2c
+ * @param devAddress 8-bit (shifted) address
+ * @param *data
+ * @param size
+ * @param timeout
+ *
+ * @return
+ */
+HAL_StatusTypeDef I2C_Bus_Transmit(I2C_HandleTypeDef *hi2c, uint16_t devAddress,
+								   uint8_t *data, uint16_t size, uint32_t timeout);
+
+/*
+ * @brief
+ *
+ * @param *hi2c
+ * @param devAddress 8-bit (shifted) address
+ * @param *data
+ * @param size
+ * @param timeout
+ *
+ * @return
+ */
+HAL_StatusTypeDef I2C_Bus_Receive(I2C_HandleTypeDef *hi2c, uint16_t devAddress,
+								  uint8_t *data, uint16_t size, uint32_t timeout);
+
+/*
+ * @brief
+ *
+ * @param *hi2c
+ * @param devAddress 8-bit (shifted) address
+ * @param memAddress 16-bit command word
+ * @param *data
+ * @param size
+ * @param timeout
+ *
+ * @return
+ */
+HAL_StatusTypeDef I2C_Bus_MemRead(I2C_HandleTypeDef *hi2c, uint16_t devAddress,
+								  uint16_t memAddress, uint8_t *data, uint16_t size,
+								  uint32_t timeout);
+
+/*
+ * @brief Clear a stuck bus and reset the peripheral
+ *
+ * @note Pulses SCL until the slave releases SDA, issues a STOP, then
+ *       software-resets and re-initializes the I2C peripheral.
+ *
+ * @param *hi2c
+ */
+void I2C_Bus_Recover(I2C_HandleTypeDef *hi2c);
+
+/*
+ * @brief
+ */
+void I2C_Bus_ResetStats(void);
+
+#endif /* I2C_BUS_H */
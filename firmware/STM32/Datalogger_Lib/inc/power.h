@@ -0,0 +1,97 @@
+/**
+ * @file power.h
+ */
+#ifndef POWER_H
+#define POWER_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include "stm32f1xx_hal.h"
+#include <stdint.h>
+
+#ifdef DATALOGGER_TICKLESS_IDLE
+
+#ifdef DATALOGGER_USE_FREERTOS
+#error "DATALOGGER_TICKLESS_IDLE is for the bare-metal loop; use configUSE_TICKLESS_IDLE with FreeRTOS"
+#endif
+
+/* DEFINES -------------------------------------------------------------------*/
+/*
+ * @brief Shorter idle periods stay in SLEEP (WFI): STOP exit + PLL relock is not free
+ */
+#ifndef POWER_STOP_MIN_MS
+#define POWER_STOP_MIN_MS		5
+#endif
+
+/*
+ * @brief Woken this much early so the fetch is not late after the clock restart
+ */
+#define POWER_WAKEUP_MARGIN_MS	1
+
+/*
+ * @brief Upper bound for one STOP period (also bounds sleep with no periodic mode)
+ */
+#define POWER_STOP_MAX_MS		60000
+
+/*
+ * @brief LSI is measured against SysTick at init over this window
+ */
+#define POWER_LSI_CAL_MS		50
+
+/*
+ * @brief Supply figures for the energy estimate (MCU only, datasheet typicals)
+ */
+#ifndef POWER_RUN_UA
+#define POWER_RUN_UA			20000
+#endif
+#ifndef POWER_STOP_UA
+#define POWER_STOP_UA			25
+#endif
+#ifndef POWER_SUPPLY_MV
+#define POWER_SUPPLY_MV			3300
+#endif
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef struct
+{
+	uint32_t stopMs;		// Time spent in STOP
+	uint32_t stopEntries;
+	uint32_t earlyWakeups;	// STOP left before the alarm (UART activity)
+	uint32_t lsiHz;			// Calibrated RTC clock
+	uint32_t startMs;		// RTC time of the last reset of the counters
+} power_stats_t;
+
+/* VARIABLES -----------------------------------------------------------------*/
+extern power_stats_t g_power_stats;
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+/*
+ * @brief Start the RTC on the calibrated LSI and arm the STOP wake-up lines
+ *
+ * @note Wake sources are the RTC alarm (EXTI17) and a falling edge on USART1 RX (PA10, EXTI10),
+ *       both in event mode.
+ */
+void POWER_Init(void);
+
+/*
+ * @brief Idle until the next scheduled work
+ *
+ * @note Uses STOP when the gap is long enough and nothing is pending on the UART,
+ *       otherwise WFI. SysTick (uwTick) is advanced by the time spent in STOP.
+ *
+ * @param sleepMs Time until the next fetch (ACQUISITION_IDLE when none)
+ */
+void POWER_Idle(uint32_t sleepMs);
+
+/*
+ * @brief Milliseconds since POWER_Init from the RTC (keeps counting in STOP)
+ */
+uint32_t POWER_GetRtcMs(void);
+
+/*
+ * @brief Clear the sleep/run counters
+ */
+void POWER_ResetStats(void);
+
+#endif /* DATALOGGER_TICKLESS_IDLE */
+
+#endif /* POWER_H */
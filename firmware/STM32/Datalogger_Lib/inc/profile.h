@@ -0,0 +1,85 @@
+/**
+ * @file profile.h
+ */
+#ifndef PROFILE_H
+#define PROFILE_H
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include "stm32f1xx_hal.h"
+#include <stdint.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+/*
+ * @brief Histogram bins, each 4x wider than the previous one
+ *
+ * @note Bin 0 is < 256 cycles, bin 7 is >= 2^20 cycles (~16 ms at 64 MHz).
+ */
+#define PROFILE_HIST_BINS		8
+
+#ifdef DATALOGGER_PROFILE
+
+#define PROFILE_INIT()			Profile_Init()
+#define PROFILE_BEGIN(region)	uint32_t profile_start_##region = DWT->CYCCNT
+#define PROFILE_END(region)		Profile_Record((region), DWT->CYCCNT - profile_start_##region)
+
+#else
+
+#define PROFILE_INIT()			((void)0)
+#define PROFILE_BEGIN(region)	((void)0)
+#define PROFILE_END(region)		((void)0)
+
+#endif /* DATALOGGER_PROFILE */
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef enum
+{
+	PROFILE_COMMAND = 0,
+	PROFILE_FETCH,
+	PROFILE_PRINT,
+	PROFILE_I2C,
+	PROFILE_REGION_COUNT
+} profile_region_t;
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t minCycles;
+	uint32_t maxCycles;
+	uint64_t sumCycles;
+	uint32_t hist[PROFILE_HIST_BINS];
+} profile_stats_t;
+
+#ifdef DATALOGGER_PROFILE
+
+/* VARIABLES -----------------------------------------------------------------*/
+extern profile_stats_t g_profile[PROFILE_REGION_COUNT];
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+/*
+ * @brief Start the DWT cycle counter and clear all regions
+ */
+void Profile_Init(void);
+
+/*
+ * @brief Clear all regions
+ */
+void Profile_Reset(void);
+
+/*
+ * @brief Account one execution of a region
+ *
+ * @param region
+ * @param cycles
+ */
+void Profile_Record(profile_region_t region, uint32_t cycles);
+
+/*
+ * @brief Print every region through PRINT_CLI
+ *
+ * @note Two lines per region: "STATS <name> n= min= max= avg=" and "HIST <name> b0..b7".
+ */
+void Profile_Print(void);
+
+#endif /* DATALOGGER_PROFILE */
+
+#endif /* PROFILE_H */
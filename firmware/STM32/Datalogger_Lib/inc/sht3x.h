@@ -6,6 +6,7 @@
 
 /* INCLUDES ------------------------------------------------------------------*/
 #include <stdint.h>
+#include <stdbool.h>
 #include <stm32f1xx_hal.h>
 
 /* DEFINES -------------------------------------------------------------------*/
@@ -20,6 +21,13 @@
  */
 #define SHT3X_RAW_DATA_SIZE 6
 
+/*
+ * @brief Append " @<us>" (sampleTimeUs) to SINGLE/PERIODIC lines for latency tracing
+ */
+#ifndef SHT3X_TIMESTAMP_LINES
+#define SHT3X_TIMESTAMP_LINES 1
+#endif
+
 /* MACROS --------------------------------------------------------------------*/
 /*
  * @brief
@@ -30,6 +38,12 @@
 										 (s)==SHT3X_PERIODIC_4MPS	|| \
 										 (s)==SHT3X_PERIODIC_10MPS)
 
+/*
+ * @brief Raw 16-bit sensor words to physical units (datasheet conversion)
+ */
+#define SHT3X_RAW_TO_TEMPERATURE(raw)	(-45.0f + (175.0f * (float)(raw) / 65535.0f))
+#define SHT3X_RAW_TO_HUMIDITY(raw)		(100.0f * (float)(raw) / 65535.0f)
+
 /* TYPEDEFS ------------------------------------------------------------------*/
 /*
  * @brief
@@ -102,6 +116,16 @@ typedef struct
 	 * @brief
 	 */
 	sht3x_repeat_t modeRepeat;
+
+	/*
+	 * @brief Last heater state confirmed by the status register
+	 */
+	sht3x_heater_mode_t heater;
+
+	/*
+	 * @brief Microseconds since boot when the last frame was read (wraps after ~71 min)
+	 */
+	uint32_t sampleTimeUs;
 } sht3x_handle_t;
 
 /* VARIABLES -----------------------------------------------------------------*/
@@ -198,4 +222,37 @@ SHT3X_StatusTypeDef SHT3X_Stop_Periodic(sht3x_handle_t *handle);
  */
 void SHT3X_FetchData(sht3x_handle_t *handle, float *outT, float *outRH);
 
+/*
+ * @brief Fetch one measurement from the periodic FIFO without printing it
+ *
+ * @note Updates handle->temperature/humidity like SHT3X_FetchData()
+ *
+ * @param *handle
+ * @param *rawT
+ * @param *rawRH
+ *
+ * @return SHT3X_OK when a CRC-valid frame was read
+ */
+SHT3X_StatusTypeDef SHT3X_FetchRaw(sht3x_handle_t *handle, uint16_t *rawT, uint16_t *rawRH);
+
+/*
+ * @brief Measurement period of a periodic mode
+ *
+ * @param mode
+ *
+ * @return Period in ms, 0 for non-periodic modes
+ */
+uint32_t SHT3X_GetPeriodMs(sht3x_mode_t mode);
+
+/*
+ * @brief Print "STATE <mps> <repeat> <heater> <status>" when the state changed
+ *
+ * @note <mps> is 0 outside periodic mode; <status> is the status register in hex
+ *       (last good value when it cannot be read).
+ *
+ * @param *handle
+ * @param force Print even when nothing changed
+ */
+void SHT3X_ReportState(sht3x_handle_t *handle, bool force);
+
 #endif /* SHT3X_H */
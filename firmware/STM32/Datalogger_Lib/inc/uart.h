@@ -7,6 +7,7 @@
 /* INCLUDES ------------------------------------------------------------------*/
 #include "stm32f1xx_hal.h"
 #include <stdint.h>
+#include <stdbool.h>
 
 /* DEFINES -------------------------------------------------------------------*/
 #define BUFFER_UART 128
@@ -45,4 +46,13 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
  */
 void UART_Handle(void);
 
+/*
+ * @brief
+ *
+ * @note True when no byte is buffered and no line is half assembled
+ *
+ * @return
+ */
+bool UART_IsIdle(void);
+
 #endif /* UART_H */
@@ -0,0 +1,257 @@
+/**
+ * @file acquisition.c
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "acquisition.h"
+#include "aggregate.h"
+#include "filter.h"
+#include "print_cli.h"
+#include "profile.h"
+#include <stddef.h>
+
+/* VARIABLES -----------------------------------------------------------------*/
+static sht3x_handle_t *acq_sensor = NULL;
+static aggregate_t acq_aggregate;
+static filter_t acq_filterT;
+static filter_t acq_filterRH;
+static uint32_t next_fetch_ms = 0;
+static uint32_t next_report_ms = 0;
+static sht3x_mode_t last_state = SHT3X_IDLE;
+static uint32_t fetch_count = 0;
+static uint32_t first_sample_ms = 0;
+
+static bool have_sample = false;
+static uint16_t last_rawT = 0;
+static uint16_t last_rawRH = 0;
+static uint32_t last_sampleUs = 0;
+
+/* STATIC FUNCTIONS ----------------------------------------------------------*/
+static void ACQUISITION_ReportAggregate(void)
+{
+	const aggregate_t *agg = &acq_aggregate;
+
+	if (agg->count == 0)
+	{
+		return;
+	}
+
+	/* Scale raw ticks to physical units only once per window */
+	const float kT  = 175.0f / 65535.0f;
+	const float kRH = 100.0f / 65535.0f;
+
+	PRINT_CLI("AGGREGATE %u %lu %.2f %.2f %.2f %.4f %.2f %.2f %.2f %.4f\r\n",
+			agg->windowSeconds, (unsigned long)agg->count,
+			SHT3X_RAW_TO_TEMPERATURE(agg->temperature.min),
+			SHT3X_RAW_TO_TEMPERATURE(agg->temperature.max),
+			-45.0f + kT * Aggregate_Mean(&agg->temperature, agg->count),
+			kT * kT * Aggregate_Variance(&agg->temperature, agg->count),
+			SHT3X_RAW_TO_HUMIDITY(agg->humidity.min),
+			SHT3X_RAW_TO_HUMIDITY(agg->humidity.max),
+			kRH * Aggregate_Mean(&agg->humidity, agg->count),
+			kRH * kRH * Aggregate_Variance(&agg->humidity, agg->count));
+}
+
+/*
+ * @brief Every FIFO sample is needed when filtering or aggregating
+ */
+static inline bool ACQUISITION_Oversampling(void)
+{
+	return acq_aggregate.windowSeconds != 0 || acq_filterT.type != FILTER_NONE;
+}
+
+static void ACQUISITION_MarkFirstSample(void)
+{
+	if (first_sample_ms == 0)
+	{
+		first_sample_ms = HAL_GetTick();
+	}
+}
+
+static void ACQUISITION_Sample(void)
+{
+	uint16_t rawT, rawRH;
+
+	PROFILE_BEGIN(PROFILE_FETCH);
+	SHT3X_StatusTypeDef status = SHT3X_FetchRaw(acq_sensor, &rawT, &rawRH);
+	PROFILE_END(PROFILE_FETCH);
+
+	if (status != SHT3X_OK)
+	{
+		return;
+	}
+	ACQUISITION_MarkFirstSample();
+
+	/* Both channels share the filter type, so they produce output together */
+	uint16_t outT, outRH;
+	bool readyT = Filter_Process(&acq_filterT, rawT, &outT);
+	bool readyRH = Filter_Process(&acq_filterRH, rawRH, &outRH);
+	if (!readyT || !readyRH)
+	{
+		return;
+	}
+
+	if (acq_aggregate.windowSeconds != 0)
+	{
+		Aggregate_Push(&acq_aggregate, outT, outRH);
+		return;
+	}
+
+	last_rawT = outT;
+	last_rawRH = outRH;
+	last_sampleUs = acq_sensor->sampleTimeUs;
+	have_sample = true;
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+void ACQUISITION_Init(sht3x_handle_t *handle)
+{
+	acq_sensor = handle;
+	next_fetch_ms = HAL_GetTick();
+	next_report_ms = next_fetch_ms;
+	last_state = SHT3X_IDLE;
+	have_sample = false;
+	Aggregate_Init(&acq_aggregate, 0, next_fetch_ms);
+	Filter_Init(&acq_filterT, FILTER_NONE);
+	Filter_Init(&acq_filterRH, FILTER_NONE);
+}
+
+uint32_t ACQUISITION_GetFetchCount(void)
+{
+	return fetch_count;
+}
+
+uint32_t ACQUISITION_GetFirstSampleMs(void)
+{
+	return first_sample_ms;
+}
+
+uint16_t ACQUISITION_GetAggregateWindow(void)
+{
+	return acq_aggregate.windowSeconds;
+}
+
+filter_type_t ACQUISITION_GetFilter(void)
+{
+	return acq_filterT.type;
+}
+
+uint32_t ACQUISITION_TimeToNextMs(void)
+{
+	if (acq_sensor == NULL || !SHT3X_IS_PERIODIC_STATE(acq_sensor->currentState))
+	{
+		return ACQUISITION_IDLE;
+	}
+
+	/* Mode changed since the last call: Handle() has to reschedule */
+	if (acq_sensor->currentState != last_state)
+	{
+		return 0;
+	}
+
+	int32_t remaining = (int32_t)(next_fetch_ms - HAL_GetTick());
+	return remaining > 0 ? (uint32_t)remaining : 0;
+}
+
+void ACQUISITION_SetFilter(filter_type_t type)
+{
+	Filter_Init(&acq_filterT, type);
+	Filter_Init(&acq_filterRH, type);
+	have_sample = false;
+	next_fetch_ms = HAL_GetTick();
+}
+
+void ACQUISITION_SetAggregateWindow(uint16_t windowSeconds)
+{
+	uint32_t now = HAL_GetTick();
+
+	Aggregate_Init(&acq_aggregate, windowSeconds, now);
+	next_fetch_ms = now;
+}
+
+void ACQUISITION_Handle(void)
+{
+	if (acq_sensor == NULL || !SHT3X_IS_PERIODIC_STATE(acq_sensor->currentState))
+	{
+		last_state = SHT3X_IDLE;
+		return;
+	}
+
+	uint32_t now = HAL_GetTick();
+
+	/* New periodic mode: first sample is ready one period after start */
+	if (acq_sensor->currentState != last_state)
+	{
+		last_state = acq_sensor->currentState;
+		next_fetch_ms = now + SHT3X_GetPeriodMs(last_state);
+		next_report_ms = next_fetch_ms;
+		have_sample = false;
+		Filter_Init(&acq_filterT, acq_filterT.type);
+		Filter_Init(&acq_filterRH, acq_filterRH.type);
+		Aggregate_Reset(&acq_aggregate, now);
+	}
+
+	if ((int32_t)(now - next_fetch_ms) < 0)
+	{
+		return;
+	}
+
+	fetch_count++;
+
+	uint32_t period_ms;
+	if (!ACQUISITION_Oversampling())
+	{
+		PROFILE_BEGIN(PROFILE_FETCH);
+		SHT3X_StatusTypeDef status = SHT3X_FetchRaw(acq_sensor, NULL, NULL);
+		PROFILE_END(PROFILE_FETCH);
+
+		if (status == SHT3X_OK)
+		{
+			ACQUISITION_MarkFirstSample();
+#if SHT3X_TIMESTAMP_LINES
+			PRINT_CLI("PERIODIC %.2f %.2f @%lu\r\n", acq_sensor->temperature, acq_sensor->humidity,
+					(unsigned long)acq_sensor->sampleTimeUs);
+#else
+			PRINT_CLI("PERIODIC %.2f %.2f\r\n", acq_sensor->temperature, acq_sensor->humidity);
+#endif
+		}
+		period_ms = ACQUISITION_REPORT_INTERVAL_MS;
+		next_fetch_ms += period_ms;
+	}
+	else
+	{
+		ACQUISITION_Sample();
+		period_ms = SHT3X_GetPeriodMs(acq_sensor->currentState);
+		next_fetch_ms += period_ms;
+
+		if (acq_aggregate.windowSeconds != 0)
+		{
+			if (Aggregate_WindowElapsed(&acq_aggregate, now))
+			{
+				ACQUISITION_ReportAggregate();
+				Aggregate_Reset(&acq_aggregate, now);
+			}
+		}
+		else if (have_sample && (int32_t)(now - next_report_ms) >= 0)
+		{
+#if SHT3X_TIMESTAMP_LINES
+			/* Stamp of the newest raw sample in the filter output */
+			PRINT_CLI("PERIODIC %.2f %.2f @%lu\r\n",
+					SHT3X_RAW_TO_TEMPERATURE(last_rawT),
+					SHT3X_RAW_TO_HUMIDITY(last_rawRH),
+					(unsigned long)last_sampleUs);
+#else
+			PRINT_CLI("PERIODIC %.2f %.2f\r\n",
+					SHT3X_RAW_TO_TEMPERATURE(last_rawT),
+					SHT3X_RAW_TO_HUMIDITY(last_rawRH));
+#endif
+			next_report_ms = now + ACQUISITION_REPORT_INTERVAL_MS;
+		}
+	}
+
+	/* Do not burst to catch up after a long blocking command: the sensor has
+	   no new sample before one more period, and NACKs an early fetch */
+	if ((int32_t)(now - next_fetch_ms) >= 0)
+	{
+		next_fetch_ms = now + period_ms;
+	}
+}
@@ -0,0 +1,90 @@
+/**
+ * @file aggregate.c
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "aggregate.h"
+#include <stddef.h>
+
+/* STATIC FUNCTIONS ----------------------------------------------------------*/
+static void Aggregate_ChannelReset(aggregate_channel_t *ch)
+{
+	ch->min = UINT16_MAX;
+	ch->max = 0;
+	ch->sum = 0;
+	ch->sumSq = 0;
+}
+
+static inline void Aggregate_ChannelPush(aggregate_channel_t *ch, uint16_t raw)
+{
+	if (raw < ch->min)
+	{
+		ch->min = raw;
+	}
+	if (raw > ch->max)
+	{
+		ch->max = raw;
+	}
+	ch->sum += raw;
+	ch->sumSq += (uint64_t)((uint32_t)raw * raw);
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+void Aggregate_Init(aggregate_t *agg, uint16_t windowSeconds, uint32_t nowMs)
+{
+	if (agg == NULL)
+	{
+		return;
+	}
+
+	agg->windowSeconds = windowSeconds;
+	Aggregate_Reset(agg, nowMs);
+}
+
+void Aggregate_Reset(aggregate_t *agg, uint32_t nowMs)
+{
+	agg->windowStartMs = nowMs;
+	agg->count = 0;
+	Aggregate_ChannelReset(&agg->temperature);
+	Aggregate_ChannelReset(&agg->humidity);
+}
+
+void Aggregate_Push(aggregate_t *agg, uint16_t rawT, uint16_t rawRH)
+{
+	Aggregate_ChannelPush(&agg->temperature, rawT);
+	Aggregate_ChannelPush(&agg->humidity, rawRH);
+	agg->count++;
+}
+
+bool Aggregate_WindowElapsed(const aggregate_t *agg, uint32_t nowMs)
+{
+	if (agg->windowSeconds == 0)
+	{
+		return false;
+	}
+
+	return (nowMs - agg->windowStartMs) >= (uint32_t)agg->windowSeconds * 1000u;
+}
+
+float Aggregate_Mean(const aggregate_channel_t *ch, uint32_t count)
+{
+	if (count == 0)
+	{
+		return 0.0f;
+	}
+
+	return (float)ch->sum / (float)count;
+}
+
+float Aggregate_Variance(const aggregate_channel_t *ch, uint32_t count)
+{
+	if (count < 2)
+	{
+		return 0.0f;
+	}
+
+	/* n*sum(x^2) - sum(x)^2 stays exact in 64 bit for 60 s at 10 mps */
+	uint64_t n = count;
+	uint64_t num = n * ch->sumSq - (uint64_t)ch->sum * ch->sum;
+
+	return (float)num / ((float)n * (float)n);
+}
@@ -0,0 +1,223 @@
+/**
+ * @file app_tasks.c
+ */
+#ifdef DATALOGGER_USE_FREERTOS
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include "app_tasks.h"
+#include "acquisition.h"
+#include "print_cli.h"
+#include "uart.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include <string.h>
+
+/* DEFINES -------------------------------------------------------------------*/
+/*
+ * @brief Run-time stats clock: DWT cycles / 64 (1 us at 64 MHz, wraps after ~71 min)
+ */
+#define APP_RUNTIME_SHIFT	6
+
+/*
+ * @brief Longest sleep of the acquisition task while idle
+ */
+#define APP_ACQ_IDLE_WAIT_MS	1000
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef struct
+{
+	uint16_t len;
+	char data[BUFFER_PRINT];
+} app_tx_line_t;
+
+/* VARIABLES -----------------------------------------------------------------*/
+app_latency_t g_acq_latency;
+uint32_t g_tx_dropped = 0;
+
+static TaskHandle_t acq_task = NULL;
+static TaskHandle_t cmd_task = NULL;
+static TaskHandle_t tx_task = NULL;
+static QueueHandle_t tx_queue = NULL;
+static SemaphoreHandle_t sensor_mutex = NULL;
+
+/* STATIC FUNCTIONS ----------------------------------------------------------*/
+static inline uint32_t APP_CyclesToUs(uint32_t cycles)
+{
+	return cycles / (SystemCoreClock / 1000000u);
+}
+
+/*
+ * @brief Sample at the sensor rate; also woken by the command task on mode changes
+ */
+static void APP_AcquisitionTask(void *argument)
+{
+	(void)argument;
+
+	for (;;)
+	{
+		uint32_t waitMs = ACQUISITION_TimeToNextMs();
+		if (waitMs > APP_ACQ_IDLE_WAIT_MS)
+		{
+			waitMs = APP_ACQ_IDLE_WAIT_MS;
+		}
+
+		uint32_t dueCycles = DWT->CYCCNT + waitMs * (SystemCoreClock / 1000u);
+		if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs)) == 0 && waitMs > 0 &&
+			ACQUISITION_TimeToNextMs() == 0)
+		{
+			/* Woken by the timeout for a scheduled fetch: record how late */
+			int32_t late = (int32_t)(DWT->CYCCNT - dueCycles);
+			uint32_t lateUs = late > 0 ? APP_CyclesToUs((uint32_t)late) : 0;
+
+			g_acq_latency.samples++;
+			g_acq_latency.sumUs += lateUs;
+			if (lateUs > g_acq_latency.maxUs)
+			{
+				g_acq_latency.maxUs = lateUs;
+			}
+		}
+
+		xSemaphoreTake(sensor_mutex, portMAX_DELAY);
+		ACQUISITION_Handle();
+		xSemaphoreGive(sensor_mutex);
+	}
+}
+
+/*
+ * @brief Assemble and execute CLI lines when the RX ISR signals new bytes
+ */
+static void APP_CommandTask(void *argument)
+{
+	(void)argument;
+
+	for (;;)
+	{
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+		/* Handlers lock the sensor per call (SENSOR_LOCK), not per line */
+		UART_Handle();
+
+		/* A command may have changed the periodic mode */
+		xTaskNotifyGive(acq_task);
+	}
+}
+
+/*
+ * @brief Only task touching the UART TX path
+ */
+static void APP_TxTask(void *argument)
+{
+	(void)argument;
+	app_tx_line_t line;
+
+	for (;;)
+	{
+		if (xQueueReceive(tx_queue, &line, portMAX_DELAY) == pdPASS)
+		{
+			HAL_UART_Transmit(&huart1, (uint8_t*)line.data, line.len, 100);
+		}
+	}
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+void APP_Tasks_Start(void)
+{
+	memset(&g_acq_latency, 0, sizeof(g_acq_latency));
+
+	tx_queue = xQueueCreate(APP_TX_QUEUE_LENGTH, sizeof(app_tx_line_t));
+	sensor_mutex = xSemaphoreCreateMutex();
+
+	xTaskCreate(APP_AcquisitionTask, "acq", APP_TASK_ACQ_STACK, NULL, APP_TASK_ACQ_PRIORITY, &acq_task);
+	xTaskCreate(APP_TxTask, "tx", APP_TASK_TX_STACK, NULL, APP_TASK_TX_PRIORITY, &tx_task);
+	xTaskCreate(APP_CommandTask, "cmd", APP_TASK_CMD_STACK, NULL, APP_TASK_CMD_PRIORITY, &cmd_task);
+
+	vTaskStartScheduler();
+}
+
+void APP_Tasks_Print(const char *data, uint16_t len)
+{
+	/* Before the scheduler runs there is nobody to drain the queue */
+	if (tx_queue == NULL || xTaskGetSchedulerState() != taskSCHEDULER_RUNNING)
+	{
+		HAL_UART_Transmit(&huart1, (uint8_t*)data, len, 100);
+		return;
+	}
+
+	app_tx_line_t line;
+	line.len = (len < sizeof(line.data)) ? len : sizeof(line.data);
+	memcpy(line.data, data, line.len);
+
+	if (xQueueSend(tx_queue, &line, 0) != pdPASS)
+	{
+		g_tx_dropped++;
+	}
+}
+
+void APP_Tasks_NotifyRxFromISR(void)
+{
+	if (cmd_task == NULL)
+	{
+		return;
+	}
+
+	BaseType_t woken = pdFALSE;
+	vTaskNotifyGiveFromISR(cmd_task, &woken);
+	portYIELD_FROM_ISR(woken);
+}
+
+void APP_Tasks_LockSensor(void)
+{
+	xSemaphoreTake(sensor_mutex, portMAX_DELAY);
+}
+
+void APP_Tasks_UnlockSensor(void)
+{
+	xSemaphoreGive(sensor_mutex);
+}
+
+void APP_Tasks_PrintStats(void)
+{
+	TaskStatus_t status[8];
+	uint32_t totalRunTime = 0;
+	UBaseType_t count = uxTaskGetSystemState(status, sizeof(status) / sizeof(status[0]), &totalRunTime);
+
+	/* Percentages without 64-bit division */
+	totalRunTime /= 100u;
+	if (totalRunTime == 0)
+	{
+		totalRunTime = 1;
+	}
+
+	for (UBaseType_t i = 0; i < count; i++)
+	{
+		PRINT_CLI("TASK %s prio=%lu cpu=%lu%% stack_free=%u\r\n",
+				status[i].pcTaskName,
+				(unsigned long)status[i].uxCurrentPriority,
+				(unsigned long)(status[i].ulRunTimeCounter / totalRunTime),
+				(unsigned)status[i].usStackHighWaterMark);
+	}
+
+	uint32_t avgUs = g_acq_latency.samples ? (uint32_t)(g_acq_latency.sumUs / g_acq_latency.samples) : 0;
+	PRINT_CLI("ACQ latency avg=%luus max=%luus n=%lu tx_dropped=%lu\r\n",
+			(unsigned long)avgUs, (unsigned long)g_acq_latency.maxUs,
+			(unsigned long)g_acq_latency.samples, (unsigned long)g_tx_dropped);
+}
+
+/*
+ * @brief Run-time stats hooks (weak in the CubeMX generated freertos.c)
+ */
+void configureTimerForRunTimeStats(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+unsigned long getRunTimeCounterValue(void)
+{
+	return DWT->CYCCNT >> APP_RUNTIME_SHIFT;
+}
+
+#endif /* DATALOGGER_USE_FREERTOS */
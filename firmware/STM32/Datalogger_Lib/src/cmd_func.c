@@ -78,6 +78,66 @@ command_function_t cmdTable[] = {
 		{.cmdString = "SHT3X PERIODIC STOP",
 		.func = SHT3X_Stop_Periodic_Parser},
 
+		{.cmdString = "SHT3X STATE",
+		.func = SHT3X_State_Parser},
+
+		{.cmdString = "SHT3X AGGREGATE 1",
+		.func = SHT3X_Aggregate_Parser},
+
+		{.cmdString = "SHT3X AGGREGATE 10",
+		.func = SHT3X_Aggregate_Parser},
+
+		{.cmdString = "SHT3X AGGREGATE 60",
+		.func = SHT3X_Aggregate_Parser},
+
+		{.cmdString = "SHT3X AGGREGATE OFF",
+		.func = SHT3X_Aggregate_Parser},
+
+		{.cmdString = "SHT3X FILTER EMA",
+		.func = SHT3X_Filter_Parser},
+
+		{.cmdString = "SHT3X FILTER MEDIAN",
+		.func = SHT3X_Filter_Parser},
+
+		{.cmdString = "SHT3X FILTER BOXCAR",
+		.func = SHT3X_Filter_Parser},
+
+		{.cmdString = "SHT3X FILTER OFF",
+		.func = SHT3X_Filter_Parser},
+
+		{.cmdString = "I2C STATS",
+		.func = I2C_Stats_Parser},
+
+		{.cmdString = "I2C STATS RESET",
+		.func = I2C_Stats_Parser},
+
+		{.cmdString = "CONFIG SHOW",
+		.func = Config_Parser},
+
+		{.cmdString = "CONFIG CLEAR",
+		.func = Config_Parser},
+
+#ifdef DATALOGGER_TICKLESS_IDLE
+		{.cmdString = "POWER STATS",
+		.func = Power_Stats_Parser},
+
+		{.cmdString = "POWER STATS RESET",
+		.func = Power_Stats_Parser},
+#endif
+
+#ifdef DATALOGGER_PROFILE
+		{.cmdString = "STATS",
+		.func = Stats_Parser},
+
+		{.cmdString = "STATS RESET",
+		.func = Stats_Parser},
+#endif
+
+#ifdef DATALOGGER_USE_FREERTOS
+		{.cmdString = "TASKS",
+		.func = Tasks_Parser},
+#endif
+
 		{NULL, NULL}
 
 };
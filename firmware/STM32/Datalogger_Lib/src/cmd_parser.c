@@ -5,22 +5,37 @@
 #include "cmd_parser.h"
 #include "print_cli.h"
 #include "sht3x.h"
+#include "acquisition.h"
+#include "i2c_bus.h"
+#include "config_store.h"
+#include "app_tasks.h"
+#include "profile.h"
+#include "power.h"
+#include <stdlib.h>
 #include <string.h>
 
 /* GLOBAL FUNCTIONS ----------------------------------------------------------*/
-void Cmd_Default(uint8_t argc, char **argv)
+cmd_status_t Cmd_Default(uint8_t argc, char **argv)
 {
     PRINT_CLI("Unknown command\r\n");
+    return CMD_ERROR;
 }
 
-void SHT3X_Heater_Parser(uint8_t argc, char **argv)
+cmd_status_t SHT3X_Heater_Parser(uint8_t argc, char **argv)
 {
+	cmd_status_t status = CMD_ERROR;
+
 	if (argc == 3 && strcmp(argv[2], "ENABLE") == 0)
 	{
 		sht3x_heater_mode_t modeHeater = SHT3X_HEATER_ENABLE;
-		if (SHT3X_Heater(&g_sht3x, &modeHeater) == SHT3X_OK)
+		SENSOR_LOCK();
+		SHT3X_StatusTypeDef result = SHT3X_Heater(&g_sht3x, &modeHeater);
+		SENSOR_UNLOCK();
+		if (result == SHT3X_OK)
 		{
+			CONFIG_Save(&g_sht3x);
 			PRINT_CLI("Heater enable succeeded\r\n");
+			status = CMD_OK;
 		}
 		else
 		{
@@ -31,20 +46,30 @@ void SHT3X_Heater_Parser(uint8_t argc, char **argv)
 	else if (argc == 3 && strcmp(argv[2], "DISABLE") == 0)
 	{
 		sht3x_heater_mode_t modeHeater = SHT3X_HEATER_DISABLE;
-		if (SHT3X_Heater(&g_sht3x, &modeHeater) == SHT3X_OK)
+		SENSOR_LOCK();
+		SHT3X_StatusTypeDef result = SHT3X_Heater(&g_sht3x, &modeHeater);
+		SENSOR_UNLOCK();
+		if (result == SHT3X_OK)
 		{
+			CONFIG_Save(&g_sht3x);
 			PRINT_CLI("Heater disable succeeded\r\n");
+			status = CMD_OK;
 		}
 		else
 		{
 			PRINT_CLI("Heater disable failed\r\n");
 		}
 	}
+
+	SENSOR_LOCK();
+	SHT3X_ReportState(&g_sht3x, false);
+	SENSOR_UNLOCK();
+	return status;
 }
 
-void SHT3X_Single_Parser(uint8_t argc, char **argv)
+cmd_status_t SHT3X_Single_Parser(uint8_t argc, char **argv)
 {
-	if (argc < 3) return;
+	if (argc < 3) return CMD_ERROR;
 
 	sht3x_repeat_t modeRepeat;
 
@@ -62,23 +87,33 @@ void SHT3X_Single_Parser(uint8_t argc, char **argv)
 	}
 	else
 	{
-		return;
+		return CMD_ERROR;
 	}
 
-	if(SHT3X_Single(&g_sht3x, &modeRepeat) == SHT3X_OK)
+	cmd_status_t status = CMD_ERROR;
+	SENSOR_LOCK();
+	SHT3X_StatusTypeDef result = SHT3X_Single(&g_sht3x, &modeRepeat);
+	SENSOR_UNLOCK();
+	if (result == SHT3X_OK)
 	{
 //		PRINT_CLI("Single mode succeeded\r\n");
+		status = CMD_OK;
 	}
 	else
 	{
 //		PRINT_CLI("Single mode failed\r\n");
 	}
+
+	SENSOR_LOCK();
+	SHT3X_ReportState(&g_sht3x, false);
+	SENSOR_UNLOCK();
+	return status;
 }
 
-void SHT3X_Periodic_Parser(uint8_t argc, char **argv)
+cmd_status_t SHT3X_Periodic_Parser(uint8_t argc, char **argv)
 {
 
-	if (argc < 4) return;
+	if (argc < 4) return CMD_ERROR;
 
 	sht3x_mode_t modePeriodic;
 	if (strcmp(argv[2], "0.5") == 0)
@@ -103,7 +138,7 @@ void SHT3X_Periodic_Parser(uint8_t argc, char **argv)
     }
     else
     {
-    	return;
+    	return CMD_ERROR;
     }
 
 	sht3x_repeat_t modeRepeat;
@@ -121,40 +156,237 @@ void SHT3X_Periodic_Parser(uint8_t argc, char **argv)
     }
     else
     {
-    	return;
+    	return CMD_ERROR;
     }
 
-    if(SHT3X_Periodic(&g_sht3x, &modePeriodic, &modeRepeat) == SHT3X_OK)
+    cmd_status_t status = CMD_ERROR;
+    SENSOR_LOCK();
+    SHT3X_StatusTypeDef result = SHT3X_Periodic(&g_sht3x, &modePeriodic, &modeRepeat);
+    SENSOR_UNLOCK();
+    if (result == SHT3X_OK)
     {
+    	CONFIG_Save(&g_sht3x);
 //    	PRINT_CLI("Periodic mode succeeded\r\n");
+    	status = CMD_OK;
     }
     else
     {
 //    	PRINT_CLI("Periodic mode failed\r\n");
     }
+
+	SENSOR_LOCK();
+	SHT3X_ReportState(&g_sht3x, false);
+	SENSOR_UNLOCK();
+	return status;
 }
 
-void SHT3X_ART_Parser(uint8_t argc, char **argv)
+cmd_status_t SHT3X_ART_Parser(uint8_t argc, char **argv)
 {
-    if (SHT3X_ART(&g_sht3x) == SHT3X_OK)
+    cmd_status_t status = CMD_ERROR;
+    SENSOR_LOCK();
+    SHT3X_StatusTypeDef result = SHT3X_ART(&g_sht3x);
+    SENSOR_UNLOCK();
+    if (result == SHT3X_OK)
     {
+    	CONFIG_Save(&g_sht3x);
 //    	PRINT_CLI("ART mode succeeded\r\n");
+    	status = CMD_OK;
     }
     else
     {
 //    	PRINT_CLI("ART mode failed\r\n");
     }
 
+	SENSOR_LOCK();
+	SHT3X_ReportState(&g_sht3x, false);
+	SENSOR_UNLOCK();
+	return status;
 }
 
-void SHT3X_Stop_Periodic_Parser(uint8_t argc, char **argv)
+cmd_status_t SHT3X_Stop_Periodic_Parser(uint8_t argc, char **argv)
 {
-    if(SHT3X_Stop_Periodic(&g_sht3x) == SHT3X_OK)
+    cmd_status_t status = CMD_ERROR;
+    SENSOR_LOCK();
+    SHT3X_StatusTypeDef result = SHT3X_Stop_Periodic(&g_sht3x);
+    SENSOR_UNLOCK();
+    if (result == SHT3X_OK)
     {
+    	CONFIG_Save(&g_sht3x);
     	PRINT_CLI("Stop periodic succeeded\r\n");
+    	status = CMD_OK;
     }
     else
     {
     	PRINT_CLI("Stop periodic failed\r\n");
     }
+
+	SENSOR_LOCK();
+	SHT3X_ReportState(&g_sht3x, false);
+	SENSOR_UNLOCK();
+	return status;
+}
+
+cmd_status_t SHT3X_State_Parser(uint8_t argc, char **argv)
+{
+	SENSOR_LOCK();
+	SHT3X_ReportState(&g_sht3x, true);
+	SENSOR_UNLOCK();
+	return CMD_OK;
+}
+
+cmd_status_t SHT3X_Aggregate_Parser(uint8_t argc, char **argv)
+{
+	if (argc < 3) return CMD_ERROR;
+
+	if (strcmp(argv[2], "OFF") == 0)
+	{
+		SENSOR_LOCK();
+		ACQUISITION_SetAggregateWindow(0);
+		SENSOR_UNLOCK();
+		CONFIG_Save(&g_sht3x);
+		PRINT_CLI("Aggregate disable succeeded\r\n");
+		return CMD_OK;
+	}
+
+	uint16_t windowSeconds = (uint16_t)atoi(argv[2]);
+	SENSOR_LOCK();
+	ACQUISITION_SetAggregateWindow(windowSeconds);
+	SENSOR_UNLOCK();
+	CONFIG_Save(&g_sht3x);
+	PRINT_CLI("Aggregate enable succeeded\r\n");
+	return CMD_OK;
+}
+
+cmd_status_t SHT3X_Filter_Parser(uint8_t argc, char **argv)
+{
+	if (argc < 3) return CMD_ERROR;
+
+	filter_type_t type;
+	if (strcmp(argv[2], "EMA") == 0)
+	{
+		type = FILTER_EMA;
+	}
+	else if (strcmp(argv[2], "MEDIAN") == 0)
+	{
+		type = FILTER_MEDIAN;
+	}
+	else if (strcmp(argv[2], "BOXCAR") == 0)
+	{
+		type = FILTER_BOXCAR;
+	}
+	else if (strcmp(argv[2], "OFF") == 0)
+	{
+		type = FILTER_NONE;
+	}
+	else
+	{
+		return CMD_ERROR;
+	}
+
+	SENSOR_LOCK();
+	ACQUISITION_SetFilter(type);
+	SENSOR_UNLOCK();
+	CONFIG_Save(&g_sht3x);
+	PRINT_CLI("Filter %s succeeded\r\n", argv[2]);
+	return CMD_OK;
+}
+
+cmd_status_t I2C_Stats_Parser(uint8_t argc, char **argv)
+{
+	if (argc == 3 && strcmp(argv[2], "RESET") == 0)
+	{
+		I2C_Bus_ResetStats();
+		PRINT_CLI("I2C stats reset succeeded\r\n");
+		return CMD_OK;
+	}
+
+	PRINT_CLI("I2C xfer=%lu retry=%lu nack=%lu berr=%lu arlo=%lu\r\n",
+			g_i2c_stats.transfers, g_i2c_stats.retries, g_i2c_stats.nack,
+			g_i2c_stats.busError, g_i2c_stats.arbitration);
+	PRINT_CLI("I2C ovr=%lu timeout=%lu recover=%lu fail=%lu\r\n",
+			g_i2c_stats.overrun, g_i2c_stats.timeout,
+			g_i2c_stats.recoveries, g_i2c_stats.failures);
+	return CMD_OK;
+}
+
+cmd_status_t Config_Parser(uint8_t argc, char **argv)
+{
+	if (argc == 2 && strcmp(argv[1], "CLEAR") == 0)
+	{
+		CONFIG_Clear();
+		PRINT_CLI("Config clear succeeded\r\n");
+		return CMD_OK;
+	}
+
+	config_record_t record;
+	uint16_t slot = 0;
+	if (!CONFIG_Load(&record, &slot))
+	{
+		PRINT_CLI("CONFIG none boot_to_sample=%lums\r\n",
+				(unsigned long)ACQUISITION_GetFirstSampleMs());
+		return CMD_OK;
+	}
+
+	PRINT_CLI("CONFIG mode=%u repeat=%u heater=%u filter=%u window=%u slot=%u/%u boot_to_sample=%lums\r\n",
+			record.mode, record.repeat, record.heater, record.filter, record.windowSeconds,
+			slot, (unsigned)CONFIG_SLOT_COUNT, (unsigned long)ACQUISITION_GetFirstSampleMs());
+	return CMD_OK;
+}
+
+#ifdef DATALOGGER_USE_FREERTOS
+cmd_status_t Tasks_Parser(uint8_t argc, char **argv)
+{
+	APP_Tasks_PrintStats();
+	return CMD_OK;
+}
+#endif
+
+#ifdef DATALOGGER_PROFILE
+cmd_status_t Stats_Parser(uint8_t argc, char **argv)
+{
+	if (argc == 2 && strcmp(argv[1], "RESET") == 0)
+	{
+		Profile_Reset();
+		PRINT_CLI("Stats reset succeeded\r\n");
+		return CMD_OK;
+	}
+
+	Profile_Print();
+	return CMD_OK;
+}
+#endif
+
+#ifdef DATALOGGER_TICKLESS_IDLE
+cmd_status_t Power_Stats_Parser(uint8_t argc, char **argv)
+{
+	static uint32_t fetchBase = 0;
+
+	if (argc == 3 && strcmp(argv[2], "RESET") == 0)
+	{
+		POWER_ResetStats();
+		fetchBase = ACQUISITION_GetFetchCount();
+		PRINT_CLI("Power stats reset succeeded\r\n");
+		return CMD_OK;
+	}
+
+	uint32_t totalMs = POWER_GetRtcMs() - g_power_stats.startMs;
+	uint32_t stopMs = g_power_stats.stopMs;
+	uint32_t runMs = (totalMs > stopMs) ? (totalMs - stopMs) : 0;
+	uint32_t samples = ACQUISITION_GetFetchCount() - fetchBase;
+
+	/* Duty cycle in 0.01 % */
+	uint32_t duty = totalMs ? (uint32_t)(((uint64_t)runMs * 10000u) / totalMs) : 0;
+
+	/* uA * ms * mV / 1e6 = uJ */
+	uint64_t charge = (uint64_t)runMs * POWER_RUN_UA + (uint64_t)stopMs * POWER_STOP_UA;
+	uint32_t uJ = samples ? (uint32_t)((charge * POWER_SUPPLY_MV / 1000000u) / samples) : 0;
+
+	PRINT_CLI("POWER run=%lums stop=%lums duty=%lu.%02lu%% stops=%lu early=%lu\r\n",
+			(unsigned long)runMs, (unsigned long)stopMs,
+			(unsigned long)(duty / 100u), (unsigned long)(duty % 100u),
+			(unsigned long)g_power_stats.stopEntries, (unsigned long)g_power_stats.earlyWakeups);
+	PRINT_CLI("POWER samples=%lu est=%luuJ/sample lsi=%luHz\r\n",
+			(unsigned long)samples, (unsigned long)uJ, (unsigned long)g_power_stats.lsiHz);
+	return CMD_OK;
 }
+#endif
@@ -5,6 +5,7 @@
 #include "command_execute.h"
 #include "cmd_func.h"
 #include "cmd_parser.h"
+#include "print_cli.h"
 #include <string.h>
 #include <stdint.h>
 
@@ -67,23 +68,44 @@ void COMMAND_EXECUTE(char *commandBuffer)
     strncpy(buffer, commandBuffer, sizeof(buffer) - 1);
     buffer[sizeof(buffer) - 1] = '\0';
 
-    char *argv[10];
-    uint8_t argc = tokenize_string(buffer, argv, 10);
+    char *tokens[10];
+    uint8_t argc = tokenize_string(buffer, tokens, 10);
 
     if (argc == 0)
         return;
 
-    char cmdString[256] = {0};
-    for (uint8_t i = 0; i < argc; i++) {
-        strcat(cmdString, argv[i]);
-        if (i < argc - 1) strcat(cmdString, " ");
+    /* "#<id> <command>": the result is acknowledged as "ACK <id> OK|ERROR" after the
+       command's own output, so the ESP32 can match it to the MQTT request */
+    char **argv = tokens;
+    const char *ackId = NULL;
+    if (argv[0][0] == '#' && argv[0][1] != '\0')
+    {
+        ackId = &argv[0][1];
+        argv++;
+        argc--;
     }
 
-    command_function_t *command = find_command(cmdString);
-
-    if (command == NULL) {
-        Cmd_Default(argc, argv);
+    cmd_status_t status = CMD_ERROR;
+    if (argc == 0) {
+        PRINT_CLI("Unknown command\r\n");
     } else {
-        command->func(argc, argv);
+        char cmdString[256] = {0};
+        for (uint8_t i = 0; i < argc; i++) {
+            strcat(cmdString, argv[i]);
+            if (i < argc - 1) strcat(cmdString, " ");
+        }
+
+        command_function_t *command = find_command(cmdString);
+
+        if (command == NULL) {
+            status = Cmd_Default(argc, argv);
+        } else {
+            status = command->func(argc, argv);
+        }
+    }
+
+    if (ackId != NULL)
+    {
+        PRINT_CLI("ACK %s %s\r\n", ackId, (status == CMD_OK) ? "OK" : "ERROR");
     }
 }
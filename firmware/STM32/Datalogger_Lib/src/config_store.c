@@ -0,0 +1,202 @@
+/**
+ * @file config_store.c
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "config_store.h"
+#include "acquisition.h"
+#include <string.h>
+
+/* VARIABLES -----------------------------------------------------------------*/
+/*
+ * @brief Start of the reserved page (linker script symbol)
+ */
+extern uint32_t _config_start[];
+
+/* STATIC FUNCTIONS ----------------------------------------------------------*/
+static inline const config_record_t* CONFIG_Slot(uint16_t index)
+{
+	return &((const config_record_t*)_config_start)[index];
+}
+
+/*
+ * @brief CRC-16/CCITT-FALSE over everything but the crc field
+ */
+static uint16_t CONFIG_CRC(const config_record_t *record)
+{
+	const uint8_t *data = (const uint8_t*)record;
+	uint16_t crc = 0xFFFF;
+
+	for (size_t i = 0; i < offsetof(config_record_t, crc); i++)
+	{
+		crc ^= (uint16_t)data[i] << 8;
+		for (uint8_t b = 0; b < 8; b++)
+		{
+			crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+		}
+	}
+
+	return crc;
+}
+
+static bool CONFIG_IsValid(const config_record_t *record)
+{
+	return record->magic == CONFIG_MAGIC && record->crc == CONFIG_CRC(record);
+}
+
+static bool CONFIG_IsBlank(const config_record_t *record)
+{
+	const uint16_t *words = (const uint16_t*)record;
+
+	for (size_t i = 0; i < sizeof(config_record_t) / sizeof(uint16_t); i++)
+	{
+		if (words[i] != 0xFFFFu)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/*
+ * @brief First erased slot, CONFIG_SLOT_COUNT when the page is full
+ */
+static uint16_t CONFIG_FirstBlank(void)
+{
+	for (uint16_t i = 0; i < CONFIG_SLOT_COUNT; i++)
+	{
+		if (CONFIG_IsBlank(CONFIG_Slot(i)))
+		{
+			return i;
+		}
+	}
+	return CONFIG_SLOT_COUNT;
+}
+
+static HAL_StatusTypeDef CONFIG_ErasePage(void)
+{
+	FLASH_EraseInitTypeDef erase = {0};
+	uint32_t pageError = 0;
+
+	erase.TypeErase = FLASH_TYPEERASE_PAGES;
+	erase.PageAddress = (uint32_t)_config_start;
+	erase.NbPages = 1;
+
+	return HAL_FLASHEx_Erase(&erase, &pageError);
+}
+
+static void CONFIG_Capture(const sht3x_handle_t *handle, config_record_t *record)
+{
+	memset(record, 0, sizeof(*record));
+	record->magic = CONFIG_MAGIC;
+
+	/* Single shot is not a mode worth resuming */
+	record->mode = SHT3X_IS_PERIODIC_STATE(handle->currentState) ? (uint8_t)handle->currentState : SHT3X_IDLE;
+	record->repeat = (uint8_t)handle->modeRepeat;
+	record->heater = (uint8_t)handle->heater;
+	record->filter = (uint8_t)ACQUISITION_GetFilter();
+	record->windowSeconds = ACQUISITION_GetAggregateWindow();
+	record->crc = CONFIG_CRC(record);
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+bool CONFIG_Load(config_record_t *record, uint16_t *slot)
+{
+	/* Newest first; a torn write falls back to the record before it */
+	for (int32_t i = (int32_t)CONFIG_FirstBlank() - 1; i >= 0; i--)
+	{
+		const config_record_t *candidate = CONFIG_Slot((uint16_t)i);
+		if (CONFIG_IsValid(candidate))
+		{
+			memcpy(record, candidate, sizeof(*record));
+			if (slot)
+			{
+				*slot = (uint16_t)i;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+void CONFIG_Save(const sht3x_handle_t *handle)
+{
+	if (handle == NULL)
+	{
+		return;
+	}
+
+	config_record_t record, last;
+	CONFIG_Capture(handle, &record);
+
+	if (CONFIG_Load(&last, NULL) && memcmp(&record, &last, sizeof(record)) == 0)
+	{
+		return;
+	}
+
+	uint16_t slot = CONFIG_FirstBlank();
+
+	HAL_FLASH_Unlock();
+
+	if (slot >= CONFIG_SLOT_COUNT)
+	{
+		if (CONFIG_ErasePage() != HAL_OK)
+		{
+			HAL_FLASH_Lock();
+			return;
+		}
+		slot = 0;
+	}
+
+	uint32_t address = (uint32_t)CONFIG_Slot(slot);
+	const uint16_t *words = (const uint16_t*)&record;
+
+	/* Magic goes first: a slot cut short by a reset is non-blank but fails its CRC */
+	for (size_t i = 0; i < sizeof(record) / sizeof(uint16_t); i++)
+	{
+		if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address + 2u * i, words[i]) != HAL_OK)
+		{
+			break;
+		}
+	}
+
+	HAL_FLASH_Lock();
+}
+
+void CONFIG_Clear(void)
+{
+	HAL_FLASH_Unlock();
+	CONFIG_ErasePage();
+	HAL_FLASH_Lock();
+}
+
+bool CONFIG_Restore(sht3x_handle_t *handle)
+{
+	config_record_t record;
+
+	if (handle == NULL || !CONFIG_Load(&record, NULL))
+	{
+		return false;
+	}
+
+	if (record.filter <= FILTER_BOXCAR)
+	{
+		ACQUISITION_SetFilter((filter_type_t)record.filter);
+	}
+	ACQUISITION_SetAggregateWindow(record.windowSeconds);
+
+	/* Heater commands are rejected in periodic mode: apply it first */
+	if (record.heater == SHT3X_HEATER_ENABLE)
+	{
+		sht3x_heater_mode_t heater = SHT3X_HEATER_ENABLE;
+		SHT3X_Heater(handle, &heater);
+	}
+
+	if (SHT3X_IS_PERIODIC_STATE(record.mode) && record.repeat <= SHT3X_LOW)
+	{
+		sht3x_mode_t mode = (sht3x_mode_t)record.mode;
+		sht3x_repeat_t repeat = (sht3x_repeat_t)record.repeat;
+		SHT3X_Periodic(handle, &mode, &repeat);
+	}
+
+	return true;
+}
@@ -0,0 +1,104 @@
+/**
+ * @file filter.c
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "filter.h"
+#include <stddef.h>
+#include <string.h>
+
+/* STATIC FUNCTIONS ----------------------------------------------------------*/
+static uint16_t Filter_EMA(filter_t *filter, uint16_t in)
+{
+	int32_t x = (int32_t)in << FILTER_EMA_FRAC_BITS;
+
+	if (!filter->emaPrimed)
+	{
+		filter->emaAcc = x;
+		filter->emaPrimed = true;
+	}
+	else
+	{
+		filter->emaAcc += (x - filter->emaAcc) >> FILTER_EMA_SHIFT;
+	}
+
+	return (uint16_t)((filter->emaAcc + (1 << (FILTER_EMA_FRAC_BITS - 1))) >> FILTER_EMA_FRAC_BITS);
+}
+
+static uint16_t Filter_Median(filter_t *filter, uint16_t in)
+{
+	filter->window[filter->windowIndex] = in;
+	filter->windowIndex = (uint8_t)((filter->windowIndex + 1) % FILTER_MEDIAN_SIZE);
+	if (filter->windowFill < FILTER_MEDIAN_SIZE)
+	{
+		filter->windowFill++;
+	}
+
+	/* Insertion sort of a copy: a handful of elements, no heap */
+	uint16_t sorted[FILTER_MEDIAN_SIZE];
+	uint8_t n = filter->windowFill;
+
+	for (uint8_t i = 0; i < n; i++)
+	{
+		uint16_t v = filter->window[i];
+		int8_t j = (int8_t)i - 1;
+		while (j >= 0 && sorted[j] > v)
+		{
+			sorted[j + 1] = sorted[j];
+			j--;
+		}
+		sorted[j + 1] = v;
+	}
+
+	return sorted[n / 2];
+}
+
+static bool Filter_Boxcar(filter_t *filter, uint16_t in, uint16_t *out)
+{
+	filter->boxSum += in;
+	filter->boxCount++;
+
+	if (filter->boxCount < FILTER_BOXCAR_SIZE)
+	{
+		return false;
+	}
+
+	*out = (uint16_t)((filter->boxSum + (FILTER_BOXCAR_SIZE / 2)) >> FILTER_BOXCAR_SHIFT);
+	filter->boxSum = 0;
+	filter->boxCount = 0;
+
+	return true;
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+void Filter_Init(filter_t *filter, filter_type_t type)
+{
+	if (filter == NULL)
+	{
+		return;
+	}
+
+	memset(filter, 0, sizeof(*filter));
+	filter->type = type;
+}
+
+bool Filter_Process(filter_t *filter, uint16_t in, uint16_t *out)
+{
+	switch (filter->type)
+	{
+		case FILTER_EMA:
+			*out = Filter_EMA(filter, in);
+			return true;
+
+		case FILTER_MEDIAN:
+			*out = Filter_Median(filter, in);
+			return true;
+
+		case FILTER_BOXCAR:
+			return Filter_Boxcar(filter, in, out);
+
+		case FILTER_NONE:
+		default:
+			*out = in;
+			return true;
+	}
+}
@@ -0,0 +1,214 @@
+/**
+ * @file i2c_bus.c
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "i2c_bus.h"
+#include "profile.h"
+#include <string.h>
+
+/* TYPEDEFS ------------------------------------------------------------------*/
+typedef enum
+{
+	I2C_BUS_OP_TRANSMIT = 0,
+	I2C_BUS_OP_RECEIVE,
+	I2C_BUS_OP_MEM_READ
+} i2c_bus_op_t;
+
+/* VARIABLES -----------------------------------------------------------------*/
+i2c_bus_stats_t g_i2c_stats;
+
+/* STATIC FUNCTIONS ----------------------------------------------------------*/
+/*
+ * @brief 5 us busy wait on the DWT cycle counter: half an SCL period at 100 kHz
+ * @note A counted loop depends on flash wait states and the compiler; the cycle
+ *       counter does not. Enabling it is idempotent and leaves CYCCNT running.
+ */
+static void I2C_Bus_HalfClockDelay(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	uint32_t start = DWT->CYCCNT;
+	uint32_t cycles = SystemCoreClock / 200000u;
+	while (DWT->CYCCNT - start < cycles)
+	{
+	}
+}
+
+/*
+ * @brief Count the error and tell whether a retry can help
+ */
+static uint8_t I2C_Bus_Account(I2C_HandleTypeDef *hi2c, HAL_StatusTypeDef status)
+{
+	uint32_t error = HAL_I2C_GetError(hi2c);
+	uint8_t recoverable = 0;
+
+	if (error & HAL_I2C_ERROR_AF)
+	{
+		g_i2c_stats.nack++;
+	}
+	if (error & HAL_I2C_ERROR_BERR)
+	{
+		g_i2c_stats.busError++;
+		recoverable = 1;
+	}
+	if (error & HAL_I2C_ERROR_ARLO)
+	{
+		g_i2c_stats.arbitration++;
+		recoverable = 1;
+	}
+	if (error & HAL_I2C_ERROR_OVR)
+	{
+		g_i2c_stats.overrun++;
+		recoverable = 1;
+	}
+	if ((error & HAL_I2C_ERROR_TIMEOUT) || status == HAL_TIMEOUT || status == HAL_BUSY)
+	{
+		g_i2c_stats.timeout++;
+		recoverable = 1;
+	}
+
+	return recoverable;
+}
+
+static HAL_StatusTypeDef I2C_Bus_Transfer(I2C_HandleTypeDef *hi2c, i2c_bus_op_t op,
+										  uint16_t devAddress, uint16_t memAddress,
+										  uint8_t *data, uint16_t size, uint32_t timeout)
+{
+	HAL_StatusTypeDef status = HAL_ERROR;
+
+	g_i2c_stats.transfers++;
+
+	for (uint8_t attempt = 0; attempt <= I2C_BUS_MAX_RETRIES; attempt++)
+	{
+		if (attempt > 0)
+		{
+			g_i2c_stats.retries++;
+		}
+
+		switch (op)
+		{
+			case I2C_BUS_OP_TRANSMIT:
+				status = HAL_I2C_Master_Transmit(hi2c, devAddress, data, size, timeout);
+				break;
+			case I2C_BUS_OP_RECEIVE:
+				status = HAL_I2C_Master_Receive(hi2c, devAddress, data, size, timeout);
+				break;
+			case I2C_BUS_OP_MEM_READ:
+				status = HAL_I2C_Mem_Read(hi2c, devAddress, memAddress, I2C_MEMADD_SIZE_16BIT,
+										  data, size, timeout);
+				break;
+			default:
+				return HAL_ERROR;
+		}
+
+		if (status == HAL_OK)
+		{
+			return HAL_OK;
+		}
+
+		/* NACK is the sensor saying "no data yet": retrying will not help */
+		if (!I2C_Bus_Account(hi2c, status))
+		{
+			return status;
+		}
+
+		/* Recover only if another attempt follows */
+		if (attempt < I2C_BUS_MAX_RETRIES)
+		{
+			I2C_Bus_Recover(hi2c);
+		}
+	}
+
+	g_i2c_stats.failures++;
+	return status;
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+HAL_StatusTypeDef I2C_Bus_Transmit(I2C_HandleTypeDef *hi2c, uint16_t devAddress,
+								   uint8_t *data, uint16_t size, uint32_t timeout)
+{
+	PROFILE_BEGIN(PROFILE_I2C);
+	HAL_StatusTypeDef status = I2C_Bus_Transfer(hi2c, I2C_BUS_OP_TRANSMIT, devAddress, 0, data, size, timeout);
+	PROFILE_END(PROFILE_I2C);
+
+	return status;
+}
+
+HAL_StatusTypeDef I2C_Bus_Receive(I2C_HandleTypeDef *hi2c, uint16_t devAddress,
+								  uint8_t *data, uint16_t size, uint32_t timeout)
+{
+	PROFILE_BEGIN(PROFILE_I2C);
+	HAL_StatusTypeDef status = I2C_Bus_Transfer(hi2c, I2C_BUS_OP_RECEIVE, devAddress, 0, data, size, timeout);
+	PROFILE_END(PROFILE_I2C);
+
+	return status;
+}
+
+HAL_StatusTypeDef I2C_Bus_MemRead(I2C_HandleTypeDef *hi2c, uint16_t devAddress,
+								  uint16_t memAddress, uint8_t *data, uint16_t size,
+								  uint32_t timeout)
+{
+	PROFILE_BEGIN(PROFILE_I2C);
+	HAL_StatusTypeDef status = I2C_Bus_Transfer(hi2c, I2C_BUS_OP_MEM_READ, devAddress, memAddress, data, size, timeout);
+	PROFILE_END(PROFILE_I2C);
+
+	return status;
+}
+
+void I2C_Bus_Recover(I2C_HandleTypeDef *hi2c)
+{
+	if (hi2c == NULL)
+	{
+		return;
+	}
+
+	g_i2c_stats.recoveries++;
+
+	/* Take the pins away from the peripheral */
+	__HAL_I2C_DISABLE(hi2c);
+
+	GPIO_InitTypeDef GPIO_InitStruct = {0};
+	GPIO_InitStruct.Pin = I2C_BUS_SCL_PIN;
+	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_OD;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+	HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_SET);
+	HAL_GPIO_Init(I2C_BUS_SCL_PORT, &GPIO_InitStruct);
+
+	GPIO_InitStruct.Pin = I2C_BUS_SDA_PIN;
+	HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_SET);
+	HAL_GPIO_Init(I2C_BUS_SDA_PORT, &GPIO_InitStruct);
+
+	/* Clock out whatever byte the slave is stuck in */
+	for (uint8_t i = 0; i < I2C_BUS_RECOVERY_CLOCKS; i++)
+	{
+		if (HAL_GPIO_ReadPin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN) == GPIO_PIN_SET)
+		{
+			break;
+		}
+		HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_RESET);
+		I2C_Bus_HalfClockDelay();
+		HAL_GPIO_WritePin(I2C_BUS_SCL_PORT, I2C_BUS_SCL_PIN, GPIO_PIN_SET);
+		I2C_Bus_HalfClockDelay();
+	}
+
+	/* STOP condition: SDA low -> high while SCL is high */
+	HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_RESET);
+	I2C_Bus_HalfClockDelay();
+	HAL_GPIO_WritePin(I2C_BUS_SDA_PORT, I2C_BUS_SDA_PIN, GPIO_PIN_SET);
+	I2C_Bus_HalfClockDelay();
+
+	/* Software reset clears a BUSY flag latched by the glitch (errata 2.13.7) */
+	hi2c->Instance->CR1 |= I2C_CR1_SWRST;
+	hi2c->Instance->CR1 &= ~I2C_CR1_SWRST;
+
+	/* MspInit gives the pins back to the peripheral */
+	HAL_I2C_DeInit(hi2c);
+	HAL_I2C_Init(hi2c);
+}
+
+void I2C_Bus_ResetStats(void)
+{
+	memset(&g_i2c_stats, 0, sizeof(g_i2c_stats));
+}
@@ -0,0 +1,222 @@
+/**
+ * @file power.c
+ */
+#ifdef DATALOGGER_TICKLESS_IDLE
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include "power.h"
+#include "uart.h"
+#include <string.h>
+
+/* VARIABLES -----------------------------------------------------------------*/
+power_stats_t g_power_stats;
+
+extern void SystemClock_Config(void);
+
+/* STATIC FUNCTIONS ----------------------------------------------------------*/
+/*
+ * @brief The HAL RTC driver is not part of this project: the F1 RTC is small enough to drive directly
+ */
+static void POWER_RTC_WaitWrite(void)
+{
+	while ((RTC->CRL & RTC_CRL_RTOFF) == 0)
+	{
+	}
+}
+
+static void POWER_RTC_EnterConfig(void)
+{
+	POWER_RTC_WaitWrite();
+	RTC->CRL |= RTC_CRL_CNF;
+}
+
+static void POWER_RTC_ExitConfig(void)
+{
+	RTC->CRL &= ~RTC_CRL_CNF;
+	POWER_RTC_WaitWrite();
+}
+
+/*
+ * @brief Registers read stale values until the APB1 interface resynchronizes
+ */
+static void POWER_RTC_WaitSync(void)
+{
+	RTC->CRL &= ~RTC_CRL_RSF;
+	while ((RTC->CRL & RTC_CRL_RSF) == 0)
+	{
+	}
+}
+
+static uint32_t POWER_RTC_GetCounter(void)
+{
+	uint16_t high = RTC->CNTH;
+	uint16_t low = RTC->CNTL;
+
+	/* CNTL rolled over between the two reads */
+	if (RTC->CNTH != high)
+	{
+		high = RTC->CNTH;
+		low = RTC->CNTL;
+	}
+
+	return ((uint32_t)high << 16) | low;
+}
+
+static void POWER_RTC_SetPrescaler(uint32_t prescaler)
+{
+	POWER_RTC_EnterConfig();
+	RTC->PRLH = (prescaler >> 16) & RTC_PRLH_PRL;
+	RTC->PRLL = prescaler & 0xFFFFu;
+	RTC->CNTH = 0;
+	RTC->CNTL = 0;
+	POWER_RTC_ExitConfig();
+}
+
+static void POWER_RTC_SetAlarm(uint32_t counter)
+{
+	POWER_RTC_EnterConfig();
+	RTC->ALRH = counter >> 16;
+	RTC->ALRL = counter & 0xFFFFu;
+	POWER_RTC_ExitConfig();
+}
+
+/*
+ * @brief Count LSI edges (divided by 2) over a SysTick-timed window
+ */
+static uint32_t POWER_CalibrateLsi(void)
+{
+	POWER_RTC_SetPrescaler(1);
+
+	uint32_t start = HAL_GetTick();
+	while (HAL_GetTick() == start)
+	{
+	}
+	start = HAL_GetTick();
+
+	uint32_t first = POWER_RTC_GetCounter();
+	while ((HAL_GetTick() - start) < POWER_LSI_CAL_MS)
+	{
+	}
+	uint32_t last = POWER_RTC_GetCounter();
+
+	return (last - first) * 2u * (1000u / POWER_LSI_CAL_MS);
+}
+
+/*
+ * @brief Let the last byte leave the shift register before the clocks stop
+ */
+static void POWER_WaitTxComplete(void)
+{
+	uint32_t start = HAL_GetTick();
+
+	while (__HAL_UART_GET_FLAG(&huart1, UART_FLAG_TC) == RESET)
+	{
+		if ((HAL_GetTick() - start) > 2)
+		{
+			break;
+		}
+	}
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+void POWER_Init(void)
+{
+	__HAL_RCC_PWR_CLK_ENABLE();
+	__HAL_RCC_BKP_CLK_ENABLE();
+	__HAL_RCC_AFIO_CLK_ENABLE();
+	HAL_PWR_EnableBkUpAccess();
+
+	__HAL_RCC_LSI_ENABLE();
+	while (__HAL_RCC_GET_FLAG(RCC_FLAG_LSIRDY) == RESET)
+	{
+	}
+
+	/* RTCSEL can only be changed after a backup domain reset */
+	if ((RCC->BDCR & RCC_BDCR_RTCSEL) != RCC_RTCCLKSOURCE_LSI)
+	{
+		__HAL_RCC_BACKUPRESET_FORCE();
+		__HAL_RCC_BACKUPRESET_RELEASE();
+		__HAL_RCC_RTC_CONFIG(RCC_RTCCLKSOURCE_LSI);
+	}
+	__HAL_RCC_RTC_ENABLE();
+	POWER_RTC_WaitSync();
+
+	/* LSI is anywhere between 30 and 60 kHz: trim the prescaler for a 1 ms RTC tick */
+	memset(&g_power_stats, 0, sizeof(g_power_stats));
+	g_power_stats.lsiHz = POWER_CalibrateLsi();
+	POWER_RTC_SetPrescaler((g_power_stats.lsiHz + 500u) / 1000u - 1u);
+
+	/* RTC alarm -> EXTI17, rising edge, event only */
+	EXTI->IMR &= ~EXTI_IMR_MR17;
+	EXTI->RTSR |= EXTI_RTSR_TR17;
+	EXTI->EMR |= EXTI_EMR_MR17;
+
+	/* USART1 RX start bit -> EXTI10 on port A, falling edge, event only */
+	AFIO->EXTICR[2] &= ~AFIO_EXTICR3_EXTI10;
+	EXTI->IMR &= ~EXTI_IMR_MR10;
+	EXTI->FTSR |= EXTI_FTSR_TR10;
+	EXTI->EMR |= EXTI_EMR_MR10;
+
+#ifdef DEBUG
+	/* Keep SWD alive across STOP */
+	DBGMCU->CR |= DBGMCU_CR_DBG_STOP;
+#endif
+}
+
+void POWER_Idle(uint32_t sleepMs)
+{
+	if (sleepMs > POWER_STOP_MAX_MS)
+	{
+		sleepMs = POWER_STOP_MAX_MS;
+	}
+
+	if (sleepMs < POWER_STOP_MIN_MS || !UART_IsIdle())
+	{
+		__WFI();
+		return;
+	}
+
+	sleepMs -= POWER_WAKEUP_MARGIN_MS;
+
+	POWER_WaitTxComplete();
+
+	uint32_t start = POWER_RTC_GetCounter();
+	RTC->CRL &= ~RTC_CRL_ALRF;
+	POWER_RTC_SetAlarm(start + sleepMs);
+
+	HAL_SuspendTick();
+	HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFE);
+
+	/* Back on HSI 8 MHz: restore the PLL before touching anything timed */
+	SystemClock_Config();
+	HAL_ResumeTick();
+
+	POWER_RTC_WaitSync();
+	uint32_t slept = POWER_RTC_GetCounter() - start;
+	RTC->CRL &= ~RTC_CRL_ALRF;
+
+	uwTick += slept;
+
+	g_power_stats.stopEntries++;
+	g_power_stats.stopMs += slept;
+	if (slept < sleepMs)
+	{
+		g_power_stats.earlyWakeups++;
+	}
+}
+
+uint32_t POWER_GetRtcMs(void)
+{
+	return POWER_RTC_GetCounter();
+}
+
+void POWER_ResetStats(void)
+{
+	uint32_t lsiHz = g_power_stats.lsiHz;
+
+	memset(&g_power_stats, 0, sizeof(g_power_stats));
+	g_power_stats.lsiHz = lsiHz;
+	g_power_stats.startMs = POWER_RTC_GetCounter();
+}
+
+#endif /* DATALOGGER_TICKLESS_IDLE */
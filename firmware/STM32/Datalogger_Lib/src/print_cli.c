@@ -3,12 +3,18 @@
  */
 /* INCLUDES ------------------------------------------------------------------*/
 #include "print_cli.h"
+#include "profile.h"
+#ifdef DATALOGGER_USE_FREERTOS
+#include "app_tasks.h"
+#endif
 #include <stdarg.h>
 #include <stdio.h>
 
 /* GLOBAL FUNCTIONS ----------------------------------------------------------*/
 void PRINT_CLI(char *fmt, ...)
 {
+	PROFILE_BEGIN(PROFILE_PRINT);
+
 	char stringBuffer [BUFFER_PRINT];
 	va_list args;
 	va_start(args, fmt);
@@ -17,6 +23,12 @@ void PRINT_CLI(char *fmt, ...)
 
 	if (len_str > 0)
 	{
+#ifdef DATALOGGER_USE_FREERTOS
+		APP_Tasks_Print(stringBuffer, len_str);
+#else
 		HAL_UART_Transmit(&huart1, (uint8_t*) stringBuffer, len_str, 100);
+#endif
 	}
+
+	PROFILE_END(PROFILE_PRINT);
 }
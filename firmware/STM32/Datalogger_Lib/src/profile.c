@@ -0,0 +1,103 @@
+/**
+ * @file profile.c
+ */
+#ifdef DATALOGGER_PROFILE
+
+/* INCLUDES ------------------------------------------------------------------*/
+#include "profile.h"
+#include "print_cli.h"
+#include <string.h>
+
+/* VARIABLES -----------------------------------------------------------------*/
+profile_stats_t g_profile[PROFILE_REGION_COUNT];
+
+static const char *const profile_names[PROFILE_REGION_COUNT] = {
+	"CMD",
+	"FETCH",
+	"PRINT",
+	"I2C"
+};
+
+/* STATIC FUNCTIONS ----------------------------------------------------------*/
+static uint8_t Profile_Bin(uint32_t cycles)
+{
+	uint32_t log2 = 31u - __CLZ(cycles | 1u);
+
+	if (log2 < 8u)
+	{
+		return 0;
+	}
+
+	uint32_t bin = (log2 - 6u) >> 1;
+	return (bin >= PROFILE_HIST_BINS) ? (PROFILE_HIST_BINS - 1) : (uint8_t)bin;
+}
+
+/* GLOBAL FUNCTIONS ----------------------------------------------------------*/
+void Profile_Init(void)
+{
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+	Profile_Reset();
+}
+
+void Profile_Reset(void)
+{
+	memset(g_profile, 0, sizeof(g_profile));
+
+	for (uint8_t i = 0; i < PROFILE_REGION_COUNT; i++)
+	{
+		g_profile[i].minCycles = UINT32_MAX;
+	}
+}
+
+void Profile_Record(profile_region_t region, uint32_t cycles)
+{
+	if (region >= PROFILE_REGION_COUNT)
+	{
+		return;
+	}
+
+	profile_stats_t *stats = &g_profile[region];
+
+	stats->count++;
+	stats->sumCycles += cycles;
+	if (cycles < stats->minCycles)
+	{
+		stats->minCycles = cycles;
+	}
+	if (cycles > stats->maxCycles)
+	{
+		stats->maxCycles = cycles;
+	}
+	stats->hist[Profile_Bin(cycles)]++;
+}
+
+void Profile_Print(void)
+{
+	/* Snapshot first: the prints below are themselves a profiled region */
+	profile_stats_t snapshot[PROFILE_REGION_COUNT];
+	memcpy(snapshot, g_profile, sizeof(snapshot));
+
+	uint32_t cyclesPerUs = SystemCoreClock / 1000000u;
+
+	for (uint8_t i = 0; i < PROFILE_REGION_COUNT; i++)
+	{
+		const profile_stats_t *s = &snapshot[i];
+		uint32_t avg = s->count ? (uint32_t)(s->sumCycles / s->count) : 0;
+		uint32_t min = s->count ? s->minCycles : 0;
+
+		PRINT_CLI("STATS %s n=%lu min=%lu max=%lu avg=%lu cyc (%lu us)\r\n",
+				profile_names[i], (unsigned long)s->count, (unsigned long)min,
+				(unsigned long)s->maxCycles, (unsigned long)avg,
+				(unsigned long)(avg / cyclesPerUs));
+		PRINT_CLI("HIST %s %lu %lu %lu %lu %lu %lu %lu %lu\r\n", profile_names[i],
+				(unsigned long)s->hist[0], (unsigned long)s->hist[1],
+				(unsigned long)s->hist[2], (unsigned long)s->hist[3],
+				(unsigned long)s->hist[4], (unsigned long)s->hist[5],
+				(unsigned long)s->hist[6], (unsigned long)s->hist[7]);
+	}
+}
+
+#endif /* DATALOGGER_PROFILE */
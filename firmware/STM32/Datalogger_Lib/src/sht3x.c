@@ -3,11 +3,13 @@
  */
 /* INCLUDES ------------------------------------------------------------------*/
 #include "sht3x.h"
+#include "i2c_bus.h"
 #include "print_cli.h"
 #include <assert.h>
 
+/* Per attempt; a 6-byte read takes ~200 us at 400 kHz, failures are retried */
 #ifndef SHT3X_I2C_TIMEOUT
-#define SHT3X_I2C_TIMEOUT	100
+#define SHT3X_I2C_TIMEOUT	2
 #endif
 
 /*  SHT3x STATUS REGISTER BITS -----------------------------------------------*/
@@ -75,6 +77,8 @@ static const uint16_t SHT3X_MEASURE_CMD[6][3] = {
 			{0x2737, 0x2721, 0x272a}	// [PERIODIC_10][H,M,L]
 };
 
+static const char *const SHT3X_REPEAT_NAME[3] = {"HIGH", "MEDIUM", "LOW"};
+
 static const uint8_t SHT3X_MEAS_DURATION_MS[3] = {
 	15,	/* HIGH */
 	6,	/* MEDIUM */
@@ -87,6 +91,30 @@ static inline uint16_t uint8_to_uint16(uint8_t msb, uint8_t lsb)
 	return (uint16_t)(((uint16_t)msb << 8) | (uint16_t)lsb);
 }
 
+/*
+ * @brief Microseconds since boot, for stamping frames
+ *
+ * @note Bare metal: HAL tick plus the elapsed fraction of the current SysTick period.
+ *       With FreeRTOS SysTick belongs to the kernel and the HAL tick runs from a TIM,
+ *       so the resolution is 1 ms.
+ */
+static uint32_t SHT3X_TimestampUs(void)
+{
+#ifdef DATALOGGER_USE_FREERTOS
+	return HAL_GetTick() * 1000u;
+#else
+	uint32_t tick, val;
+	do
+	{
+		tick = HAL_GetTick();
+		val = SysTick->VAL;
+	} while (tick != HAL_GetTick());	/* SysTick wrapped between the two reads */
+
+	uint32_t load = SysTick->LOAD + 1u;
+	return tick * 1000u + ((load - 1u - val) * 1000u) / load;
+#endif
+}
+
 static inline uint8_t SHT3X_CRC(const uint8_t *data, size_t len)
 {
 	uint8_t crc = 0xFF;
@@ -116,7 +144,7 @@ static HAL_StatusTypeDef SHT3X_Send_Command(const sht3x_handle_t *handle, uint16
 
     uint8_t command_buffer[2] = {(uint8_t)((command >> 8) & 0xFF), (uint8_t)(command & 0xFF)};
 
-    if (HAL_I2C_Master_Transmit(handle->i2c_handle,
+    if (I2C_Bus_Transmit(handle->i2c_handle,
     							(uint16_t)(handle->device_address << 1U),
 								command_buffer,sizeof(command_buffer),
 								SHT3X_I2C_TIMEOUT) != HAL_OK)
@@ -144,8 +172,8 @@ static SHT3X_StatusTypeDef SHT3X_ParseFrame(const uint8_t frame[SHT3X_RAW_DATA_S
     uint16_t rawRH = uint8_to_uint16(frame[3], frame[4]);
 
     /* Convert per datasheet */
-    if (tC)  *tC  = -45.0f + (175.0f * (float)rawT  / 65535.0f);
-    if (rh)  *rh  = 100.0f * (float)rawRH / 65535.0f;
+    if (tC)  *tC  = SHT3X_RAW_TO_TEMPERATURE(rawT);
+    if (rh)  *rh  = SHT3X_RAW_TO_HUMIDITY(rawRH);
 
     return SHT3X_OK;
 }
@@ -159,10 +187,9 @@ static SHT3X_StatusTypeDef SHT3X_ReadStatus(sht3x_handle_t *handle, uint16_t *st
 
 	uint8_t read_buffer[3]; // [0]=MSB, [1]=LSB, [2]=CRC
 
-	if (HAL_I2C_Mem_Read(handle->i2c_handle,
+	if (I2C_Bus_MemRead(handle->i2c_handle,
 						(uint16_t)(handle->device_address << 1U),	// 7-bit addr <<1
-						SHT3X_COMMAND_READ_STATUS,					// 0xF32D
-						I2C_MEMADD_SIZE_16BIT,						// send [MSB:LSB]
+						SHT3X_COMMAND_READ_STATUS,					// 0xF32D, sent [MSB:LSB]
 						read_buffer, sizeof(read_buffer),
 						SHT3X_I2C_TIMEOUT) != HAL_OK)
 	{
@@ -210,14 +237,28 @@ void SHT3X_Init(sht3x_handle_t *handle, I2C_HandleTypeDef *hi2c, uint8_t addr7bi
 	handle->humidity = 0.0f;
 	handle->currentState = SHT3X_IDLE;
 	handle->modeRepeat = SHT3X_HIGH;
+	handle->heater = SHT3X_HEATER_DISABLE;
 
+	/* The sensor is long past its 1.5 ms power-up by now: one probe is enough */
 	if (HAL_I2C_IsDeviceReady(hi2c, (uint16_t)(addr7bit << 1U),
-							3, SHT3X_I2C_TIMEOUT) != HAL_OK)
+							1, SHT3X_I2C_TIMEOUT) != HAL_OK)
 	{
+		/* A reset mid-transfer can leave the sensor holding SDA low */
+		I2C_Bus_Recover(hi2c);
+		if (HAL_I2C_IsDeviceReady(hi2c, (uint16_t)(addr7bit << 1U),
+								3, SHT3X_I2C_TIMEOUT) != HAL_OK)
+		{
+			return;
+		}
+	}
 
-		return;
+	/* After an MCU-only reset the sensor may still be in periodic mode, which ignores soft reset */
+	if (SHT3X_Send_Command(handle, SHT3X_COMMAND_STOP_PERIODIC_MEAS) == HAL_OK)
+	{
+		HAL_Delay(1);
 	}
 
+	/* HAL_Delay(n) waits at least n ms: 2 ms covers the 1.5 ms soft reset time */
 	if (SHT3X_Send_Command(handle, SHT3X_COMMAND_SOFT_RESET) != HAL_OK)
 	{
 		return;
@@ -272,6 +313,7 @@ void SHT3X_DeInit(sht3x_handle_t *handle)
 	handle->humidity = 0.0f;
 	handle->currentState = SHT3X_IDLE;
 	handle->modeRepeat = SHT3X_HIGH;
+	handle->heater = SHT3X_HEATER_DISABLE;
 }
 
 SHT3X_StatusTypeDef SHT3X_Heater(sht3x_handle_t *handle, const sht3x_heater_mode_t *modeHeater)
@@ -317,6 +359,8 @@ SHT3X_StatusTypeDef SHT3X_Heater(sht3x_handle_t *handle, const sht3x_heater_mode
         return SHT3X_ERROR;
     }
 
+    handle->heater = *modeHeater;
+
     return SHT3X_OK;
 }
 
@@ -348,13 +392,15 @@ SHT3X_StatusTypeDef SHT3X_Single(sht3x_handle_t *handle, sht3x_repeat_t *modeRep
 	HAL_Delay(SHT3X_MEAS_DURATION_MS[*modeRepeat]);
 
 	uint8_t frame[SHT3X_RAW_DATA_SIZE] = {0};
-	if (HAL_I2C_Master_Receive(handle->i2c_handle,
+	if (I2C_Bus_Receive(handle->i2c_handle,
 								(uint16_t)(handle->device_address << 1U),
 								frame, sizeof(frame), SHT3X_I2C_TIMEOUT) != HAL_OK)
 	{
 		return SHT3X_ERROR;
 	}
 
+	handle->sampleTimeUs = SHT3X_TimestampUs();
+
 	float tC = 0.0f, rh = 0.0f;
 	if (SHT3X_ParseFrame(frame, &tC, &rh) != SHT3X_OK)
 	{
@@ -364,7 +410,12 @@ SHT3X_StatusTypeDef SHT3X_Single(sht3x_handle_t *handle, sht3x_repeat_t *modeRep
 	handle->temperature = tC;
 	handle->humidity = rh;
 
+#if SHT3X_TIMESTAMP_LINES
+    PRINT_CLI("SINGLE %.2f %.2f @%lu\r\n\0", handle->temperature, handle->humidity,
+    		(unsigned long)handle->sampleTimeUs);
+#else
     PRINT_CLI("SINGLE %.2f %.2f\r\n\0", handle->temperature, handle->humidity);
+#endif
 
 	if (SHT3X_IS_PERIODIC_STATE(savedMode))
 	{
@@ -478,44 +529,130 @@ SHT3X_StatusTypeDef SHT3X_Stop_Periodic(sht3x_handle_t *handle)
 	return SHT3X_OK;
 }
 
-void SHT3X_FetchData(sht3x_handle_t *handle, float *outT, float *outRH)
+SHT3X_StatusTypeDef SHT3X_FetchRaw(sht3x_handle_t *handle, uint16_t *rawT, uint16_t *rawRH)
 {
 	if (!handle || !handle->i2c_handle)
 	{
-		return;
+		return SHT3X_ERROR;
 	}
 
 	if (!SHT3X_IS_PERIODIC_STATE(handle->currentState))
 	{
-		return;
+		return SHT3X_ERROR;
 	}
 
 	uint8_t frame[SHT3X_RAW_DATA_SIZE] = {0};
-	if (HAL_I2C_Mem_Read(handle->i2c_handle,
+	if (I2C_Bus_MemRead(handle->i2c_handle,
 						(uint16_t)(handle->device_address << 1U),
-						SHT3X_COMMAND_FETCH_DATA, I2C_MEMADD_SIZE_16BIT,
+						SHT3X_COMMAND_FETCH_DATA,
 						frame, sizeof(frame), SHT3X_I2C_TIMEOUT) != HAL_OK)
     {
-        return;
+        return SHT3X_ERROR;
     }
+    handle->sampleTimeUs = SHT3X_TimestampUs();
 
     float tC = 0.0f, rh = 0.0f;
-    if(SHT3X_ParseFrame(frame, &tC, &rh) != SHT3X_OK)
+    if (SHT3X_ParseFrame(frame, &tC, &rh) != SHT3X_OK)
     {
-    	return;
+    	return SHT3X_ERROR;
     }
 
     handle->temperature = tC;
     handle->humidity    = rh;
 
+    if (rawT)
+    {
+    	*rawT  = uint8_to_uint16(frame[0], frame[1]);
+    }
+    if (rawRH)
+    {
+    	*rawRH = uint8_to_uint16(frame[3], frame[4]);
+    }
+
+    return SHT3X_OK;
+}
+
+void SHT3X_FetchData(sht3x_handle_t *handle, float *outT, float *outRH)
+{
+	if (SHT3X_FetchRaw(handle, NULL, NULL) != SHT3X_OK)
+	{
+		return;
+	}
+
     if (outT)
     {
-    	*outT  = tC;
+    	*outT  = handle->temperature;
     }
     if (outRH)
     {
-    	*outRH = rh;
+    	*outRH = handle->humidity;
     }
 
+#if SHT3X_TIMESTAMP_LINES
+    PRINT_CLI("PERIODIC %.2f %.2f @%lu\r\n\0", handle->temperature, handle->humidity,
+    		(unsigned long)handle->sampleTimeUs);
+#else
     PRINT_CLI("PERIODIC %.2f %.2f\r\n\0", handle->temperature, handle->humidity);
+#endif
+}
+
+uint32_t SHT3X_GetPeriodMs(sht3x_mode_t mode)
+{
+	switch (mode)
+	{
+		case SHT3X_PERIODIC_05MPS:	return 2000;
+		case SHT3X_PERIODIC_1MPS:	return 1000;
+		case SHT3X_PERIODIC_2MPS:	return 500;
+		case SHT3X_PERIODIC_4MPS:	return 250;
+		case SHT3X_PERIODIC_10MPS:	return 100;
+		default:					return 0;
+	}
+}
+
+void SHT3X_ReportState(sht3x_handle_t *handle, bool force)
+{
+	static bool reported = false;
+	static uint8_t lastMode, lastRepeat, lastHeater;
+	static uint16_t lastStatus = 0;
+
+	if (handle == NULL)
+	{
+		return;
+	}
+
+	/* Single shot leaves the sensor idle: not a state of its own */
+	uint8_t mode = SHT3X_IS_PERIODIC_STATE(handle->currentState) ? (uint8_t)handle->currentState : SHT3X_IDLE;
+
+	if (!force && reported && mode == lastMode &&
+		lastRepeat == (uint8_t)handle->modeRepeat && lastHeater == (uint8_t)handle->heater)
+	{
+		return;
+	}
+
+	uint16_t status;
+	if (handle->i2c_handle && SHT3X_ReadStatus(handle, &status) == SHT3X_OK)
+	{
+		lastStatus = status;
+	}
+
+	reported = true;
+	lastMode = mode;
+	lastRepeat = (uint8_t)handle->modeRepeat;
+	lastHeater = (uint8_t)handle->heater;
+
+	const char *mps;
+	switch (handle->currentState)
+	{
+		case SHT3X_PERIODIC_05MPS:	mps = "0.5"; break;
+		case SHT3X_PERIODIC_1MPS:	mps = "1"; break;
+		case SHT3X_PERIODIC_2MPS:	mps = "2"; break;
+		case SHT3X_PERIODIC_4MPS:	mps = "4"; break;
+		case SHT3X_PERIODIC_10MPS:	mps = "10"; break;
+		default:					mps = "0"; break;
+	}
+
+	PRINT_CLI("STATE %s %s %s 0x%04X\r\n", mps,
+			SHT3X_REPEAT_NAME[handle->modeRepeat <= SHT3X_LOW ? handle->modeRepeat : SHT3X_HIGH],
+			handle->heater == SHT3X_HEATER_ENABLE ? "ON" : "OFF",
+			lastStatus);
 }
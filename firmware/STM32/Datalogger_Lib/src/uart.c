@@ -5,6 +5,10 @@
 #include "uart.h"
 #include "command_execute.h"
 #include "ring_buffer.h"
+#include "profile.h"
+#ifdef DATALOGGER_USE_FREERTOS
+#include "app_tasks.h"
+#endif
 #include <string.h>
 
 /* VARIABLES -----------------------------------------------------------------*/
@@ -49,8 +53,31 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
 {
 	if (huart->Instance == huart1.Instance)
 	{
-		RingBuffer_Put(&uart_rx_rb, data_rx);
+		/* Re-arming reuses data_rx: the next byte may land in it before the test below */
+		uint8_t byte = data_rx;
 
+		RingBuffer_Put(&uart_rx_rb, byte);
+
+		HAL_UART_Receive_IT(&huart1, &data_rx, sizeof(data_rx));
+
+#ifdef DATALOGGER_USE_FREERTOS
+		if (byte == '\n' || byte == '\r')
+		{
+			APP_Tasks_NotifyRxFromISR();
+		}
+#endif
+	}
+}
+
+/*
+ * @brief An overrun aborts interrupt reception: re-arm it
+ *
+ * @note Happens on the garbled first byte after a wake-up from STOP.
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	if (huart->Instance == huart1.Instance)
+	{
 		HAL_UART_Receive_IT(&huart1, &data_rx, sizeof(data_rx));
 	}
 }
@@ -75,10 +102,17 @@ void UART_Handle(void)
 
 	if (Flag_UART)
 	{
+		PROFILE_BEGIN(PROFILE_COMMAND);
 		COMMAND_EXECUTE((char*)buff);
+		PROFILE_END(PROFILE_COMMAND);
 
 		memset(buff, 0, sizeof(buff));
 		index_uart = 0;
 		Flag_UART = 0;
 	}
 }
+
+bool UART_IsIdle(void)
+{
+	return RingBuffer_Available(&uart_rx_rb) == 0 && index_uart == 0;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file filter_bench.c
+ * @brief Host benchmark of the acquisition filters (cost per sample + noise)
+ *
+ * Build and run from firmware/STM32:
+ *   gcc -O2 -IDatalogger_Lib/inc bench/filter_bench.c Datalogger_Lib/src/filter.c -lm -o filter_bench
+ *   ./filter_bench [samples]
+ */
+/* INCLUDES ------------------------------------------------------------------*/
+#include "filter.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_HAVE_TSC 1
+#endif
+
+/* DEFINES -------------------------------------------------------------------*/
+#define BENCH_DEFAULT_SAMPLES	1000000u
+
+/* STATIC FUNCTIONS ----------------------------------------------------------*/
+static uint32_t lcg_state = 12345u;
+
+static int32_t bench_noise(void)
+{
+	/* Sum of 4 uniforms ~ gaussian, about +-40 raw ticks (LOW repeatability) */
+	int32_t acc = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		lcg_state = lcg_state * 1664525u + 1013904223u;
+		acc += (int32_t)(lcg_state >> 24) - 128;
+	}
+	return acc / 6;
+}
+
+static uint64_t bench_now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static double bench_stddev(const uint16_t *in, const uint16_t *ref, size_t n)
+{
+	double acc = 0.0;
+	for (size_t i = 0; i < n; i++)
+	{
+		double d = (double)in[i] - (double)ref[i];
+		acc += d * d;
+	}
+	return n ? sqrt(acc / (double)n) : 0.0;
+}
+
+static void bench_run(const char *name, filter_type_t type,
+					  const uint16_t *input, const uint16_t *clean, size_t n,
+					  uint16_t *out, uint16_t *outRef)
+{
+	filter_t filter;
+	Filter_Init(&filter, type);
+
+	size_t produced = 0;
+	uint64_t t0 = bench_now_ns();
+#ifdef BENCH_HAVE_TSC
+	uint64_t c0 = __rdtsc();
+#endif
+	for (size_t i = 0; i < n; i++)
+	{
+		uint16_t v;
+		if (Filter_Process(&filter, input[i], &v))
+		{
+			out[produced] = v;
+			outRef[produced] = clean[i];
+			produced++;
+		}
+	}
+#ifdef BENCH_HAVE_TSC
+	uint64_t c1 = __rdtsc();
+#endif
+	uint64_t t1 = bench_now_ns();
+
+	printf("%-8s %10zu %10.2f", name, produced, (double)(t1 - t0) / (double)n);
+#ifdef BENCH_HAVE_TSC
+	printf(" %12.2f", (double)(c1 - c0) / (double)n);
+#else
+	printf(" %12s", "n/a");
+#endif
+	/* Skip the warm-up of the windowed filters */
+	size_t skip = produced > 64 ? 64 : 0;
+	printf(" %10.2f\n", bench_stddev(out + skip, outRef + skip, produced - skip));
+}
+
+/* MAIN ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+	size_t n = (argc > 1) ? strtoul(argv[1], NULL, 10) : BENCH_DEFAULT_SAMPLES;
+	if (n == 0)
+	{
+		n = BENCH_DEFAULT_SAMPLES;
+	}
+
+	uint16_t *input = malloc(n * sizeof(uint16_t));
+	uint16_t *clean = malloc(n * sizeof(uint16_t));
+	uint16_t *out = malloc(n * sizeof(uint16_t));
+	uint16_t *outRef = malloc(n * sizeof(uint16_t));
+	if (!input || !clean || !out || !outRef)
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	/* Slow temperature drift around 25 degC (raw ~26214) plus sensor noise */
+	for (size_t i = 0; i < n; i++)
+	{
+		int32_t base = 26214 + (int32_t)(200.0 * sin((double)i / 5000.0));
+		int32_t v = base + bench_noise();
+		clean[i] = (uint16_t)base;
+		input[i] = (uint16_t)(v < 0 ? 0 : (v > 65535 ? 65535 : v));
+	}
+
+	printf("samples: %zu\n", n);
+	printf("%-8s %10s %10s %12s %10s\n", "filter", "outputs", "ns/sample", "cycles/smpl", "rms_err");
+	bench_run("none",   FILTER_NONE,   input, clean, n, out, outRef);
+	bench_run("ema",    FILTER_EMA,    input, clean, n, out, outRef);
+	bench_run("median", FILTER_MEDIAN, input, clean, n, out, outRef);
+	bench_run("boxcar", FILTER_BOXCAR, input, clean, n, out, outRef);
+
+	free(input);
+	free(clean);
+	free(out);
+	free(outRef);
+	return 0;
+}
@@ -0,0 +1,118 @@
+#!/usr/bin/env node
+// Text/JSON vs CBOR payloads as the dashboard and the Node tools see them:
+// bytes on the wire and decode (and encode) time per message.
+// The firmware-side numbers come from firmware/ESP32/host/bench/payload_bench.c.
+'use strict';
+
+const { performance } = require('perf_hooks');
+const CBOR = require('../cbor.js');
+
+const ITERATIONS = Number(process.argv[2]) || 200000;
+
+// MQTT PUBLISH overhead: fixed header (2) + topic length (2) + topic, QoS 0
+const DEVICE = 'esp32/ESP32_A1B2C3/';
+const wire = (topic, payloadBytes) => 4 + Buffer.byteLength(DEVICE + topic) + payloadBytes;
+
+// Same values and key order as the bridge sends them
+const state = {
+    device: 'ON', periodic: 'ON', rate: 0.5, repeat: 'HIGH', heater: 'OFF',
+    status: '0x8010', group: 'lab2', timestamp: 61234567
+};
+const trace = { seq: 4242, stm_us: 23234871, rx_us: 61234567, pub_us: 61234990 };
+
+function batch(n) {
+    const b = { seq: 7, rx_us: 61234567, dt_us: [], temperature: [], humidity: [] };
+    for (let i = 0; i < n; i++) {
+        b.dt_us.push(i * 100000 + (i % 3) * 17);
+        b.temperature.push(Math.fround(23.5 + (i % 7) * 0.01));
+        b.humidity.push(Math.fround(65.2 - (i % 5) * 0.03));
+    }
+    return b;
+}
+
+// JSON the way the per-sample topics would carry the same batch, one message per value
+function batchAsText(b) {
+    return b.temperature.flatMap((t, i) => [t.toFixed(2), b.humidity[i].toFixed(2)]);
+}
+
+function time(fn) {
+    for (let i = 0; i < ITERATIONS / 10; i++) fn();     // Warm-up
+    const start = performance.now();
+    for (let i = 0; i < ITERATIONS; i++) fn();
+    return ((performance.now() - start) * 1e6) / ITERATIONS;
+}
+
+const cases = [
+    {
+        name: 'sample',
+        topic: 'sensor/sht3x/periodic/temperature',
+        text: () => Buffer.from('27.82'),
+        cbor: () => CBOR.encode(Math.fround(27.82)),
+        decodeText: (buf) => parseFloat(buf.toString()),
+        encodeText: () => (27.82).toFixed(2)
+    },
+    {
+        name: 'state',
+        topic: 'state',
+        text: () => Buffer.from(JSON.stringify(state)),
+        cbor: () => CBOR.encode(state),
+        decodeText: (buf) => JSON.parse(buf.toString()),
+        encodeText: () => JSON.stringify(state)
+    },
+    {
+        name: 'trace',
+        topic: 'sensor/sht3x/trace',
+        text: () => Buffer.from(JSON.stringify(trace)),
+        cbor: () => CBOR.encode(trace),
+        decodeText: (buf) => JSON.parse(buf.toString()),
+        encodeText: () => JSON.stringify(trace)
+    },
+    ...[16, 64].map((n) => {
+        const b = batch(n);
+        const messages = batchAsText(b).map((t) => Buffer.from(t));
+        return {
+            name: `batch x${n}`,
+            topic: 'sensor/sht3x/batch',
+            textTopics: messages.map((m, i) => `sensor/sht3x/periodic/${i % 2 ? 'humidity' : 'temperature'}`),
+            // Text side: the 2n single-value messages the batch replaces
+            text: () => messages,
+            cbor: () => CBOR.encode(b),
+            decodeText: (list) => list.map((m) => parseFloat(m.toString())),
+            encodeText: () => batchAsText(b)
+        };
+    })
+];
+
+console.log(`${ITERATIONS} iterations per case, Node ${process.version}\n`);
+console.log('| Payload | Text bytes | CBOR bytes | Text wire | CBOR wire | Text decode ns | CBOR decode ns | Text encode ns | CBOR encode ns |');
+console.log('|---------|------------|------------|-----------|-----------|----------------|----------------|----------------|----------------|');
+
+for (const c of cases) {
+    const text = c.text();
+    const cbor = c.cbor();
+    const textBytes = Array.isArray(text) ? text.reduce((sum, m) => sum + m.length, 0) : text.length;
+    const textWire = Array.isArray(text)
+        ? text.reduce((sum, m, i) => sum + wire(c.textTopics[i], m.length), 0)
+        : wire(c.topic, text.length);
+    const cborBuf = Buffer.from(cbor);
+
+    // Round trip must give back what was encoded before timing anything
+    const decoded = CBOR.decode(cborBuf);
+    const again = Buffer.from(CBOR.encode(decoded));
+    if (!again.equals(cborBuf)) {
+        console.error(`${c.name}: CBOR round trip differs`);
+        process.exit(1);
+    }
+
+    const textDecode = time(() => c.decodeText(text));
+    const cborDecode = time(() => CBOR.decode(cborBuf));
+    const textEncode = time(() => c.encodeText());
+    const cborEncode = time(() => c.cbor());
+    const ns = (v) => v.toFixed(0);
+    console.log(`| ${c.name} | ${textBytes} | ${cborBuf.length} | ${textWire} | ${wire(c.topic, cborBuf.length)} | ` +
+                `${ns(textDecode)} | ${ns(cborDecode)} | ` +
+                `${ns(textEncode)} | ${ns(cborEncode)} |`);
+}
+
+console.log('\nThe text side of a batch is the 2 x n per-value messages it replaces.');
+console.log('Wire bytes add the MQTT PUBLISH header and the topic of a QoS 0 message.');
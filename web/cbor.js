@@ -0,0 +1,227 @@
+// Minimal CBOR (RFC 8949) codec for the bridge's binary payloads.
+// Same subset as firmware/ESP32/components/cbor_codec: integers, floats, text,
+// booleans, null and definite-length arrays and maps. Loaded by index.html as
+// window.CBOR and required by the Node tools in broker/.
+(function (root, factory) {
+    if (typeof module === 'object' && module.exports) {
+        module.exports = factory();
+    } else {
+        root.CBOR = factory();
+    }
+}(typeof self !== 'undefined' ? self : this, function () {
+    'use strict';
+
+    const utf8Decoder = new TextDecoder();
+    const utf8Encoder = new TextEncoder();
+    const scratch = new DataView(new ArrayBuffer(8));
+
+    // Keys and state values are short ASCII; TextDecoder costs more than the string itself
+    function decodeText(data, start, end) {
+        if (end - start <= 32) {
+            let text = '';
+            for (let i = start; i < end; i++) {
+                const c = data[i];
+                if (c >= 0x80) {
+                    return utf8Decoder.decode(data.subarray(start, end));
+                }
+                text += String.fromCharCode(c);
+            }
+            return text;
+        }
+        return utf8Decoder.decode(data.subarray(start, end));
+    }
+
+    // Every bridge CBOR payload starts with an array, map or float head (>= 0x80);
+    // text samples and JSON never do
+    function isBinary(bytes) {
+        return bytes.length > 0 && bytes[0] >= 0x80;
+    }
+
+    function halfToNumber(half) {
+        const exponent = (half >> 10) & 0x1f;
+        const mantissa = half & 0x3ff;
+        let value;
+        if (exponent === 0) {
+            value = mantissa * 2 ** -24;
+        } else if (exponent === 0x1f) {
+            value = mantissa ? NaN : Infinity;
+        } else {
+            value = (mantissa + 1024) * 2 ** (exponent - 25);
+        }
+        return half & 0x8000 ? -value : value;
+    }
+
+    function decode(bytes) {
+        const data = bytes instanceof Uint8Array ? bytes : new Uint8Array(bytes);
+        const view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+        let pos = 0;
+
+        function need(n) {
+            if (pos + n > data.length) {
+                throw new Error('CBOR: truncated');
+            }
+        }
+
+        function argument(info) {
+            if (info < 24) return info;
+            let value;
+            switch (info) {
+            case 24: need(1); value = data[pos]; pos += 1; return value;
+            case 25: need(2); value = view.getUint16(pos); pos += 2; return value;
+            case 26: need(4); value = view.getUint32(pos); pos += 4; return value;
+            case 27: {
+                need(8);
+                const big = view.getBigUint64(pos);
+                pos += 8;
+                if (big > BigInt(Number.MAX_SAFE_INTEGER)) throw new Error('CBOR: integer too large');
+                return Number(big);
+            }
+            default: throw new Error(`CBOR: unsupported additional info ${info}`);
+            }
+        }
+
+        function item() {
+            need(1);
+            const initial = data[pos++];
+            const major = initial >> 5;
+            const info = initial & 0x1f;
+
+            if (major === 7) {
+                switch (info) {
+                case 20: return false;
+                case 21: return true;
+                case 22: return null;
+                case 25: { need(2); const v = halfToNumber(view.getUint16(pos)); pos += 2; return v; }
+                case 26: { need(4); const v = view.getFloat32(pos); pos += 4; return v; }
+                case 27: { need(8); const v = view.getFloat64(pos); pos += 8; return v; }
+                default: throw new Error(`CBOR: unsupported simple value ${info}`);
+                }
+            }
+
+            const arg = argument(info);
+            switch (major) {
+            case 0: return arg;
+            case 1: return -1 - arg;
+            case 3: {
+                need(arg);
+                const text = decodeText(data, pos, pos + arg);
+                pos += arg;
+                return text;
+            }
+            case 4: {
+                const list = new Array(arg);
+                for (let i = 0; i < arg; i++) list[i] = item();
+                return list;
+            }
+            case 5: {
+                const map = {};
+                for (let i = 0; i < arg; i++) {
+                    const key = item();
+                    map[key] = item();
+                }
+                return map;
+            }
+            default: throw new Error(`CBOR: unsupported major type ${major}`);
+            }
+        }
+
+        const value = item();
+        if (pos !== data.length) {
+            throw new Error('CBOR: trailing bytes');
+        }
+        return value;
+    }
+
+    // Shortest float that holds the number exactly, as the firmware writer does (plus float64)
+    function floatHead(value, out) {
+        scratch.setFloat32(0, value);
+        if (scratch.getFloat32(0) === value || Number.isNaN(value)) {
+            const bits = scratch.getUint32(0);
+            const exponent = ((bits >>> 23) & 0xff) - 127;
+            const mantissa = bits & 0x7fffff;
+            const sign = (bits >>> 16) & 0x8000;
+            let half = -1;
+            if (Number.isNaN(value)) half = 0x7e00;
+            else if (!isFinite(value)) half = sign | 0x7c00;
+            else if (value === 0) half = sign;
+            else if (exponent >= -14 && exponent <= 15 && (mantissa & 0x1fff) === 0) {
+                half = sign | ((exponent + 15) << 10) | (mantissa >>> 13);
+            } else if (exponent >= -24 && exponent < -14) {
+                const full = mantissa | 0x800000;
+                const shift = -1 - exponent;
+                if ((full & ((1 << shift) - 1)) === 0) half = sign | (full >>> shift);
+            }
+            if (half >= 0) {
+                out.push(0xf9, half >> 8, half & 0xff);
+                return;
+            }
+            out.push(0xfa, bits >>> 24, (bits >>> 16) & 0xff, (bits >>> 8) & 0xff, bits & 0xff);
+            return;
+        }
+        scratch.setFloat64(0, value);
+        out.push(0xfb);
+        for (let i = 0; i < 8; i++) out.push(scratch.getUint8(i));
+    }
+
+    function head(major, value, out) {
+        if (value < 24) {
+            out.push((major << 5) | value);
+        } else if (value <= 0xff) {
+            out.push((major << 5) | 24, value);
+        } else if (value <= 0xffff) {
+            out.push((major << 5) | 25, value >> 8, value & 0xff);
+        } else if (value <= 0xffffffff) {
+            out.push((major << 5) | 26, value >>> 24, (value >>> 16) & 0xff, (value >>> 8) & 0xff, value & 0xff);
+        } else {
+            const big = BigInt(value);
+            out.push((major << 5) | 27);
+            for (let shift = 56n; shift >= 0n; shift -= 8n) out.push(Number((big >> shift) & 0xffn));
+        }
+    }
+
+    function encodeItem(value, out) {
+        if (value === null || value === undefined) {
+            out.push(0xf6);
+        } else if (typeof value === 'boolean') {
+            out.push(value ? 0xf5 : 0xf4);
+        } else if (typeof value === 'number') {
+            if (Number.isSafeInteger(value)) {
+                if (value >= 0) head(0, value, out);
+                else head(1, -1 - value, out);
+            } else {
+                floatHead(value, out);
+            }
+        } else if (typeof value === 'string') {
+            if (/^[\x00-\x7f]*$/.test(value)) {
+                head(3, value.length, out);
+                for (let i = 0; i < value.length; i++) out.push(value.charCodeAt(i));
+                return;
+            }
+            const bytes = utf8Encoder.encode(value);
+            head(3, bytes.length, out);
+            for (const b of bytes) out.push(b);
+        } else if (Array.isArray(value)) {
+            head(4, value.length, out);
+            for (let i = 0; i < value.length; i++) encodeItem(value[i], out);
+        } else if (typeof value === 'object') {
+            const keys = Object.keys(value);
+            head(5, keys.length, out);
+            for (const key of keys) {
+                encodeItem(key, out);
+                encodeItem(value[key], out);
+            }
+        } else {
+            throw new Error(`CBOR: cannot encode ${typeof value}`);
+        }
+    }
+
+    // Integral numbers become CBOR integers; pass sensor values through Math.fround()
+    // to get the firmware's 5-byte single floats instead of 9-byte doubles
+    function encode(value) {
+        const out = [];
+        encodeItem(value, out);
+        return Uint8Array.from(out);
+    }
+
+    return { decode, encode, isBinary };
+}));
@@ -24,7 +24,8 @@ let stateSync = {
     maxSyncRetries: 3,
     deviceOffLock: false,
     deviceOffLockTimeout: null,
-    lastSyncMessage: '' // Track duplicate messages
+    lastSyncMessage: '', // Track duplicate messages
+    stateReceived: false // Retained state seen since (re)connect
 };
 
 // Firebase Configuration
@@ -34,6 +35,19 @@ let FIREBASE_CONFIG = {
     projectId: "datalogger-8c5d5"
 };
 
+// Local archive (broker/archive): one subscriber stores every sample, so when it is
+// reachable the dashboard reads history from it and stops writing to Firebase.
+// Override with ?archive=http://host:port
+const ARCHIVE_CONFIG = {
+    url: new URLSearchParams(window.location.search).get('archive') ||
+        `http://${window.location.hostname || '127.0.0.1'}:8090`
+};
+let isArchiveAvailable = false;
+
+// Latest retained rollup of the selected device per topic key (rollup1m, rollup15m, rollup1h):
+// { period_s, up_s, buckets: [[start_s, count, t_min, t_max, t_mean, h_min, h_max, h_mean]], receivedMs }
+let rollups = {};
+
 // FIXED: Enhanced MQTT Configuration
 const MQTT_CONFIG = {
     host: '127.0.0.1',
@@ -42,17 +56,52 @@ const MQTT_CONFIG = {
     username: 'DataLogger',
     password: 'datalogger',
     url: 'ws://127.0.0.1:8083/mqtt',
+    // Every bridge publishes below <root>/<client id>/, e.g. esp32/ESP32_A1B2C3/state
+    root: 'esp32',
     topics: {
-        command: "esp32/sensor/sht3x/command",
-        deviceControl: "esp32/control/relay",
-        periodicTemp: "esp32/sensor/sht3x/periodic/temperature",
-        periodicHumi: "esp32/sensor/sht3x/periodic/humidity",
-        singleTemp: "esp32/sensor/sht3x/single/temperature",
-        singleHumi: "esp32/sensor/sht3x/single/humidity",
-        stateSync: "esp32/state"
+        command: "sensor/sht3x/command",
+        deviceControl: "control/relay",
+        periodicTemp: "sensor/sht3x/periodic/temperature",
+        periodicHumi: "sensor/sht3x/periodic/humidity",
+        singleTemp: "sensor/sht3x/single/temperature",
+        singleHumi: "sensor/sht3x/single/humidity",
+        stateSync: "state",
+        trace: "sensor/sht3x/trace",
+        batch: "sensor/sht3x/batch",
+        rollup1m: "sensor/sht3x/rollup/1m",
+        rollup15m: "sensor/sht3x/rollup/15m",
+        rollup1h: "sensor/sht3x/rollup/1h"
     }
 };
 
+// Topic suffix -> MQTT_CONFIG.topics key, for routing incoming messages
+const TOPIC_KEYS = Object.fromEntries(Object.entries(MQTT_CONFIG.topics).map(([key, suffix]) => [suffix, key]));
+
+// Device discovery and selection: every bridge's retained state arrives on <root>/+/state,
+// but sample topics are subscribed for the selected bridge only, so the broker's fan-out
+// grows with what is being watched rather than with the fleet
+const devices = {
+    known: new Map(),           // client id -> last parsed state
+    selected: new URLSearchParams(window.location.search).get('device'),
+    subscribed: null            // Device whose sample topics are subscribed on this connection
+};
+
+// End-to-end latency tracing: STM32 I2C read -> ESP32 UART line -> MQTT publish -> browser -> chart paint
+// Clocks are not synchronized, so each cross-device offset is the minimum of
+// (receiver time - sender time) over the last OFFSET_WINDOW samples. A hop then reads
+// as its delay above the fastest recent sample, plus the known floor of that hop.
+const latencyTrace = {
+    OFFSET_WINDOW: 64,          // Short enough that crystal drift (~20 ppm) stays well below 1 ms
+    HISTORY: 500,               // Samples kept per hop for percentiles
+    UART_FLOOR_US: 3100,        // ~36 bytes at 115200 baud, 10 bits each
+    stmDeltas: [],              // (esp rx - stm) mod 2^32, us
+    pubDeltas: [],              // browser receive - esp publish, us
+    hops: { uart: [], bridge: [], mqtt: [], render: [], total: [] },
+    lastRecvMs: null,           // performance.now() when the sample's temperature arrived
+    lastPaintMs: null,          // performance.now() of the first frame painted after it
+    lastUpdateMs: 0
+};
+
 // Enhanced Chart configurations
 const chartTempConfig = {
     type: 'line',
@@ -279,8 +328,15 @@ function updateFirebaseStatus(connected) {
     }
 }
 
+// History is kept per bridge: sht31/<client_id>/<type>/<timestamp>
+function firebaseSeries(device, type) {
+    return `sht31/${device}/${type}`;
+}
+
 function saveToFirebase(type, value, timestamp) {
-    if (!isFirebaseConnected || !firebaseDb) return;
+    // Samples arrive only from the subscribed device's topics
+    const device = devices.subscribed;
+    if (!isFirebaseConnected || !firebaseDb || !device) return;
     
     const data = {
         value: value,
@@ -289,7 +345,7 @@ function saveToFirebase(type, value, timestamp) {
         source: isPeriodic ? 'periodic' : 'single'
     };
     
-    firebaseDb.ref(`sht31/${type}/${timestamp}`).set(data)
+    firebaseDb.ref(`${firebaseSeries(device, type)}/${timestamp}`).set(data)
         .then(() => {
             console.log(`Saved ${type}: ${value} to Firebase`);
         })
@@ -298,67 +354,157 @@ function saveToFirebase(type, value, timestamp) {
         });
 }
 
+function checkArchive() {
+    fetch(`${ARCHIVE_CONFIG.url}/api/stats`, { cache: 'no-store' })
+        .then(response => response.ok ? response.json() : Promise.reject(new Error(`HTTP ${response.status}`)))
+        .then(stats => {
+            isArchiveAvailable = true;
+            addStatus(`Archive connected: ${stats.series} series, history from ${ARCHIVE_CONFIG.url}`, 'INFO');
+        })
+        .catch(() => {
+            isArchiveAvailable = false;
+        });
+}
+
+// [time ms, value] pairs, oldest first, appended to a chart and its data array
+function appendHistory(chart, data, points) {
+    points.forEach(([time, value]) => {
+        const timestamp = new Date(time).toLocaleTimeString('en-US', {
+            hour12: false,
+            hour: '2-digit',
+            minute: '2-digit',
+            second: '2-digit'
+        });
+        
+        if (chart) {
+            chart.data.labels.push(timestamp);
+            chart.data.datasets[0].data.push(value);
+        }
+        data.push(value);
+    });
+    
+    if (chart) chart.update('none');
+}
+
+function loadArchiveHistory() {
+    if (!devices.selected) {
+        addStatus('No device selected', 'ERROR');
+        return;
+    }
+    
+    addStatus(`Loading ${devices.selected} history from archive...`, 'INFO');
+    clearChartData();
+    
+    const query = (metric) => {
+        const params = new URLSearchParams({ device: devices.selected, metric: metric, limit: maxDataPoints });
+        return fetch(`${ARCHIVE_CONFIG.url}/api/range?${params}`, { cache: 'no-store' })
+            .then(response => response.ok ? response.json() : Promise.reject(new Error(`HTTP ${response.status}`)));
+    };
+    
+    Promise.all([query('temperature'), query('humidity')])
+        .then(([temperature, humidity]) => {
+            appendHistory(chart1, temperatureData, temperature.points);
+            appendHistory(chart2, humidityData, humidity.points);
+            updateTempStats();
+            updateHumiStats();
+            addStatus(`Historical data loaded: ${temperature.points.length} + ${humidity.points.length} samples`, 'INFO');
+        })
+        .catch((error) => {
+            addStatus(`Archive query error: ${error.message}`, 'ERROR');
+        });
+}
+
+function handleRollupMessage(key, body) {
+    if (body === '') {
+        delete rollups[key];    // Cleared by a bridge that restarted
+        return;
+    }
+    const rollup = typeof body === 'string' ? JSON.parse(body) : body;
+    if (!rollup || !Array.isArray(rollup.buckets) || typeof rollup.up_s !== 'number') {
+        return;
+    }
+    // CBOR floats carry the exact mean; JSON has 2 decimals already
+    rollup.buckets = rollup.buckets.map(b => b.map((v, i) => (i < 2 ? v : Math.round(v * 100) / 100)));
+    rollup.receivedMs = Date.now();
+    rollups[key] = rollup;
+}
+
+// Bucket start (bridge uptime, s) -> wall clock. All rollups of a bridge share its uptime,
+// so the most recently published one, which a retained message is least behind, anchors all
+function rollupTime(startS) {
+    const anchor = Object.values(rollups).reduce((a, r) => (!a || r.up_s > a.up_s ? r : a), null);
+    return anchor.receivedMs - (anchor.up_s - startS) * 1000;
+}
+
+function showRollupStats(elementId, unit, buckets, offset) {
+    const stats = document.getElementById(elementId);
+    if (!stats) return;
+    const count = buckets.reduce((n, b) => n + b[1], 0);
+    const min = Math.min(...buckets.map(b => b[offset])).toFixed(1);
+    const max = Math.max(...buckets.map(b => b[offset + 1])).toFixed(1);
+    const avg = (buckets.reduce((sum, b) => sum + b[offset + 2] * b[1], 0) / count).toFixed(1);
+    stats.textContent = `Min: ${min}${unit} | Max: ${max}${unit} | Avg: ${avg}${unit}`;
+}
+
+// One point per bucket (its mean), from the bridge's retained 1 min / 15 min / 1 h rollups
+function loadRollupHistory(key) {
+    const rollup = rollups[key];
+    if (!rollup || !rollup.buckets.length) {
+        addStatus('No rollups received from this device yet', 'ERROR');
+        return;
+    }
+    
+    clearChartData();
+    const buckets = rollup.buckets;
+    appendHistory(chart1, temperatureData, buckets.map(b => [rollupTime(b[0]), b[4]]));
+    appendHistory(chart2, humidityData, buckets.map(b => [rollupTime(b[0]), b[7]]));
+    showRollupStats('tempStats', '°C', buckets, 2);
+    showRollupStats('humiStats', '%', buckets, 5);
+    addStatus(`Rollup loaded: ${buckets.length} x ${rollup.period_s / 60} min, ` +
+        `${buckets.reduce((n, b) => n + b[1], 0)} samples`, 'INFO');
+}
+
 function loadHistoricalData() {
+    const range = document.getElementById('historyRange');
+    if (range && range.value !== 'raw') {
+        loadRollupHistory(range.value);
+        return;
+    }
+    
+    if (isArchiveAvailable) {
+        loadArchiveHistory();
+        return;
+    }
+    
     if (!isFirebaseConnected || !firebaseDb) {
         addStatus('Firebase not connected', 'ERROR');
         return;
     }
     
-    addStatus('Loading historical data...', 'FIREBASE');
+    const device = devices.selected;
+    if (!device) {
+        addStatus('No device selected', 'ERROR');
+        return;
+    }
+    
+    addStatus(`Loading ${device} history...`, 'FIREBASE');
     clearChartData();
     
+    const toPoints = (snapshot) => Object.values(snapshot.val() || {}).map(item => [item.timestamp, item.value]);
+    
+    // Replies for a device no longer selected are dropped, not drawn on the new one's charts
     // Load temperature data
-    firebaseDb.ref('sht31/temperature').limitToLast(maxDataPoints).once('value', (snapshot) => {
-        const tempData = snapshot.val();
-        if (tempData) {
-            const tempArray = Object.values(tempData);
-            tempArray.forEach(item => {
-                const timestamp = new Date(item.timestamp).toLocaleTimeString('en-US', {
-                    hour12: false,
-                    hour: '2-digit',
-                    minute: '2-digit',
-                    second: '2-digit'
-                });
-                
-                if (chart1) {
-                    chart1.data.labels.push(timestamp);
-                    chart1.data.datasets[0].data.push(item.value);
-                }
-                temperatureData.push(item.value);
-            });
-            
-            if (chart1) {
-                chart1.update('none');
-                updateTempStats();
-            }
-        }
+    firebaseDb.ref(firebaseSeries(device, 'temperature')).limitToLast(maxDataPoints).once('value', (snapshot) => {
+        if (device !== devices.selected) return;
+        appendHistory(chart1, temperatureData, toPoints(snapshot));
+        updateTempStats();
     });
     
     // Load humidity data
-    firebaseDb.ref('sht31/humidity').limitToLast(maxDataPoints).once('value', (snapshot) => {
-        const humiData = snapshot.val();
-        if (humiData) {
-            const humiArray = Object.values(humiData);
-            humiArray.forEach(item => {
-                const timestamp = new Date(item.timestamp).toLocaleTimeString('en-US', {
-                    hour12: false,
-                    hour: '2-digit',
-                    minute: '2-digit',
-                    second: '2-digit'
-                });
-                
-                if (chart2) {
-                    chart2.data.labels.push(timestamp);
-                    chart2.data.datasets[0].data.push(item.value);
-                }
-                humidityData.push(item.value);
-            });
-            
-            if (chart2) {
-                chart2.update('none');
-                updateHumiStats();
-            }
-        }
+    firebaseDb.ref(firebaseSeries(device, 'humidity')).limitToLast(maxDataPoints).once('value', (snapshot) => {
+        if (device !== devices.selected) return;
+        appendHistory(chart2, humidityData, toPoints(snapshot));
+        updateHumiStats();
         addStatus('Historical data loaded successfully', 'FIREBASE');
     });
 }
@@ -413,6 +559,132 @@ function updateHumiStats() {
     }
 }
 
+// Latency tracing functions
+function markSampleReceived() {
+    latencyTrace.lastRecvMs = performance.now();
+    latencyTrace.lastPaintMs = null;
+}
+
+function markSampleRendered() {
+    // Chart.js has drawn into the canvas; the browser shows it on the next frame
+    requestAnimationFrame(() => {
+        latencyTrace.lastPaintMs = performance.now();
+    });
+}
+
+function pushBounded(list, value, limit) {
+    list.push(value);
+    if (list.length > limit) {
+        list.shift();
+    }
+}
+
+function percentile(sorted, p) {
+    if (sorted.length === 0) {
+        return NaN;
+    }
+    const idx = Math.min(sorted.length - 1, Math.ceil((p / 100) * sorted.length) - 1);
+    return sorted[Math.max(0, idx)];
+}
+
+// JSON text, or the same object already decoded from CBOR
+function handleTraceMessage(body) {
+    let trace;
+    try {
+        trace = typeof body === 'string' ? JSON.parse(body) : body;
+    } catch (e) {
+        return;
+    }
+    if (latencyTrace.lastRecvMs === null) {
+        return;
+    }
+
+    // The trace follows its sample on the same connection; wait for the sample's paint
+    if (latencyTrace.lastPaintMs === null) {
+        requestAnimationFrame(() => requestAnimationFrame(() => recordTrace(trace)));
+        return;
+    }
+    recordTrace(trace);
+}
+
+function recordTrace(trace) {
+    const recvMs = latencyTrace.lastRecvMs;
+    const paintMs = latencyTrace.lastPaintMs;
+    if (recvMs === null || paintMs === null) {
+        return;
+    }
+    latencyTrace.lastRecvMs = null;
+
+    // STM32 stamps are 32-bit microseconds; compare modulo 2^32 so wraps cancel out
+    const stmDelta = ((trace.rx_us % 4294967296) - trace.stm_us + 4294967296) % 4294967296;
+    const pubDelta = (performance.timeOrigin + recvMs) * 1000 - trace.pub_us;
+    pushBounded(latencyTrace.stmDeltas, stmDelta, latencyTrace.OFFSET_WINDOW);
+    pushBounded(latencyTrace.pubDeltas, pubDelta, latencyTrace.OFFSET_WINDOW);
+
+    const uart = stmDelta - Math.min(...latencyTrace.stmDeltas) + latencyTrace.UART_FLOOR_US;
+    const bridge = trace.pub_us - trace.rx_us;
+    const mqtt = pubDelta - Math.min(...latencyTrace.pubDeltas);
+    const render = (paintMs - recvMs) * 1000;
+
+    const hops = latencyTrace.hops;
+    pushBounded(hops.uart, uart, latencyTrace.HISTORY);
+    pushBounded(hops.bridge, bridge, latencyTrace.HISTORY);
+    pushBounded(hops.mqtt, mqtt, latencyTrace.HISTORY);
+    pushBounded(hops.render, render, latencyTrace.HISTORY);
+    pushBounded(hops.total, uart + bridge + mqtt + render, latencyTrace.HISTORY);
+
+    // Sorting 5 x 500 values is cheap, but there is no need to do it at 10 Hz
+    const now = performance.now();
+    if (now - latencyTrace.lastUpdateMs >= 1000) {
+        latencyTrace.lastUpdateMs = now;
+        updateLatencyStats();
+    }
+}
+
+function updateLatencyStats() {
+    const el = document.getElementById('latencyStats');
+    if (!el) {
+        return;
+    }
+
+    const ms = (us) => isNaN(us) ? '--' : (us / 1000).toFixed(1);
+    const parts = Object.entries(latencyTrace.hops).map(([name, values]) => {
+        const sorted = [...values].sort((a, b) => a - b);
+        return `${name} ${ms(percentile(sorted, 50))}/${ms(percentile(sorted, 95))}/${ms(percentile(sorted, 99))}`;
+    });
+    el.textContent = `Latency p50/p95/p99 ms (n=${latencyTrace.hops.total.length}): ${parts.join(' | ')}`;
+}
+
+// Periodic samples batched by the bridge (CONFIG_BRIDGE_SAMPLE_BATCH_SIZE), CBOR:
+// {"seq","rx_us","dt_us":[],"temperature":[],"humidity":[]}, dt_us relative to rx_us.
+// The last sample is taken as received now and the others placed before it.
+// A ts_codec block (CONFIG_BRIDGE_SAMPLE_BATCH_DELTA) is converted to the same shape first.
+function batchFromBlock(block) {
+    const rxUs = block.time.length ? block.time[0] : 0;
+    return {
+        seq: block.sequence,
+        rx_us: rxUs,
+        dt_us: block.time.map((t) => t - rxUs),
+        temperature: block.values[0] || [],
+        humidity: block.values[1] || []
+    };
+}
+
+function handleBatchMessage(batch) {
+    if (!batch || !Array.isArray(batch.dt_us) || !Array.isArray(batch.temperature) ||
+        !Array.isArray(batch.humidity) || !batch.dt_us.length) {
+        return;
+    }
+    const now = Date.now();
+    const lastUs = batch.dt_us[batch.dt_us.length - 1];
+    addStatus(`Periodic batch ${batch.seq}: ${batch.dt_us.length} samples`, 'DATA');
+    batch.dt_us.forEach((dtUs, i) => {
+        const timestamp = now - Math.round((lastUs - dtUs) / 1000);
+        pushTemperature(Math.round(batch.temperature[i] * 100) / 100, true, timestamp);
+        pushHumidity(Math.round(batch.humidity[i] * 100) / 100, true, timestamp);
+    });
+}
+
 // FIXED: Enhanced device OFF lock management
 function setDeviceOffLock(duration = 1500) {
     // Clear existing timeout if any
@@ -432,7 +704,7 @@ function setDeviceOffLock(duration = 1500) {
 
 // State synchronization functions
 function requestStateSync() {
-    if (!isMqttConnected || stateSync.syncInProgress) {
+    if (!isMqttConnected || stateSync.syncInProgress || !devices.selected) {
         return;
     }
     
@@ -447,7 +719,7 @@ function requestStateSync() {
     addStatus(`Requesting system state sync... (${stateSync.syncRetryCount}/${stateSync.maxSyncRetries})`, 'SYNC');
     
     // Request current state from ESP32
-    publishMQTT(MQTT_CONFIG.topics.stateSync, 'REQUEST');
+    publishMQTT(deviceTopic('stateSync'), 'REQUEST');
     
     // Reset sync state after timeout
     setTimeout(() => {
@@ -460,13 +732,15 @@ function requestStateSync() {
 
 function parseStateMessage(stateData) {
     try {
-        // Parse JSON state message from ESP32
-        const state = JSON.parse(stateData);
+        // JSON state message from ESP32, or the same map already decoded from CBOR
+        const state = typeof stateData === 'string' ? JSON.parse(stateData) : stateData;
         
         return {
             device: state.device === 'ON',
             periodic: state.periodic === 'ON',
-            rate: parseInt(state.rate) || 1,
+            rate: parseFloat(state.rate) || 1,
+            repeat: state.repeat || 'HIGH',
+            heater: state.heater === 'ON',
             timestamp: state.timestamp || Date.now()
         };
     } catch (error) {
@@ -532,7 +806,7 @@ function syncUIWithHardwareState(parsedState) {
             
             // Send stop command if needed
             if (previousPeriodicState) {
-                publishMQTT(MQTT_CONFIG.topics.command, 'SHT3X PERIODIC STOP');
+                publishMQTT(deviceTopic('command'), 'SHT3X PERIODIC STOP');
                 addStatus('Periodic mode force-stopped (device OFF)', 'SYNC');
             }
         }
@@ -576,7 +850,7 @@ function syncUIWithHardwareState(parsedState) {
         if (isDeviceOn && !isPeriodic && (currentTemp === null || currentHumi === null)) {
             setTimeout(() => {
                 if (isDeviceOn && isMqttConnected && !isPeriodic) {
-                    publishMQTT(MQTT_CONFIG.topics.command, 'SHT3X SINGLE HIGH');
+                    publishMQTT(deviceTopic('command'), 'SHT3X SINGLE HIGH');
                     addStatus('Auto-requesting current values after sync...', 'SYNC');
                 }
             }, 1500); // Wait 1.5s for device to be ready
@@ -587,6 +861,120 @@ function syncUIWithHardwareState(parsedState) {
     stateSync.syncRetryCount = 0;
 }
 
+// Device topics and selection
+function deviceTopic(key, device = devices.selected) {
+    return `${MQTT_CONFIG.root}/${device}/${MQTT_CONFIG.topics[key]}`;
+}
+
+function discoveryTopic() {
+    return `${MQTT_CONFIG.root}/+/${MQTT_CONFIG.topics.stateSync}`;
+}
+
+// State is left out: the discovery subscription already covers it
+function deviceSubscriptions(device) {
+    return ['periodicTemp', 'periodicHumi', 'singleTemp', 'singleHumi', 'deviceControl', 'trace', 'batch',
+        'rollup1m', 'rollup15m', 'rollup1h'].map((key) => deviceTopic(key, device));
+}
+
+// "<root>/<device>/<suffix>" -> { device, key }, null for anything else
+function parseDeviceTopic(topic) {
+    const rootLength = MQTT_CONFIG.root.length + 1;
+    const slash = topic.indexOf('/', rootLength);
+    if (!topic.startsWith(MQTT_CONFIG.root + '/') || slash < 0) {
+        return null;
+    }
+    const key = TOPIC_KEYS[topic.substring(slash + 1)];
+    return key ? { device: topic.substring(rootLength, slash), key } : null;
+}
+
+function updateDeviceSelector() {
+    const select = document.getElementById('deviceSelect');
+    if (!select) return;
+
+    const ids = [...devices.known.keys()].sort();
+    if (devices.selected && !devices.known.has(devices.selected)) {
+        ids.unshift(devices.selected);
+    }
+    select.innerHTML = ids.length ? '' : '<option value="">No devices</option>';
+    ids.forEach((id) => {
+        const option = document.createElement('option');
+        option.value = id;
+        option.textContent = id;
+        select.appendChild(option);
+    });
+    select.value = devices.selected || '';
+}
+
+function onDeviceState(device, parsedState) {
+    const isNew = !devices.known.has(device);
+    devices.known.set(device, parsedState);
+    if (isNew) {
+        addStatus(`Device discovered: ${device}`, 'MQTT');
+        updateDeviceSelector();
+    }
+
+    if (!devices.selected) {
+        selectDevice(device);
+    } else if (device === devices.selected) {
+        stateSync.stateReceived = true;
+        syncUIWithHardwareState(parsedState);
+    }
+}
+
+function subscribeDevice() {
+    if (!mqttClient || !isMqttConnected || !devices.selected || devices.subscribed === devices.selected) {
+        return;
+    }
+    if (devices.subscribed) {
+        mqttClient.unsubscribe(deviceSubscriptions(devices.subscribed));
+    }
+
+    const device = devices.selected;
+    devices.subscribed = device;
+    mqttClient.subscribe(deviceSubscriptions(device), { qos: 0 }, (err) => {
+        if (err) {
+            addStatus(`Subscribe to ${device} failed: ${err.message}`, 'ERROR');
+            devices.subscribed = null;
+        } else {
+            addStatus(`Subscribed to ${device}`, 'MQTT');
+        }
+    });
+}
+
+function selectDevice(device) {
+    if (!device || (device === devices.selected && devices.subscribed === device)) {
+        return;
+    }
+
+    const previous = devices.selected;
+    devices.selected = device;
+    updateDeviceSelector();
+    addStatus(`Selected device: ${device}`, 'INFO');
+
+    // Another bridge: its samples, clocks and state have nothing to do with the last one
+    clearChartData();
+    rollups = {};
+    latencyTrace.stmDeltas = [];
+    latencyTrace.pubDeltas = [];
+    Object.keys(latencyTrace.hops).forEach((hop) => { latencyTrace.hops[hop] = []; });
+    latencyTrace.lastRecvMs = null;
+    stateSync.lastSyncMessage = '';
+    stateSync.syncRetryCount = 0;
+    stateSync.stateReceived = devices.known.has(device);
+    if (stateSync.stateReceived) {
+        syncUIWithHardwareState(devices.known.get(device));
+    }
+
+    subscribeDevice();
+
+    // The charts were cleared: reload raw history for the new device. Rollups need no
+    // load, they arrive as retained messages on the new subscription
+    const range = document.getElementById('historyRange');
+    if (previous && (!range || range.value === 'raw') && (isArchiveAvailable || isFirebaseConnected)) {
+        loadHistoricalData();
+    }
+}
+
 // MQTT Functions
 function updateConnectionStatus(connected) {
     isMqttConnected = connected;
@@ -598,16 +986,20 @@ function updateConnectionStatus(connected) {
         statusText.textContent = 'MQTT Connected';
         addStatus('MQTT broker connected', 'MQTT');
         
-        // Request state sync after connection
+        // The broker replays the retained state on subscribe; only ask when none arrived
+        stateSync.stateReceived = false;
         setTimeout(() => {
-            requestStateSync();
-        }, 1000);
+            if (!stateSync.stateReceived) {
+                requestStateSync();
+            }
+        }, 2000);
     } else {
         statusDot.className = 'status-dot disconnected';
         statusText.textContent = 'MQTT Disconnected';
         addStatus('MQTT broker disconnected', 'MQTT');
         
-        // Reset sync state
+        // Reset sync state; subscriptions are gone with the clean session
+        devices.subscribed = null;
         stateSync.syncInProgress = false;
         stateSync.syncRetryCount = 0;
         stateSync.lastSyncMessage = '';
@@ -615,7 +1007,9 @@ function updateConnectionStatus(connected) {
 }
 
 function publishMQTT(topic, message) {
-    if (mqttClient && isMqttConnected) {
+    if (!devices.selected) {
+        addStatus('Cannot publish: no device selected', 'ERROR');
+    } else if (mqttClient && isMqttConnected) {
         mqttClient.publish(topic, message, (err) => {
             if (err) {
                 addStatus(`Publish failed: ${err.message}`, 'ERROR');
@@ -662,22 +1056,15 @@ function connectMQTT() {
             console.log('MQTT Connected:', connack);
             updateConnectionStatus(true);
             
-            const topics = [
-                MQTT_CONFIG.topics.periodicTemp,
-                MQTT_CONFIG.topics.periodicHumi,
-                MQTT_CONFIG.topics.singleTemp,
-                MQTT_CONFIG.topics.singleHumi,
-                MQTT_CONFIG.topics.deviceControl,
-                MQTT_CONFIG.topics.stateSync
-            ];
-            
-            mqttClient.subscribe(topics, { qos: 0 }, (err) => {
+            // Retained states list every device; the selected one also gets its sample topics
+            mqttClient.subscribe(discoveryTopic(), { qos: 0 }, (err) => {
                 if (err) {
                     addStatus('MQTT subscribe failed: ' + err.message, 'ERROR');
                 } else {
-                    addStatus('All topics subscribed successfully', 'MQTT');
+                    addStatus('Discovering devices on ' + discoveryTopic(), 'MQTT');
                 }
             });
+            subscribeDevice();
         });
 
         mqttClient.on('reconnect', () => {
@@ -709,37 +1096,90 @@ function connectMQTT() {
         });
 
         mqttClient.on('message', (topic, payload) => {
-            const text = payload.toString();
-            console.log('MQTT Message:', topic, text);
+            const route = parseDeviceTopic(topic);
+            if (!route) {
+                return;
+            }
+            
+            // Bridges built with CBOR encoding send binary payloads; text never starts >= 0x80.
+            // Batches may instead be ts_codec blocks, which start with 0x01.
+            let body;
+            if (route.key === 'batch' && TSCodec.isBlock(payload)) {
+                try {
+                    body = batchFromBlock(TSCodec.decode(payload));
+                } catch (e) {
+                    console.log('Bad batch block:', topic, e.message);
+                    return;
+                }
+            } else if (CBOR.isBinary(payload)) {
+                try {
+                    body = CBOR.decode(payload);
+                } catch (e) {
+                    console.log('Bad CBOR payload:', topic, e.message);
+                    return;
+                }
+            } else {
+                body = payload.toString();
+            }
+            const text = typeof body === 'string' ? body : JSON.stringify(body);
             
-            // FIXED: Handle state synchronization messages
-            if (topic === MQTT_CONFIG.topics.stateSync) {
-                const parsedState = parseStateMessage(text);
+            // State of any device feeds discovery; REQUEST messages from other dashboards do not parse
+            if (route.key === 'stateSync') {
+                console.log('MQTT Message:', topic, text);
+                const parsedState = body === 'REQUEST' ? null : parseStateMessage(body);
                 if (parsedState) {
-                    syncUIWithHardwareState(parsedState);
+                    onDeviceState(route.device, parsedState);
                 }
                 return;
             }
             
-            // Handle sensor data
-            let val = parseFloat(text);
+            // In flight while switching devices
+            if (route.device !== devices.selected) {
+                return;
+            }
+            
+            // Trace messages arrive with every sample; keep them out of the console
+            if (route.key === 'trace') {
+                handleTraceMessage(body);
+                return;
+            }
+            if (route.key === 'batch') {
+                handleBatchMessage(body);
+                return;
+            }
+            if (route.key.startsWith('rollup')) {
+                try {
+                    handleRollupMessage(route.key, body);
+                } catch (e) {
+                    console.log('Bad rollup:', topic, e.message);
+                }
+                return;
+            }
+            console.log('MQTT Message:', topic, text);
+            
+            // Handle sensor data; CBOR floats carry the raw reading, text has 2 decimals
+            let val = typeof body === 'number' ? Math.round(body * 100) / 100 : parseFloat(body);
             
             if (!isNaN(val) && isFinite(val)) {
                 const timestamp = Date.now();
-                switch (topic) {
-                    case MQTT_CONFIG.topics.periodicTemp:
+                switch (route.key) {
+                    case 'periodicTemp':
+                        markSampleReceived();
                         addStatus(`Periodic temp: ${val}°C`, 'DATA');
                         pushTemperature(val, true, timestamp);
+                        markSampleRendered();
                         break;
-                    case MQTT_CONFIG.topics.periodicHumi:
+                    case 'periodicHumi':
                         addStatus(`Periodic humi: ${val}%`, 'DATA');
                         pushHumidity(val, true, timestamp);
                         break;
-                    case MQTT_CONFIG.topics.singleTemp:
+                    case 'singleTemp':
+                        markSampleReceived();
                         addStatus(`Single temp: ${val}°C`, 'SINGLE');
                         pushTemperature(val, false, timestamp);
+                        markSampleRendered();
                         break;
-                    case MQTT_CONFIG.topics.singleHumi:
+                    case 'singleHumi':
                         addStatus(`Single humi: ${val}%`, 'SINGLE');
                         pushHumidity(val, false, timestamp);
                         break;
@@ -831,7 +1271,7 @@ function pushTemperature(newTemp, isPeriodicData = false, timestamp = Date.now()
     updateCurrentDisplay();
     
     // Save to Firebase if enabled and is periodic data
-    if (isFirebaseConnected && isPeriodicData) {
+    if (isFirebaseConnected && isPeriodicData && !isArchiveAvailable) {
         saveToFirebase('temperature', newTemp, timestamp);
     }
     
@@ -867,7 +1307,7 @@ function pushHumidity(newHumi, isPeriodicData = false, timestamp = Date.now()) {
     updateCurrentDisplay();
     
     // Save to Firebase if enabled and is periodic data
-    if (isFirebaseConnected && isPeriodicData) {
+    if (isFirebaseConnected && isPeriodicData && !isArchiveAvailable) {
         saveToFirebase('humidity', newHumi, timestamp);
     }
     
@@ -961,7 +1401,7 @@ function startPeriodicMode() {
     if (!validateDeviceState('periodic mode')) return;
     
     const command = `SHT3X PERIODIC ${frameRate} HIGH`;
-    publishMQTT(MQTT_CONFIG.topics.command, command);
+    publishMQTT(deviceTopic('command'), command);
     
     // Update UI immediately (will be synced with hardware via state sync)
     isPeriodic = true;
@@ -977,7 +1417,7 @@ function stopPeriodicMode() {
         return;
     }
     
-    publishMQTT(MQTT_CONFIG.topics.command, 'SHT3X PERIODIC STOP');
+    publishMQTT(deviceTopic('command'), 'SHT3X PERIODIC STOP');
     
     // Update UI immediately (will be synced with hardware via state sync)
     isPeriodic = false;
@@ -990,7 +1430,7 @@ function stopPeriodicMode() {
 function singleRead() {
     if (!validateDeviceState('single read')) return;
     
-    publishMQTT(MQTT_CONFIG.topics.command, 'SHT3X SINGLE HIGH');
+    publishMQTT(deviceTopic('command'), 'SHT3X SINGLE HIGH');
     addStatus('Single read command sent', 'SINGLE');
 }
 
@@ -1003,7 +1443,7 @@ function toggleDevice() {
     const command = isDeviceOn ? 'RELAY OFF' : 'RELAY ON';
     const willBeDeviceOn = !isDeviceOn; // Store the future state
     
-    publishMQTT(MQTT_CONFIG.topics.deviceControl, command);
+    publishMQTT(deviceTopic('deviceControl'), command);
     
     // Update UI state immediately
     isDeviceOn = willBeDeviceOn;
@@ -1026,7 +1466,7 @@ function toggleDevice() {
         if (stopBtn) stopBtn.style.display = 'none';
         
         // Send MQTT command to stop periodic mode
-        publishMQTT(MQTT_CONFIG.topics.command, 'SHT3X PERIODIC STOP');
+        publishMQTT(deviceTopic('command'), 'SHT3X PERIODIC STOP');
         addStatus('Periodic mode stopped (device OFF)', 'STOP');
     }
     
@@ -1044,7 +1484,7 @@ function toggleDevice() {
         addStatus('Device turned ON - requesting current sensor values', 'POWER');
         setTimeout(() => {
             if (isDeviceOn && isMqttConnected) {
-                publishMQTT(MQTT_CONFIG.topics.command, 'SHT3X SINGLE HIGH');
+                publishMQTT(deviceTopic('command'), 'SHT3X SINGLE HIGH');
                 addStatus('Requesting latest sensor readings...', 'SINGLE');
             }
         }, 1000); // Wait 1 second for device to be ready
@@ -1108,6 +1548,13 @@ document.addEventListener('DOMContentLoaded', function() {
     if (ctx1) chart1 = new Chart(ctx1.getContext('2d'), chartTempConfig);
     if (ctx2) chart2 = new Chart(ctx2.getContext('2d'), chartHumiConfig);
     
+    // Device selector, filled by discovery
+    const deviceSelect = document.getElementById('deviceSelect');
+    if (deviceSelect) {
+        deviceSelect.addEventListener('change', () => selectDevice(deviceSelect.value));
+        updateDeviceSelector();
+    }
+    
     // Modal event listeners
     document.getElementById('settingsBtn').addEventListener('click', openModal);
     document.getElementById('cancelBtn').addEventListener('click', closeModal);
@@ -1159,6 +1606,7 @@ document.addEventListener('DOMContentLoaded', function() {
         addStatus('[WARNING] Firebase needed for data persistence', 'WARNING');
         updateConnectionStatus(false);
         updateFirebaseStatus(false);
+        checkArchive();
     }, 500);
     
     // Auto-connect MQTT
@@ -0,0 +1,122 @@
+// Decoder and encoder for firmware/ESP32/components/ts_codec blocks: delta-of-delta times and
+// delta values, as zigzag LEB128 varints. The bridge sends its sample batches this
+// way when built with CONFIG_BRIDGE_SAMPLE_BATCH_DELTA, and broker/archive stores
+// its blocks in the same format. Loaded by index.html as window.TSCodec and
+// required by the Node tools in broker/.
+(function (root, factory) {
+    if (typeof module === 'object' && module.exports) {
+        module.exports = factory();
+    } else {
+        root.TSCodec = factory();
+    }
+}(typeof self !== 'undefined' ? self : this, function () {
+    'use strict';
+
+    const FORMAT = 0x01;
+    const MAX_CHANNELS = 4;
+
+    // First byte 0x01: neither CBOR (>= 0x80) nor text or JSON (printable)
+    function isBlock(bytes) {
+        return bytes.length > 0 && bytes[0] === FORMAT;
+    }
+
+    // Numbers, not BigInt: exact up to 2^53, far beyond microseconds since boot.
+    // Value deltas are int32, so they never get near that.
+    function decode(bytes) {
+        const data = bytes instanceof Uint8Array ? bytes : new Uint8Array(bytes);
+        let pos = 0;
+
+        function varint() {
+            let value = 0;
+            let scale = 1;
+            for (let i = 0; i < 8; i++) {
+                if (pos >= data.length) throw new Error('TSCodec: truncated');
+                const b = data[pos++];
+                value += (b & 0x7f) * scale;
+                if (!(b & 0x80)) return value;
+                scale *= 128;
+            }
+            throw new Error('TSCodec: varint too large');
+        }
+
+        function zigzag() {
+            const n = varint();
+            return n % 2 ? -(n + 1) / 2 : n / 2;
+        }
+
+        if (varint() !== FORMAT) throw new Error('TSCodec: not a block');
+        const channels = varint();
+        if (channels < 1 || channels > MAX_CHANNELS) throw new Error(`TSCodec: ${channels} channels`);
+        const decimals = varint();
+        const sequence = varint();
+        const scale = 10 ** decimals;
+
+        const time = [];
+        const values = Array.from({ length: channels }, () => []);
+        const last = new Array(channels).fill(0);
+        let t = 0;
+        let delta = 0;
+
+        while (pos < data.length) {
+            const n = time.length;
+            if (n === 0) {
+                t = zigzag();
+            } else {
+                delta = n === 1 ? zigzag() : delta + zigzag();
+                t += delta;
+            }
+            time.push(t);
+            for (let c = 0; c < channels; c++) {
+                // Same int32 wrap-around as the encoder
+                last[c] = (last[c] + zigzag()) | 0;
+                values[c].push(last[c] / scale);
+            }
+        }
+        return { sequence, decimals, time, values };
+    }
+
+    function pushVarint(value, out) {
+        while (value >= 128) {
+            out.push((value % 128) | 0x80);
+            value = Math.floor(value / 128);
+        }
+        out.push(value);
+    }
+
+    function pushZigzag(value, out) {
+        pushVarint(value < 0 ? -2 * value - 1 : 2 * value, out);
+    }
+
+    // { sequence, decimals, time: [], values: [[], ...] } -> block; values are rounded
+    // to `decimals` and must fit an int32 once scaled
+    function encode(block) {
+        const channels = block.values.length;
+        if (channels < 1 || channels > MAX_CHANNELS) throw new Error(`TSCodec: ${channels} channels`);
+        const decimals = block.decimals || 0;
+        const scale = 10 ** decimals;
+        const out = [FORMAT, channels, decimals];
+        pushVarint(block.sequence || 0, out);
+
+        const last = new Array(channels).fill(0);
+        let t = 0;
+        let delta = 0;
+        block.time.forEach((time, n) => {
+            if (n === 0) {
+                pushZigzag(time, out);
+            } else {
+                const d = time - t;
+                pushZigzag(n === 1 ? d : d - delta, out);
+                delta = d;
+            }
+            t = time;
+            for (let c = 0; c < channels; c++) {
+                const v = Math.round(block.values[c][n] * scale) | 0;
+                pushZigzag((v - last[c]) | 0, out);
+                last[c] = v;
+            }
+        });
+        return Uint8Array.from(out);
+    }
+
+    return { decode, encode, isBlock };
+}));